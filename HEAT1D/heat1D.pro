@@ -14,6 +14,7 @@ INCLUDEPATH += ../soilFluxes3D/header
 INCLUDEPATH += ../gis
 
 LIBS += -L../soilFluxes3D/debug -lsoilFluxes3D
+!win32-msvc*: LIBS += -fopenmp
 LIBS += -L../mathFunctions/debug -lmathFunctions
 LIBS += -L../gis/debug -lgis
 
@@ -20,6 +20,7 @@ LIBS += -L../meteo/debug -lmeteo
 LIBS += -L../gis/debug -lgis
 LIBS += -L../quality/debug -lquality
 LIBS += -L../interpolation/debug -linterpolation
+!win32-msvc*: LIBS += -fopenmp
 LIBS += -L../MapGraphics/debug -lMapGraphics
 LIBS += -L../netcdfHandler/debug -lnetcdfHandler
 
@@ -2,8 +2,11 @@
 #include <math.h>
 #include <vector>
 #include <string>
+#include <algorithm>
 #include <QString>
 #include <QFile>
+#include <QDir>
+#include <QThread>
 
 #include "interpolation.h"
 #include "solarRadiation.h"
@@ -232,12 +235,16 @@ bool computeHumidityMap(const gis::Crit3DRasterGrid& myTemperatureMap,
 }
 
 
-bool interpolationProjectDtm(Crit3DProject* myProject, meteoVariable myVar,
-                             const Crit3DTime& myCrit3DTime, bool isLoadData)
+/*!
+ * \brief load and check the data of myVar and prepare the interpolator (quality control, detrending)
+ */
+bool preInterpolationProjectDtm(Crit3DProject* myProject, meteoVariable myVar,
+                                const Crit3DTime& myCrit3DTime, bool isLoadData, Crit3DInterpolator* myInterpolator)
 {
     myProject->interpolationSettings.setCurrentDate(myCrit3DTime.date);
     myProject->interpolationSettings.setCurrentHour(myCrit3DTime.getHour());
-    setInterpolationSettings(&(myProject->interpolationSettings));
+    myInterpolator->setSettings(myProject->interpolationSettings);
+    myInterpolator->setNrThreads(QThread::idealThreadCount());
 
     bool dataAvailable = true;
     if (myProject->meteoDataConsistency(myVar, myCrit3DTime, myCrit3DTime) == 0.0)
@@ -249,28 +256,27 @@ bool interpolationProjectDtm(Crit3DProject* myProject, meteoVariable myVar,
 
     if (! dataAvailable) return false;
 
-    gis::Crit3DRasterGrid* myMap;
-    myMap = myProject->meteoMaps->getMapFromVar(myVar);    
-
-    bool isSuccessful = false;
-
     // quality control
-    if (myProject->qualityParameters.checkData(myVar, hourly, myProject->meteoPoints, myProject->nrMeteoPoints, myCrit3DTime))
+    if (! myProject->qualityParameters.checkData(myVar, hourly, myProject->meteoPoints, myProject->nrMeteoPoints,
+                                                 myCrit3DTime, myInterpolator))
     {
-        if (preInterpolation(myVar))
-        {
-            if (interpolateGridDtm(myMap, myProject->dtm, myVar))
-                isSuccessful = true;
-            else
-                myProject->projectError = "Function interpolationProjectDtm: interpolateGridDtm";
-        }
-        else
-            myProject->projectError = "Function interpolationProjectDtm: preparing interpolation";
-    }
-    else
         myProject->projectError = "Function interpolationProjectDtm: passing data to interpolation";
+        return false;
+    }
 
-    if (! isSuccessful) return false;
+    if (! myInterpolator->preInterpolation(myVar))
+    {
+        myProject->projectError = "Function interpolationProjectDtm: preparing interpolation";
+        return false;
+    }
+
+    return true;
+}
+
+
+bool postInterpolationProjectDtm(Crit3DProject* myProject, meteoVariable myVar, const Crit3DTime& myCrit3DTime)
+{
+    gis::Crit3DRasterGrid* myMap = myProject->meteoMaps->getMapFromVar(myVar);
 
     Crit3DTime t = myCrit3DTime;
     myMap->timeString = t.toStdString();
@@ -284,6 +290,144 @@ bool interpolationProjectDtm(Crit3DProject* myProject, meteoVariable myVar,
     }
 }
 
+
+bool interpolationProjectDtm(Crit3DProject* myProject, meteoVariable myVar,
+                             const Crit3DTime& myCrit3DTime, bool isLoadData)
+{
+    Crit3DInterpolator* myInterpolator = getDefaultInterpolator();
+
+    if (! preInterpolationProjectDtm(myProject, myVar, myCrit3DTime, isLoadData, myInterpolator))
+        return false;
+
+    if (! myInterpolator->interpolateGridDtm(myProject->meteoMaps->getMapFromVar(myVar), myProject->dtm, myVar,
+                                             &(myProject->interpolationStencils[myVar])))
+    {
+        myProject->projectError = "Function interpolationProjectDtm: interpolateGridDtm";
+        return false;
+    }
+
+    return postInterpolationProjectDtm(myProject, myVar, myCrit3DTime);
+}
+
+
+/*!
+ * \brief interpolation of several variables in a single pass on the DTM
+ * (one interpolator for each variable, the cell geometry is shared);
+ * airHumidity is computed from temperature and dew point if required by the settings,
+ * windIntensity is set to the default value if not available
+ * \param isInterpolated [nrVars] result for each variable of myVars
+ */
+bool interpolationProjectDtmMultiple(Crit3DProject* myProject, const std::vector <meteoVariable>& myVars,
+                                     const Crit3DTime& myCrit3DTime, bool isLoadData, std::vector <bool>* isInterpolated)
+{
+    bool useDewPoint = myProject->interpolationSettings.getUseDewPoint();
+    unsigned int i, j;
+
+    // gridded variables
+    std::vector <meteoVariable> griddedVars;
+    for (i = 0; i < myVars.size(); i++)
+    {
+        std::vector <meteoVariable> currentVars;
+        if (myVars[i] == airHumidity && useDewPoint)
+            currentVars = {airTemperature, airDewTemperature};
+        else
+            currentVars = {myVars[i]};
+
+        for (j = 0; j < currentVars.size(); j++)
+            if (std::find(griddedVars.begin(), griddedVars.end(), currentVars[j]) == griddedVars.end())
+                griddedVars.push_back(currentVars[j]);
+    }
+
+    // prepare the interpolators
+    std::vector <Crit3DInterpolator> interpolators(griddedVars.size());
+    std::vector <bool> isPrepared(griddedVars.size());
+    std::vector <const Crit3DInterpolator*> preparedInterpolators;
+    std::vector <meteoVariable> preparedVars;
+    std::vector <gis::Crit3DRasterGrid*> preparedGrids;
+    std::vector <Crit3DInterpolationStencil*> preparedStencils;
+
+    for (i = 0; i < griddedVars.size(); i++)
+    {
+        isPrepared[i] = preInterpolationProjectDtm(myProject, griddedVars[i], myCrit3DTime, isLoadData, &(interpolators[i]));
+        if (isPrepared[i])
+        {
+            preparedInterpolators.push_back(&(interpolators[i]));
+            preparedVars.push_back(griddedVars[i]);
+            preparedGrids.push_back(myProject->meteoMaps->getMapFromVar(griddedVars[i]));
+            preparedStencils.push_back(&(myProject->interpolationStencils[griddedVars[i]]));
+        }
+    }
+
+    if (! preparedVars.empty())
+    {
+        if (! interpolateGridDtmMultiple(preparedInterpolators, preparedVars, preparedGrids, myProject->dtm,
+                                        QThread::idealThreadCount(), preparedStencils))
+        {
+            myProject->projectError = "Function interpolationProjectDtmMultiple: interpolateGridDtmMultiple";
+            return false;
+        }
+    }
+
+    for (i = 0; i < griddedVars.size(); i++)
+        if (isPrepared[i])
+            isPrepared[i] = postInterpolationProjectDtm(myProject, griddedVars[i], myCrit3DTime);
+
+    // results
+    isInterpolated->resize(myVars.size());
+    bool isAllInterpolated = true;
+    for (i = 0; i < myVars.size(); i++)
+    {
+        bool isOk;
+        if (myVars[i] == airHumidity && useDewPoint)
+        {
+            unsigned int indexT = unsigned(std::find(griddedVars.begin(), griddedVars.end(), airTemperature) - griddedVars.begin());
+            unsigned int indexTd = unsigned(std::find(griddedVars.begin(), griddedVars.end(), airDewTemperature) - griddedVars.begin());
+            isOk = isPrepared[indexT] && isPrepared[indexTd]
+                   && computeHumidityMap(*(myProject->meteoMaps->airTemperatureMap),
+                                         *(myProject->meteoMaps->airDewTemperatureMap),
+                                         myProject->meteoMaps->airHumidityMap);
+        }
+        else
+        {
+            unsigned int index = unsigned(std::find(griddedVars.begin(), griddedVars.end(), myVars[i]) - griddedVars.begin());
+            isOk = isPrepared[index];
+
+            if (! isOk && myVars[i] == windIntensity)
+            {
+                myProject->meteoMaps->windIntensityMap->setConstantValueWithBase(myProject->windIntensityDefault, myProject->dtm);
+                isOk = postInterpolation(windIntensity, myProject->meteoMaps->windIntensityMap);
+            }
+        }
+
+        (*isInterpolated)[i] = isOk;
+        if (! isOk) isAllInterpolated = false;
+    }
+
+    return isAllInterpolated;
+}
+
+
+/*!
+ * \brief remove the oldest files of the potential radiation cache above maxSize [MB]
+ */
+void limitPotentialRadiationCache(const QString& cachePath, int maxSize)
+{
+    QDir cacheDir(cachePath);
+    QFileInfoList fileList = cacheDir.entryInfoList(QStringList() << "potential_*.bin", QDir::Files, QDir::Time);
+
+    qint64 maxBytes = qint64(maxSize) * 1024 * 1024;
+    qint64 totalBytes = 0;
+
+    // sorted from the newest file
+    for (int i = 0; i < fileList.size(); i++)
+    {
+        totalBytes += fileList[i].size();
+        if (totalBytes > maxBytes)
+            QFile::remove(fileList[i].absoluteFilePath());
+    }
+}
+
+
 bool computeRadiationProjectDtm(Crit3DProject* myProject, const Crit3DTime& myCrit3DTime, bool isLoadData)
 {
     bool myResult = false;
@@ -291,6 +435,26 @@ bool computeRadiationProjectDtm(Crit3DProject* myProject, const Crit3DTime& myCr
     myProject->radiationSettings.setGisSettings(&(myProject->gisSettings));
     radiation::setRadiationSettings(&(myProject->radiationSettings));
 
+    /*! terrain shadowing: horizon map computed once for the DTM, then read from file */
+    if (myProject->radiationSettings.getComputeShadowing() && myProject->radiationSettings.getHorizonSectors() > 0)
+    {
+        QString horizonFileName = myProject->path + myProject->dtmFileName.left(myProject->dtmFileName.length()-4) + ".horizon";
+        std::string myError;
+        if (! radiation::loadHorizonMap(myProject->dtm, myProject->meteoMaps->radiationMaps, horizonFileName.toStdString(),
+                                        QThread::idealThreadCount(), &myError))
+            myProject->logInfo("Horizon map not available, shadows computed on the DTM: " + QString::fromStdString(myError));
+    }
+
+    /*! potential radiation saved for each day of year and time, if enabled in the radiation settings
+     *  (radiation maps are rebuilt with the DTM) */
+    QString cachePath = myProject->path + "radiationCache/";
+    int cacheSize = myProject->radiationSettings.getPotentialCacheSize();
+    if (cacheSize > 0 && myProject->meteoMaps->radiationMaps->potentialCachePath.empty())
+    {
+        if (QDir().mkpath(cachePath))
+            radiation::setPotentialRadiationCache(myProject->dtm, myProject->meteoMaps->radiationMaps, cachePath.toStdString());
+    }
+
     gis::Crit3DPoint myDtmCenter = myProject->dtm.mapCenter();
     int intervalWidth = radiation::estimateTransmissivityWindow(myProject->dtm, *(myProject->meteoMaps->radiationMaps), &myDtmCenter, myCrit3DTime, (int)(3600 / myProject->hourlyIntervals));
     int myTimeStep = getTimeStepFromHourlyInterval(myProject->hourlyIntervals);
@@ -310,7 +474,8 @@ bool computeRadiationProjectDtm(Crit3DProject* myProject, const Crit3DTime& myCr
     radAvailable = (myProject->meteoDataConsistency(globalIrradiance, myTimeIni, myTimeFin) > 0.5);
 
     if (radAvailable)
-        if(computeTransmissivity(myProject->meteoPoints, myProject->nrMeteoPoints, intervalWidth, myCrit3DTime, myProject->dtm) > 0)
+        if(computeTransmissivity(myProject->meteoPoints, myProject->nrMeteoPoints, intervalWidth, myCrit3DTime,
+                                 myProject->dtm, *(myProject->meteoMaps->radiationMaps)) > 0)
             transComputed = true;
 
     if (! transComputed)
@@ -359,11 +524,15 @@ bool computeRadiationProjectDtm(Crit3DProject* myProject, const Crit3DTime& myCr
             return false;
         }
 
-    if (radiation::computeRadiationGridPresentTime(myProject->dtm, myProject->meteoMaps->radiationMaps, myCrit3DTime))
+    if (radiation::computeRadiationGridPresentTime(myProject->dtm, myProject->meteoMaps->radiationMaps, myCrit3DTime,
+                                                   QThread::idealThreadCount()))
         myResult = setRadiationScale(myProject->meteoMaps->radiationMaps->globalRadiationMap->colorScale);
     else
         myProject->projectError = "Function computeRadiationProjectDtm: error computing irradiance";
 
+    if (cacheSize > 0 && ! myProject->meteoMaps->radiationMaps->potentialCachePath.empty())
+        limitPotentialRadiationCache(cachePath, cacheSize);
+
     return myResult;
 }
 
@@ -587,3 +756,35 @@ bool interpolateAndSaveHourlyMeteo(Crit3DProject* myProject, meteoVariable myVar
     else
         return true;
 }
+
+
+/*!
+ * \brief interpolate several variables in a single pass on the DTM and save the maps
+ */
+bool interpolateAndSaveHourlyMeteoMultiple(Crit3DProject* myProject, const std::vector <meteoVariable>& myVars,
+                                           const Crit3DTime& myCrit3DTime, const QString& myOutputPath,
+                                           bool isSave, const QString& myArea)
+{
+    std::vector <bool> isInterpolated;
+    bool isAllSaved = true;
+
+    interpolationProjectDtmMultiple(myProject, myVars, myCrit3DTime, false, &isInterpolated);
+
+    for (unsigned int i = 0; i < myVars.size(); i++)
+    {
+        if (i >= isInterpolated.size() || ! isInterpolated[i])
+        {
+            Crit3DTime t = myCrit3DTime;
+            QString myTimeStr = QString::fromStdString(t.toStdString());
+            myProject->logError("interpolateAndSave: interpolation of " + getVarNameFromMeteoVariable(myVars[i]) + " at time: " + myTimeStr);
+            isAllSaved = false;
+        }
+        else if (isSave)
+        {
+            if (! saveMeteoHourlyOutput(myProject, myVars[i], myOutputPath, myCrit3DTime, myArea))
+                isAllSaved = false;
+        }
+    }
+
+    return isAllSaved;
+}
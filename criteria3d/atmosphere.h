@@ -10,6 +10,9 @@
     #ifndef METEO_H
         #include "meteo.h"
     #endif
+    #ifndef VECTOR_H
+        #include <vector>
+    #endif
 
     class Crit3DProject;
 
@@ -18,6 +21,9 @@
 
     bool interpolationProjectDtm(Crit3DProject* myProject, meteoVariable myVar, const Crit3DTime& myTime, bool loadData);
 
+    bool interpolationProjectDtmMultiple(Crit3DProject* myProject, const std::vector <meteoVariable>& myVars,
+                                         const Crit3DTime& myTime, bool isLoadData, std::vector <bool>* isInterpolated);
+
     bool computeRadiationProjectDtm(Crit3DProject* myProject, const Crit3DTime& myTime, bool loadData);
 
     bool interpolationProjectDtmMain(Crit3DProject* myProject, meteoVariable myVar, const Crit3DTime& myTime, bool isLoadData);
@@ -30,6 +36,10 @@
                             const Crit3DTime& myCrit3DTime, const QString& myOutputPath,
                             bool isSave, const QString& myArea);
 
+    bool interpolateAndSaveHourlyMeteoMultiple(Crit3DProject* myProject, const std::vector <meteoVariable>& myVars,
+                                               const Crit3DTime& myCrit3DTime, const QString& myOutputPath,
+                                               bool isSave, const QString& myArea);
+
     bool aggregateAndSaveDailyMap(Crit3DProject* myProject, meteoVariable myVar,
                              aggregationType myAggregation, const Crit3DDate& myDate,
                              const QString& dailyPath, const QString& hourlyPath, const QString& myArea);
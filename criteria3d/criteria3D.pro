@@ -15,6 +15,7 @@ INCLUDEPATH += ../soilFluxes3D/header
 LIBS += -L../crit3dDate/debug -lcrit3dDate
 LIBS += -L../mathFunctions/debug -lmathFunctions
 LIBS += -L../soilFluxes3D/debug -lsoilFluxes3D
+!win32-msvc*: LIBS += -fopenmp
 LIBS += -L../gis/debug -lgis
 LIBS += -L../meteo/debug -lmeteo
 LIBS += -L../crop/debug -lcrop
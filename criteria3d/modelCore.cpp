@@ -2,6 +2,7 @@
 #include <math.h>
 #include <qstring.h>
 #include <QDate>
+#include <vector>
 
 #include "commonConstants.h"
 #include "project.h"
@@ -54,6 +55,8 @@ bool modelDailyCycle(bool isInitialState, Crit3DDate myDate, int nrHours,
     myFirstTime = Crit3DTime(myDate, myTimeStep);
     myLastTime = Crit3DTime(myDate, nrHours * 3600);
 
+    const std::vector <meteoVariable> hourlyMeteoVars = {airTemperature, precipitation, airHumidity, windIntensity};
+
     /*
     int checkStressHour;
     if (!myProject->gisSettings.isUTC)
@@ -69,10 +72,8 @@ bool modelDailyCycle(bool isInitialState, Crit3DDate myDate, int nrHours,
         // meteo interpolation
         myProject->logInfo("Interpolate meteo data");
         myProject->initializeMeteoMaps();
-        interpolateAndSaveHourlyMeteo(myProject, airTemperature, myCurrentTime, myOutputPath, isSave, myArea);
-        interpolateAndSaveHourlyMeteo(myProject, precipitation, myCurrentTime, myOutputPath, isSave, myArea);
-        interpolateAndSaveHourlyMeteo(myProject, airHumidity, myCurrentTime, myOutputPath, isSave, myArea);
-        interpolateAndSaveHourlyMeteo(myProject, windIntensity, myCurrentTime, myOutputPath, isSave, myArea);
+        // single pass on the DTM for the interpolated variables
+        interpolateAndSaveHourlyMeteoMultiple(myProject, hourlyMeteoVars, myCurrentTime, myOutputPath, isSave, myArea);
         interpolateAndSaveHourlyMeteo(myProject, globalIrradiance, myCurrentTime, myOutputPath, isSave, myArea);
         //ET0
         if (computeET0Map(myProject))
@@ -74,6 +74,7 @@ void Crit3DProject::deleteAllGrids()
     this->boundaryGrid.freeGrid();
     this->indexGrid.freeGrid();
     this->interpolatedDtm.freeGrid();
+    this->interpolationStencils.clear();
 
     delete this->meteoMaps;
 }
@@ -443,6 +444,7 @@ bool Crit3DProject::loadDTM(QString myFileName)
     }
     else
     {
+        interpolationStencils.clear();
         logInfo ("Read DTM " + myFileName);
         return (true);
     }
@@ -1241,7 +1243,9 @@ bool Crit3DProject::loadStates(QDate myDate, QString myArea)
     loadPlantState(this, degreeDaysFromFirstMarchVar, myDate, statePath, myArea);
     loadPlantState(this, degreeDaysAtFruitSetVar, myDate, statePath, myArea);
 
-    if (!loadWaterBalanceState(this, myDate, myArea, statePath, waterMatricPotential)) return false;
+    // matric potential maps: states without the soilFluxes3D snapshot or with a snapshot of a different domain
+    if (! loadSoilFluxesState(this, myDate, myArea, statePath))
+        if (!loadWaterBalanceState(this, myDate, myArea, statePath, waterMatricPotential)) return false;
 
     this->logInfo("Load state: " + myDate.toString("yyyy-MM-dd"));
     return(true);
@@ -1276,7 +1280,10 @@ bool Crit3DProject::saveStateAndOutput(QDate myDate, QString myArea)
     if (!savePlantState(this, degreeDaysAtFruitSetVar, myDate, statePath, myArea)) return(false);
     if (!savePlantState(this,fruitBiomassIndexVar,myDate,statePath, myArea)) return(false);
 
+    // matric potential maps: daily state also if the snapshot fails, or after a change of the soil map or DTM
     if (!saveWaterBalanceState(this, myDate, myArea, statePath, waterMatricPotential)) return (false);
+    // complete soilFluxes3D state (the error is logged, the matric potential maps are saved)
+    saveSoilFluxesState(this, myDate, myArea, statePath);
 
     QString notes = "";
     if (!savePlantOutput(this, wineYieldVar, myDate, outputPath, myArea, notes, false, true)) return(false);
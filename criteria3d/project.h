@@ -27,6 +27,9 @@
     #ifndef INTERPOLATIONSETTINGS_H
         #include "interpolationSettings.h"
     #endif
+    #ifndef INTERPOLATIONSTENCIL_H
+        #include "interpolationStencil.h"
+    #endif
     #ifndef QUALITY_H
         #include "quality.h"
     #endif
@@ -39,6 +42,9 @@
     #ifndef VECTOR_H
         #include <vector>
     #endif
+    #ifndef MAP_H
+        #include <map>
+    #endif
 
     enum Tenvironment {gui, batch};
 
@@ -118,6 +124,9 @@
         Crit3DInterpolationSettings interpolationSettings;
         Crit3DRadiationSettings radiationSettings;
 
+        /*! nearest stations of the DTM cells for each variable (reused while the stations do not change) */
+        std::map <meteoVariable, Crit3DInterpolationStencil> interpolationStencils;
+
         int hourlyIntervals;
         QDate lastDateTransmissivity;
 
@@ -6,6 +6,8 @@
 #include "soilFluxes3D.h"
 
 #include <vector>
+#include <QThread>
+#include <QFile>
 
 std::vector <double> waterSinkSource;     //[m^3/sec]
 
@@ -984,6 +986,44 @@ bool saveWaterBalanceState(Crit3DProject* myProject, QDate myDate, QString myAre
 }
 
 
+QString getSoilFluxesStateFileName(QDate myDate, QString myArea, QString statePath)
+{
+    return statePath + myDate.toString("yyyyMMdd") + "_" + myArea + "_soilFluxes3D.bin";
+}
+
+
+// complete soilFluxes3D state (water, heat, boundaries, balance) in a single binary snapshot
+bool saveSoilFluxesState(Crit3DProject* myProject, QDate myDate, QString myArea, QString statePath)
+{
+    QString fileName = getSoilFluxesStateFileName(myDate, myArea, statePath);
+
+    int result = soilFluxes3D::saveStateSnapshot(fileName.toStdString().c_str());
+    if (result != CRIT3D_OK)
+    {
+        myProject->logError("Error in saving soilFluxes3D state: " + fileName + " code: " + QString::number(result));
+        return false;
+    }
+
+    return true;
+}
+
+
+bool loadSoilFluxesState(Crit3DProject* myProject, QDate myDate, QString myArea, QString statePath)
+{
+    QString fileName = getSoilFluxesStateFileName(myDate, myArea, statePath);
+    if (! QFile::exists(fileName)) return false;
+
+    int result = soilFluxes3D::loadStateSnapshot(fileName.toStdString().c_str());
+    if (result != CRIT3D_OK)
+    {
+        myProject->logError("Error in loading soilFluxes3D state: " + fileName + " code: " + QString::number(result));
+        return false;
+    }
+
+    return true;
+}
+
+
 bool waterBalance(Crit3DProject* myProject)
 {
     double totalPrecipitation = 0.0, totalEvaporation = 0.0, totalTranspiration = 0.0;
@@ -1063,9 +1103,10 @@ bool initializeWaterBalance(Crit3DProject* myProject)
     if (! setCrit3DNodeSoil(myProject)) return(false);
 
 
-    //criteria3D::setNumericalParameters(6.0, 600.0, 200, 10, 12, 3);   // precision
-    soilFluxes3D::setNumericalParameters(30.0, 1800.0, 100, 10, 12, 2);  // speedy
-    //criteria3D::setNumericalParameters(300.0, 3600.0, 100, 10, 12, 1);   // very speedy (high error)
+    int nrThreads = QThread::idealThreadCount();
+    //criteria3D::setNumericalParameters(6.0, 600.0, 200, 10, 12, 3, nrThreads);   // precision
+    soilFluxes3D::setNumericalParameters(30.0, 1800.0, 100, 10, 12, 2, nrThreads);  // speedy
+    //criteria3D::setNumericalParameters(300.0, 3600.0, 100, 10, 12, 1, nrThreads);   // very speedy (high error)
     soilFluxes3D::setHydraulicProperties(MODIFIEDVANGENUCHTEN, MEAN_LOGARITHMIC, 10.0);
 
     myProject->logInfo("Waterbalance initialized");
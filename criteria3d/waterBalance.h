@@ -40,6 +40,9 @@
     bool loadWaterBalanceState(Crit3DProject* myProject, QDate myDate, QString myArea,
                                QString myStatePath, criteria3DVariable myVar);
 
+    bool saveSoilFluxesState(Crit3DProject* myProject, QDate myDate, QString myArea, QString statePath);
+    bool loadSoilFluxesState(Crit3DProject* myProject, QDate myDate, QString myArea, QString statePath);
+
     bool waterBalance(Crit3DProject* myProject);
 
     bool getCriteria3DVarMap(Crit3DProject* myProject, criteria3DVariable myVar, int layerIndex,
@@ -376,6 +376,31 @@ namespace gis
         return(true);
     }
 
+    /*!
+     * \brief checksum (FNV-1a) of header and values of a grid:
+     * identifies a DTM in the files computed from it
+     */
+    unsigned long long getRasterChecksum(const Crit3DRasterGrid& myGrid)
+    {
+        unsigned long long hash = 14695981039346656037ULL;
+        const unsigned long long prime = 1099511628211ULL;
+
+        double headerValues[6] = {double(myGrid.header->nrRows), double(myGrid.header->nrCols), myGrid.header->cellSize,
+                                  myGrid.header->llCorner->x, myGrid.header->llCorner->y, double(myGrid.header->flag)};
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(headerValues);
+        for (unsigned int i = 0; i < sizeof(headerValues); i++)
+            hash = (hash ^ bytes[i]) * prime;
+
+        for (int row = 0; row < myGrid.header->nrRows; row++)
+        {
+            bytes = reinterpret_cast<const unsigned char*>(myGrid.value[row]);
+            for (unsigned int i = 0; i < unsigned(myGrid.header->nrCols) * sizeof(float); i++)
+                hash = (hash ^ bytes[i]) * prime;
+        }
+
+        return hash;
+    }
+
     bool updateColorScale(Crit3DRasterGrid* myGrid, const Crit3DRasterWindow& myWindow)
     {
         return updateColorScale(myGrid, myWindow.v[0].row, myWindow.v[0].col, myWindow.v[1].row, myWindow.v[1].col);
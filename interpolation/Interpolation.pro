@@ -11,16 +11,27 @@ TARGET = Interpolation
 TEMPLATE = lib
 CONFIG += staticlib
 
+# parallel gridding
+win32-msvc*: QMAKE_CXXFLAGS += -openmp
+else: QMAKE_CXXFLAGS += -fopenmp
+
+# vectorized kernels (sqrt without errno)
+!win32-msvc*: QMAKE_CXXFLAGS += -fno-math-errno
+
 INCLUDEPATH += ../crit3dDate ../mathFunctions ../gis ../meteo
 
 SOURCES += interpolation.cpp \
     interpolationSettings.cpp \
     interpolationPoint.cpp \
+    spatialIndex.cpp \
+    interpolationStencil.cpp \
     kriging.cpp
 
 HEADERS += interpolation.h \
     interpolationSettings.h \
     interpolationPoint.h \
+    spatialIndex.h \
+    interpolationStencil.h \
     interpolationConstants.h \
     kriging.h
 
@@ -0,0 +1,26 @@
+#-------------------------------------------------
+#
+# CRITERIA3D
+# interpolation kernels microbenchmark
+#
+#-------------------------------------------------
+
+QT       -= gui
+
+TARGET = idwBenchmark
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+!win32-msvc*: QMAKE_CXXFLAGS += -fno-math-errno
+
+INCLUDEPATH += ../../crit3dDate ../../mathFunctions ../../gis ../../meteo ../../interpolation
+
+LIBS += -L../debug -linterpolation
+LIBS += -L../../meteo/debug -lmeteo
+LIBS += -L../../gis/debug -lgis
+LIBS += -L../../crit3dDate/debug -lcrit3dDate
+LIBS += -L../../mathFunctions/debug -lmathFunctions
+!win32-msvc*: LIBS += -fopenmp
+
+SOURCES += main.cpp
@@ -0,0 +1,122 @@
+/*!
+    \name idwBenchmark
+    \brief time per million cells of the inverse distance weighted and gauss kernels:
+    point list version and packed arrays version
+
+    usage: idwBenchmark [nrStations] [nrCells]
+
+    This file is part of CRITERIA3D.
+    CRITERIA3D has been developed under contract issued by A.R.P.A. Emilia-Romagna
+
+    CRITERIA3D is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CRITERIA3D is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with CRITERIA3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+
+#include "commonConstants.h"
+#include "interpolationPoint.h"
+#include "interpolation.h"
+
+using namespace std;
+
+#define AREA_SIZE 200000.f        // [m]
+
+
+static double secondsPerMillionCells(chrono::steady_clock::time_point t0, int nrCells)
+{
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - t0;
+    return elapsed.count() * 1.e6 / nrCells;
+}
+
+
+int main(int argc, char *argv[])
+{
+    int nrStations = (argc > 1) ? atoi(argv[1]) : 500;
+    int nrCells = (argc > 2) ? atoi(argv[2]) : 200000;
+    if (nrStations < 1 || nrCells < 1)
+    {
+        printf("usage: idwBenchmark [nrStations] [nrCells]\n");
+        return 1;
+    }
+
+    srand(1);
+    vector <Crit3DInterpolationDataPoint> points(nrStations);
+    for (int i = 0; i < nrStations; i++)
+    {
+        points[i].index = i;
+        points[i].isActive = true;
+        points[i].point->utm.x = double(AREA_SIZE * rand() / RAND_MAX);
+        points[i].point->utm.y = double(AREA_SIZE * rand() / RAND_MAX);
+        points[i].point->z = double(2000.f * rand() / RAND_MAX);
+        points[i].value = 10.f + 20.f * rand() / RAND_MAX;
+    }
+
+    TinterpolationArrays arrays;
+    arrays.build(points);
+
+    vector <float> cellX(nrCells), cellY(nrCells), cellZ(nrCells);
+    for (int i = 0; i < nrCells; i++)
+    {
+        cellX[i] = AREA_SIZE * rand() / RAND_MAX;
+        cellY[i] = AREA_SIZE * rand() / RAND_MAX;
+        cellZ[i] = 2000.f * rand() / RAND_MAX;
+    }
+
+    vector <float> resultList(nrCells), resultArrays(nrCells);
+    chrono::steady_clock::time_point t0;
+    double maxDifference;
+
+    printf("stations: %d  cells: %d\n", nrStations, nrCells);
+    printf("kernel    point list [s/Mcells]  packed arrays [s/Mcells]  max difference\n");
+
+    // inverse distance weighted
+    t0 = chrono::steady_clock::now();
+    for (int i = 0; i < nrCells; i++)
+        resultList[i] = inverseDistanceWeighted(points, cellX[i], cellY[i], NODATA);
+    double timeList = secondsPerMillionCells(t0, nrCells);
+
+    t0 = chrono::steady_clock::now();
+    for (int i = 0; i < nrCells; i++)
+        resultArrays[i] = inverseDistanceWeighted(arrays.x.data(), arrays.y.data(), arrays.value.data(), arrays.index.data(),
+                                                            arrays.size(), cellX[i], cellY[i], NODATA);
+    double timeArrays = secondsPerMillionCells(t0, nrCells);
+
+    maxDifference = 0;
+    for (int i = 0; i < nrCells; i++)
+        maxDifference = maxValue(maxDifference, double(fabs(resultList[i] - resultArrays[i])));
+    printf("idw       %21.3f  %24.3f  %14g\n", timeList, timeArrays, maxDifference);
+
+    // gauss
+    t0 = chrono::steady_clock::now();
+    for (int i = 0; i < nrCells; i++)
+        resultList[i] = gaussWeighted(points, cellX[i], cellY[i], cellZ[i], NODATA);
+    timeList = secondsPerMillionCells(t0, nrCells);
+
+    t0 = chrono::steady_clock::now();
+    for (int i = 0; i < nrCells; i++)
+        resultArrays[i] = gaussWeighted(arrays.x.data(), arrays.y.data(), arrays.z.data(), arrays.value.data(), arrays.index.data(),
+                                                  arrays.size(), cellX[i], cellY[i], cellZ[i], NODATA);
+    timeArrays = secondsPerMillionCells(t0, nrCells);
+
+    maxDifference = 0;
+    for (int i = 0; i < nrCells; i++)
+        maxDifference = maxValue(maxDifference, double(fabs(resultList[i] - resultArrays[i])));
+    printf("gauss     %21.3f  %24.3f  %14g\n", timeList, timeArrays, maxDifference);
+
+    return 0;
+}
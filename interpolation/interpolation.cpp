@@ -41,59 +41,68 @@
 using namespace std;
 using namespace statistics;
 
-vector <Crit3DInterpolationDataPoint> interpolationPointList;
-vector <Crit3DInterpolationDataPoint> precBinaryPointList;
-
-float lapseRateH1;
-float lapseRateH0;
-float inversionLapseRate;
-bool inversionIsSignificative;
-
-gis::Crit3DRasterGrid orogIndexMap;
-gis::Crit3DRasterGrid distSeaMap;
-gis::Crit3DRasterGrid genericProxyMap;
-gis::Crit3DRasterGrid urbanFractionMap;
-
-float actualLapseRate;
-float actualR2;
-float actualR2Levels;
-float urbanCoefficient;
-float urbanIntercept;
-float urbanR2;
-float orogIndexCoefficient;
-float orogIndexIntercept;
-float orogIndexR2;
-float seaDistCoefficient;
-float seaDistIntercept;
-float seaDistR2;
-float aspectCoefficient;
-float aspectIntercept;
-float aspectR2;
-float genericCoefficient;
-float genericIntercept;
-float genericR2;
-
-bool precipitationAllZero = false;
-int indexPointJacknife = NODATA;
-
-Crit3DInterpolationSettings currentSettings;
+Crit3DInterpolator::Crit3DInterpolator()
+{
+    initializeOrography();
 
-void setInterpolationSettings(Crit3DInterpolationSettings* mySettings)
+    urbanCoefficient = NODATA;
+    urbanIntercept = NODATA;
+    urbanR2 = NODATA;
+    orogIndexCoefficient = NODATA;
+    orogIndexIntercept = NODATA;
+    orogIndexR2 = NODATA;
+    seaDistCoefficient = NODATA;
+    seaDistIntercept = NODATA;
+    seaDistR2 = NODATA;
+    aspectCoefficient = NODATA;
+    aspectIntercept = NODATA;
+    aspectR2 = NODATA;
+    genericCoefficient = NODATA;
+    genericIntercept = NODATA;
+    genericR2 = NODATA;
+
+    precipitationAllZero = false;
+    nrThreads = 1;
+}
+
+void Crit3DInterpolator::setSettings(const Crit3DInterpolationSettings& mySettings)
 {
-    currentSettings = *(mySettings);
+    currentSettings = mySettings;
 }
 
-void setindexPointJacknife(int index)
+const Crit3DInterpolationSettings& Crit3DInterpolator::getSettings() const
 {
-    indexPointJacknife = index;
+    return currentSettings;
 }
 
-void clearInterpolationPoints()
+void Crit3DInterpolator::setNrThreads(int myNrThreads)
+{
+    nrThreads = maxValue(myNrThreads, 1);
+}
+
+int Crit3DInterpolator::getNrThreads() const
+{
+    return nrThreads;
+}
+
+void Crit3DInterpolator::clearPoints()
 {
     interpolationPointList.clear();
+    precBinaryPointList.clear();
+    interpolationPointIndex.clear();
+    precBinaryPointIndex.clear();
+    interpolationPointArrays.clear();
+    precBinaryPointArrays.clear();
+    kriging.clear();
+    precipitationAllZero = false;
 }
 
-bool addInterpolationPoint(int myIndex, float myValue, float myX, float myY, float myHeight, float myOrogIndex, float myUrban, float mySeaDist, float myAspect, float myGenericProxy)
+int Crit3DInterpolator::getNrPoints() const
+{
+    return int(interpolationPointList.size());
+}
+
+bool Crit3DInterpolator::addPoint(int myIndex, float myValue, float myX, float myY, float myHeight, float myOrogIndex, float myUrban, float mySeaDist, float myAspect, float myGenericProxy)
 {
     Crit3DInterpolationDataPoint myPoint;
 
@@ -110,12 +119,15 @@ bool addInterpolationPoint(int myIndex, float myValue, float myX, float myY, flo
     myPoint.setGenericProxy(myGenericProxy);
 
     interpolationPointList.push_back(myPoint);
+    interpolationPointIndex.clear();
+    interpolationPointArrays.clear();
+    kriging.clear();
 
     return (true);
 }
 
 
-void printInterpolationData()
+void Crit3DInterpolator::printData() const
 {
     for (unsigned long i = 0; i < interpolationPointList.size() ; i++)
     {
@@ -133,7 +145,7 @@ void assignDistances(vector <Crit3DInterpolationDataPoint> *myPoints, float x, f
     }
 }
 
-bool initializeOrography()
+bool Crit3DInterpolator::initializeOrography()
 {
     lapseRateH0 = 0.;
     lapseRateH1 = NODATA;
@@ -150,7 +162,7 @@ bool initializeOrography()
 }
 
 
-float getMinHeight()
+float Crit3DInterpolator::getMinHeight()
 {
     float myZmin = NODATA;
 
@@ -161,7 +173,7 @@ float getMinHeight()
     return myZmin;
 }
 
-float getMaxHeight()
+float Crit3DInterpolator::getMaxHeight()
 {
     float zMax;
     zMax = NODATA;
@@ -175,12 +187,13 @@ float getMaxHeight()
     return zMax;
 }
 
-int sortPointsByDistance(int maxIndex, vector <Crit3DInterpolationDataPoint> myPoints, vector <Crit3DInterpolationDataPoint>* myValidPoints)
+int Crit3DInterpolator::sortPointsByDistance(int maxIndex, const vector <Crit3DInterpolationDataPoint> &myPoints, vector <Crit3DInterpolationDataPoint>* myValidPoints) const
 {   
     int i, first, index;
     float min_value;
     int* indici_ordinati;
     int* indice_minimo;
+    bool* isCandidate;
     int outIndex;
 
     if (myPoints.size() == 0) return 0;
@@ -188,6 +201,11 @@ int sortPointsByDistance(int maxIndex, vector <Crit3DInterpolationDataPoint> myP
     indici_ordinati = (int *) calloc(maxIndex + 1, sizeof(int));
     indice_minimo = (int *) calloc(myPoints.size(), sizeof(int));
 
+    // selected points are marked here: the point list is not copied
+    isCandidate = (bool *) calloc(myPoints.size(), sizeof(bool));
+    for (i = 0; i < int(myPoints.size()); i++)
+        isCandidate[i] = myPoints.at(i).isActive;
+
     first = 0;
     index = 0;
 
@@ -198,10 +216,10 @@ int sortPointsByDistance(int maxIndex, vector <Crit3DInterpolationDataPoint> myP
         if (first == 0)
         {
             i = 0;
-            while ((! myPoints.at(i).isActive || (myPoints.at(i).distance == 0 && currentSettings.isCrossValidation)) && (i < int(myPoints.size())-1))
+            while ((! isCandidate[i] || (myPoints.at(i).distance == 0 && currentSettings.isCrossValidation)) && (i < int(myPoints.size())-1))
                 i++;
 
-            if (i == int(myPoints.size())-1 && ! myPoints.at(i).isActive)
+            if (i == int(myPoints.size())-1 && ! isCandidate[i])
                 exit=true;
             else
             {
@@ -217,7 +235,7 @@ int sortPointsByDistance(int maxIndex, vector <Crit3DInterpolationDataPoint> myP
         {
             for (i = indice_minimo[first-1] + 1; i < int(myPoints.size()); i++)
                 if (myPoints.at(i).distance < min_value)
-                    if (myPoints.at(i).isActive)
+                    if (isCandidate[i])
                         if (myPoints.at(i).distance > 0 || ! currentSettings.isCrossValidation)
                         {
                             first++;
@@ -226,7 +244,7 @@ int sortPointsByDistance(int maxIndex, vector <Crit3DInterpolationDataPoint> myP
                         }
 
             indici_ordinati[index] = indice_minimo[first-1];
-            myPoints.at(indice_minimo[first-1]).isActive = false;
+            isCandidate[indice_minimo[first-1]] = false;
             index++;
             first--;
         }
@@ -236,17 +254,18 @@ int sortPointsByDistance(int maxIndex, vector <Crit3DInterpolationDataPoint> myP
     (*myValidPoints).resize(outIndex+1);
 
     for (i=0; i<outIndex+1; i++)
-    {
-        myPoints.at(indici_ordinati[i]).isActive = true;
         (*myValidPoints).at(i) = myPoints.at(indici_ordinati[i]);
-    }
+
+    free(indici_ordinati);
+    free(indice_minimo);
+    free(isCandidate);
 
     return outIndex+1;
 }
 
 
-bool neighbourhoodVariability(float x, float y, float z, int nMax,
-                              float* devSt, float* devStDeltaZ, float* minDistance)
+bool Crit3DInterpolator::neighbourhoodVariability(float x, float y, float z, int nMax,
+                              float* devSt, float* devStDeltaZ, float* minDistance) const
 {
     int i, max_points;
     float* dataNeighborhood;
@@ -254,8 +273,24 @@ bool neighbourhoodVariability(float x, float y, float z, int nMax,
     vector <float> deltaZ;
     vector <Crit3DInterpolationDataPoint> validPoints;
 
-    assignDistances(&interpolationPointList, x, y, z);
-    max_points = sortPointsByDistance(nMax, interpolationPointList, &validPoints);
+    if (interpolationPointIndex.isBuilt(interpolationPointList))
+    {
+        vector <TneighbourPoint> neighbours;
+        max_points = interpolationPointIndex.searchNearest(x, y, nMax + 1, interpolationPointList, true,
+                                                           currentSettings.isCrossValidation, NODATA, &neighbours);
+        validPoints.resize(unsigned(max_points));
+        for (i = 0; i < max_points; i++)
+        {
+            validPoints[unsigned(i)] = interpolationPointList[unsigned(neighbours[unsigned(i)].position)];
+            validPoints[unsigned(i)].distance = neighbours[unsigned(i)].distance;
+        }
+    }
+    else
+    {
+        vector <Crit3DInterpolationDataPoint> myPoints = interpolationPointList;
+        assignDistances(&myPoints, x, y, z);
+        max_points = sortPointsByDistance(nMax, myPoints, &validPoints);
+    }
 
     if (max_points > 1)
     {
@@ -287,7 +322,7 @@ bool neighbourhoodVariability(float x, float y, float z, int nMax,
         return false;
 }
 
-void regressionSimple(proxyVars::TProxyVar myProxy, bool isZeroIntercept, float* myCoeff, float* myIntercept, float* myR2)
+void Crit3DInterpolator::regressionSimple(proxyVars::TProxyVar myProxy, bool isZeroIntercept, float* myCoeff, float* myIntercept, float* myR2)
 {
     long i;
     float myProxyValue;
@@ -333,7 +368,7 @@ void regressionSimple(proxyVars::TProxyVar myProxy, bool isZeroIntercept, float*
                                      myIntercept, myCoeff, myR2);
 }
 
-bool regressionGeneric(proxyVars::TProxyVar myProxy, bool isZeroIntercept)
+bool Crit3DInterpolator::regressionGeneric(proxyVars::TProxyVar myProxy, bool isZeroIntercept)
 {
     float q, m, r2;
 
@@ -387,7 +422,7 @@ bool regressionGeneric(proxyVars::TProxyVar myProxy, bool isZeroIntercept)
 }
 
 
-bool regressionSimpleT(meteoVariable myVar)
+bool Crit3DInterpolator::regressionSimpleT(meteoVariable myVar)
 {
     float q, m, r2;
 
@@ -418,7 +453,7 @@ bool regressionSimpleT(meteoVariable myVar)
 }
 
 
-float findHeightIntervalAvgValue(float heightInf, float heightSup, float maxPointsZ)
+float Crit3DInterpolator::findHeightIntervalAvgValue(float heightInf, float heightSup, float maxPointsZ)
 {
     long myIndex;
     float myValue, mySum, nValues;
@@ -444,7 +479,7 @@ float findHeightIntervalAvgValue(float heightInf, float heightSup, float maxPoin
         return NODATA;
 }
 
-bool regressionOrographyT(meteoVariable myVar, bool climateExists)
+bool Crit3DInterpolator::regressionOrographyT(meteoVariable myVar, bool climateExists)
 {
     long i;
     float heightInf, heightSup;
@@ -803,7 +838,7 @@ bool regressionOrographyT(meteoVariable myVar, bool climateExists)
 }
 
 
-bool regressionOrography(meteoVariable myVar)
+bool Crit3DInterpolator::regressionOrography(meteoVariable myVar)
 {
     initializeOrography();
 
@@ -825,18 +860,25 @@ bool regressionOrography(meteoVariable myVar)
 }
 
 
-float inverseDistanceWeighted(vector <Crit3DInterpolationDataPoint> myPointList)
+/*!
+ * \brief inverse distance weighted of the points from (x, y);
+ * the distances are computed on the fly, so that the point list is not modified
+ * and concurrent calls are allowed
+ */
+float inverseDistanceWeighted(const vector <Crit3DInterpolationDataPoint> &myPointList, float x, float y, int indexPointJacknife)
 {
     double sum, sumWeights, weight;
+    float distance;
 
     sum = 0 ;
     sumWeights = 0 ;
     for (int i = 0 ; i < (int)(myPointList.size()); i++)
     {
-        Crit3DInterpolationDataPoint* myPoint = &(myPointList.at(i));
-        if (myPoint->distance > 0.)
+        const Crit3DInterpolationDataPoint* myPoint = &(myPointList.at(i));
+        distance = gis::computeDistance(x, y, float(myPoint->point->utm.x), float(myPoint->point->utm.y));
+        if (distance > 0.)
         {
-            weight = myPoint->distance / 10000. ;
+            weight = distance / 10000. ;
             weight = fabs(1 / (weight * weight * weight));
             sumWeights += weight;
             sum += myPoint->value * weight;
@@ -851,7 +893,7 @@ float inverseDistanceWeighted(vector <Crit3DInterpolationDataPoint> myPointList)
         return NODATA;
 }
 
-float gaussWeighted(vector <Crit3DInterpolationDataPoint> myPointList)
+float gaussWeighted(const vector <Crit3DInterpolationDataPoint> &myPointList, float x, float y, float z, int indexPointJacknife)
 {
     double sum, sumWeights, weight;
     double distance, deltaZ;
@@ -862,10 +904,11 @@ float gaussWeighted(vector <Crit3DInterpolationDataPoint> myPointList)
     sumWeights = 0 ;
     for (int i = 0 ; i < (int)(myPointList.size()); i++)
     {
-        Crit3DInterpolationDataPoint* myPoint = &(myPointList.at(i));
-        distance = myPoint->distance / 1000.;
-        deltaZ = myPoint->deltaZ / 1000.;
-        if (myPoint->distance > 0.)
+        const Crit3DInterpolationDataPoint* myPoint = &(myPointList.at(i));
+        float pointDistance = gis::computeDistance(x, y, float(myPoint->point->utm.x), float(myPoint->point->utm.y));
+        distance = pointDistance / 1000.;
+        deltaZ = float(fabs(myPoint->point->z - z)) / 1000.;
+        if (pointDistance > 0.)
         {
             weight = 1 - exp(-(distance*distance)/(Rd*Rd)) * exp(-(deltaZ*deltaZ)/(Rz*Rz));
             weight = fabs(1 / (weight * weight * weight));
@@ -882,7 +925,199 @@ float gaussWeighted(vector <Crit3DInterpolationDataPoint> myPointList)
         return NODATA;
 }
 
-bool checkPrecipitationZero(int* nrPrecNotNull, bool* flatPrecipitation)
+/*!
+ * \brief inverse distance weighted on the nearest points (settings: maxNeighbours),
+ * on all the points if the number of neighbours is not limited or the index is not built
+ */
+float Crit3DInterpolator::inverseDistanceWeightedNearest(const vector <Crit3DInterpolationDataPoint> &myPointList,
+                                                         const Crit3DSpatialIndex &myIndex, const TinterpolationArrays &myArrays,
+                                                         float x, float y, int indexPointJacknife) const
+{
+    int maxNeighbours = currentSettings.getMaxNeighbours();
+    if (maxNeighbours <= 0 || ! myIndex.isBuilt(myPointList))
+    {
+        if (myArrays.size() == int(myPointList.size()))
+            return inverseDistanceWeighted(myArrays.x.data(), myArrays.y.data(), myArrays.value.data(),
+                                           myArrays.index.data(), myArrays.size(), x, y, indexPointJacknife);
+        else
+            return inverseDistanceWeighted(myPointList, x, y, indexPointJacknife);
+    }
+
+    vector <TneighbourPoint> neighbours;
+    int nrNeighbours = myIndex.searchNearest(x, y, maxNeighbours, myPointList, false, false, indexPointJacknife, &neighbours);
+
+    double sum = 0;
+    double sumWeights = 0;
+    for (int i = 0; i < nrNeighbours; i++)
+    {
+        float myValue = myPointList[unsigned(neighbours[unsigned(i)].position)].value;
+        if (neighbours[unsigned(i)].distance == 0)
+            return myValue;
+
+        double weight = neighbours[unsigned(i)].distance / 10000.;
+        weight = fabs(1 / (weight * weight * weight));
+        sumWeights += weight;
+        sum += myValue * weight;
+    }
+
+    if (sumWeights > 0.0)
+        return float(sum / sumWeights);
+    else
+        return NODATA;
+}
+
+/*!
+ * \brief inverse distance weighted on packed arrays (same result of the point list version):
+ * the weights of a block of points are computed in a branch-free vectorized pass,
+ * then summed in the order of the points (no reordering of the float sums);
+ * the points at zero distance are checked only if there are any
+ */
+float inverseDistanceWeighted(const float* x, const float* y, const float* value, const int* index,
+                              int nrPoints, float myX, float myY, int indexPointJacknife)
+{
+    double weights[INTERPOLATION_SIMD_BLOCK];
+    double sum = 0;
+    double sumWeights = 0;
+    int nrZeroDistance = 0;
+
+    for (int first = 0; first < nrPoints; first += INTERPOLATION_SIMD_BLOCK)
+    {
+        int nrBlockPoints = minValue(INTERPOLATION_SIMD_BLOCK, nrPoints - first);
+
+        // integer reduction: exact in any order
+        #pragma omp simd reduction(+:nrZeroDistance)
+        for (int j = 0; j < nrBlockPoints; j++)
+        {
+            float dx = x[first + j] - myX;
+            float dy = y[first + j] - myY;
+            float distance = sqrtf(dx * dx + dy * dy);
+
+            // weight = 0 at zero distance, without branches
+            int isNotZero = (distance > 0);
+            double weight = (distance + (1 - isNotZero)) / 10000.;
+            weights[j] = isNotZero / (weight * weight * weight);
+            nrZeroDistance += 1 - isNotZero;
+        }
+
+        for (int j = 0; j < nrBlockPoints; j++)
+        {
+            sumWeights += weights[j];
+            sum += value[first + j] * weights[j];
+        }
+    }
+
+    if (nrZeroDistance > 0)
+    {
+        for (int i = 0; i < nrPoints; i++)
+            if (x[i] == myX && y[i] == myY && index[i] != indexPointJacknife)
+                return value[i];
+    }
+
+    if (sumWeights > 0.0)
+        return float(sum / sumWeights);
+    else
+        return NODATA;
+}
+
+float gaussWeighted(const float* x, const float* y, const float* z, const float* value, const int* index,
+                    int nrPoints, float myX, float myY, float myZ, int indexPointJacknife)
+{
+    const double Rd=10;
+    const double Rz=1;
+    double weights[INTERPOLATION_SIMD_BLOCK];
+    double sum = 0;
+    double sumWeights = 0;
+    int nrZeroDistance = 0;
+
+    for (int first = 0; first < nrPoints; first += INTERPOLATION_SIMD_BLOCK)
+    {
+        int nrBlockPoints = minValue(INTERPOLATION_SIMD_BLOCK, nrPoints - first);
+
+        // integer reduction: exact in any order
+        #pragma omp simd reduction(+:nrZeroDistance)
+        for (int j = 0; j < nrBlockPoints; j++)
+        {
+            float dx = x[first + j] - myX;
+            float dy = y[first + j] - myY;
+            float pointDistance = sqrtf(dx * dx + dy * dy);
+            double distance = pointDistance / 1000.;
+            double deltaZ = fabsf(z[first + j] - myZ) / 1000.;
+
+            int isNotZero = (pointDistance > 0);
+            double weight = 1 - exp(-(distance*distance)/(Rd*Rd)) * exp(-(deltaZ*deltaZ)/(Rz*Rz));
+            weights[j] = isNotZero / fabs(weight * weight * weight + (1 - isNotZero));
+            nrZeroDistance += 1 - isNotZero;
+        }
+
+        for (int j = 0; j < nrBlockPoints; j++)
+        {
+            sumWeights += weights[j];
+            sum += value[first + j] * weights[j];
+        }
+    }
+
+    if (nrZeroDistance > 0)
+    {
+        for (int i = 0; i < nrPoints; i++)
+            if (x[i] == myX && y[i] == myY && index[i] != indexPointJacknife)
+                return value[i];
+    }
+
+    if (sumWeights > 0.0)
+        return float(sum / sumWeights);
+    else
+        return NODATA;
+}
+
+/*!
+ * \brief ordinary kriging of the current points (residuals after detrending):
+ * with all the points the variogram matrix is factorized here, once per time step;
+ * with a limited number of neighbours (maxNeighbours) the systems are solved for each cell
+ * \return false if the matrix is singular (i.e. coincident stations)
+ */
+bool Crit3DInterpolator::initializeKriging()
+{
+    kriging.setVariogram(short(currentSettings.getKrigingMode()), double(currentSettings.getKrigingRange()),
+                         double(currentSettings.getKrigingNugget()), double(currentSettings.getKrigingSill()),
+                         double(currentSettings.getKrigingSlope()));
+
+    if (currentSettings.getMaxNeighbours() > 0)
+    {
+        kriging.clear();
+        return true;
+    }
+
+    return kriging.initialize(interpolationPointArrays.x.data(), interpolationPointArrays.y.data(),
+                              interpolationPointArrays.value.data(), interpolationPointArrays.size());
+}
+
+/*!
+ * \brief kriging estimate in (x, y): local on the nearest points if the number of neighbours
+ * is limited or a point is excluded (cross-validation), global otherwise
+ */
+float Crit3DInterpolator::krigingEstimate(float myX, float myY, int indexPointJacknife) const
+{
+    int maxNeighbours = currentSettings.getMaxNeighbours();
+
+    if ((maxNeighbours > 0 || indexPointJacknife != NODATA)
+        && interpolationPointIndex.isBuilt(interpolationPointList)
+        && interpolationPointArrays.size() == int(interpolationPointList.size()))
+    {
+        vector <TneighbourPoint> neighbours;
+        int nrNeighbours = interpolationPointIndex.searchNearest(myX, myY, maxNeighbours, interpolationPointList,
+                                                                 false, false, indexPointJacknife, &neighbours);
+        vector <int> positions(neighbours.size());
+        for (int i = 0; i < nrNeighbours; i++)
+            positions[i] = neighbours[i].position;
+
+        return kriging.estimateLocal(interpolationPointArrays.x.data(), interpolationPointArrays.y.data(),
+                                     interpolationPointArrays.value.data(), positions.data(), nrNeighbours, myX, myY);
+    }
+
+    return kriging.estimate(myX, myY);
+}
+
+bool Crit3DInterpolator::checkPrecipitationZero(int* nrPrecNotNull, bool* flatPrecipitation)
 {
     *flatPrecipitation = true;
     *nrPrecNotNull = 0;
@@ -903,7 +1138,7 @@ bool checkPrecipitationZero(int* nrPrecNotNull, bool* flatPrecipitation)
     return (nrPrecNotNull == 0);
 }
 
-void prepareJRC()
+void Crit3DInterpolator::prepareJRC()
 {
     vector <Crit3DInterpolationDataPoint> precPoints;
 
@@ -929,38 +1164,33 @@ void prepareJRC()
     interpolationPointList = precPoints;
 }
 
-float interpolatePrecStep1()
-{
-    return inverseDistanceWeighted(precBinaryPointList);
-}
-
-float interpolatePrecStep2()
+float Crit3DInterpolator::interpolatePrecStep2(float myX, float myY, int indexPointJacknife) const
 {
     if (currentSettings.getInterpolationMethod() == geostatisticsMethods::idw)
-        return inverseDistanceWeighted(interpolationPointList);
-        //return gaussWeighted(interpolationPointList);
+        return inverseDistanceWeightedNearest(interpolationPointList, interpolationPointIndex, interpolationPointArrays, myX, myY, indexPointJacknife);
+        //return gaussWeighted(interpolationPointList, myX, myY, myZ, indexPointJacknife);
     else if (currentSettings.getInterpolationMethod() == geostatisticsMethods::kriging)
-        return NODATA;
+        return krigingEstimate(myX, myY, indexPointJacknife);
     else
         return NODATA;
 }
 
-float interpolatePrec()
+float Crit3DInterpolator::interpolatePrec(float myX, float myY, int indexPointJacknife) const
 {
     float myResult;
 
     if (! currentSettings.getUseJRC())
-        myResult = interpolatePrecStep2();
+        myResult = interpolatePrecStep2(myX, myY, indexPointJacknife);
     else
-        if (interpolatePrecStep1() >= PREC_BINARY_THRESHOLD)
-            myResult = interpolatePrecStep2();
+        if (inverseDistanceWeightedNearest(precBinaryPointList, precBinaryPointIndex, precBinaryPointArrays, myX, myY, indexPointJacknife) >= PREC_BINARY_THRESHOLD)
+            myResult = interpolatePrecStep2(myX, myY, indexPointJacknife);
         else
             myResult = 0.;
 
     return ((myResult < 0 && myResult != NODATA) ? 0 : myResult);
 }
 
-bool getDetrendActive(int myPosition)
+bool Crit3DInterpolator::getDetrendActive(int myPosition) const
 {
     if (myPosition >= 0 && myPosition <= PROXY_VAR_NR)
     {
@@ -984,7 +1214,7 @@ bool getDetrendActive(int myPosition)
 
 }
 
-proxyVars::TProxyVar getDetrendType(int myPosition)
+proxyVars::TProxyVar Crit3DInterpolator::getDetrendType(int myPosition) const
 {
     if (myPosition >= 0 && myPosition <= PROXY_VAR_NR)
         return (currentSettings.getDetrendList(myPosition));
@@ -992,7 +1222,7 @@ proxyVars::TProxyVar getDetrendType(int myPosition)
         return (proxyVars::noProxy);
 }
 
-void detrend(meteoVariable myVar, proxyVars::TProxyVar myProxy)
+void Crit3DInterpolator::detrend(meteoVariable myVar, proxyVars::TProxyVar myProxy)
 {
     float detrendValue;
     long myIndex;
@@ -1052,7 +1282,7 @@ void detrend(meteoVariable myVar, proxyVars::TProxyVar myProxy)
     }
 }
 
-float retrend(meteoVariable myVar, float myZ, float myOrogIndex, float mySeaDist, float myUrban, float myAspect)
+float Crit3DInterpolator::retrend(meteoVariable myVar, float myZ, float myOrogIndex, float mySeaDist, float myUrban, float myAspect) const
 {
 
     float retrendZ = 0.;
@@ -1097,7 +1327,7 @@ float retrend(meteoVariable myVar, float myZ, float myOrogIndex, float mySeaDist
     return (retrendZ + retrendIPL + retrendDistSea + retrendUrban + retrendAspect);
 }
 
-bool preInterpolation(meteoVariable myVar)
+bool Crit3DInterpolator::preInterpolation(meteoVariable myVar)
 {
     if (myVar == precipitation || myVar == dailyPrecipitation)
     {
@@ -1158,21 +1388,49 @@ bool preInterpolation(meteoVariable myVar)
         }
     }
 
+    buildSpatialIndex();
+
+    if (currentSettings.getInterpolationMethod() == geostatisticsMethods::kriging)
+        return initializeKriging();
+
     return (true);
 }
 
 
-float interpolateSimple(meteoVariable myVar, float myZ, float myOrogIndex, float myDistSea, float myUrban, float myAspect)
+/*!
+ * \brief neighbour search and packed arrays of the current points (built by preInterpolation);
+ * it has to be called again after the points are modified
+ */
+void Crit3DInterpolator::buildSpatialIndex()
+{
+    interpolationPointIndex.build(interpolationPointList);
+    interpolationPointArrays.build(interpolationPointList);
+
+    if (precBinaryPointList.empty())
+    {
+        precBinaryPointIndex.clear();
+        precBinaryPointArrays.clear();
+    }
+    else
+    {
+        precBinaryPointIndex.build(precBinaryPointList);
+        precBinaryPointArrays.build(precBinaryPointList);
+    }
+}
+
+
+float Crit3DInterpolator::interpolateSimple(meteoVariable myVar, float myX, float myY, float myZ, float myOrogIndex,
+                                            float myDistSea, float myUrban, float myAspect, int indexPointJacknife) const
 {
     float myResult = NODATA;
 
     /*! interpolate residuals */
     if (currentSettings.getInterpolationMethod() == geostatisticsMethods::idw)
     {
-        myResult = inverseDistanceWeighted(interpolationPointList);
+        myResult = inverseDistanceWeightedNearest(interpolationPointList, interpolationPointIndex, interpolationPointArrays, myX, myY, indexPointJacknife);
     }
     else if (currentSettings.getInterpolationMethod() == geostatisticsMethods::kriging)
-        myResult = NODATA;
+        myResult = krigingEstimate(myX, myY, indexPointJacknife);
 
     if (myResult != NODATA)
         return (myResult + retrend(myVar, myZ, myOrogIndex, myDistSea, myUrban, myAspect));
@@ -1181,48 +1439,189 @@ float interpolateSimple(meteoVariable myVar, float myZ, float myOrogIndex, float
 }
 
 
-float interpolate(meteoVariable myVar, float myX, float myY, float myZ, float myOrogIndex, float myUrban, float mySeaDist, float myAspect)
+/*!
+ * \brief interpolated value in (x, y, z) after preInterpolation
+ * \param indexPointJacknife index of the point excluded (cross-validation), NODATA otherwise
+ */
+float Crit3DInterpolator::interpolate(meteoVariable myVar, float myX, float myY, float myZ, float myOrogIndex,
+                                      float myUrban, float mySeaDist, float myAspect, int indexPointJacknife) const
 {
     if ((myVar == precipitation || myVar == dailyPrecipitation) && precipitationAllZero) return 0.;
 
     float myResult = NODATA;
 
-    if (currentSettings.getInterpolationMethod() == geostatisticsMethods::idw)
-    {
-        if ((myVar == precipitation || myVar == dailyPrecipitation) && currentSettings.getUseJRC())
-            assignDistances(&precBinaryPointList, myX, myY, myZ);
-
-        assignDistances(&interpolationPointList, myX, myY, myZ);
-    }
-
     if (myVar == precipitation || myVar == dailyPrecipitation)
     {
-        myResult = interpolatePrec();
+        myResult = interpolatePrec(myX, myY, indexPointJacknife);
         if (myResult != NODATA)
             if (!currentSettings.getUseJRC() && myResult <= PREC_THRESHOLD) myResult = 0.;
     }
     else
-        myResult = interpolateSimple(myVar, myZ, myOrogIndex, mySeaDist, myUrban, myAspect);
+        myResult = interpolateSimple(myVar, myX, myY, myZ, myOrogIndex, mySeaDist, myUrban, myAspect, indexPointJacknife);
 
     return myResult;
 
 }
 
-bool interpolateGridDtm(gis::Crit3DRasterGrid* myGrid, const gis::Crit3DRasterGrid& myDTM, meteoVariable myVar)
+/*!
+ * \brief leave-one-out cross-validation of all the points in a single call:
+ * the points are detrended once (on a copy: call it on the points as added, before preInterpolation),
+ * then each point is interpolated without itself. The regressions are not fitted again
+ * without the point (as in the jacknife of the quality control).
+ * Kriging on all the points does not solve a system for each point (closed form).
+ * \param pointIndex [nrPoints] index of the points
+ * \param residuals [nrPoints] interpolated - observed value (NODATA if not available)
+ * \param rmse, mae root mean square and mean absolute residual (NODATA if there are no valid residuals)
+ * \return false if there are no points or the preInterpolation fails
+ */
+bool Crit3DInterpolator::crossValidation(meteoVariable myVar, vector <int>* pointIndex, vector <float>* residuals,
+                                         float* rmse, float* mae) const
+{
+    int i;
+    int nrPoints = int(interpolationPointList.size());
+    bool isPrecipitation = (myVar == precipitation || myVar == dailyPrecipitation);
+
+    *rmse = NODATA;
+    *mae = NODATA;
+    pointIndex->resize(nrPoints);
+    residuals->assign(nrPoints, NODATA);
+    if (nrPoints == 0) return false;
+
+    Crit3DInterpolator detrended = *this;
+    if (! detrended.preInterpolation(myVar)) return false;
+
+    // kriging on all the points: same point order after detrending
+    vector <float> krigingEstimates;
+    bool isKrigingClosedForm = (! isPrecipitation && detrended.kriging.isReady()
+                                && detrended.interpolationPointArrays.size() == nrPoints
+                                && detrended.kriging.leaveOneOut(detrended.interpolationPointArrays.value.data(), &krigingEstimates));
+
+    #pragma omp parallel for schedule(dynamic) num_threads(nrThreads)
+    for (int pos = 0; pos < nrPoints; pos++)
+    {
+        const Crit3DInterpolationDataPoint* myPoint = &(interpolationPointList[pos]);
+        float myValue = myPoint->value;
+        float interpolatedValue;
+
+        if (isKrigingClosedForm)
+        {
+            interpolatedValue = krigingEstimates[pos];
+            if (interpolatedValue != NODATA)
+                interpolatedValue += detrended.retrend(myVar, float(myPoint->point->z), myPoint->getOrogIndex(), myPoint->getSeaDistance(),
+                                                       myPoint->getUrbanFraction(), myPoint->getAspect());
+        }
+        else
+            interpolatedValue = detrended.interpolate(myVar, float(myPoint->point->utm.x), float(myPoint->point->utm.y),
+                                                      float(myPoint->point->z), myPoint->getOrogIndex(), myPoint->getUrbanFraction(),
+                                                      myPoint->getSeaDistance(), myPoint->getAspect(), myPoint->index);
+
+        if (isPrecipitation)
+        {
+            if (myValue != NODATA)
+                if (myValue < PREC_THRESHOLD) myValue=0.;
+
+            if (interpolatedValue != NODATA)
+                if (interpolatedValue < PREC_THRESHOLD) interpolatedValue=0.;
+        }
+
+        (*pointIndex)[pos] = myPoint->index;
+        if ((interpolatedValue != NODATA) && (myValue != NODATA))
+            (*residuals)[pos] = interpolatedValue - myValue;
+    }
+
+    int nrValid = 0;
+    double sumSquare = 0;
+    double sumAbs = 0;
+    for (i = 0; i < nrPoints; i++)
+        if ((*residuals)[i] != NODATA)
+        {
+            nrValid++;
+            sumSquare += double((*residuals)[i]) * (*residuals)[i];
+            sumAbs += fabs((*residuals)[i]);
+        }
+
+    if (nrValid > 0)
+    {
+        *rmse = float(sqrt(sumSquare / nrValid));
+        *mae = float(sumAbs / nrValid);
+    }
+
+    return true;
+}
+
+/*!
+ * \brief the stencil is used only for the inverse distance weighted on the nearest stations
+ * (precipitation has its own two steps interpolation)
+ */
+bool Crit3DInterpolator::isStencilUsed(meteoVariable myVar) const
+{
+    return (currentSettings.getInterpolationMethod() == geostatisticsMethods::idw
+            && currentSettings.getMaxNeighbours() > 0
+            && myVar != precipitation && myVar != dailyPrecipitation);
+}
+
+/*!
+ * \brief the stencil is built again only if the stations (or the grid) are changed
+ * \return false if the stencil cannot be used
+ */
+bool Crit3DInterpolator::prepareStencil(Crit3DInterpolationStencil* myStencil, const gis::Crit3DRasterGrid &myDTM, meteoVariable myVar) const
+{
+    if (! isStencilUsed(myVar) || interpolationPointArrays.size() != int(interpolationPointList.size()))
+        return false;
+
+    if (myStencil->isValid(interpolationPointList, myDTM, currentSettings.getMaxNeighbours()))
+        return true;
+
+    return myStencil->build(interpolationPointList, interpolationPointIndex, myDTM, currentSettings.getMaxNeighbours(), nrThreads);
+}
+
+/*!
+ * \brief same result of interpolate on the cell, with the neighbours of the stencil
+ */
+float Crit3DInterpolator::interpolateStencil(const Crit3DInterpolationStencil& myStencil, meteoVariable myVar,
+                                             int myRow, int myCol, float myZ) const
+{
+    float myResult = myStencil.inverseDistanceWeighted(myRow, myCol, interpolationPointArrays.value.data());
+
+    if (myResult != NODATA)
+        return (myResult + retrend(myVar, myZ, NODATA, NODATA, NODATA, NODATA));
+    else
+        return NODATA;
+}
+
+/*!
+ * \brief interpolation on the cells of the DTM;
+ * the cells are independent: blocks of rows are computed in parallel (nrThreads)
+ * and the result does not depend on the number of threads
+ */
+bool Crit3DInterpolator::interpolateGridDtm(gis::Crit3DRasterGrid* myGrid, const gis::Crit3DRasterGrid& myDTM, meteoVariable myVar,
+                                            Crit3DInterpolationStencil* myStencil) const
 {
     if (! myGrid->initializeGrid(myDTM))
         return (false);
 
-    float myX, myY;
+    bool useStencil = (myStencil != nullptr && prepareStencil(myStencil, myDTM, myVar));
+    int nrRows = myGrid->header->nrRows;
+
+    #pragma omp parallel for schedule(dynamic, INTERPOLATION_ROW_BLOCK) num_threads(nrThreads)
+    for (int myRow = 0; myRow < nrRows; myRow++)
+    {
+        float myX, myY;
 
-    for (long myRow = 0; myRow < myGrid->header->nrRows ; myRow++)
-        for (long myCol = 0; myCol < myGrid->header->nrCols; myCol++)
+        for (int myCol = 0; myCol < myGrid->header->nrCols; myCol++)
         {
-            gis::getUtmXYFromRowColSinglePrecision(*myGrid, myRow, myCol, &myX, &myY);
             float myZ = myDTM.value[myRow][myCol];
-            if (myZ != myGrid->header->flag)
+            if (myZ == myGrid->header->flag) continue;
+
+            if (useStencil)
+                myGrid->value[myRow][myCol] = interpolateStencil(*myStencil, myVar, myRow, myCol, myZ);
+            else
+            {
+                gis::getUtmXYFromRowColSinglePrecision(*myGrid, myRow, myCol, &myX, &myY);
                 myGrid->value[myRow][myCol] = interpolate(myVar, myX, myY, myZ, NODATA, NODATA, NODATA, NODATA);
+            }
         }
+    }
 
     if (! gis::updateMinMaxRasterGrid(myGrid))
         return (false);
@@ -1231,10 +1630,128 @@ bool interpolateGridDtm(gis::Crit3DRasterGrid* myGrid, const gis::Crit3DRasterGr
 }
 
 
+/*!
+ * \brief interpolation of several variables on the cells of the DTM in a single pass:
+ * the cell geometry (coordinates, height) is computed once for all the variables
+ * \param interpolators prepared interpolators (preInterpolation), one for each variable
+ * \param myGrids output grids, one for each variable
+ * \param myStencils [optional] stencils of the variables (nullptr: not used), kept by the caller between the calls
+ */
+bool interpolateGridDtmMultiple(const std::vector <const Crit3DInterpolator*> &interpolators,
+                                const std::vector <meteoVariable> &myVars,
+                                const std::vector <gis::Crit3DRasterGrid*> &myGrids,
+                                const gis::Crit3DRasterGrid& myDTM, int nrThreads,
+                                const std::vector <Crit3DInterpolationStencil*> &myStencils)
+{
+    int nrVars = int(myVars.size());
+    if (int(interpolators.size()) != nrVars || int(myGrids.size()) != nrVars)
+        return false;
+    if (! myStencils.empty() && int(myStencils.size()) != nrVars)
+        return false;
+
+    std::vector <Crit3DInterpolationStencil*> usedStencils(unsigned(nrVars), nullptr);
+    for (int i = 0; i < nrVars; i++)
+    {
+        if (! myGrids[i]->initializeGrid(myDTM))
+            return false;
+
+        if (! myStencils.empty() && myStencils[i] != nullptr)
+            if (interpolators[i]->prepareStencil(myStencils[i], myDTM, myVars[i]))
+                usedStencils[i] = myStencils[i];
+    }
+
+    int nrRows = myDTM.header->nrRows;
+
+    #pragma omp parallel for schedule(dynamic, INTERPOLATION_ROW_BLOCK) num_threads(maxValue(nrThreads, 1))
+    for (int myRow = 0; myRow < nrRows; myRow++)
+    {
+        float myX, myY;
+
+        for (int myCol = 0; myCol < myDTM.header->nrCols; myCol++)
+        {
+            float myZ = myDTM.value[myRow][myCol];
+            if (myZ == myDTM.header->flag) continue;
+
+            gis::getUtmXYFromRowColSinglePrecision(myDTM, myRow, myCol, &myX, &myY);
+            for (int i = 0; i < nrVars; i++)
+            {
+                if (usedStencils[i] != nullptr)
+                    myGrids[i]->value[myRow][myCol] = interpolators[i]->interpolateStencil(*usedStencils[i], myVars[i],
+                                                                                           myRow, myCol, myZ);
+                else
+                    myGrids[i]->value[myRow][myCol] = interpolators[i]->interpolate(myVars[i], myX, myY, myZ,
+                                                                                    NODATA, NODATA, NODATA, NODATA);
+            }
+        }
+    }
+
+    for (int i = 0; i < nrVars; i++)
+        if (! gis::updateMinMaxRasterGrid(myGrids[i]))
+            return false;
+
+    return true;
+}
+
+
+Crit3DInterpolator* getDefaultInterpolator()
+{
+    static Crit3DInterpolator defaultInterpolator;
+    return &defaultInterpolator;
+}
+
+static int indexPointJacknife = NODATA;
+
+void setInterpolationSettings(Crit3DInterpolationSettings* mySettings)
+{
+    getDefaultInterpolator()->setSettings(*mySettings);
+}
+
+void setindexPointJacknife(int index)
+{
+    indexPointJacknife = index;
+}
+
+void clearInterpolationPoints()
+{
+    getDefaultInterpolator()->clearPoints();
+}
+
+bool addInterpolationPoint(int myIndex, float myValue, float myX, float myY, float myHeight, float myOrogIndex, float myUrban, float mySeaDist, float myAspect, float myGenericProxy)
+{
+    return getDefaultInterpolator()->addPoint(myIndex, myValue, myX, myY, myHeight, myOrogIndex, myUrban, mySeaDist, myAspect, myGenericProxy);
+}
+
+void printInterpolationData()
+{
+    getDefaultInterpolator()->printData();
+}
+
+bool preInterpolation(meteoVariable myVar)
+{
+    return getDefaultInterpolator()->preInterpolation(myVar);
+}
+
+bool neighbourhoodVariability(float x, float y, float z, int nMax,
+                              float* devSt, float* devStDeltaZ, float* minDistance)
+{
+    return getDefaultInterpolator()->neighbourhoodVariability(x, y, z, nMax, devSt, devStDeltaZ, minDistance);
+}
+
+float interpolate(meteoVariable myVar, float myX, float myY, float myZ, float myOrogIndex, float myUrban, float mySeaDist, float myAspect)
+{
+    return getDefaultInterpolator()->interpolate(myVar, myX, myY, myZ, myOrogIndex, myUrban, mySeaDist, myAspect, indexPointJacknife);
+}
+
+bool interpolateGridDtm(gis::Crit3DRasterGrid* myGrid, const gis::Crit3DRasterGrid& myDTM, meteoVariable myVar)
+{
+    return getDefaultInterpolator()->interpolateGridDtm(myGrid, myDTM, myVar);
+}
+
+
 bool checkInterpolationRaster(const  gis::Crit3DRasterGrid& myDTM, std::string *myError)
 {
     // check data presence
-    if (interpolationPointList.size() == 0)
+    if (getDefaultInterpolator()->getNrPoints() == 0)
     {
         *myError = "No data to interpolate";
         return false;
@@ -26,6 +26,9 @@
 #ifndef INTERPOLATION_H
 #define INTERPOLATION_H
 
+    #ifndef COMMONCONSTANTS_H
+        #include "commonConstants.h"
+    #endif
     #ifndef METEO_H
         #include "meteoPoint.h"
     #endif
@@ -35,22 +38,144 @@
     #ifndef INTERPOLATIONPOINT_H
         #include "interpolationPoint.h"
     #endif
+    #ifndef SPATIALINDEX_H
+        #include "spatialIndex.h"
+    #endif
+    #ifndef KRIGING_H
+        #include "kriging.h"
+    #endif
+    #ifndef INTERPOLATIONSTENCIL_H
+        #include "interpolationStencil.h"
+    #endif
+    #ifndef VECTOR_H
+        #include <vector>
+    #endif
 
     #define MIN_REGRESSION_POINTS 3
 
     class Crit3DMeteoPoint;
 
-    enum TkrigingMode {KRIGING_SPHERICAL = 1,
-                       KRIGING_EXPONENTIAL=2,
-                       KRIGING_GAUSSIAN=3,
-                       KRIGING_LINEAR=4
-                      };
+    /*! interpolation engine: stations, settings and the regressions of the detrending.
+     *  After preInterpolation the object is read-only: interpolate and interpolateGridDtm
+     *  can be called concurrently on the same object, and independent objects
+     *  (gridding, cross-validation, quality control) can be prepared in parallel */
+    class Crit3DInterpolator
+    {
+    private:
+        std::vector <Crit3DInterpolationDataPoint> interpolationPointList;
+        std::vector <Crit3DInterpolationDataPoint> precBinaryPointList;
+        Crit3DSpatialIndex interpolationPointIndex;
+        Crit3DSpatialIndex precBinaryPointIndex;
+        TinterpolationArrays interpolationPointArrays;
+        TinterpolationArrays precBinaryPointArrays;
+        Crit3DKriging kriging;
+
+        Crit3DInterpolationSettings currentSettings;
+
+        float lapseRateH1;
+        float lapseRateH0;
+        float inversionLapseRate;
+        bool inversionIsSignificative;
+
+        float actualLapseRate;
+        float actualR2;
+        float actualR2Levels;
+        float urbanCoefficient;
+        float urbanIntercept;
+        float urbanR2;
+        float orogIndexCoefficient;
+        float orogIndexIntercept;
+        float orogIndexR2;
+        float seaDistCoefficient;
+        float seaDistIntercept;
+        float seaDistR2;
+        float aspectCoefficient;
+        float aspectIntercept;
+        float aspectR2;
+        float genericCoefficient;
+        float genericIntercept;
+        float genericR2;
+
+        bool precipitationAllZero;
+        int nrThreads;
+
+        bool initializeOrography();
+        float getMinHeight();
+        float getMaxHeight();
+        int sortPointsByDistance(int maxIndex, const std::vector <Crit3DInterpolationDataPoint> &myPoints,
+                                 std::vector <Crit3DInterpolationDataPoint>* myValidPoints) const;
+        void regressionSimple(proxyVars::TProxyVar myProxy, bool isZeroIntercept, float* myCoeff, float* myIntercept, float* myR2);
+        bool regressionGeneric(proxyVars::TProxyVar myProxy, bool isZeroIntercept);
+        bool regressionSimpleT(meteoVariable myVar);
+        float findHeightIntervalAvgValue(float heightInf, float heightSup, float maxPointsZ);
+        bool regressionOrographyT(meteoVariable myVar, bool climateExists);
+        bool regressionOrography(meteoVariable myVar);
+        bool checkPrecipitationZero(int* nrPrecNotNull, bool* flatPrecipitation);
+        void prepareJRC();
+        bool getDetrendActive(int myPosition) const;
+        proxyVars::TProxyVar getDetrendType(int myPosition) const;
+        void detrend(meteoVariable myVar, proxyVars::TProxyVar myProxy);
+        float retrend(meteoVariable myVar, float myZ, float myOrogIndex, float mySeaDist, float myUrban, float myAspect) const;
+        float inverseDistanceWeightedNearest(const std::vector <Crit3DInterpolationDataPoint> &myPointList,
+                                             const Crit3DSpatialIndex &myIndex, const TinterpolationArrays &myArrays,
+                                             float myX, float myY,
+                                             int indexPointJacknife) const;
+        bool initializeKriging();
+        float krigingEstimate(float myX, float myY, int indexPointJacknife) const;
+        float interpolatePrecStep2(float myX, float myY, int indexPointJacknife) const;
+        float interpolatePrec(float myX, float myY, int indexPointJacknife) const;
+        float interpolateSimple(meteoVariable myVar, float myX, float myY, float myZ, float myOrogIndex,
+                                float myDistSea, float myUrban, float myAspect, int indexPointJacknife) const;
+
+    public:
+        Crit3DInterpolator();
+
+        void setSettings(const Crit3DInterpolationSettings &mySettings);
+        const Crit3DInterpolationSettings& getSettings() const;
+        void setNrThreads(int myNrThreads);
+        int getNrThreads() const;
+
+        void clearPoints();
+        bool addPoint(int index, float myValue, float myX, float myY, float myHeight, float myOrogIndex,
+                      float myUrban, float mySeaDist, float myAspect, float myGenericProxy);
+        int getNrPoints() const;
+
+        bool preInterpolation(meteoVariable myVar);
+        void buildSpatialIndex();
+
+        bool neighbourhoodVariability(float x, float y, float z, int nMax,
+                                      float* devSt, float* devStDeltaZ, float* minDistance) const;
+
+        float interpolate(meteoVariable myVar, float myX, float myY, float myZ, float myOrogIndex,
+                          float myUrban, float mySeaDist, float myAspect, int indexPointJacknife = NODATA) const;
+        bool crossValidation(meteoVariable myVar, std::vector <int>* pointIndex, std::vector <float>* residuals,
+                             float* rmse, float* mae) const;
+        bool isStencilUsed(meteoVariable myVar) const;
+        bool prepareStencil(Crit3DInterpolationStencil* myStencil, const gis::Crit3DRasterGrid &myGridDtm, meteoVariable myVar) const;
+        float interpolateStencil(const Crit3DInterpolationStencil& myStencil, meteoVariable myVar,
+                                 int myRow, int myCol, float myZ) const;
+        bool interpolateGridDtm(gis::Crit3DRasterGrid* myGrid, const gis::Crit3DRasterGrid &myGridDtm, meteoVariable myVar,
+                                Crit3DInterpolationStencil* myStencil = nullptr) const;
+
+        void printData() const;
+    };
+
+    /*! the functions below work on a default interpolator shared by the whole program
+     *  (not thread-safe) */
+    Crit3DInterpolator* getDefaultInterpolator();
 
     void setInterpolationSettings(Crit3DInterpolationSettings *mySettings);
     void setindexPointJacknife(int index);
 
     bool preInterpolation(meteoVariable myVar);
 
+    float inverseDistanceWeighted(const std::vector <Crit3DInterpolationDataPoint> &myPointList, float x, float y, int indexPointJacknife);
+    float inverseDistanceWeighted(const float* x, const float* y, const float* value, const int* index,
+                                  int nrPoints, float myX, float myY, int indexPointJacknife);
+    float gaussWeighted(const std::vector <Crit3DInterpolationDataPoint> &myPointList, float x, float y, float z, int indexPointJacknife);
+    float gaussWeighted(const float* x, const float* y, const float* z, const float* value, const int* index,
+                        int nrPoints, float myX, float myY, float myZ, int indexPointJacknife);
+
     bool krigingEstimateVariogram(float *myDist, float *mySemiVar,int sizeMyVar, int nrMyPoints,float myMaxDistance, double *mySill, double *myNugget, double *myRange, double *mySlope, TkrigingMode *myMode, int nrPointData);
     bool krigLinearPrep(double *mySlope, double *myNugget, int nrPointData);
 
@@ -63,6 +188,11 @@
 
     float interpolate(meteoVariable myVar, float myX, float myY, float myZ, float myOrogIndex, float myUrban, float mySeaDist, float myAspect);
     bool interpolateGridDtm(gis::Crit3DRasterGrid* myGrid, const gis::Crit3DRasterGrid &myGridDtm, meteoVariable myVar);
+    bool interpolateGridDtmMultiple(const std::vector <const Crit3DInterpolator*> &interpolators,
+                                    const std::vector <meteoVariable> &myVars,
+                                    const std::vector <gis::Crit3DRasterGrid*> &myGrids,
+                                    const gis::Crit3DRasterGrid& myDTM, int nrThreads,
+                                    const std::vector <Crit3DInterpolationStencil*> &myStencils = std::vector <Crit3DInterpolationStencil*>());
 
     void printInterpolationData();
 
@@ -6,6 +6,12 @@
         enum { idw, kriging, shepard };
     }
 
+    enum TkrigingMode {KRIGING_SPHERICAL = 1,
+                       KRIGING_EXPONENTIAL=2,
+                       KRIGING_GAUSSIAN=3,
+                       KRIGING_LINEAR=4
+                      };
+
     namespace proxyVars
     {
         enum TProxyVar { height, urbanFraction, orogIndex, seaDistance, aspect, generic, noProxy };
@@ -16,4 +22,10 @@
     #define PREC_BINARY_THRESHOLD 0.5
     #define PREC_THRESHOLD 0.2
 
+    // rows of the grid assigned to a thread at a time (parallel gridding)
+    #define INTERPOLATION_ROW_BLOCK 8
+
+    // points of the packed kernels weighted in a vectorized pass, then summed in order
+    #define INTERPOLATION_SIMD_BLOCK 64
+
 #endif // INTERPOLATIONCONSTS_H
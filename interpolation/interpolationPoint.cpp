@@ -59,17 +59,52 @@ void Crit3DInterpolationDataPoint::setAspect(float myValue)
 void Crit3DInterpolationDataPoint::setGenericProxy(float myValue)
 { genericProxyValue = myValue;}
 
-float Crit3DInterpolationDataPoint::getOrogIndex()
+float Crit3DInterpolationDataPoint::getOrogIndex() const
 { return orogIndex;}
 
-float Crit3DInterpolationDataPoint::getUrbanFraction()
+float Crit3DInterpolationDataPoint::getUrbanFraction() const
 { return urbanFraction;}
 
-float Crit3DInterpolationDataPoint::getSeaDistance()
+float Crit3DInterpolationDataPoint::getSeaDistance() const
 { return seaDistance;}
 
-float Crit3DInterpolationDataPoint::getAspect()
+float Crit3DInterpolationDataPoint::getAspect() const
 { return aspect;}
 
-float Crit3DInterpolationDataPoint::getGenericProxy()
+float Crit3DInterpolationDataPoint::getGenericProxy() const
 { return genericProxyValue;}
+
+
+void TinterpolationArrays::clear()
+{
+    x.clear();
+    y.clear();
+    z.clear();
+    value.clear();
+    index.clear();
+}
+
+void TinterpolationArrays::build(const std::vector <Crit3DInterpolationDataPoint> &myPoints)
+{
+    unsigned long n = myPoints.size();
+
+    x.resize(n);
+    y.resize(n);
+    z.resize(n);
+    value.resize(n);
+    index.resize(n);
+
+    for (unsigned long i = 0; i < n; i++)
+    {
+        x[i] = float(myPoints[i].point->utm.x);
+        y[i] = float(myPoints[i].point->utm.y);
+        z[i] = float(myPoints[i].point->z);
+        value[i] = myPoints[i].value;
+        index[i] = myPoints[i].index;
+    }
+}
+
+int TinterpolationArrays::size() const
+{
+    return int(value.size());
+}
@@ -4,6 +4,9 @@
     #ifndef GIS_H
         #include "gis.h"
     #endif
+    #ifndef VECTOR_H
+        #include <vector>
+    #endif
 
     class Crit3DInterpolationDataPoint {
     private:
@@ -27,13 +30,27 @@
         void setAspect(float myValue);
         void setGenericProxy(float myValue);
 
-        float getOrogIndex();
-        float getUrbanFraction();
-        float getSeaDistance();
-        float getAspect();
-        float getGenericProxy();
+        float getOrogIndex() const;
+        float getUrbanFraction() const;
+        float getSeaDistance() const;
+        float getAspect() const;
+        float getGenericProxy() const;
 
         Crit3DInterpolationDataPoint();
     };
 
+    /*! contiguous copy (structure of arrays) of a point list, used by the vectorized kernels:
+     *  it has to be built again when the points are modified */
+    struct TinterpolationArrays {
+        std::vector <float> x;
+        std::vector <float> y;
+        std::vector <float> z;
+        std::vector <float> value;
+        std::vector <int> index;
+
+        void clear();
+        void build(const std::vector <Crit3DInterpolationDataPoint> &myPoints);
+        int size() const;
+    };
+
 #endif // INTERPOLATIONPOINT_H
@@ -46,6 +46,12 @@ Crit3DInterpolationSettings::Crit3DInterpolationSettings()
     isRetrendActive = true;
     genericPearsonThreshold = float(PEARSONSTANDARDTHRESHOLD);
     maxHeightInversion = 1000.;
+    maxNeighbours = 0;
+    krigingMode = KRIGING_LINEAR;
+    krigingRange = NODATA;
+    krigingNugget = 0;
+    krigingSill = NODATA;
+    krigingSlope = 1;
     detrendList[0] = proxyVars::height;
     detrendList[1] = proxyVars::urbanFraction;
     detrendList[2] = proxyVars::orogIndex;
@@ -83,16 +89,16 @@ void Crit3DInterpolationSettings::setCurrentHour(int myHour)
 void Crit3DInterpolationSettings::setCurrentHourFraction(int myHourFraction)
 { currentHourFraction = myHourFraction;}
 
-float Crit3DInterpolationSettings::getGenericPearsonThreshold()
+float Crit3DInterpolationSettings::getGenericPearsonThreshold() const
 { return genericPearsonThreshold;}
 
-int Crit3DInterpolationSettings::getInterpolationMethod()
+int Crit3DInterpolationSettings::getInterpolationMethod() const
 { return interpolationMethod;}
 
-bool Crit3DInterpolationSettings::getUseTad()
+bool Crit3DInterpolationSettings::getUseTad() const
 { return useTAD;}
 
-float Crit3DInterpolationSettings::getMaxHeightInversion()
+float Crit3DInterpolationSettings::getMaxHeightInversion() const
 { return maxHeightInversion;}
 
 void Crit3DInterpolationSettings::setInterpolationMethod(bool myValue)
@@ -131,34 +137,64 @@ void Crit3DInterpolationSettings::setUseDewPoint(bool myValue)
 void Crit3DInterpolationSettings::setIsCrossValidation(bool myValue)
 { isCrossValidation = myValue;}
 
-bool Crit3DInterpolationSettings::getUseHeight()
+void Crit3DInterpolationSettings::setMaxNeighbours(int myValue)
+{ maxNeighbours = maxValue(myValue, 0);}
+
+void Crit3DInterpolationSettings::setKrigingVariogram(TkrigingMode myMode, float myRange, float myNugget, float mySill, float mySlope)
+{
+    krigingMode = myMode;
+    krigingRange = myRange;
+    krigingNugget = myNugget;
+    krigingSill = mySill;
+    krigingSlope = mySlope;
+}
+
+bool Crit3DInterpolationSettings::getUseHeight() const
 { return (useHeight);}
 
-bool Crit3DInterpolationSettings::getUseThermalInversion()
+bool Crit3DInterpolationSettings::getUseThermalInversion() const
 { return (useThermalInversion);}
 
-bool Crit3DInterpolationSettings::getUseOrogIndex()
+bool Crit3DInterpolationSettings::getUseOrogIndex() const
 { return (useOrogIndex);}
 
-bool Crit3DInterpolationSettings::getUseSeaDistance()
+bool Crit3DInterpolationSettings::getUseSeaDistance() const
 { return (useSeaDistance);}
 
-bool Crit3DInterpolationSettings::getUseUrbanFraction()
+bool Crit3DInterpolationSettings::getUseUrbanFraction() const
 { return (useUrbanFraction);}
 
-bool Crit3DInterpolationSettings::getUseAspect()
+bool Crit3DInterpolationSettings::getUseAspect() const
 { return (useAspect);}
 
-bool Crit3DInterpolationSettings::getUseGenericProxy()
+bool Crit3DInterpolationSettings::getUseGenericProxy() const
 { return (useGenericProxy);}
 
-bool Crit3DInterpolationSettings::getUseJRC()
+bool Crit3DInterpolationSettings::getUseJRC() const
 { return (useJRC);}
 
-bool Crit3DInterpolationSettings::getUseDewPoint()
+bool Crit3DInterpolationSettings::getUseDewPoint() const
 { return (useDewPoint);}
 
-bool Crit3DInterpolationSettings::getIsCrossValidation()
+int Crit3DInterpolationSettings::getMaxNeighbours() const
+{ return maxNeighbours;}
+
+TkrigingMode Crit3DInterpolationSettings::getKrigingMode() const
+{ return krigingMode;}
+
+float Crit3DInterpolationSettings::getKrigingRange() const
+{ return krigingRange;}
+
+float Crit3DInterpolationSettings::getKrigingNugget() const
+{ return krigingNugget;}
+
+float Crit3DInterpolationSettings::getKrigingSill() const
+{ return krigingSill;}
+
+float Crit3DInterpolationSettings::getKrigingSlope() const
+{ return krigingSlope;}
+
+bool Crit3DInterpolationSettings::getIsCrossValidation() const
 { return (isCrossValidation);}
 
 void Crit3DInterpolationSettings::setDetrendOrographyActive(bool myValue)
@@ -179,25 +215,25 @@ void Crit3DInterpolationSettings::setDetrendAspectActive(bool myValue)
 void Crit3DInterpolationSettings::setDetrendGenericProxyActive(bool myValue)
 { detrendGenericProxyActive = myValue;}
 
-bool Crit3DInterpolationSettings::getDetrendOrographyActive()
+bool Crit3DInterpolationSettings::getDetrendOrographyActive() const
 { return detrendOrographyActive;}
 
-bool Crit3DInterpolationSettings::getDetrendUrbanActive()
+bool Crit3DInterpolationSettings::getDetrendUrbanActive() const
 { return detrendUrbanActive;}
 
-bool Crit3DInterpolationSettings::getDetrendOrogIndexActive()
+bool Crit3DInterpolationSettings::getDetrendOrogIndexActive() const
 { return detrendOrogIndexActive;}
 
-bool Crit3DInterpolationSettings::getDetrendSeaDistanceActive()
+bool Crit3DInterpolationSettings::getDetrendSeaDistanceActive() const
 { return detrendSeaDistanceActive;}
 
-bool Crit3DInterpolationSettings::getDetrendAspectActive()
+bool Crit3DInterpolationSettings::getDetrendAspectActive() const
 { return detrendAspectActive;}
 
-bool Crit3DInterpolationSettings::getDetrendGenericProxyActive()
+bool Crit3DInterpolationSettings::getDetrendGenericProxyActive() const
 { return detrendGenericProxyActive;}
 
-proxyVars::TProxyVar Crit3DInterpolationSettings::getDetrendList(int myPosition)
+proxyVars::TProxyVar Crit3DInterpolationSettings::getDetrendList(int myPosition) const
 {
     return detrendList[myPosition];
 }
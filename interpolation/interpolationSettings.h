@@ -35,6 +35,13 @@ private:
     bool isRetrendActive;
     float genericPearsonThreshold;
     float maxHeightInversion;
+    int maxNeighbours;                  /*!< max number of stations used by idw and kriging (0: all) */
+
+    TkrigingMode krigingMode;           /*!< variogram model */
+    float krigingRange;                 /*!< [m] */
+    float krigingNugget;
+    float krigingSill;
+    float krigingSlope;                 /*!< linear model [m-1] */
 
     proxyVars::TProxyVar detrendList[PROXY_VAR_NR];
 
@@ -49,7 +56,7 @@ public:
     Crit3DInterpolationSettings();
     bool isCrossValidation;
 
-    proxyVars::TProxyVar getDetrendList(int myPosition);
+    proxyVars::TProxyVar getDetrendList(int myPosition) const;
 
     void setClimateParameters(Crit3DClimateParameters* myParameters);
     void setCurrentDate(Crit3DDate myDate);
@@ -68,21 +75,29 @@ public:
     void setUseJRC(bool myValue);
     void setUseDewPoint(bool myValue);
     void setIsCrossValidation(bool myValue);
-
-    bool getUseTad();
-    int getInterpolationMethod();
-    float getMaxHeightInversion();
-    bool getUseHeight();
-    bool getUseThermalInversion();
-    bool getUseOrogIndex();
-    bool getUseSeaDistance();
-    bool getUseUrbanFraction();
-    bool getUseAspect();
-    bool getUseGenericProxy();
-    bool getUseTAD();
-    bool getUseJRC();
-    bool getUseDewPoint();
-    bool getIsCrossValidation();
+    void setMaxNeighbours(int myValue);
+    void setKrigingVariogram(TkrigingMode myMode, float myRange, float myNugget, float mySill, float mySlope);
+
+    bool getUseTad() const;
+    int getInterpolationMethod() const;
+    float getMaxHeightInversion() const;
+    bool getUseHeight() const;
+    bool getUseThermalInversion() const;
+    bool getUseOrogIndex() const;
+    bool getUseSeaDistance() const;
+    bool getUseUrbanFraction() const;
+    bool getUseAspect() const;
+    bool getUseGenericProxy() const;
+    bool getUseTAD() const;
+    bool getUseJRC() const;
+    bool getUseDewPoint() const;
+    bool getIsCrossValidation() const;
+    int getMaxNeighbours() const;
+    TkrigingMode getKrigingMode() const;
+    float getKrigingRange() const;
+    float getKrigingNugget() const;
+    float getKrigingSill() const;
+    float getKrigingSlope() const;
 
     void setDetrendOrographyActive(bool myValue);
     void setDetrendUrbanActive(bool myValue);
@@ -91,14 +106,14 @@ public:
     void setDetrendAspectActive(bool myValue);
     void setDetrendGenericProxyActive(bool myValue);
 
-    bool getDetrendOrographyActive();
-    bool getDetrendUrbanActive();
-    bool getDetrendOrogIndexActive();
-    bool getDetrendSeaDistanceActive();
-    bool getDetrendAspectActive();
-    bool getDetrendGenericProxyActive();
+    bool getDetrendOrographyActive() const;
+    bool getDetrendUrbanActive() const;
+    bool getDetrendOrogIndexActive() const;
+    bool getDetrendSeaDistanceActive() const;
+    bool getDetrendAspectActive() const;
+    bool getDetrendGenericProxyActive() const;
 
-    float getGenericPearsonThreshold();
+    float getGenericPearsonThreshold() const;
 
     float getCurrentClimateLapseRate(meteoVariable myVar);
 };
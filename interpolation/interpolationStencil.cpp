@@ -0,0 +1,193 @@
+/*!
+    \copyright 2016 Fausto Tomei, Gabriele Antolini,
+    Alberto Pistocchi, Marco Bittelli, Antonio Volta, Laura Costantini
+
+    This file is part of CRITERIA3D.
+    CRITERIA3D has been developed under contract issued by A.R.P.A. Emilia-Romagna
+
+    CRITERIA3D is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CRITERIA3D is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with CRITERIA3D.  If not, see <http://www.gnu.org/licenses/>.
+
+    contacts:
+    fausto.tomei@gmail.com
+    ftomei@arpae.it
+*/
+
+#include <math.h>
+
+#include "commonConstants.h"
+#include "gis.h"
+#include "interpolationConstants.h"
+#include "interpolationStencil.h"
+
+using namespace std;
+
+
+Crit3DInterpolationStencil::Crit3DInterpolationStencil()
+{
+    clear();
+}
+
+
+void Crit3DInterpolationStencil::clear()
+{
+    nrRows = 0;
+    nrCols = 0;
+    cellSize = NODATA;
+    xll = NODATA;
+    yll = NODATA;
+    nrNeighbours = 0;
+
+    stationIndex.clear();
+    stationX.clear();
+    stationY.clear();
+    cellOffset.clear();
+    position.clear();
+    distance.clear();
+}
+
+
+/*!
+ * \brief true if the stencil was built on the same stations and grid
+ */
+bool Crit3DInterpolationStencil::isValid(const vector <Crit3DInterpolationDataPoint> &points,
+                                         const gis::Crit3DRasterGrid& myDTM, int myNrNeighbours) const
+{
+    if (cellOffset.empty() || myNrNeighbours != nrNeighbours) return false;
+
+    if (myDTM.header->nrRows != nrRows || myDTM.header->nrCols != nrCols
+        || myDTM.header->cellSize != cellSize
+        || myDTM.header->llCorner->x != xll || myDTM.header->llCorner->y != yll)
+        return false;
+
+    if (points.size() != stationIndex.size()) return false;
+
+    for (unsigned long i = 0; i < points.size(); i++)
+    {
+        if (points[i].index != stationIndex[i]
+            || float(points[i].point->utm.x) != stationX[i]
+            || float(points[i].point->utm.y) != stationY[i])
+            return false;
+    }
+
+    return true;
+}
+
+
+/*!
+ * \brief nearest stations of each valid cell of the DTM (rows in parallel)
+ * \param myIndex spatial index of points
+ * \param myNrNeighbours stations of each cell (limited to the number of points)
+ */
+bool Crit3DInterpolationStencil::build(const vector <Crit3DInterpolationDataPoint> &points, const Crit3DSpatialIndex& myIndex,
+                                       const gis::Crit3DRasterGrid& myDTM, int myNrNeighbours, int nrThreads)
+{
+    clear();
+    if (points.empty() || myNrNeighbours < 1 || ! myIndex.isBuilt(points)) return false;
+
+    nrRows = myDTM.header->nrRows;
+    nrCols = myDTM.header->nrCols;
+    cellSize = myDTM.header->cellSize;
+    xll = myDTM.header->llCorner->x;
+    yll = myDTM.header->llCorner->y;
+    nrNeighbours = minValue(myNrNeighbours, int(points.size()));
+
+    unsigned long i;
+    stationIndex.resize(points.size());
+    stationX.resize(points.size());
+    stationY.resize(points.size());
+    for (i = 0; i < points.size(); i++)
+    {
+        stationIndex[i] = points[i].index;
+        stationX[i] = float(points[i].point->utm.x);
+        stationY[i] = float(points[i].point->utm.y);
+    }
+
+    // offsets of the valid cells
+    int nrValidCells = 0;
+    cellOffset.resize(unsigned(nrRows * nrCols));
+    for (int row = 0; row < nrRows; row++)
+        for (int col = 0; col < nrCols; col++)
+        {
+            if (myDTM.value[row][col] != myDTM.header->flag)
+                cellOffset[unsigned(row * nrCols + col)] = (nrValidCells++) * nrNeighbours;
+            else
+                cellOffset[unsigned(row * nrCols + col)] = NODATA;
+        }
+
+    position.resize(unsigned(nrValidCells * nrNeighbours));
+    distance.resize(unsigned(nrValidCells * nrNeighbours));
+
+    #pragma omp parallel for schedule(dynamic, INTERPOLATION_ROW_BLOCK) num_threads(maxValue(nrThreads, 1))
+    for (int row = 0; row < nrRows; row++)
+    {
+        float x, y;
+        vector <TneighbourPoint> neighbours;
+
+        for (int col = 0; col < nrCols; col++)
+        {
+            int offset = cellOffset[unsigned(row * nrCols + col)];
+            if (offset == NODATA) continue;
+
+            gis::getUtmXYFromRowColSinglePrecision(myDTM, row, col, &x, &y);
+            myIndex.searchNearest(x, y, nrNeighbours, points, false, false, NODATA, &neighbours);
+
+            for (int j = 0; j < nrNeighbours; j++)
+            {
+                position[unsigned(offset + j)] = neighbours[unsigned(j)].position;
+                distance[unsigned(offset + j)] = neighbours[unsigned(j)].distance;
+            }
+        }
+    }
+
+    return true;
+}
+
+
+/*!
+ * \brief inverse distance weighted in the cell (same result of the interpolation on the nearest stations)
+ * \param values values of the stations, in the order of the points used to build the stencil
+ */
+float Crit3DInterpolationStencil::inverseDistanceWeighted(int row, int col, const float* values) const
+{
+    int offset = cellOffset[unsigned(row * nrCols + col)];
+    if (offset == NODATA) return NODATA;
+
+    double sum = 0;
+    double sumWeights = 0;
+    for (int j = offset; j < offset + nrNeighbours; j++)
+    {
+        if (distance[unsigned(j)] == 0)
+            return values[position[unsigned(j)]];
+
+        double weight = distance[unsigned(j)] / 10000.;
+        weight = fabs(1 / (weight * weight * weight));
+        sumWeights += weight;
+        sum += values[position[unsigned(j)]] * weight;
+    }
+
+    if (sumWeights > 0.0)
+        return float(sum / sumWeights);
+    else
+        return NODATA;
+}
+
+
+/*!
+ * \brief memory used by the stencil [bytes]
+ */
+long Crit3DInterpolationStencil::getMemorySize() const
+{
+    return long(cellOffset.size() * sizeof(int) + position.size() * sizeof(int) + distance.size() * sizeof(float)
+                + stationIndex.size() * (sizeof(int) + 2 * sizeof(float)));
+}
@@ -0,0 +1,47 @@
+#ifndef INTERPOLATIONSTENCIL_H
+#define INTERPOLATIONSTENCIL_H
+
+    #ifndef VECTOR_H
+        #include <vector>
+    #endif
+    #ifndef INTERPOLATIONPOINT_H
+        #include "interpolationPoint.h"
+    #endif
+    #ifndef SPATIALINDEX_H
+        #include "spatialIndex.h"
+    #endif
+
+    /*! nearest stations of each cell of a DTM, with their distances:
+     *  with the same stations (hours with the same available data, variables with the same network)
+     *  the inverse distance weighted becomes a sparse matrix-vector product on the station values.
+     *  It is valid for a list of stations (indices and coordinates) and a grid header:
+     *  it has to be cleared when the DTM is changed */
+    class Crit3DInterpolationStencil
+    {
+    private:
+        int nrRows, nrCols;
+        double cellSize, xll, yll;
+        int nrNeighbours;                   /*!< stations of each valid cell */
+
+        std::vector <int> stationIndex;     /*!< key: stations used for the stencil */
+        std::vector <float> stationX;
+        std::vector <float> stationY;
+
+        std::vector <int> cellOffset;       /*!< [nrRows*nrCols] first neighbour of the cell (NODATA: no data cell) */
+        std::vector <int> position;         /*!< [nrValidCells * nrNeighbours] position of the station in the list */
+        std::vector <float> distance;       /*!< [nrValidCells * nrNeighbours] [m] sorted */
+
+    public:
+        Crit3DInterpolationStencil();
+
+        void clear();
+        bool isValid(const std::vector <Crit3DInterpolationDataPoint> &points,
+                     const gis::Crit3DRasterGrid& myDTM, int myNrNeighbours) const;
+        bool build(const std::vector <Crit3DInterpolationDataPoint> &points, const Crit3DSpatialIndex& myIndex,
+                   const gis::Crit3DRasterGrid& myDTM, int myNrNeighbours, int nrThreads);
+
+        float inverseDistanceWeighted(int row, int col, const float* values) const;
+        long getMemorySize() const;
+    };
+
+#endif // INTERPOLATIONSTENCIL_H
@@ -10,6 +10,8 @@
     #include <math.h>
     #include <stdio.h>
 
+    #include "commonConstants.h"
+    #include "interpolationConstants.h"
     #include "kriging.h"
 
     /*! global variables */
@@ -81,6 +83,40 @@
 
 
 
+    /*!
+     * \brief variogram model
+     * \param myMode mode 1-Spher mode 2-Expon mode 3-Gauss mode 4-Linear mode
+     * \param h distance
+     * \return semivariance
+     */
+    double krigingSemivariance(short myMode, double h, double myRange, double myNugget, double mySill, double mySlope)
+    {
+        double tmp = h / myRange;
+
+        switch (myMode)
+        {
+            /*! Spherical */
+            case 1 :
+                if (h < myRange)
+                    return myNugget + (mySill - myNugget) * (1.5 * tmp - 0.5 * tmp * tmp * tmp);
+                else
+                    return myNugget + (mySill - myNugget);
+
+            /*! Exponential */
+            case 2 :
+                return myNugget + (mySill - myNugget) * (1. - exp(-3.* tmp));
+
+            /*! Gaussian */
+            case 3 :
+                return myNugget + (mySill - myNugget) * (1. - exp(-4.* tmp * tmp));
+
+            /*! Linear (default) */
+            default:
+                return myNugget + mySlope * h;
+        }
+    }
+
+
     /*!
      * \brief costruisce la matrice delle distanze e il variogramma
      * \param myPos pos[N*2]	[i*2]   x i-esima stazione  [i*2+1] y i-esima stazione
@@ -97,7 +133,7 @@
                           double myRange, double myNugget, double mySill, double mySlope)
     {
         int i, j;
-        double dx, dy, tmp;
+        double dx, dy;
         double *Cd;
 
         /*! global variables */
@@ -155,40 +191,7 @@
         {
             for (j = i; j < nrItems; j++)
             {
-                tmp = Cd[i*dim+j] / range;
-                switch (mode)
-                {
-                /*! Spherical */
-                    case 1 :
-                            if (Cd[i*dim+j] < range)
-                            {
-                                V[i*dim+j] = V[j*dim+i] = nugget + sill_nugget *
-                                            (1.5 * tmp - 0.5 * tmp * tmp * tmp);
-                            }
-                            else V[i*dim+j] = V[j*dim+i] = nugget + sill_nugget;
-                            break;
-                /*! Exponential */
-                    case 2 :
-                            V[i*dim+j] = V[j*dim+i] = nugget + sill_nugget *
-                                        (1. - exp(-3.* tmp));
-                            break;
-
-                /*! Gaussian */
-                    case 3 :
-                            V[i*dim+j] = V[j*dim+i] = nugget + sill_nugget *
-                                        (1. - exp(-4.* tmp * tmp));
-                            break;
-
-                /*! Linear */
-                    case 4 :
-                            V[i*dim+j] = V[j*dim+i] = nugget + slope * Cd[i*dim+j];
-                            break;
-
-                /*! Default: linear */
-                    default:
-                            V[i*dim+j] = V[j*dim+i] = nugget + slope * Cd[i*dim+j];
-                            break;
-                }
+                V[i*dim+j] = V[j*dim+i] = krigingSemivariance(mode, Cd[i*dim+j], range, nugget, sill, slope);
             }
         }
 
@@ -210,7 +213,7 @@
 bool krigingSetWeight(double x_p, double y_p)
     {
         int i, j;
-        double dx, dy, tmp, h;
+        double dx, dy, h;
 
         /*! calcola le distanze tra P e i punti di misura e calcola il variogramma (memorizzato in D) */
         for (i=0; i < dim-1; i++)
@@ -218,36 +221,7 @@ bool krigingSetWeight(double x_p, double y_p)
             dx = pos[i*2] - x_p;
             dy = pos[i*2+1] - y_p;
             h = sqrt(dx * dx + dy * dy);
-            tmp = h / range;
-            switch( mode )
-                {
-            /*! Sferico */
-                case 1 :
-                         if ( h < range )
-                            D[i] = nugget + sill_nugget * (1.5 * tmp - 0.5 * tmp * tmp * tmp);
-                         else
-                            D[i] = nugget + sill_nugget;
-                         break;
-            /*! Esponenziale */
-                case 2 :
-                         D[i] = nugget + sill_nugget * (1. - exp(-3.* tmp));
-                         break;
-
-            /*! Gaussiano */
-                case 3 :
-                         D[i] = nugget + sill_nugget * (1. - exp(-4.* tmp * tmp));
-                         break;
-
-            /*! Lineare */
-                case 4 :
-                         D[i] = nugget + slope * h;
-                         break;
-
-            /*! Default: Lineare */
-                default:
-                         D[i] = nugget + slope * h;
-                         break;
-                }
+            D[i] = krigingSemivariance(mode, h, range, nugget, sill, slope);
         }
         D[dim-1] = 1;
 
@@ -328,3 +302,269 @@ void krigingFreeMemory()
             weight = NULL;
         }
     }
+
+
+/*!
+ * \brief LU decomposition with partial pivoting (in place, row-major)
+ * the kriging matrix is symmetric but not positive definite (lagrange multiplier)
+ * \return false if the matrix is singular
+ */
+bool luDecomposition(double *A, int n, int *pivot)
+{
+    for (int k = 0; k < n; k++)
+    {
+        int p = k;
+        for (int i = k + 1; i < n; i++)
+            if (fabs(A[i*n+k]) > fabs(A[p*n+k])) p = i;
+
+        if (A[p*n+k] == 0.) return false;
+
+        pivot[k] = p;
+        if (p != k)
+            for (int j = 0; j < n; j++)
+            {
+                double tmp = A[k*n+j];
+                A[k*n+j] = A[p*n+j];
+                A[p*n+j] = tmp;
+            }
+
+        for (int i = k + 1; i < n; i++)
+        {
+            double factor = A[i*n+k] / A[k*n+k];
+            A[i*n+k] = factor;
+            for (int j = k + 1; j < n; j++)
+                A[i*n+j] -= factor * A[k*n+j];
+        }
+    }
+
+    return true;
+}
+
+
+/*!
+ * \brief solve A x = b with the factors of luDecomposition (b is overwritten by x)
+ */
+void luSolve(const double *LU, int n, const int *pivot, double *b)
+{
+    int i, j;
+
+    for (i = 0; i < n; i++)
+    {
+        if (pivot[i] != i)
+        {
+            double tmp = b[i];
+            b[i] = b[pivot[i]];
+            b[pivot[i]] = tmp;
+        }
+    }
+
+    for (i = 1; i < n; i++)
+        for (j = 0; j < i; j++)
+            b[i] -= LU[i*n+j] * b[j];
+
+    for (i = n - 1; i >= 0; i--)
+    {
+        for (j = i + 1; j < n; j++)
+            b[i] -= LU[i*n+j] * b[j];
+        b[i] /= LU[i*n+i];
+    }
+}
+
+
+/*!
+ * \brief variogram matrix of ordinary kriging [n+1 x n+1]: last row and column for the lagrange multiplier
+ */
+static void krigingMatrix(const Crit3DKriging &myKriging, const float *x, const float *y,
+                          const int *positions, int n, double *A)
+{
+    int dim = n + 1;
+    for (int i = 0; i < n; i++)
+    {
+        int pi = (positions != nullptr) ? positions[i] : i;
+        for (int j = i; j < n; j++)
+        {
+            int pj = (positions != nullptr) ? positions[j] : j;
+            double dx = double(x[pi]) - double(x[pj]);
+            double dy = double(y[pi]) - double(y[pj]);
+            A[i*dim+j] = A[j*dim+i] = myKriging.semivariance(sqrt(dx * dx + dy * dy));
+        }
+        A[i*dim+n] = A[n*dim+i] = 1;
+    }
+    A[n*dim+n] = 0;
+}
+
+
+Crit3DKriging::Crit3DKriging()
+{
+    setVariogram(KRIGING_LINEAR, NODATA, 0, NODATA, 1);
+    clear();
+}
+
+void Crit3DKriging::clear()
+{
+    nrPoints = 0;
+    x.clear();
+    y.clear();
+    factors.clear();
+    pivot.clear();
+    dualWeights.clear();
+}
+
+void Crit3DKriging::setVariogram(short myMode, double myRange, double myNugget, double mySill, double mySlope)
+{
+    mode = myMode;
+    range = myRange;
+    nugget = myNugget;
+    sill = mySill;
+    slope = mySlope;
+}
+
+double Crit3DKriging::semivariance(double h) const
+{
+    return krigingSemivariance(mode, h, range, nugget, sill, slope);
+}
+
+bool Crit3DKriging::isReady() const
+{
+    return (nrPoints > 0);
+}
+
+
+/*!
+ * \brief build and factorize the variogram matrix of the points (once per time step)
+ * the dual weights (A^-1 [values, 0]) give the estimate in a single pass on the points
+ * \return false if there are no points or the matrix is singular (i.e. coincident points)
+ */
+bool Crit3DKriging::initialize(const float *myX, const float *myY, const float *myValue, int myNrPoints)
+{
+    clear();
+    if (myNrPoints < 1) return false;
+
+    int dim = myNrPoints + 1;
+    factors.resize(dim * dim);
+    pivot.resize(dim);
+
+    krigingMatrix(*this, myX, myY, nullptr, myNrPoints, factors.data());
+    if (! luDecomposition(factors.data(), dim, pivot.data()))
+    {
+        clear();
+        return false;
+    }
+
+    x.assign(myX, myX + myNrPoints);
+    y.assign(myY, myY + myNrPoints);
+    dualWeights.assign(myValue, myValue + myNrPoints);
+    dualWeights.push_back(0);
+    luSolve(factors.data(), dim, pivot.data(), dualWeights.data());
+
+    nrPoints = myNrPoints;
+    return true;
+}
+
+
+/*!
+ * \brief ordinary kriging estimate in (x, y) on all the points of initialize
+ * \param krigingStdDev if not null: kriging standard deviation (the weights are solved)
+ */
+float Crit3DKriging::estimate(float myX, float myY, float *krigingStdDev) const
+{
+    if (nrPoints == 0) return NODATA;
+
+    int i;
+    double result = dualWeights[nrPoints];
+    for (i = 0; i < nrPoints; i++)
+    {
+        double dx = x[i] - double(myX);
+        double dy = y[i] - double(myY);
+        result += dualWeights[i] * semivariance(sqrt(dx * dx + dy * dy));
+    }
+
+    if (krigingStdDev != nullptr)
+    {
+        std::vector <double> D(nrPoints + 1);
+        for (i = 0; i < nrPoints; i++)
+        {
+            double dx = x[i] - double(myX);
+            double dy = y[i] - double(myY);
+            D[i] = semivariance(sqrt(dx * dx + dy * dy));
+        }
+        D[nrPoints] = 1;
+
+        std::vector <double> weights(D);
+        luSolve(factors.data(), nrPoints + 1, pivot.data(), weights.data());
+
+        double variance = 0;
+        for (i = 0; i <= nrPoints; i++)
+            variance += weights[i] * D[i];
+        *krigingStdDev = float(sqrt(fabs(variance)));
+    }
+
+    return float(result);
+}
+
+
+/*!
+ * \brief ordinary kriging estimate in (x, y) on a neighbourhood of the points
+ * (the system is built and solved for each call)
+ * \param positions positions of the neighbours in the arrays
+ */
+float Crit3DKriging::estimateLocal(const float *myX, const float *myY, const float *myValue,
+                                   const int *positions, int nrNeighbours, float px, float py) const
+{
+    if (nrNeighbours < 1) return NODATA;
+
+    int dim = nrNeighbours + 1;
+    std::vector <double> A(dim * dim);
+    std::vector <int> myPivot(dim);
+    std::vector <double> weights(dim);
+
+    krigingMatrix(*this, myX, myY, positions, nrNeighbours, A.data());
+    if (! luDecomposition(A.data(), dim, myPivot.data()))
+        return NODATA;
+
+    for (int i = 0; i < nrNeighbours; i++)
+    {
+        double dx = double(myX[positions[i]]) - double(px);
+        double dy = double(myY[positions[i]]) - double(py);
+        weights[i] = semivariance(sqrt(dx * dx + dy * dy));
+    }
+    weights[nrNeighbours] = 1;
+
+    luSolve(A.data(), dim, myPivot.data(), weights.data());
+
+    double result = 0;
+    for (int i = 0; i < nrNeighbours; i++)
+        result += weights[i] * myValue[positions[i]];
+
+    return float(result);
+}
+
+
+/*!
+ * \brief leave-one-out estimates in the points of initialize, without solving a system
+ * for each point: z(i) - estimate(i) = dualWeight(i) / inverse(i,i)  (Dubrule, 1983)
+ * \param myValue values passed to initialize
+ * \param estimates [nrPoints] estimate in each point without the point itself (NODATA if not available)
+ */
+bool Crit3DKriging::leaveOneOut(const float *myValue, std::vector <float> *estimates) const
+{
+    if (nrPoints == 0) return false;
+
+    estimates->assign(nrPoints, NODATA);
+    if (nrPoints == 1) return true;
+
+    int dim = nrPoints + 1;
+    std::vector <double> column(dim);
+
+    for (int i = 0; i < nrPoints; i++)
+    {
+        column.assign(dim, 0.);
+        column[i] = 1;
+        luSolve(factors.data(), dim, pivot.data(), column.data());
+
+        if (column[i] != 0.)
+            (*estimates)[i] = float(myValue[i] - dualWeights[i] / column[i]);
+    }
+
+    return true;
+}
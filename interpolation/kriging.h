@@ -1,8 +1,14 @@
 #ifndef KRIGING_H
 #define KRIGING_H
 
+    #ifndef VECTOR_H
+        #include <vector>
+    #endif
+
     bool matrixInversion(double *A);
 
+    double krigingSemivariance(short myMode, double h, double myRange, double myNugget, double mySill, double mySlope);
+
     bool krigingVariogram(double *myPos, double *mtVal, int nrItems, short myMode,
                          double myRange, double myNugget, double mySill, double mySlope);
 
@@ -14,4 +20,37 @@
 
     void krigingFreeMemory();
 
+    bool luDecomposition(double *A, int n, int *pivot);
+    void luSolve(const double *LU, int n, const int *pivot, double *b);
+
+    /*! ordinary kriging without global variables: the variogram matrix is factorized once
+     *  (initialize), then the estimates are read-only and can be computed concurrently */
+    class Crit3DKriging
+    {
+    private:
+        short mode;
+        double range, nugget, sill, slope;
+
+        int nrPoints;
+        std::vector <double> x, y;
+        std::vector <double> factors;       /*!< LU factors of the variogram matrix [nrPoints+1]^2 */
+        std::vector <int> pivot;
+        std::vector <double> dualWeights;   /*!< [nrPoints+1] estimate = sum(dualWeights * semivariance) + lagrange */
+
+    public:
+        Crit3DKriging();
+
+        void clear();
+        void setVariogram(short myMode, double myRange, double myNugget, double mySill, double mySlope);
+        double semivariance(double h) const;
+
+        bool initialize(const float *myX, const float *myY, const float *myValue, int myNrPoints);
+        bool isReady() const;
+
+        float estimate(float myX, float myY, float *krigingStdDev = nullptr) const;
+        float estimateLocal(const float *myX, const float *myY, const float *myValue,
+                            const int *positions, int nrNeighbours, float px, float py) const;
+        bool leaveOneOut(const float *myValue, std::vector <float> *estimates) const;
+    };
+
 #endif // KRIGING_H
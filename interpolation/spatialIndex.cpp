@@ -0,0 +1,236 @@
+/*!
+    \copyright 2016 Fausto Tomei, Gabriele Antolini,
+    Alberto Pistocchi, Marco Bittelli, Antonio Volta, Laura Costantini
+
+    This file is part of CRITERIA3D.
+    CRITERIA3D has been developed under contract issued by A.R.P.A. Emilia-Romagna
+
+    CRITERIA3D is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CRITERIA3D is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with CRITERIA3D.  If not, see <http://www.gnu.org/licenses/>.
+
+    contacts:
+    fausto.tomei@gmail.com
+    ftomei@arpae.it
+*/
+
+#include <math.h>
+#include <algorithm>
+
+#include "commonConstants.h"
+#include "gis.h"
+#include "spatialIndex.h"
+
+using namespace std;
+
+
+/*! neighbours are ordered by distance, then by position in the list
+ *  (the same order of a linear scan with strict comparison) */
+static bool isNearer(const TneighbourPoint &a, const TneighbourPoint &b)
+{
+    if (a.distance != b.distance)
+        return (a.distance < b.distance);
+    else
+        return (a.position < b.position);
+}
+
+
+Crit3DSpatialIndex::Crit3DSpatialIndex()
+{
+    clear();
+}
+
+
+void Crit3DSpatialIndex::clear()
+{
+    nrPoints = 0;
+    nrCols = 0;
+    nrRows = 0;
+    xMin = 0;
+    yMin = 0;
+    bucketSize = 1;
+    bucketStart.clear();
+    bucketPoints.clear();
+}
+
+
+bool Crit3DSpatialIndex::isBuilt(const vector <Crit3DInterpolationDataPoint> &points) const
+{
+    return (! bucketStart.empty() && nrPoints == int(points.size()));
+}
+
+
+/*!
+ * \brief build the buckets: about two points per bucket, cells of the same size in x and y
+ * (the search rings are squares)
+ */
+void Crit3DSpatialIndex::build(const vector <Crit3DInterpolationDataPoint> &points)
+{
+    int i, col, row, cell;
+
+    clear();
+    nrPoints = int(points.size());
+
+    if (nrPoints == 0)
+    {
+        bucketStart.resize(1, 0);
+        return;
+    }
+
+    float xMax, yMax;
+    xMin = xMax = float(points[0].point->utm.x);
+    yMin = yMax = float(points[0].point->utm.y);
+    for (i = 1; i < nrPoints; i++)
+    {
+        float x = float(points[i].point->utm.x);
+        float y = float(points[i].point->utm.y);
+        xMin = minValue(xMin, x);
+        xMax = maxValue(xMax, x);
+        yMin = minValue(yMin, y);
+        yMax = maxValue(yMax, y);
+    }
+
+    double width = double(xMax - xMin);
+    double height = double(yMax - yMin);
+    double side = maxValue(width, height);
+
+    if (side <= 0)
+        bucketSize = 1;
+    else
+    {
+        double area = maxValue(width, side / nrPoints) * maxValue(height, side / nrPoints);
+        bucketSize = float(sqrt(area / maxValue(nrPoints / 2, 1)));
+
+        // points aligned along a line: limit the number of empty buckets
+        while (double(floor(width / bucketSize) + 1) * (floor(height / bucketSize) + 1) > 4. * nrPoints + 4)
+            bucketSize *= 2;
+    }
+
+    nrCols = int(floor(width / bucketSize)) + 1;
+    nrRows = int(floor(height / bucketSize)) + 1;
+
+    // counting sort of the points by bucket
+    vector <int> pointCell;
+    pointCell.resize(unsigned(nrPoints));
+    bucketStart.assign(unsigned(nrCols * nrRows + 1), 0);
+    for (i = 0; i < nrPoints; i++)
+    {
+        col = minValue(int((float(points[i].point->utm.x) - xMin) / bucketSize), nrCols - 1);
+        row = minValue(int((float(points[i].point->utm.y) - yMin) / bucketSize), nrRows - 1);
+        cell = row * nrCols + col;
+        pointCell[unsigned(i)] = cell;
+        bucketStart[unsigned(cell + 1)]++;
+    }
+
+    for (cell = 0; cell < nrCols * nrRows; cell++)
+        bucketStart[unsigned(cell + 1)] += bucketStart[unsigned(cell)];
+
+    vector <int> next(bucketStart.begin(), bucketStart.end() - 1);
+    bucketPoints.resize(unsigned(nrPoints));
+    for (i = 0; i < nrPoints; i++)
+        bucketPoints[unsigned(next[unsigned(pointCell[unsigned(i)])]++)] = i;
+}
+
+
+void Crit3DSpatialIndex::searchBucket(int col, int row, float x, float y, unsigned int nrNeighbours,
+                                      const vector <Crit3DInterpolationDataPoint> &points,
+                                      bool onlyActive, bool excludeZeroDistance, int excludedIndex,
+                                      vector <TneighbourPoint> *neighbours) const
+{
+    if (col < 0 || col >= nrCols || row < 0 || row >= nrRows) return;
+
+    int cell = row * nrCols + col;
+    for (int j = bucketStart[unsigned(cell)]; j < bucketStart[unsigned(cell + 1)]; j++)
+    {
+        int position = bucketPoints[unsigned(j)];
+        const Crit3DInterpolationDataPoint* myPoint = &(points[unsigned(position)]);
+
+        if (onlyActive && ! myPoint->isActive) continue;
+
+        TneighbourPoint candidate;
+        candidate.position = position;
+        candidate.distance = gis::computeDistance(x, y, float(myPoint->point->utm.x), float(myPoint->point->utm.y));
+
+        if (candidate.distance == 0 && (excludeZeroDistance || myPoint->index == excludedIndex)) continue;
+
+        // neighbours is a max-heap: the farthest neighbour on the front
+        if (neighbours->size() < nrNeighbours)
+        {
+            neighbours->push_back(candidate);
+            push_heap(neighbours->begin(), neighbours->end(), isNearer);
+        }
+        else if (isNearer(candidate, neighbours->front()))
+        {
+            pop_heap(neighbours->begin(), neighbours->end(), isNearer);
+            neighbours->back() = candidate;
+            push_heap(neighbours->begin(), neighbours->end(), isNearer);
+        }
+    }
+}
+
+
+/*!
+ * \brief nearest points to (x, y), sorted by distance
+ * \param nrNeighbours max number of points (<= 0: all points)
+ * \param onlyActive skip the points not active
+ * \param excludeZeroDistance skip the points in (x, y)
+ * \param excludedIndex index of a point skipped if in (x, y) (jacknife), NODATA otherwise
+ * \return number of neighbours found
+ */
+int Crit3DSpatialIndex::searchNearest(float x, float y, int nrNeighbours,
+                                      const vector <Crit3DInterpolationDataPoint> &points,
+                                      bool onlyActive, bool excludeZeroDistance, int excludedIndex,
+                                      vector <TneighbourPoint> *neighbours) const
+{
+    neighbours->clear();
+    if (nrPoints == 0 || nrCols == 0) return 0;
+
+    unsigned int maxNeighbours = unsigned(nrNeighbours > 0 ? minValue(nrNeighbours, nrPoints) : nrPoints);
+    neighbours->reserve(maxNeighbours);
+
+    // bucket of the projection of (x, y) on the bounding box
+    int col0 = int(floor((x - xMin) / bucketSize));
+    int row0 = int(floor((y - yMin) / bucketSize));
+    col0 = maxValue(0, minValue(col0, nrCols - 1));
+    row0 = maxValue(0, minValue(row0, nrRows - 1));
+
+    int maxRing = maxValue(maxValue(col0, nrCols - 1 - col0), maxValue(row0, nrRows - 1 - row0));
+
+    for (int ring = 0; ring <= maxRing; ring++)
+    {
+        if (ring == 0)
+            searchBucket(col0, row0, x, y, maxNeighbours, points, onlyActive, excludeZeroDistance, excludedIndex, neighbours);
+        else
+        {
+            for (int col = col0 - ring; col <= col0 + ring; col++)
+            {
+                searchBucket(col, row0 - ring, x, y, maxNeighbours, points, onlyActive, excludeZeroDistance, excludedIndex, neighbours);
+                searchBucket(col, row0 + ring, x, y, maxNeighbours, points, onlyActive, excludeZeroDistance, excludedIndex, neighbours);
+            }
+            for (int row = row0 - ring + 1; row <= row0 + ring - 1; row++)
+            {
+                searchBucket(col0 - ring, row, x, y, maxNeighbours, points, onlyActive, excludeZeroDistance, excludedIndex, neighbours);
+                searchBucket(col0 + ring, row, x, y, maxNeighbours, points, onlyActive, excludeZeroDistance, excludedIndex, neighbours);
+            }
+        }
+
+        // the points in the next rings are farther than ring * bucketSize
+        // (strict test with a margin for the single precision distances)
+        if (neighbours->size() == maxNeighbours
+            && neighbours->front().distance < ring * bucketSize * 0.999f)
+            break;
+    }
+
+    sort_heap(neighbours->begin(), neighbours->end(), isNearer);
+
+    return int(neighbours->size());
+}
@@ -0,0 +1,48 @@
+#ifndef SPATIALINDEX_H
+#define SPATIALINDEX_H
+
+    #ifndef VECTOR_H
+        #include <vector>
+    #endif
+    #ifndef INTERPOLATIONPOINT_H
+        #include "interpolationPoint.h"
+    #endif
+
+    struct TneighbourPoint {
+        float distance;                 /*!< [m] */
+        int position;                   /*!< position in the point list */
+    };
+
+    /*! uniform grid of buckets over the points of an interpolation list:
+     *  k-nearest search without scanning the whole list.
+     *  The index refers to the positions of the list: it has to be rebuilt
+     *  when points are added or removed (not when values change) */
+    class Crit3DSpatialIndex
+    {
+    private:
+        int nrPoints;
+        int nrCols, nrRows;
+        float xMin, yMin;
+        float bucketSize;
+        std::vector <int> bucketStart;      /*!< [nrCols*nrRows + 1] first element of each bucket in bucketPoints */
+        std::vector <int> bucketPoints;     /*!< positions of the points, sorted by bucket */
+
+        void searchBucket(int col, int row, float x, float y, unsigned int nrNeighbours,
+                          const std::vector <Crit3DInterpolationDataPoint> &points,
+                          bool onlyActive, bool excludeZeroDistance, int excludedIndex,
+                          std::vector <TneighbourPoint> *neighbours) const;
+
+    public:
+        Crit3DSpatialIndex();
+
+        void clear();
+        void build(const std::vector <Crit3DInterpolationDataPoint> &points);
+        bool isBuilt(const std::vector <Crit3DInterpolationDataPoint> &points) const;
+
+        int searchNearest(float x, float y, int nrNeighbours,
+                          const std::vector <Crit3DInterpolationDataPoint> &points,
+                          bool onlyActive, bool excludeZeroDistance, int excludedIndex,
+                          std::vector <TneighbourPoint> *neighbours) const;
+    };
+
+#endif // SPATIALINDEX_H
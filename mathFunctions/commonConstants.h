@@ -76,6 +76,7 @@
     #define MEMORY_ERROR -2222
     #define TOPOGRAPHY_ERROR -3333
     #define BOUNDARY_ERROR -4444
+    #define FILE_ERROR -5555
     #define MISSING_DATA_ERROR -9999
     #define PARAMETER_ERROR -7777
 
@@ -99,6 +100,16 @@
     #define BOUNDARY_NONE 99
 
     #define RELAXATION 1
+    #define BICGSTAB 2
+    #define CONJUGATE_GRADIENT 3
+
+    #define TIMESTEP_HALVE_DOUBLE 0
+    #define TIMESTEP_ADAPTIVE 1
+
+    #define REJECTED_ALL 0
+    #define REJECTED_COURANT 1
+    #define REJECTED_SOLVER 2
+    #define REJECTED_BALANCE 3
 
     #define MAX_SOILS 1024
     #define MAX_SURFACES 1024
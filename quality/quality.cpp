@@ -98,7 +98,13 @@ quality::Range* Crit3DQuality::getQualityRange(meteoVariable myVar)
 }
 
 
-bool Crit3DQuality::checkData(meteoVariable myVar, frequencyType myFrequency, Crit3DMeteoPoint* meteoPoints, int nrMeteoPoints, Crit3DTime myTime)
+/*!
+ * \brief quality control of the meteo points data, the accepted data are passed to the interpolator
+ * (the default interpolator if interpolator is NULL)
+ * \return true if at least one valid data
+ */
+bool Crit3DQuality::checkData(meteoVariable myVar, frequencyType myFrequency, Crit3DMeteoPoint* meteoPoints,
+                              int nrMeteoPoints, Crit3DTime myTime, Crit3DInterpolator* interpolator)
 {
     if (nrMeteoPoints == 0)
         return false;
@@ -115,7 +121,10 @@ bool Crit3DQuality::checkData(meteoVariable myVar, frequencyType myFrequency, Cr
         spatialQualityControl(myVar, meteoPoints, nrMeteoPoints);
 
     // return true if at least one valid data
-    return passDataToInterpolation(meteoPoints, nrMeteoPoints);
+    if (interpolator == NULL)
+        return passDataToInterpolation(meteoPoints, nrMeteoPoints);
+    else
+        return passDataToInterpolation(interpolator, meteoPoints, nrMeteoPoints);
 }
 
 
@@ -151,10 +160,14 @@ void Crit3DQuality::syntacticQualityControl(meteoVariable myVar, Crit3DMeteoPoin
 
 
 float findThreshold(meteoVariable myVar, float value, float stdDev, float nrStdDev, float stdDevZ, float minDistance);
-bool computeResiduals(meteoVariable myVar, Crit3DMeteoPoint* meteoPoints, int nrMeteoPoints);
+bool computeResiduals(meteoVariable myVar, Crit3DMeteoPoint* meteoPoints, int nrMeteoPoints, const Crit3DInterpolator& interpolator);
 void setSpatialQualityControlSettings(Crit3DInterpolationSettings* mySettings, meteoVariable myVar);
 
 
+/*!
+ * \brief spatial quality control: it uses its own interpolators,
+ * the settings and the data of the default interpolator are not modified
+ */
 void spatialQualityControl(meteoVariable myVar, Crit3DMeteoPoint* meteoPoints, int nrMeteoPoints)
 {
     int i;
@@ -163,27 +176,23 @@ void spatialQualityControl(meteoVariable myVar, Crit3DMeteoPoint* meteoPoints, i
     std::vector <float> listResiduals;
 
     Crit3DInterpolationSettings mySettings;
+    Crit3DInterpolator dataInterpolator;
 
     setSpatialQualityControlSettings(&mySettings, myVar);
-    setInterpolationSettings(&mySettings);
+    dataInterpolator.setSettings(mySettings);
 
-    if (passDataToInterpolation(meteoPoints, nrMeteoPoints))
+    if (passDataToInterpolation(&dataInterpolator, meteoPoints, nrMeteoPoints))
     {
-        // detrend
-        if (! preInterpolation(myVar))
-            return;
+        dataInterpolator.buildSpatialIndex();
 
-        // compute residuals
-        if (! computeResiduals(myVar, meteoPoints, nrMeteoPoints))
+        // compute residuals (detrended on a copy: dataInterpolator keeps the original data)
+        if (! computeResiduals(myVar, meteoPoints, nrMeteoPoints, dataInterpolator))
             return;
 
-        // re-load data
-        passDataToInterpolation(meteoPoints, nrMeteoPoints);
-
         for (i = 0; i < nrMeteoPoints; i++)
             if (meteoPoints[i].myQuality == quality::accepted)
             {
-                if (neighbourhoodVariability(float(meteoPoints[i].point.utm.x),
+                if (dataInterpolator.neighbourhoodVariability(float(meteoPoints[i].point.utm.x),
                          float(meteoPoints[i].point.utm.y),float(meteoPoints[i].point.z),
                          10, &stdDev, &stdDevZ, &minDist))
                 {
@@ -200,14 +209,17 @@ void spatialQualityControl(meteoVariable myVar, Crit3DMeteoPoint* meteoPoints, i
 
         if (listIndex.size() > 0)
         {
-            if (passDataToInterpolation(meteoPoints, nrMeteoPoints))
+            // data without the suspect points
+            if (passDataToInterpolation(&dataInterpolator, meteoPoints, nrMeteoPoints))
             {
-                preInterpolation(myVar);
+                dataInterpolator.buildSpatialIndex();
+                Crit3DInterpolator detrendedInterpolator = dataInterpolator;
+                detrendedInterpolator.preInterpolation(myVar);
 
                 float interpolatedValue;
                 for (i=0; i < int(listIndex.size()); i++)
                 {
-                    interpolatedValue = interpolate(myVar,
+                    interpolatedValue = detrendedInterpolator.interpolate(myVar,
                                             float(meteoPoints[listIndex[i]].point.utm.x),
                                             float(meteoPoints[listIndex[i]].point.utm.y),
                                             float(meteoPoints[listIndex[i]].point.z),
@@ -218,11 +230,9 @@ void spatialQualityControl(meteoVariable myVar, Crit3DMeteoPoint* meteoPoints, i
                     listResiduals.push_back(interpolatedValue - myValue);
                 }
 
-                passDataToInterpolation(meteoPoints, nrMeteoPoints);
-
                 for (i=0; i < int(listIndex.size()); i++)
                 {
-                    if (neighbourhoodVariability(float(meteoPoints[listIndex[i]].point.utm.x),
+                    if (dataInterpolator.neighbourhoodVariability(float(meteoPoints[listIndex[i]].point.utm.x),
                              float(meteoPoints[listIndex[i]].point.utm.y),
                              float(meteoPoints[listIndex[i]].point.z),
                              10, &stdDev, &stdDevZ, &minDist))
@@ -268,46 +278,27 @@ void setSpatialQualityControlSettings(Crit3DInterpolationSettings* mySettings, m
 }
 
 
-bool computeResiduals(meteoVariable myVar, Crit3DMeteoPoint* meteoPoints, int nrMeteoPoints)
+/*!
+ * \brief leave-one-out residuals of the accepted points
+ * \param interpolator points as passed to the interpolation (not detrended)
+ */
+bool computeResiduals(meteoVariable myVar, Crit3DMeteoPoint* meteoPoints, int nrMeteoPoints, const Crit3DInterpolator& interpolator)
 {
-
     if (myVar == noMeteoVar) return false;
 
-    float myValue, interpolatedValue;
-    interpolatedValue = NODATA;
-    myValue = NODATA;
-
     for (int i = 0; i < nrMeteoPoints; i++)
-    {
         meteoPoints[i].residual = NODATA;
 
-        if (meteoPoints[i].myQuality == quality::accepted)
-        {
-            myValue = meteoPoints[i].value;
-            setindexPointJacknife(i);
-            interpolatedValue = interpolate(myVar, float(meteoPoints[i].point.utm.x),
-                                            float(meteoPoints[i].point.utm.y),
-                                            float(meteoPoints[i].point.z),
-                                            NODATA, NODATA, NODATA, NODATA);
-
-            setindexPointJacknife(NODATA);
+    // TODO derived var
 
-            if (  myVar == precipitation
-               || myVar == dailyPrecipitation)
-            {
-                if (myValue != NODATA)
-                    if (myValue < PREC_THRESHOLD) myValue=0.;
-
-                if (interpolatedValue != NODATA)
-                    if (interpolatedValue < PREC_THRESHOLD) interpolatedValue=0.;
-            }
-
-            // TODO derived var
+    std::vector <int> pointIndex;
+    std::vector <float> residuals;
+    float rmse, mae;
+    if (! interpolator.crossValidation(myVar, &pointIndex, &residuals, &rmse, &mae))
+        return false;
 
-            if ((interpolatedValue != NODATA) && (myValue != NODATA))
-                meteoPoints[i].residual = interpolatedValue - myValue;
-        }
-    }
+    for (unsigned int i = 0; i < residuals.size(); i++)
+        meteoPoints[pointIndex[i]].residual = residuals[i];
 
     return true;
 }
@@ -370,11 +361,17 @@ float findThreshold(meteoVariable myVar, float value, float stdDev, float nrStdD
 
 
 bool passDataToInterpolation(Crit3DMeteoPoint* meteoPoints, int nrMeteoPoints)
+{
+    return passDataToInterpolation(getDefaultInterpolator(), meteoPoints, nrMeteoPoints);
+}
+
+
+bool passDataToInterpolation(Crit3DInterpolator* interpolator, Crit3DMeteoPoint* meteoPoints, int nrMeteoPoints)
 {
     int myCounter = 0;
     float myValue, myX, myY, myZ;
 
-    clearInterpolationPoints();
+    interpolator->clearPoints();
 
     for (int i = 0; i < nrMeteoPoints; i++)
     {
@@ -385,11 +382,10 @@ bool passDataToInterpolation(Crit3DMeteoPoint* meteoPoints, int nrMeteoPoints)
             myY = float(meteoPoints[i].point.utm.y);
             myZ = float(meteoPoints[i].point.z);
 
-            if (addInterpolationPoint(i, myValue, myX, myY, myZ, NODATA, NODATA, NODATA, NODATA, NODATA))
+            if (interpolator->addPoint(i, myValue, myX, myY, myZ, NODATA, NODATA, NODATA, NODATA, NODATA))
                 myCounter++;
         }
     }
 
     return (myCounter > 0);
 }
-
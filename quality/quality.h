@@ -5,6 +5,8 @@
         #include "meteoPoint.h"
     #endif
 
+    class Crit3DInterpolator;
+
     namespace quality
     {
         class Range {
@@ -52,10 +54,12 @@
         void syntacticQualityControl(meteoVariable myVar, Crit3DMeteoPoint* meteoPoints, int nrMeteoPoints);
 
         bool checkData(meteoVariable myVar, frequencyType myFrequency,
-                      Crit3DMeteoPoint* meteoPoints, int nrMeteoPoints, Crit3DTime myTime);
+                      Crit3DMeteoPoint* meteoPoints, int nrMeteoPoints, Crit3DTime myTime,
+                      Crit3DInterpolator* interpolator = NULL);
     };
 
     bool passDataToInterpolation(Crit3DMeteoPoint* meteoPoints, int nrMeteoPoints);
+    bool passDataToInterpolation(Crit3DInterpolator* interpolator, Crit3DMeteoPoint* meteoPoints, int nrMeteoPoints);
 
     void spatialQualityControl(meteoVariable myVar, Crit3DMeteoPoint* meteoPoints, int nrMeteoPoints);
 
@@ -39,24 +39,98 @@
 #include "header/water.h"
 
 
-Tbalance balanceCurrentTimeStep, balancePreviousTimeStep, balanceCurrentPeriod, balanceWholePeriod;
+inline void doubleTimeStep(TCrit3Dcontext *ctx)
+{
+    ctx->myParameters.current_delta_t *= 2.0;
+    ctx->myParameters.current_delta_t = min_value(ctx->myParameters.current_delta_t, ctx->myParameters.delta_t_max);
+}
+
 
-double bestMBRerror;
-bool isHalfTimeStepForced = false;
-double Courant = 0.0;
+void halveTimeStep(TCrit3Dcontext *ctx)
+{
+    ctx->myParameters.current_delta_t /= 2.0;
+    ctx->myParameters.current_delta_t = max_value(ctx->myParameters.current_delta_t, ctx->myParameters.delta_t_min);
+}
 
 
-inline void doubleTimeStep()
+/*! adaptive time step control */
+#define DT_SAFETY 0.9               /*!< [-] safety factor on the predicted step */
+#define DT_COURANT_TARGET 0.9       /*!< [-] Courant number aimed at */
+#define DT_MAX_GROWTH 2.0           /*!< [-] maximum increase after an accepted step */
+#define DT_MIN_REDUCTION 0.25       /*!< [-] maximum reduction after a rejected step */
+#define DT_EXPONENT_I 0.3           /*!< [-] PI controller: exponent of the current error */
+#define DT_EXPONENT_P 0.2           /*!< [-] PI controller: exponent of the error trend */
+
+
+/*!
+ * \brief predicts the next time step after an accepted step (TIMESTEP_ADAPTIVE).
+ * The mass balance error is driven towards MBRThreshold with a PI control on its trend,
+ * the step is bounded by the Courant number and does not grow if many approximations
+ * or iterations have been needed.
+ * \param deltaT       [s] accepted step
+ * \param approxNr     last approximation
+ * \param MBRerror     [-] mass balance error of the accepted step
+ */
+void adaptTimeStep(TCrit3Dcontext *ctx, double deltaT, int approxNr, double MBRerror)
 {
-    myParameters.current_delta_t *= 2.0;
-    myParameters.current_delta_t = min_value(myParameters.current_delta_t, myParameters.delta_t_max);
+    double threshold = ctx->myParameters.MBRThreshold;
+    double error = max_value(MBRerror / threshold, 0.001);
+    double previousError = (ctx->previousMBRerror > 0.) ? max_value(ctx->previousMBRerror / threshold, 0.001) : error;
+    ctx->previousMBRerror = MBRerror;
+
+    /*! mass balance error and its trend */
+    double factor = DT_SAFETY * pow(error, -DT_EXPONENT_I) * pow(previousError / error, DT_EXPONENT_P);
+
+    /*! Courant number */
+    if (ctx->Courant > 0.)
+        factor = min_value(factor, DT_COURANT_TARGET / ctx->Courant);
+
+    /*! non linear approximations and linear iterations */
+    int maxApproximations = ctx->myParameters.maxApproximationsNumber;
+    if (approxNr >= maxApproximations - 2)
+        factor = min_value(factor, 0.7);
+    else if ((approxNr + 1) > maxApproximations / 2
+             || ctx->waterSolverStatistics.lastIterations > ctx->myParameters.iterazioni_max / 2)
+        factor = min_value(factor, 1.0);
+
+    factor = max_value(min_value(factor, DT_MAX_GROWTH), 0.5);
+
+    /*! a step shortened by the end of the period is not a reason to reduce the next one */
+    double newDeltaT = deltaT * factor;
+    if (deltaT < ctx->myParameters.current_delta_t && factor >= 1.)
+        newDeltaT = max_value(newDeltaT, ctx->myParameters.current_delta_t);
+
+    ctx->myParameters.current_delta_t = max_value(min_value(newDeltaT, ctx->myParameters.delta_t_max),
+                                                  ctx->myParameters.delta_t_min);
 }
 
 
-void halveTimeStep()
+/*!
+ * \brief reduces the time step after a rejected step and counts the rejection
+ * \param cause REJECTED_COURANT, REJECTED_SOLVER or REJECTED_BALANCE
+ */
+void rejectTimeStep(TCrit3Dcontext *ctx, int cause)
 {
-    myParameters.current_delta_t /= 2.0;
-    myParameters.current_delta_t = max_value(myParameters.current_delta_t, myParameters.delta_t_min);
+    if (cause == REJECTED_COURANT) ctx->timeStepStatistics.nrRejectedCourant++;
+    else if (cause == REJECTED_SOLVER) ctx->timeStepStatistics.nrRejectedSolver++;
+    else if (cause == REJECTED_BALANCE) ctx->timeStepStatistics.nrRejectedBalance++;
+
+    if (ctx->myParameters.timeStepControl != TIMESTEP_ADAPTIVE)
+    {
+        halveTimeStep(ctx);
+        return;
+    }
+
+    double factor = 0.5;
+    if (cause == REJECTED_COURANT && ctx->Courant > 0.)
+        factor = DT_COURANT_TARGET / ctx->Courant;
+    else if (cause == REJECTED_BALANCE && ctx->bestMBRerror > 0.)
+        factor = min_value(0.7, DT_SAFETY * sqrt(ctx->myParameters.MBRThreshold / ctx->bestMBRerror));
+
+    factor = max_value(factor, DT_MIN_REDUCTION);
+
+    ctx->myParameters.current_delta_t *= factor;
+    ctx->myParameters.current_delta_t = max_value(ctx->myParameters.current_delta_t, ctx->myParameters.delta_t_min);
 }
 
 
@@ -74,37 +148,37 @@ inline bool link_uguali(long n, TlinkedNode *myLink)
 
 
 
-void InitializeBalanceWater()
+void InitializeBalanceWater(TCrit3Dcontext *ctx)
 {
-     bestMBRerror = 100.;
-
-     balanceWholePeriod.storageWater = computeTotalWaterContent();
-     balanceCurrentTimeStep.storageWater = balanceWholePeriod.storageWater;
-     balancePreviousTimeStep.storageWater = balanceWholePeriod.storageWater;
-     balanceCurrentPeriod.storageWater = balanceWholePeriod.storageWater;
-
-     balanceCurrentTimeStep.sinkSourceWater = 0.;
-     balancePreviousTimeStep.sinkSourceWater = 0.;
-     balanceCurrentTimeStep.waterMBR = 0.;
-     balanceCurrentTimeStep.waterMBE = 0.;
-     balanceCurrentPeriod.sinkSourceWater = 0.;
-     balanceWholePeriod.sinkSourceWater = 0.;
-     balanceWholePeriod.waterMBE = 0.;
-     balanceWholePeriod.waterMBR = 0.;
+     ctx->bestMBRerror = 100.;
+
+     ctx->balanceWholePeriod.storageWater = computeTotalWaterContent(ctx);
+     ctx->balanceCurrentTimeStep.storageWater = ctx->balanceWholePeriod.storageWater;
+     ctx->balancePreviousTimeStep.storageWater = ctx->balanceWholePeriod.storageWater;
+     ctx->balanceCurrentPeriod.storageWater = ctx->balanceWholePeriod.storageWater;
+
+     ctx->balanceCurrentTimeStep.sinkSourceWater = 0.;
+     ctx->balancePreviousTimeStep.sinkSourceWater = 0.;
+     ctx->balanceCurrentTimeStep.waterMBR = 0.;
+     ctx->balanceCurrentTimeStep.waterMBE = 0.;
+     ctx->balanceCurrentPeriod.sinkSourceWater = 0.;
+     ctx->balanceWholePeriod.sinkSourceWater = 0.;
+     ctx->balanceWholePeriod.waterMBE = 0.;
+     ctx->balanceWholePeriod.waterMBR = 0.;
 
     /*! initialize link flow */
-    for (long n = 0; n < myStructure.nrNodes; n++)
+    for (long n = 0; n < ctx->myStructure.nrNodes; n++)
         {
-        myNode[n].up.sumFlow = 0.;
-        myNode[n].down.sumFlow = 0.;
-        for (short i = 0; i < myStructure.nrLateralLinks; i++)
-             myNode[n].lateral[i].sumFlow = 0.;
+        ctx->myNode[n].up.sumFlow = 0.;
+        ctx->myNode[n].down.sumFlow = 0.;
+        for (short i = 0; i < ctx->myStructure.nrLateralLinks; i++)
+             ctx->myNode[n].lateral[i].sumFlow = 0.;
         }
 
     /*! initialize boundary flow */
-    for (long n = 0; n < myStructure.nrNodes; n++)
-        if (myNode[n].boundary != NULL)
-            myNode[n].boundary->sumBoundaryWaterFlow = 0.;
+    for (long n = 0; n < ctx->myStructure.nrNodes; n++)
+        if (ctx->myNode[n].boundary != NULL)
+            ctx->myNode[n].boundary->sumBoundaryWaterFlow = 0.;
 }
 
 
@@ -112,19 +186,19 @@ void InitializeBalanceWater()
  * \brief computes total water content          [m^3]
  * \return result
  */
-double computeTotalWaterContent()
+double computeTotalWaterContent(TCrit3Dcontext *ctx)
 {
    double theta, sum = 0.0;
 
-   for (long i = 0; i < myStructure.nrNodes; i++)
-       if  (myNode[i].isSurface)
+   for (long i = 0; i < ctx->myStructure.nrNodes; i++)
+       if  (ctx->nodeData.isSurface[i])
        {
-           sum += (myNode[i].H - myNode[i].z) * myNode[i].volume_area;
+           sum += (ctx->nodeData.H[i] - ctx->nodeData.z[i]) * ctx->nodeData.volume_area[i];
        }
        else
        {
-           theta = theta_from_Se(i);
-           sum += theta * myNode[i].volume_area;
+           theta = theta_from_Se(ctx, i);
+           sum += theta * ctx->nodeData.volume_area[i];
        }
    return(sum);
 }
@@ -135,48 +209,48 @@ double computeTotalWaterContent()
  * \param deltaT
  * \return result
  */
-double sumWaterFlow(double deltaT)
+double sumWaterFlow(TCrit3Dcontext *ctx, double deltaT)
 {
     double sum = 0.0;
-    for (long n = 0; n < myStructure.nrNodes; n++)
+    for (long n = 0; n < ctx->myStructure.nrNodes; n++)
     {
-        if (myNode[n].Qw != 0.)
-            sum += myNode[n].Qw * deltaT;
+        if (ctx->nodeData.Qw[n] != 0.)
+            sum += ctx->nodeData.Qw[n] * deltaT;
     }
     return (sum);
 }
 
 
 
-void computeMassBalance(double deltaT)
+void computeMassBalance(TCrit3Dcontext *ctx, double deltaT)
 {
-     balanceCurrentTimeStep.storageWater = computeTotalWaterContent();
+     ctx->balanceCurrentTimeStep.storageWater = computeTotalWaterContent(ctx);
 
-	 double dStorage = balanceCurrentTimeStep.storageWater - balancePreviousTimeStep.storageWater;
+	 double dStorage = ctx->balanceCurrentTimeStep.storageWater - ctx->balancePreviousTimeStep.storageWater;
 
-     balanceCurrentTimeStep.sinkSourceWater = sumWaterFlow(deltaT);
+     ctx->balanceCurrentTimeStep.sinkSourceWater = sumWaterFlow(ctx, deltaT);
 
-     balanceCurrentTimeStep.waterMBE = dStorage - balanceCurrentTimeStep.sinkSourceWater;
+     ctx->balanceCurrentTimeStep.waterMBE = dStorage - ctx->balanceCurrentTimeStep.sinkSourceWater;
 
      /*! reference water: sumWaterFlow or 1percent of storage */
-	 double denominator = max_value(fabs(balanceCurrentTimeStep.sinkSourceWater), balanceCurrentTimeStep.storageWater * 1e-2);
+	 double denominator = max_value(fabs(ctx->balanceCurrentTimeStep.sinkSourceWater), ctx->balanceCurrentTimeStep.storageWater * 1e-2);
      /*! no water - minimum 1 liter */
 	 denominator = max_value(denominator, 0.001);
 
-	 balanceCurrentTimeStep.waterMBR = balanceCurrentTimeStep.waterMBE / denominator;
+	 ctx->balanceCurrentTimeStep.waterMBR = ctx->balanceCurrentTimeStep.waterMBE / denominator;
 }
 
 
-double getMatrixValue(long i, TlinkedNode *link)
+double getMatrixValue(TCrit3Dcontext *ctx, long i, TlinkedNode *link)
 {
 	if (link != NULL)
         {
-        int j = 1;
-        while ((j < myStructure.maxNrColumns) && (A[i][j].index != NOLINK) && (A[i][j].index != (*link).index)) j++;
+        long k = ctx->A.rowStart[i] + 1;
+        while ((k < ctx->A.rowStart[i+1]) && (ctx->A.column[k] != (*link).index)) k++;
 
         /*! Rebuild the A elements (previously normalized) */
-		if (A[i][j].index == (*link).index)
-			return (A[i][j].val * A[i][0].val);
+		if (k < ctx->A.rowStart[i+1])
+			return (ctx->A.val[k] * ctx->A.val[ctx->A.rowStart[i]]);
         }
 	return double(INDEX_ERROR);
 }
@@ -188,99 +262,103 @@ double getMatrixValue(long i, TlinkedNode *link)
  * \param link TlinkedNode pointer
  * \param delta_t
  */
-void update_flux(long index, TlinkedNode *link, double delta_t)
+void update_flux(TCrit3Dcontext *ctx, long index, TlinkedNode *link, double delta_t)
 {
     if (link->index != NOLINK)
-        (*link).sumFlow += float(getWaterExchange(index, link, delta_t));
+        (*link).sumFlow += float(getWaterExchange(ctx, index, link, delta_t));
 }
 
 
 
-void saveBestStep()
+void saveBestStep(TCrit3Dcontext *ctx)
 {
-	for (long n = 0; n < myStructure.nrNodes; n++)
-		myNode[n].bestH = myNode[n].H;
+	for (long n = 0; n < ctx->myStructure.nrNodes; n++)
+		ctx->nodeData.bestH[n] = ctx->nodeData.H[n];
 }
 
 
 
 
-void restoreBestStep(double deltaT)
+void restoreBestStep(TCrit3Dcontext *ctx, double deltaT)
 {
-    for (long n = 0; n < myStructure.nrNodes; n++)
+    for (long n = 0; n < ctx->myStructure.nrNodes; n++)
     {
-        myNode[n].H = myNode[n].bestH;
+        ctx->nodeData.H[n] = ctx->nodeData.bestH[n];
 
         /*! compute new soil moisture (only sub-surface nodes) */
-        if (!myNode[n].isSurface)
-                myNode[n].Se = computeSe(n);
+        if (!ctx->nodeData.isSurface[n])
+                ctx->nodeData.Se[n] = computeSe(ctx, n);
     }
 
-     computeMassBalance(deltaT);
+     computeMassBalance(ctx, deltaT);
 }
 
 
-void acceptStep(double deltaT)
+void acceptStep(TCrit3Dcontext *ctx, double deltaT)
 {
+    ctx->timeStepStatistics.nrAccepted++;
+
     /*! update balanceCurrentPeriod and balanceWholePeriod */
-    balancePreviousTimeStep.storageWater = balanceCurrentTimeStep.storageWater;
-    balancePreviousTimeStep.sinkSourceWater = balanceCurrentTimeStep.sinkSourceWater;
-    balanceCurrentPeriod.sinkSourceWater += balanceCurrentTimeStep.sinkSourceWater;
+    ctx->balancePreviousTimeStep.storageWater = ctx->balanceCurrentTimeStep.storageWater;
+    ctx->balancePreviousTimeStep.sinkSourceWater = ctx->balanceCurrentTimeStep.sinkSourceWater;
+    ctx->balanceCurrentPeriod.sinkSourceWater += ctx->balanceCurrentTimeStep.sinkSourceWater;
 
     /*! update sum of flow */
-    for (long i = 0; i < myStructure.nrNodes; i++)
+    for (long i = 0; i < ctx->myStructure.nrNodes; i++)
         {
-		update_flux(i, &(myNode[i].up), deltaT);
-        update_flux(i, &(myNode[i].down), deltaT);
-        for (short j = 0; j < myStructure.nrLateralLinks; j++)
-			update_flux(i, &(myNode[i].lateral[j]), deltaT);
+		update_flux(ctx, i, &(ctx->myNode[i].up), deltaT);
+        update_flux(ctx, i, &(ctx->myNode[i].down), deltaT);
+        for (short j = 0; j < ctx->myStructure.nrLateralLinks; j++)
+			update_flux(ctx, i, &(ctx->myNode[i].lateral[j]), deltaT);
 
-        if (myNode[i].boundary != NULL)
-            myNode[i].boundary->sumBoundaryWaterFlow += myNode[i].boundary->waterFlow * deltaT;
+        if (ctx->myNode[i].boundary != NULL)
+            ctx->myNode[i].boundary->sumBoundaryWaterFlow += ctx->myNode[i].boundary->waterFlow * deltaT;
         }
 
 }
 
-bool waterBalance(double deltaT, int approxNr)
+bool waterBalance(TCrit3Dcontext *ctx, double deltaT, int approxNr)
 {
-	computeMassBalance(deltaT);
-	double MBRerror = fabs(balanceCurrentTimeStep.waterMBR);
+	computeMassBalance(ctx, deltaT);
+	double MBRerror = fabs(ctx->balanceCurrentTimeStep.waterMBR);
 
-	isHalfTimeStepForced = false;
+	ctx->isHalfTimeStepForced = false;
 
     /*! error better than previuosly */
-	if ((approxNr == 0) || (MBRerror < bestMBRerror))
+	if ((approxNr == 0) || (MBRerror < ctx->bestMBRerror))
 	{
-		saveBestStep();
-		bestMBRerror = MBRerror;
+		saveBestStep(ctx);
+		ctx->bestMBRerror = MBRerror;
 	}
 
     /*! best case */
-    if (MBRerror < myParameters.MBRThreshold)
+    if (MBRerror < ctx->myParameters.MBRThreshold)
         {
-        acceptStep(deltaT);
-		if ((approxNr < 2) && (Courant < 0.5) && (MBRerror < (myParameters.MBRThreshold * 0.5)))
+        acceptStep(ctx, deltaT);
+        if (ctx->myParameters.timeStepControl == TIMESTEP_ADAPTIVE)
+            adaptTimeStep(ctx, deltaT, approxNr, MBRerror);
+		else if ((approxNr < 2) && (ctx->Courant < 0.5) && (MBRerror < (ctx->myParameters.MBRThreshold * 0.5)))
             {
             /*! system is stable: double time step */
-            doubleTimeStep();
+            doubleTimeStep(ctx);
             }
         return (true);
         }
 
     /*! worst case: error high or last approximation */
-    if ((MBRerror > (bestMBRerror * 2.0))
-        ||(approxNr == (myParameters.maxApproximationsNumber-1)))
+    if ((MBRerror > (ctx->bestMBRerror * 2.0))
+        ||(approxNr == (ctx->myParameters.maxApproximationsNumber-1)))
         {
-        if (deltaT > myParameters.delta_t_min)
+        if (deltaT > ctx->myParameters.delta_t_min)
             {
-            halveTimeStep();
-            isHalfTimeStepForced = true;
+            rejectTimeStep(ctx, REJECTED_BALANCE);
+            ctx->isHalfTimeStepForced = true;
             return (false);
             }
         else
             {
-            restoreBestStep(deltaT);
-            acceptStep(deltaT);
+            restoreBestStep(ctx, deltaT);
+            acceptStep(ctx, deltaT);
             return (true);
             }
         }
@@ -291,36 +369,36 @@ bool waterBalance(double deltaT, int approxNr)
 
 
 
-void updateBalanceWaterWholePeriod()
+void updateBalanceWaterWholePeriod(TCrit3Dcontext *ctx)
 {
     /*! update the flows in the balance (balanceWholePeriod) */
-    balanceWholePeriod.sinkSourceWater  += balanceCurrentPeriod.sinkSourceWater;
+    ctx->balanceWholePeriod.sinkSourceWater  += ctx->balanceCurrentPeriod.sinkSourceWater;
 
-    double deltaStoragePeriod = balanceCurrentTimeStep.storageWater - balanceCurrentPeriod.storageWater;
+    double deltaStoragePeriod = ctx->balanceCurrentTimeStep.storageWater - ctx->balanceCurrentPeriod.storageWater;
 
-    double deltaStorageHistorical = balanceCurrentTimeStep.storageWater - balanceWholePeriod.storageWater;
+    double deltaStorageHistorical = ctx->balanceCurrentTimeStep.storageWater - ctx->balanceWholePeriod.storageWater;
 
     /*! compute waterMBE and waterMBR */
-    balanceCurrentPeriod.waterMBE = fabs(deltaStoragePeriod - balanceCurrentPeriod.sinkSourceWater);
-    if ((balanceWholePeriod.storageWater == 0.) && (balanceWholePeriod.sinkSourceWater == 0.)) balanceWholePeriod.waterMBR = 1.;
-    else if (balanceCurrentTimeStep.storageWater > fabs(balanceWholePeriod.sinkSourceWater))
-        balanceWholePeriod.waterMBR = balanceCurrentTimeStep.storageWater / (balanceWholePeriod.storageWater + balanceWholePeriod.sinkSourceWater);
+    ctx->balanceCurrentPeriod.waterMBE = fabs(deltaStoragePeriod - ctx->balanceCurrentPeriod.sinkSourceWater);
+    if ((ctx->balanceWholePeriod.storageWater == 0.) && (ctx->balanceWholePeriod.sinkSourceWater == 0.)) ctx->balanceWholePeriod.waterMBR = 1.;
+    else if (ctx->balanceCurrentTimeStep.storageWater > fabs(ctx->balanceWholePeriod.sinkSourceWater))
+        ctx->balanceWholePeriod.waterMBR = ctx->balanceCurrentTimeStep.storageWater / (ctx->balanceWholePeriod.storageWater + ctx->balanceWholePeriod.sinkSourceWater);
     else
-        balanceWholePeriod.waterMBR = deltaStorageHistorical / balanceWholePeriod.sinkSourceWater;
+        ctx->balanceWholePeriod.waterMBR = deltaStorageHistorical / ctx->balanceWholePeriod.sinkSourceWater;
 
     /*! update storageWater in balanceCurrentPeriod */
-    balanceCurrentPeriod.storageWater = balanceCurrentTimeStep.storageWater;
+    ctx->balanceCurrentPeriod.storageWater = ctx->balanceCurrentTimeStep.storageWater;
 }
 
 
 
-bool getForcedHalvedTime()
+bool getForcedHalvedTime(TCrit3Dcontext *ctx)
 {
-    return (isHalfTimeStepForced);
+    return (ctx->isHalfTimeStepForced);
 }
 
-void setForcedHalvedTime(bool isForced)
+void setForcedHalvedTime(TCrit3Dcontext *ctx, bool isForced)
 {
-    isHalfTimeStepForced = isForced;
+    ctx->isHalfTimeStepForced = isForced;
 }
 
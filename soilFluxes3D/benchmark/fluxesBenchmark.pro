@@ -0,0 +1,21 @@
+#-------------------------------------------------
+#
+# CRITERIA3D
+# soilFluxes3D water flow benchmark
+#
+#-------------------------------------------------
+
+QT       -= gui
+
+TARGET = fluxesBenchmark
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+INCLUDEPATH += ../../mathFunctions ../header
+
+LIBS += -L../debug -lsoilFluxes3D
+LIBS += -L../../mathFunctions/debug -lmathFunctions
+!win32-msvc*: LIBS += -fopenmp
+
+SOURCES += main.cpp
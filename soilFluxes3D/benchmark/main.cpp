@@ -0,0 +1,154 @@
+/*!
+    \name fluxesBenchmark
+    \brief time per simulated hour of the water flow on a synthetic hillslope grid
+    (nrCells x nrCells columns of nrLayers nodes, rain in the first half of the period)
+
+    usage: fluxesBenchmark [nrCells] [nrLayers] [nrHours] [nrThreads]
+
+    The benchmark uses only the global API of soilFluxes3D: the same source can be built
+    on different versions of the library to compare them (time and final water content)
+
+    This file is part of CRITERIA3D.
+    CRITERIA3D has been developed under contract issued by A.R.P.A. Emilia-Romagna
+
+    CRITERIA3D is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CRITERIA3D is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with CRITERIA3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+
+#include "commonConstants.h"
+#include "soilFluxes3D.h"
+
+using namespace std;
+using namespace soilFluxes3D;
+
+#define CELL_SIZE 10.            // [m]
+#define RAIN_INTENSITY 10.       // [mm h-1]
+
+
+int main(int argc, char *argv[])
+{
+    int nrCells = (argc > 1) ? atoi(argv[1]) : 200;
+    int nrLayers = (argc > 2) ? atoi(argv[2]) : 12;
+    int nrHours = (argc > 3) ? atoi(argv[3]) : 2;
+    int nrThreads = (argc > 4) ? atoi(argv[4]) : 1;
+    if (nrCells < 2 || nrLayers < 3 || nrHours < 1 || nrThreads < 1)
+    {
+        printf("usage: fluxesBenchmark [nrCells] [nrLayers] [nrHours] [nrThreads]\n");
+        return 1;
+    }
+
+    long layerNodes = long(nrCells) * nrCells;
+    long nrNodes = layerNodes * nrLayers;
+
+    if (initialize(nrNodes, nrLayers, 8, true, false, false) != CRIT3D_OK)
+    {
+        printf("error in initialize\n");
+        return 1;
+    }
+    setNumericalParameters(30, 1800, 100, 10, 12, 2, nrThreads);
+    setHydraulicProperties(MODIFIEDVANGENUCHTEN, MEAN_LOGARITHMIC, 10);
+    setSoilProperties(0, 0, 1.2, 1.4, 1 - 1/1.4, 0.01, 0.05, 0.45, 1e-6, 0.5, 2.0, 30);
+    setSoilProperties(0, 1, 2.0, 1.6, 1 - 1/1.6, 0.01, 0.04, 0.40, 5e-6, 0.5, 1.0, 20);
+    setSurfaceProperties(0, 0.24, 0.002);
+
+    // layer thickness increasing with depth [m]
+    double* depth = (double *) calloc(unsigned(nrLayers), sizeof(double));
+    double* thickness = (double *) calloc(unsigned(nrLayers), sizeof(double));
+    double bottom = 0;
+    for (int layer = 1; layer < nrLayers; layer++)
+    {
+        thickness[layer] = 0.05 * layer;
+        depth[layer] = bottom + thickness[layer] / 2;
+        bottom += thickness[layer];
+    }
+
+    for (int row = 0; row < nrCells; row++)
+        for (int col = 0; col < nrCells; col++)
+        {
+            long surfaceIndex = row * nrCells + col;
+            float x = float(col * CELL_SIZE);
+            float y = float(row * CELL_SIZE);
+            double z = 100 + 0.02 * y + 0.01 * x + 0.5 * sin(row * 0.3) * cos(col * 0.2);
+            bool isEdge = (row == 0 || col == 0 || row == nrCells-1 || col == nrCells-1);
+
+            for (int layer = 0; layer < nrLayers; layer++)
+            {
+                long index = layer * layerNodes + surfaceIndex;
+                float nodeZ = float(z - depth[layer]);
+
+                if (layer == 0)
+                    setNode(index, x, y, nodeZ, CELL_SIZE * CELL_SIZE, true, isEdge,
+                            isEdge ? BOUNDARY_RUNOFF : BOUNDARY_NONE, 0.02f);
+                else if (layer == nrLayers-1)
+                    setNode(index, x, y, nodeZ, CELL_SIZE * CELL_SIZE * thickness[layer], false, true,
+                            BOUNDARY_FREEDRAINAGE, 0);
+                else
+                    setNode(index, x, y, nodeZ, CELL_SIZE * CELL_SIZE * thickness[layer], false, isEdge,
+                            isEdge ? BOUNDARY_FREELATERALDRAINAGE : BOUNDARY_NONE, 0.02f);
+
+                if (layer > 0) setNodeLink(index, index - layerNodes, UP, float(CELL_SIZE * CELL_SIZE));
+                if (layer < nrLayers-1) setNodeLink(index, index + layerNodes, DOWN, float(CELL_SIZE * CELL_SIZE));
+
+                double lateralArea = (layer == 0) ? CELL_SIZE : CELL_SIZE * thickness[layer];
+                for (int i = -1; i <= 1; i++)
+                    for (int j = -1; j <= 1; j++)
+                        if ((i != 0 || j != 0) && row+i >= 0 && row+i < nrCells && col+j >= 0 && col+j < nrCells)
+                            setNodeLink(index, layer * layerNodes + (row+i) * nrCells + col+j, LATERAL, float(lateralArea / 2));
+
+                if (layer == 0)
+                    setNodeSurface(index, 0);
+                else
+                    setNodeSoil(index, 0, (layer < nrLayers/2) ? 0 : 1);
+            }
+        }
+
+    for (long i = 0; i < layerNodes; i++)
+    {
+        setWaterContent(i, 0);
+        for (int layer = 1; layer < nrLayers; layer++)
+            setMatricPotential(layer * layerNodes + i, -3.0 - 0.5 * layer);
+    }
+
+    free(depth);
+    free(thickness);
+    initializeBalance();
+
+    printf("nodes: %ld  hours: %d  threads: %d\n", nrNodes, nrHours, nrThreads);
+    printf("hour  time [s]  water MBR  total water content [m3]\n");
+
+    double totalTime = 0;
+    for (int hour = 0; hour < nrHours; hour++)
+    {
+        // rain in the first half of the period [m3 s-1]
+        double rain = (hour < (nrHours+1) / 2) ? RAIN_INTENSITY * 0.001 / 3600. * CELL_SIZE * CELL_SIZE : 0;
+        for (long i = 0; i < layerNodes; i++)
+            setWaterSinkSource(i, rain);
+
+        chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+        computePeriod(3600);
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - t0;
+        totalTime += elapsed.count();
+
+        printf("%4d  %8.3f  %9.2e  %.6f\n", hour, elapsed.count(), getWaterMBR(), getTotalWaterContent());
+    }
+
+    printf("seconds per simulated hour: %.3f\n", totalTime / nrHours);
+
+    cleanMemory();
+    return 0;
+}
@@ -40,7 +40,7 @@
 
 #include <iostream>
 
-void initializeBoundary(Tboundary *myBoundary, int myType, float slope)
+void initializeBoundary(TCrit3Dcontext *ctx, Tboundary *myBoundary, int myType, float slope)
 {
 	(*myBoundary).type = myType;
 	(*myBoundary).slope = slope;
@@ -48,7 +48,7 @@ void initializeBoundary(Tboundary *myBoundary, int myType, float slope)
     (*myBoundary).sumBoundaryWaterFlow = 0;
 	(*myBoundary).prescribedTotalPotential = NODATA;
 
-    if (myStructure.computeHeat)
+    if (ctx->myStructure.computeHeat)
     {
         (*myBoundary).Heat = new(TboundaryHeat);
 
@@ -96,18 +96,18 @@ double computeSoilSurfaceResistanceCG(double theta, double thetaSat)
  * \param i
  * \return latent heat (W m-2)
  */
-double computeAtmosphericSensibleFlux(long i)
+double computeAtmosphericSensibleFlux(TCrit3Dcontext *ctx, long i)
 {
-    if (myNode[i].boundary->Heat == NULL || ! myNode[myNode[i].up.index].isSurface)
+    if (ctx->myNode[i].boundary->Heat == NULL || ! ctx->nodeData.isSurface[ctx->myNode[i].up.index])
         return 0;
 
-    double myPressure = PressureFromAltitude(myNode[i].z);
+    double myPressure = PressureFromAltitude(ctx->nodeData.z[i]);
 
-    double myDeltaT = myNode[i].boundary->Heat->temperature - myNode[i].extra->Heat->T;
+    double myDeltaT = ctx->myNode[i].boundary->Heat->temperature - ctx->myNode[i].extra->Heat->T;
 
-    double myCvAir = AirVolumetricSpecificHeat(myPressure, myNode[i].boundary->Heat->temperature);
+    double myCvAir = AirVolumetricSpecificHeat(myPressure, ctx->myNode[i].boundary->Heat->temperature);
 
-    return (myCvAir * myDeltaT * myNode[i].boundary->Heat->aerodynamicConductance);
+    return (myCvAir * myDeltaT * ctx->myNode[i].boundary->Heat->aerodynamicConductance);
 }
 
 /*!
@@ -115,22 +115,22 @@ double computeAtmosphericSensibleFlux(long i)
  * \param i
  * \return vapor flux (kg m-2 s-1)
  */
-double computeAtmosphericLatentFlux(long i)
+double computeAtmosphericLatentFlux(TCrit3Dcontext *ctx, long i)
 {
-    if (myNode[i].boundary->Heat == NULL || ! myNode[myNode[i].up.index].isSurface)
+    if (ctx->myNode[i].boundary->Heat == NULL || ! ctx->nodeData.isSurface[ctx->myNode[i].up.index])
         return 0;
 
     double PressSat, ConcVapSat, BoundaryVapor;
 
-    PressSat = SaturationVaporPressure(myNode[i].boundary->Heat->temperature - ZEROCELSIUS);
-    ConcVapSat = VaporConcentrationFromPressure(PressSat, myNode[i].boundary->Heat->temperature);
-    BoundaryVapor = ConcVapSat * (myNode[i].boundary->Heat->relativeHumidity / 100.);
+    PressSat = SaturationVaporPressure(ctx->myNode[i].boundary->Heat->temperature - ZEROCELSIUS);
+    ConcVapSat = VaporConcentrationFromPressure(PressSat, ctx->myNode[i].boundary->Heat->temperature);
+    BoundaryVapor = ConcVapSat * (ctx->myNode[i].boundary->Heat->relativeHumidity / 100.);
 
     // kg m-3
-    double myDeltaVapor = BoundaryVapor - soilFluxes3D::getNodeVapor(i);
+    double myDeltaVapor = BoundaryVapor - soilFluxes3D::getNodeVapor(ctx, i);
 
     // m s-1
-    double myTotalConductance = 1./((1./myNode[i].boundary->Heat->aerodynamicConductance) + (1. / myNode[i].boundary->Heat->soilConductance));
+    double myTotalConductance = 1./((1./ctx->myNode[i].boundary->Heat->aerodynamicConductance) + (1. / ctx->myNode[i].boundary->Heat->soilConductance));
 
     // kg m-2 s-1
     double myVaporFlow = myDeltaVapor * myTotalConductance;
@@ -143,28 +143,28 @@ double computeAtmosphericLatentFlux(long i)
  * \param i
  * \return vapor flux (kg m-2 s-1)
  */
-double computeAtmosphericLatentFluxSurfaceWater(long i)
+double computeAtmosphericLatentFluxSurfaceWater(TCrit3Dcontext *ctx, long i)
 {
-    if (! myNode[i].isSurface) return 0.;
-    if (&(myNode[i].down) == NULL) return 0.;
+    if (! ctx->nodeData.isSurface[i]) return 0.;
+    if (&(ctx->myNode[i].down) == NULL) return 0.;
 
-    long downIndex = myNode[i].down.index;
+    long downIndex = ctx->myNode[i].down.index;
 
-    if (myNode[downIndex].boundary->Heat == NULL || myNode[downIndex].boundary->type != BOUNDARY_HEAT_SURFACE) return 0.;
+    if (ctx->myNode[downIndex].boundary->Heat == NULL || ctx->myNode[downIndex].boundary->type != BOUNDARY_HEAT_SURFACE) return 0.;
 
     double PressSat, ConcVapSat, BoundaryVapor;
 
     // atmospheric vapor content (kg m-3)
-    PressSat = SaturationVaporPressure(myNode[downIndex].boundary->Heat->temperature - ZEROCELSIUS);
-    ConcVapSat = VaporConcentrationFromPressure(PressSat, myNode[downIndex].boundary->Heat->temperature);
-    BoundaryVapor = ConcVapSat * (myNode[downIndex].boundary->Heat->relativeHumidity / 100.);
+    PressSat = SaturationVaporPressure(ctx->myNode[downIndex].boundary->Heat->temperature - ZEROCELSIUS);
+    ConcVapSat = VaporConcentrationFromPressure(PressSat, ctx->myNode[downIndex].boundary->Heat->temperature);
+    BoundaryVapor = ConcVapSat * (ctx->myNode[downIndex].boundary->Heat->relativeHumidity / 100.);
 
     // surface water vapor content (kg m-3) (assuming water temperature is the same of atmosphere)
     double myDeltaVapor = BoundaryVapor - ConcVapSat;
 
     // kg m-2 s-1
     // using aerodynamic conductance of index below (boundary for heat)
-    double myVaporFlow = myDeltaVapor * myNode[downIndex].boundary->Heat->aerodynamicConductance;
+    double myVaporFlow = myDeltaVapor * ctx->myNode[downIndex].boundary->Heat->aerodynamicConductance;
 
     return myVaporFlow;
 }
@@ -174,247 +174,247 @@ double computeAtmosphericLatentFluxSurfaceWater(long i)
  * \param i
  * \return latent flux (W)
  */
-double computeAtmosphericLatentHeatFlux(long i)
+double computeAtmosphericLatentHeatFlux(TCrit3Dcontext *ctx, long i)
 {
-    if (myNode[i].boundary->Heat == NULL || ! myNode[myNode[i].up.index].isSurface)
+    if (ctx->myNode[i].boundary->Heat == NULL || ! ctx->nodeData.isSurface[ctx->myNode[i].up.index])
         return 0;
 
     double latentHeatFlow = 0.;
 
     // J kg-1
-    double lambda = LatentHeatVaporization(myNode[i].extra->Heat->T - ZEROCELSIUS);
+    double lambda = LatentHeatVaporization(ctx->myNode[i].extra->Heat->T - ZEROCELSIUS);
     // waterFlow: vapor sink source (m3 s-1)
-    latentHeatFlow = myNode[i].boundary->waterFlow * WATER_DENSITY * lambda;
+    latentHeatFlow = ctx->myNode[i].boundary->waterFlow * WATER_DENSITY * lambda;
 
     return latentHeatFlow;
 }
 
-double getSurfaceWaterFraction(int i)
+double getSurfaceWaterFraction(TCrit3Dcontext *ctx, int i)
 {
-    if (! myNode[i].isSurface)
+    if (! ctx->nodeData.isSurface[i])
         return 0.0;
     else
     {
-        double h = max_value(myNode[i].H - myNode[i].z, 0.0);
-        return 1.0 - max_value(0.0, myNode[i].Soil->Pond - h) / myNode[i].Soil->Pond;
+        double h = max_value(ctx->nodeData.H[i] - ctx->nodeData.z[i], 0.0);
+        return 1.0 - max_value(0.0, ctx->myNode[i].Soil->Pond - h) / ctx->myNode[i].Soil->Pond;
     }
 }
 
-void updateBoundary()
+void updateBoundary(TCrit3Dcontext *ctx)
 {
-    for (long i = 0; i < myStructure.nrNodes; i++)
-        if (myNode[i].boundary != NULL)
-            if (myStructure.computeHeat)
-                if (myNode[i].extra->Heat != NULL)
-                    if (myNode[i].boundary->type == BOUNDARY_HEAT_SURFACE)
+    for (long i = 0; i < ctx->myStructure.nrNodes; i++)
+        if (ctx->myNode[i].boundary != NULL)
+            if (ctx->myStructure.computeHeat)
+                if (ctx->myNode[i].extra->Heat != NULL)
+                    if (ctx->myNode[i].boundary->type == BOUNDARY_HEAT_SURFACE)
                     {
                         // update aerodynamic conductance
-                        myNode[i].boundary->Heat->aerodynamicConductance =
-                                AerodynamicConductance(myNode[i].boundary->Heat->heightTemperature,
-                                    myNode[i].boundary->Heat->heightWind,
-                                    myNode[i].extra->Heat->T,
-                                    myNode[i].boundary->Heat->roughnessHeight,
-                                    myNode[i].boundary->Heat->temperature,
-                                    myNode[i].boundary->Heat->windSpeed);
-
-                        if (myStructure.computeWater)
+                        ctx->myNode[i].boundary->Heat->aerodynamicConductance =
+                                AerodynamicConductance(ctx->myNode[i].boundary->Heat->heightTemperature,
+                                    ctx->myNode[i].boundary->Heat->heightWind,
+                                    ctx->myNode[i].extra->Heat->T,
+                                    ctx->myNode[i].boundary->Heat->roughnessHeight,
+                                    ctx->myNode[i].boundary->Heat->temperature,
+                                    ctx->myNode[i].boundary->Heat->windSpeed);
+
+                        if (ctx->myStructure.computeWater)
                             // update soil surface conductance
                         {
-                            double theta = theta_from_sign_Psi(myNode[i].H - myNode[i].z, i);
-                            myNode[i].boundary->Heat->soilConductance = 1./ computeSoilSurfaceResistance(theta);
+                            double theta = theta_from_sign_Psi(ctx, ctx->nodeData.H[i] - ctx->nodeData.z[i], i);
+                            ctx->myNode[i].boundary->Heat->soilConductance = 1./ computeSoilSurfaceResistance(theta);
                         }
                     }
 }
 
 
-void updateBoundaryWater(double deltaT)
+void updateBoundaryWater(TCrit3Dcontext *ctx, double deltaT)
 {
     double boundaryPsi, boundarySe, boundaryK, meanK;
     double const EPSILON_mm = 0.0001;          //0.1 mm
     double area, boundarySide, boundaryArea, Hs, avgH, maxFlow, flow;
 
-    for (long i = 0; i < myStructure.nrNodes; i++)
+    for (long i = 0; i < ctx->myStructure.nrNodes; i++)
     {
         // extern sink/source
-        myNode[i].Qw = myNode[i].waterSinkSource;
+        ctx->nodeData.Qw[i] = ctx->nodeData.waterSinkSource[i];
 
-        if (myNode[i].boundary != NULL)
+        if (ctx->myNode[i].boundary != NULL)
         {
             // initialize
-            myNode[i].boundary->waterFlow = 0.;
-            if (myNode[i].boundary->type == BOUNDARY_RUNOFF)
+            ctx->myNode[i].boundary->waterFlow = 0.;
+            if (ctx->myNode[i].boundary->type == BOUNDARY_RUNOFF)
             {
                 // current surface water available to runoff [m]
-                avgH = (myNode[i].H + myNode[i].oldH) * 0.5;
-                Hs = max_value(avgH - (myNode[i].z + myNode[i].Soil->Pond), 0.0);
+                avgH = (ctx->nodeData.H[i] + ctx->nodeData.oldH[i]) * 0.5;
+                Hs = max_value(avgH - (ctx->nodeData.z[i] + ctx->myNode[i].Soil->Pond), 0.0);
                 if (Hs > EPSILON_mm)
                 {
-                    area = myNode[i].volume_area;       //  [m^2] (surface)
+                    area = ctx->nodeData.volume_area[i];       //  [m^2] (surface)
                     boundarySide = sqrt(area);          //  [m] approximation: side = sqrt(area)
                     maxFlow = (Hs * area) / deltaT;     //  [m^3 s^-1] max available flow in time step
                     boundaryArea = boundarySide * Hs;   //  [m^2]
                     // [m^3 s^-1] Manning
-                    flow = boundaryArea *(pow(Hs, (2./3.)) / myNode[i].Soil->Roughness) * sqrt(myNode[i].boundary->slope);
-                    myNode[i].boundary->waterFlow = -min_value(flow, maxFlow);
+                    flow = boundaryArea *(pow(Hs, (2./3.)) / ctx->myNode[i].Soil->Roughness) * sqrt(ctx->myNode[i].boundary->slope);
+                    ctx->myNode[i].boundary->waterFlow = -min_value(flow, maxFlow);
                 }
             }
-            else if (myNode[i].boundary->type == BOUNDARY_FREEDRAINAGE)
+            else if (ctx->myNode[i].boundary->type == BOUNDARY_FREEDRAINAGE)
             {
                 // [m^3 s^-1] Darcy unit gradient
                 // dH=dz=L  ->  q=K(h)
-                double myFlux = -myNode[i].k * myNode[i].up.area;
-                myNode[i].boundary->waterFlow = myFlux;               
+                double myFlux = -ctx->nodeData.k[i] * ctx->myNode[i].up.area;
+                ctx->myNode[i].boundary->waterFlow = myFlux;               
             }
 
-            else if (myNode[i].boundary->type == BOUNDARY_FREELATERALDRAINAGE)
+            else if (ctx->myNode[i].boundary->type == BOUNDARY_FREELATERALDRAINAGE)
             {
                 // TODO approximation: boundary area equal to other lateral link
-				area = myNode[i].lateral[0].area;
+				area = ctx->myNode[i].lateral[0].area;
                 // [m^3 s^-1] Darcy,  gradient = slope (dH=dz)
-                myNode[i].boundary->waterFlow = -myNode[i].k * area * myNode[i].boundary->slope
-                                            * myParameters.k_lateral_vertical_ratio;
+                ctx->myNode[i].boundary->waterFlow = -ctx->nodeData.k[i] * area * ctx->myNode[i].boundary->slope
+                                            * ctx->myParameters.k_lateral_vertical_ratio;
             }
 
-            else if (myNode[i].boundary->type == BOUNDARY_PRESCRIBEDTOTALPOTENTIAL)
+            else if (ctx->myNode[i].boundary->type == BOUNDARY_PRESCRIBEDTOTALPOTENTIAL)
             {
-                if (myNode[i].boundary->prescribedTotalPotential >= myNode[i].z)
-                    boundaryK = myNode[i].Soil->K_sat;
+                if (ctx->myNode[i].boundary->prescribedTotalPotential >= ctx->nodeData.z[i])
+                    boundaryK = ctx->myNode[i].Soil->K_sat;
                 else
                 {
-                    boundaryPsi = fabs(myNode[i].boundary->prescribedTotalPotential - myNode[i].z);
-                    boundarySe = computeSefromPsi(boundaryPsi, myNode[i].Soil);
-                    boundaryK = computeWaterConductivity(boundarySe, myNode[i].Soil);
+                    boundaryPsi = fabs(ctx->myNode[i].boundary->prescribedTotalPotential - ctx->nodeData.z[i]);
+                    boundarySe = computeSefromPsi(ctx, boundaryPsi, ctx->myNode[i].Soil);
+                    boundaryK = computeWaterConductivity(ctx, boundarySe, ctx->myNode[i].Soil);
                 }
-                meanK = computeMean(myNode[i].k, boundaryK);
-                myNode[i].boundary->waterFlow = meanK * (myNode[i].boundary->prescribedTotalPotential - myNode[i].H) * myNode[i].up.area;
+                meanK = computeMean(ctx, ctx->nodeData.k[i], boundaryK);
+                ctx->myNode[i].boundary->waterFlow = meanK * (ctx->myNode[i].boundary->prescribedTotalPotential - ctx->nodeData.H[i]) * ctx->myNode[i].up.area;
             }
 
-            else if (myNode[i].boundary->type == BOUNDARY_HEAT_SURFACE)
+            else if (ctx->myNode[i].boundary->type == BOUNDARY_HEAT_SURFACE)
             {
 
-                if (myStructure.computeHeat && myStructure.computeHeatVapor)
+                if (ctx->myStructure.computeHeat && ctx->myStructure.computeHeatVapor)
                 {
                     long upIndex;
 
                     double surfaceWaterFraction = 0.;
-                    if (&(myNode[i].up) != NULL)
+                    if (&(ctx->myNode[i].up) != NULL)
                     {
-                        upIndex = myNode[i].up.index;
-                        surfaceWaterFraction = getSurfaceWaterFraction(upIndex);
+                        upIndex = ctx->myNode[i].up.index;
+                        surfaceWaterFraction = getSurfaceWaterFraction(ctx, upIndex);
                     }
 
-                    double evapFromSoil = computeAtmosphericLatentFlux(i) / WATER_DENSITY * myNode[i].up.area;
+                    double evapFromSoil = computeAtmosphericLatentFlux(ctx, i) / WATER_DENSITY * ctx->myNode[i].up.area;
 
                     // surface water
                     if (surfaceWaterFraction > 0.)
                     {
-                        double waterVolume = (myNode[upIndex].H - myNode[upIndex].z) * myNode[upIndex].volume_area;
-                        double evapFromSurface = computeAtmosphericLatentFluxSurfaceWater(upIndex) / WATER_DENSITY * myNode[i].up.area;
+                        double waterVolume = (ctx->nodeData.H[upIndex] - ctx->nodeData.z[upIndex]) * ctx->nodeData.volume_area[upIndex];
+                        double evapFromSurface = computeAtmosphericLatentFluxSurfaceWater(ctx, upIndex) / WATER_DENSITY * ctx->myNode[i].up.area;
 
                         evapFromSoil *= (1. - surfaceWaterFraction);
                         evapFromSurface *= surfaceWaterFraction;
 
                         evapFromSurface = max_value(evapFromSurface, -waterVolume / deltaT);
 
-                        if (myNode[upIndex].boundary != NULL)
-                            myNode[upIndex].boundary->waterFlow = evapFromSurface;
+                        if (ctx->myNode[upIndex].boundary != NULL)
+                            ctx->myNode[upIndex].boundary->waterFlow = evapFromSurface;
                         else
-                            myNode[upIndex].Qw += evapFromSurface;
+                            ctx->nodeData.Qw[upIndex] += evapFromSurface;
 
                     }
 
                     if (evapFromSoil < 0.)
-                        evapFromSoil = max_value(evapFromSoil, -(theta_from_Se(i) - myNode[i].Soil->Theta_r) * myNode[i].volume_area / deltaT);
+                        evapFromSoil = max_value(evapFromSoil, -(theta_from_Se(ctx, i) - ctx->myNode[i].Soil->Theta_r) * ctx->nodeData.volume_area[i] / deltaT);
                     else
-                        evapFromSoil = min_value(evapFromSoil, (myNode[i].Soil->Theta_s - myNode[i].Soil->Theta_r) * myNode[i].volume_area / deltaT);
+                        evapFromSoil = min_value(evapFromSoil, (ctx->myNode[i].Soil->Theta_s - ctx->myNode[i].Soil->Theta_r) * ctx->nodeData.volume_area[i] / deltaT);
 
-                    myNode[i].boundary->waterFlow = evapFromSoil;
+                    ctx->myNode[i].boundary->waterFlow = evapFromSoil;
                 }
             }            
 
-            myNode[i].Qw += myNode[i].boundary->waterFlow;
+            ctx->nodeData.Qw[i] += ctx->myNode[i].boundary->waterFlow;
         }
     }
 }
 
 
-void updateBoundaryHeat()
+void updateBoundaryHeat(TCrit3Dcontext *ctx)
 {
     double myWaterFlux, advTemperature, heatFlux;
 
-    for (long i = 1; i < myStructure.nrNodes; i++)
+    for (long i = 1; i < ctx->myStructure.nrNodes; i++)
     {
-        if (isHeatNode(i))
+        if (isHeatNode(ctx, i))
         {
-            myNode[i].extra->Heat->Qh = myNode[i].extra->Heat->sinkSource;
+            ctx->myNode[i].extra->Heat->Qh = ctx->myNode[i].extra->Heat->sinkSource;
 
-            if (myNode[i].boundary != NULL)
+            if (ctx->myNode[i].boundary != NULL)
             {
-                if (myNode[i].boundary->type == BOUNDARY_HEAT_SURFACE)
+                if (ctx->myNode[i].boundary->type == BOUNDARY_HEAT_SURFACE)
                 {
-                    myNode[i].boundary->Heat->advectiveHeatFlux = 0.;
-                    myNode[i].boundary->Heat->sensibleFlux = 0.;
-                    myNode[i].boundary->Heat->latentFlux = 0.;
-                    myNode[i].boundary->Heat->radiativeFlux = 0.;
+                    ctx->myNode[i].boundary->Heat->advectiveHeatFlux = 0.;
+                    ctx->myNode[i].boundary->Heat->sensibleFlux = 0.;
+                    ctx->myNode[i].boundary->Heat->latentFlux = 0.;
+                    ctx->myNode[i].boundary->Heat->radiativeFlux = 0.;
 
-                    if (myNode[i].boundary->Heat->netIrradiance != NODATA)
-                        myNode[i].boundary->Heat->radiativeFlux = myNode[i].boundary->Heat->netIrradiance;
+                    if (ctx->myNode[i].boundary->Heat->netIrradiance != NODATA)
+                        ctx->myNode[i].boundary->Heat->radiativeFlux = ctx->myNode[i].boundary->Heat->netIrradiance;
 
-                    myNode[i].boundary->Heat->sensibleFlux += computeAtmosphericSensibleFlux(i);
+                    ctx->myNode[i].boundary->Heat->sensibleFlux += computeAtmosphericSensibleFlux(ctx, i);
 
-                    if (myStructure.computeWater && myStructure.computeHeatVapor)
-                        myNode[i].boundary->Heat->latentFlux += computeAtmosphericLatentHeatFlux(i) / myNode[i].up.area;
+                    if (ctx->myStructure.computeWater && ctx->myStructure.computeHeatVapor)
+                        ctx->myNode[i].boundary->Heat->latentFlux += computeAtmosphericLatentHeatFlux(ctx, i) / ctx->myNode[i].up.area;
 
-                    if (myStructure.computeWater && myStructure.computeHeatAdvection)
+                    if (ctx->myStructure.computeWater && ctx->myStructure.computeHeatAdvection)
                     {
                         // advective heat from rain
-                        myWaterFlux = myNode[i].up.linkedExtra->heatFlux->waterFlux;
+                        myWaterFlux = ctx->myNode[i].up.linkedExtra->heatFlux->waterFlux;
                         if (myWaterFlux > 0.)
                         {
-                            advTemperature = myNode[i].boundary->Heat->temperature;
-                            heatFlux =  myWaterFlux * HEAT_CAPACITY_WATER * advTemperature / myNode[i].up.area;
-                            myNode[i].boundary->Heat->advectiveHeatFlux += heatFlux;
+                            advTemperature = ctx->myNode[i].boundary->Heat->temperature;
+                            heatFlux =  myWaterFlux * HEAT_CAPACITY_WATER * advTemperature / ctx->myNode[i].up.area;
+                            ctx->myNode[i].boundary->Heat->advectiveHeatFlux += heatFlux;
                         }
 
                         // advective heat from evaporation/condensation
-                        if (myNode[i].boundary->waterFlow < 0.)
-                            advTemperature = myNode[i].extra->Heat->T;
+                        if (ctx->myNode[i].boundary->waterFlow < 0.)
+                            advTemperature = ctx->myNode[i].extra->Heat->T;
                         else
-                            advTemperature = myNode[i].boundary->Heat->temperature;
+                            advTemperature = ctx->myNode[i].boundary->Heat->temperature;
 
-                        myNode[i].boundary->Heat->advectiveHeatFlux += myNode[i].boundary->waterFlow * WATER_DENSITY * HEAT_CAPACITY_WATER_VAPOR * advTemperature / myNode[i].up.area;
+                        ctx->myNode[i].boundary->Heat->advectiveHeatFlux += ctx->myNode[i].boundary->waterFlow * WATER_DENSITY * HEAT_CAPACITY_WATER_VAPOR * advTemperature / ctx->myNode[i].up.area;
 
                     }
 
-                    myNode[i].extra->Heat->Qh += myNode[i].up.area * (myNode[i].boundary->Heat->radiativeFlux +
-                                                                      myNode[i].boundary->Heat->sensibleFlux +
-                                                                      myNode[i].boundary->Heat->latentFlux +
-                                                                      myNode[i].boundary->Heat->advectiveHeatFlux);
+                    ctx->myNode[i].extra->Heat->Qh += ctx->myNode[i].up.area * (ctx->myNode[i].boundary->Heat->radiativeFlux +
+                                                                      ctx->myNode[i].boundary->Heat->sensibleFlux +
+                                                                      ctx->myNode[i].boundary->Heat->latentFlux +
+                                                                      ctx->myNode[i].boundary->Heat->advectiveHeatFlux);
                 }
-                else if (myNode[i].boundary->type == BOUNDARY_FREEDRAINAGE ||
-                         myNode[i].boundary->type == BOUNDARY_PRESCRIBEDTOTALPOTENTIAL)
+                else if (ctx->myNode[i].boundary->type == BOUNDARY_FREEDRAINAGE ||
+                         ctx->myNode[i].boundary->type == BOUNDARY_PRESCRIBEDTOTALPOTENTIAL)
                 {
-                    if (myStructure.computeWater && myStructure.computeHeatAdvection)
+                    if (ctx->myStructure.computeWater && ctx->myStructure.computeHeatAdvection)
                     {
-                        myWaterFlux = myNode[i].boundary->waterFlow;
+                        myWaterFlux = ctx->myNode[i].boundary->waterFlow;
 
                         if (myWaterFlux < 0)
-                            advTemperature = myNode[i].extra->Heat->T;
+                            advTemperature = ctx->myNode[i].extra->Heat->T;
                         else
-                            advTemperature = myNode[i].boundary->Heat->fixedTemperature;
+                            advTemperature = ctx->myNode[i].boundary->Heat->fixedTemperature;
 
-                        heatFlux =  myWaterFlux * HEAT_CAPACITY_WATER * advTemperature / myNode[i].up.area;
-                        myNode[i].boundary->Heat->advectiveHeatFlux = heatFlux;
+                        heatFlux =  myWaterFlux * HEAT_CAPACITY_WATER * advTemperature / ctx->myNode[i].up.area;
+                        ctx->myNode[i].boundary->Heat->advectiveHeatFlux = heatFlux;
 
-                        myNode[i].extra->Heat->Qh += myNode[i].up.area * myNode[i].boundary->Heat->advectiveHeatFlux;
+                        ctx->myNode[i].extra->Heat->Qh += ctx->myNode[i].up.area * ctx->myNode[i].boundary->Heat->advectiveHeatFlux;
                     }
 
-                    if (myNode[i].boundary->Heat->fixedTemperature != NODATA)
+                    if (ctx->myNode[i].boundary->Heat->fixedTemperature != NODATA)
                     {
-                        double avgH = getHMean(i);
-                        double boundaryHeatConductivity = SoilHeatConductivity(i, myNode[i].extra->Heat->T, avgH - myNode[i].z);
-                        double deltaT = myNode[i].boundary->Heat->fixedTemperature - myNode[i].extra->Heat->T;
-                        myNode[i].extra->Heat->Qh += boundaryHeatConductivity * deltaT / myNode[i].boundary->Heat->fixedTemperatureDepth * myNode[i].up.area;
+                        double avgH = getHMean(ctx, i);
+                        double boundaryHeatConductivity = SoilHeatConductivity(ctx, i, ctx->myNode[i].extra->Heat->T, avgH - ctx->nodeData.z[i]);
+                        double deltaT = ctx->myNode[i].boundary->Heat->fixedTemperature - ctx->myNode[i].extra->Heat->T;
+                        ctx->myNode[i].extra->Heat->Qh += boundaryHeatConductivity * deltaT / ctx->myNode[i].boundary->Heat->fixedTemperatureDepth * ctx->myNode[i].up.area;
                     }
                 }
             }
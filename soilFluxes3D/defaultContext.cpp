@@ -0,0 +1,415 @@
+/*!
+    \name defaultContext.cpp
+    \copyright (C) 2011 Fausto Tomei, Gabriele Antolini, Antonio Volta,
+                        Alberto Pistocchi, Marco Bittelli
+
+    This file is part of CRITERIA3D.
+    CRITERIA3D has been developed under contract issued by A.R.P.A. Emilia-Romagna
+
+    CRITERIA3D is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CRITERIA3D is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with CRITERIA3D.  If not, see <http://www.gnu.org/licenses/>.
+
+    contacts:
+    fausto.tomei@gmail.com
+    ftomei@arpae.emr.it
+    gantolini@arpae.emr.it
+*/
+
+#include "header/types.h"
+#include "header/soilFluxes3D.h"
+
+
+namespace soilFluxes3D {
+
+    /*!
+     * \brief the process-wide context used by the functions without a context argument
+     * (created at the first call)
+     */
+    TCrit3Dcontext* DLL_EXPORT __STDCALL getDefaultContext()
+ {
+    static TCrit3Dcontext *defaultContext = createContext();
+    return defaultContext;
+ }
+
+
+    void DLL_EXPORT __STDCALL cleanMemory()
+ {
+    cleanMemory(getDefaultContext());
+ }
+
+    int DLL_EXPORT __STDCALL initialize(long nrNodes, int nrLayers, int nrLateralLinks, bool computeWater_, bool computeHeat_, bool computeSolutes_)
+ {
+    return initialize(getDefaultContext(), nrNodes, nrLayers, nrLateralLinks, computeWater_, computeHeat_, computeSolutes_);
+ }
+
+    void DLL_EXPORT __STDCALL initializeHeat(short saveHeatFluxes_, bool computeAdvectiveHeat, bool computeLatentHeat)
+ {
+    initializeHeat(getDefaultContext(), saveHeatFluxes_, computeAdvectiveHeat, computeLatentHeat);
+ }
+
+    int DLL_EXPORT __STDCALL setNumericalParameters(float minDeltaT, float maxDeltaT, int maxIterationNumber, int maxApproximationsNumber, int errorMagnitude, float MBRMagnitude, int nrThreads)
+ {
+    return setNumericalParameters(getDefaultContext(), minDeltaT, maxDeltaT, maxIterationNumber, maxApproximationsNumber, errorMagnitude, MBRMagnitude, nrThreads);
+ }
+
+    int DLL_EXPORT __STDCALL setSolverMethod(int process, int method)
+ {
+    return setSolverMethod(getDefaultContext(), process, method);
+ }
+
+    void DLL_EXPORT __STDCALL resetSolverStatistics()
+ {
+    resetSolverStatistics(getDefaultContext());
+ }
+
+    int DLL_EXPORT __STDCALL setTimeStepControl(int method)
+ {
+    return setTimeStepControl(getDefaultContext(), method);
+ }
+
+    void DLL_EXPORT __STDCALL resetTimeStepStatistics()
+ {
+    resetTimeStepStatistics(getDefaultContext());
+ }
+
+    long DLL_EXPORT __STDCALL getNrAcceptedTimeSteps()
+ {
+    return getNrAcceptedTimeSteps(getDefaultContext());
+ }
+
+    long DLL_EXPORT __STDCALL getNrRejectedTimeSteps(int cause)
+ {
+    return getNrRejectedTimeSteps(getDefaultContext(), cause);
+ }
+
+    double DLL_EXPORT __STDCALL getCurrentTimeStep()
+ {
+    return getCurrentTimeStep(getDefaultContext());
+ }
+
+    void DLL_EXPORT __STDCALL setHeatSubCycling(bool useSubCycling)
+ {
+    setHeatSubCycling(getDefaultContext(), useSubCycling);
+ }
+
+    long DLL_EXPORT __STDCALL getNrHeatTimeSteps(bool isRejected)
+ {
+    return getNrHeatTimeSteps(getDefaultContext(), isRejected);
+ }
+
+    long DLL_EXPORT __STDCALL getSolverNrSystems(int process)
+ {
+    return getSolverNrSystems(getDefaultContext(), process);
+ }
+
+    long DLL_EXPORT __STDCALL getSolverNrIterations(int process)
+ {
+    return getSolverNrIterations(getDefaultContext(), process);
+ }
+
+    int DLL_EXPORT __STDCALL getSolverLastIterations(int process)
+ {
+    return getSolverLastIterations(getDefaultContext(), process);
+ }
+
+    double DLL_EXPORT __STDCALL getSolverLastResidual(int process)
+ {
+    return getSolverLastResidual(getDefaultContext(), process);
+ }
+
+    long DLL_EXPORT __STDCALL getNrAssemblyNodes(bool isReused)
+ {
+    return getNrAssemblyNodes(getDefaultContext(), isReused);
+ }
+
+    long DLL_EXPORT __STDCALL getNrHeatPropertyEvaluations(bool isReused)
+ {
+    return getNrHeatPropertyEvaluations(getDefaultContext(), isReused);
+ }
+
+    int DLL_EXPORT __STDCALL setNode(long myIndex, float x, float y, float z, double volume_or_area, bool isSurface, bool isBoundary, int boundaryType, float slope)
+ {
+    return setNode(getDefaultContext(), myIndex, x, y, z, volume_or_area, isSurface, isBoundary, boundaryType, slope);
+ }
+
+    int DLL_EXPORT __STDCALL setNodeLink(long nodeIndex, long linkIndex, int direction, float S0)
+ {
+    return setNodeLink(getDefaultContext(), nodeIndex, linkIndex, direction, S0);
+ }
+
+    int DLL_EXPORT __STDCALL setSoilProperties(int nrSoil, int nrHorizon, double VG_alpha, double VG_n, double VG_m, double VG_he, double ThetaR, double ThetaS, double Ksat, double L, double organicMatter, double clay)
+ {
+    return setSoilProperties(getDefaultContext(), nrSoil, nrHorizon, VG_alpha, VG_n, VG_m, VG_he, ThetaR, ThetaS, Ksat, L, organicMatter, clay);
+ }
+
+    int DLL_EXPORT __STDCALL setNodeSoil(long nodeIndex, int soilIndex, int horizonIndex)
+ {
+    return setNodeSoil(getDefaultContext(), nodeIndex, soilIndex, horizonIndex);
+ }
+
+    int DLL_EXPORT __STDCALL setSurfaceProperties(int surfaceIndex, double Roughness, double minWaterLevelRunoff)
+ {
+    return setSurfaceProperties(getDefaultContext(), surfaceIndex, Roughness, minWaterLevelRunoff);
+ }
+
+    int DLL_EXPORT __STDCALL setNodeSurface(long nodeIndex, int surfaceIndex)
+ {
+    return setNodeSurface(getDefaultContext(), nodeIndex, surfaceIndex);
+ }
+
+    int DLL_EXPORT __STDCALL setSoilTables(bool useTables, double tolerance)
+ {
+    return setSoilTables(getDefaultContext(), useTables, tolerance);
+ }
+
+    int DLL_EXPORT __STDCALL setIncrementalAssembly(bool useIncremental, double tolerance)
+ {
+    return setIncrementalAssembly(getDefaultContext(), useIncremental, tolerance);
+ }
+
+    int DLL_EXPORT __STDCALL setHydraulicProperties(int waterRetentionCurve, int conductivityMeanType, float horizVertRatioConductivity)
+ {
+    return setHydraulicProperties(getDefaultContext(), waterRetentionCurve, conductivityMeanType, horizVertRatioConductivity);
+ }
+
+    int DLL_EXPORT __STDCALL setWaterContent(long index, double myWaterContent)
+ {
+    return setWaterContent(getDefaultContext(), index, myWaterContent);
+ }
+
+    int DLL_EXPORT __STDCALL setMatricPotential(long index, double potential)
+ {
+    return setMatricPotential(getDefaultContext(), index, potential);
+ }
+
+    int DLL_EXPORT __STDCALL setTotalPotential(long index, double totalPotential)
+ {
+    return setTotalPotential(getDefaultContext(), index, totalPotential);
+ }
+
+    int DLL_EXPORT __STDCALL setPrescribedTotalPotential(long index, double prescribedTotalPotential)
+ {
+    return setPrescribedTotalPotential(getDefaultContext(), index, prescribedTotalPotential);
+ }
+
+    int DLL_EXPORT __STDCALL setWaterSinkSource(long index, double sinkSource)
+ {
+    return setWaterSinkSource(getDefaultContext(), index, sinkSource);
+ }
+
+    double DLL_EXPORT __STDCALL getWaterContent(long index)
+ {
+    return getWaterContent(getDefaultContext(), index);
+ }
+
+    double DLL_EXPORT __STDCALL getAvailableWaterContent(long index)
+ {
+    return getAvailableWaterContent(getDefaultContext(), index);
+ }
+
+    double DLL_EXPORT __STDCALL getWaterDeficit(long index, double fieldCapacity)
+ {
+    return getWaterDeficit(getDefaultContext(), index, fieldCapacity);
+ }
+
+    double DLL_EXPORT __STDCALL getTotalWaterContent()
+ {
+    return getTotalWaterContent(getDefaultContext());
+ }
+
+    double DLL_EXPORT __STDCALL getDegreeOfSaturation(long index)
+ {
+    return getDegreeOfSaturation(getDefaultContext(), index);
+ }
+
+    double DLL_EXPORT __STDCALL getBoundaryWaterFlow(long index)
+ {
+    return getBoundaryWaterFlow(getDefaultContext(), index);
+ }
+
+    double DLL_EXPORT __STDCALL getBoundaryWaterSumFlow(int boundaryType)
+ {
+    return getBoundaryWaterSumFlow(getDefaultContext(), boundaryType);
+ }
+
+    double DLL_EXPORT __STDCALL getMatricPotential(long index)
+ {
+    return getMatricPotential(getDefaultContext(), index);
+ }
+
+    double DLL_EXPORT __STDCALL getTotalPotential(long index)
+ {
+    return getTotalPotential(getDefaultContext(), index);
+ }
+
+    double DLL_EXPORT __STDCALL getWaterMBR()
+ {
+    return getWaterMBR(getDefaultContext());
+ }
+
+    double DLL_EXPORT __STDCALL getWaterConductivity(long index)
+ {
+    return getWaterConductivity(getDefaultContext(), index);
+ }
+
+    double DLL_EXPORT __STDCALL getWaterFlow(long index, short direction)
+ {
+    return getWaterFlow(getDefaultContext(), index, direction);
+ }
+
+    double DLL_EXPORT __STDCALL getSumLateralWaterFlow(long n)
+ {
+    return getSumLateralWaterFlow(getDefaultContext(), n);
+ }
+
+    int DLL_EXPORT __STDCALL setHeatSinkSource(long nodeIndex, double myHeatFlow)
+ {
+    return setHeatSinkSource(getDefaultContext(), nodeIndex, myHeatFlow);
+ }
+
+    int DLL_EXPORT __STDCALL setTemperature(long nodeIndex, double myT)
+ {
+    return setTemperature(getDefaultContext(), nodeIndex, myT);
+ }
+
+    int DLL_EXPORT __STDCALL setHeatBoundaryHeightWind(long nodeIndex, double myHeight)
+ {
+    return setHeatBoundaryHeightWind(getDefaultContext(), nodeIndex, myHeight);
+ }
+
+    int DLL_EXPORT __STDCALL setHeatBoundaryHeightTemperature(long nodeIndex, double myHeight)
+ {
+    return setHeatBoundaryHeightTemperature(getDefaultContext(), nodeIndex, myHeight);
+ }
+
+    int DLL_EXPORT __STDCALL setHeatBoundaryTemperature(long nodeIndex, double myTemperature)
+ {
+    return setHeatBoundaryTemperature(getDefaultContext(), nodeIndex, myTemperature);
+ }
+
+    int DLL_EXPORT __STDCALL setHeatBoundaryRelativeHumidity(long nodeIndex, double myRelativeHumidity)
+ {
+    return setHeatBoundaryRelativeHumidity(getDefaultContext(), nodeIndex, myRelativeHumidity);
+ }
+
+    int DLL_EXPORT __STDCALL setHeatBoundaryRoughness(long nodeIndex, double myRoughness)
+ {
+    return setHeatBoundaryRoughness(getDefaultContext(), nodeIndex, myRoughness);
+ }
+
+    int DLL_EXPORT __STDCALL setHeatBoundaryWindSpeed(long nodeIndex, double myWindSpeed)
+ {
+    return setHeatBoundaryWindSpeed(getDefaultContext(), nodeIndex, myWindSpeed);
+ }
+
+    int DLL_EXPORT __STDCALL setHeatBoundaryNetIrradiance(long nodeIndex, double myNetIrradiance)
+ {
+    return setHeatBoundaryNetIrradiance(getDefaultContext(), nodeIndex, myNetIrradiance);
+ }
+
+    int DLL_EXPORT __STDCALL setFixedTemperature(long nodeIndex, double myT, double myDepth)
+ {
+    return setFixedTemperature(getDefaultContext(), nodeIndex, myT, myDepth);
+ }
+
+    double DLL_EXPORT __STDCALL getTemperature(long nodeIndex)
+ {
+    return getTemperature(getDefaultContext(), nodeIndex);
+ }
+
+    double DLL_EXPORT __STDCALL getHeatConductivity(long nodeIndex)
+ {
+    return getHeatConductivity(getDefaultContext(), nodeIndex);
+ }
+
+    double DLL_EXPORT __STDCALL getHeat(long nodeIndex, double h)
+ {
+    return getHeat(getDefaultContext(), nodeIndex, h);
+ }
+
+    double DLL_EXPORT __STDCALL getNodeVapor(long nodeIndex)
+ {
+    return getNodeVapor(getDefaultContext(), nodeIndex);
+ }
+
+    float DLL_EXPORT __STDCALL getHeatFlux(long nodeIndex, short myDirection, int fluxType)
+ {
+    return getHeatFlux(getDefaultContext(), nodeIndex, myDirection, fluxType);
+ }
+
+    double DLL_EXPORT __STDCALL getBoundarySensibleFlux(long nodeIndex)
+ {
+    return getBoundarySensibleFlux(getDefaultContext(), nodeIndex);
+ }
+
+    double DLL_EXPORT __STDCALL getBoundaryAdvectiveFlux(long nodeIndex)
+ {
+    return getBoundaryAdvectiveFlux(getDefaultContext(), nodeIndex);
+ }
+
+    double DLL_EXPORT __STDCALL getBoundaryLatentFlux(long nodeIndex)
+ {
+    return getBoundaryLatentFlux(getDefaultContext(), nodeIndex);
+ }
+
+    double DLL_EXPORT __STDCALL getBoundaryRadiativeFlux(long nodeIndex)
+ {
+    return getBoundaryRadiativeFlux(getDefaultContext(), nodeIndex);
+ }
+
+    double DLL_EXPORT __STDCALL getBoundaryAerodynamicConductance(long nodeIndex)
+ {
+    return getBoundaryAerodynamicConductance(getDefaultContext(), nodeIndex);
+ }
+
+    double DLL_EXPORT __STDCALL getBoundarySoilConductance(long nodeIndex)
+ {
+    return getBoundarySoilConductance(getDefaultContext(), nodeIndex);
+ }
+
+    double DLL_EXPORT __STDCALL getHeatMBR()
+ {
+    return getHeatMBR(getDefaultContext());
+ }
+
+    double DLL_EXPORT __STDCALL getHeatMBE()
+ {
+    return getHeatMBE(getDefaultContext());
+ }
+
+    void DLL_EXPORT __STDCALL initializeBalance()
+ {
+    initializeBalance(getDefaultContext());
+ }
+
+    void DLL_EXPORT __STDCALL computePeriod(double myPeriod)
+ {
+    computePeriod(getDefaultContext(), myPeriod);
+ }
+
+    double DLL_EXPORT __STDCALL computeStep(double maxTime)
+ {
+    return computeStep(getDefaultContext(), maxTime);
+ }
+
+    int DLL_EXPORT __STDCALL saveStateSnapshot(const char *fileName)
+ {
+    return saveStateSnapshot(getDefaultContext(), fileName);
+ }
+
+    int DLL_EXPORT __STDCALL loadStateSnapshot(const char *fileName)
+ {
+    return loadStateSnapshot(getDefaultContext(), fileName);
+ }
+
+}
@@ -0,0 +1,191 @@
+/*!
+    \name ensemble.cpp
+    \copyright (C) 2011 Fausto Tomei, Gabriele Antolini, Antonio Volta,
+                        Alberto Pistocchi, Marco Bittelli
+
+    This file is part of CRITERIA3D.
+    CRITERIA3D has been developed under contract issued by A.R.P.A. Emilia-Romagna
+
+    CRITERIA3D is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CRITERIA3D is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with CRITERIA3D.  If not, see <http://www.gnu.org/licenses/>.
+
+    contacts:
+    fausto.tomei@gmail.com
+    ftomei@arpae.emr.it
+    gantolini@arpae.emr.it
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <new>
+#include "../mathFunctions/commonConstants.h"
+#include "header/types.h"
+#include "header/memory.h"
+#include "header/solver.h"
+#include "header/soilFluxes3D.h"
+
+
+/*!
+ * \brief copy the current water state of the topology context into a new member
+ * (node records with their links and boundaries, potentials, sink/source)
+ * \return OK/ERROR
+ */
+int copyMemberState(TCrit3Dcontext *member, TCrit3Dcontext *topology)
+{
+    long n = topology->myStructure.nrNodes;
+    long i;
+
+    member->myNode = (TCrit3Dnode *) malloc(n * sizeof(TCrit3Dnode));
+    if (member->myNode == NULL) return(MEMORY_ERROR);
+    memcpy(member->myNode, topology->myNode, n * sizeof(TCrit3Dnode));
+    for (i = 0; i < n; i++)
+    {
+        member->myNode[i].lateral = NULL;
+        member->myNode[i].boundary = NULL;
+    }
+
+    /*! links and boundaries store the flows, so every member has its own copy */
+    int nrLateralLinks = topology->myStructure.nrLateralLinks;
+    for (i = 0; i < n; i++)
+    {
+        member->myNode[i].lateral = (TlinkedNode *) malloc(nrLateralLinks * sizeof(TlinkedNode));
+        if (member->myNode[i].lateral == NULL && nrLateralLinks > 0) return(MEMORY_ERROR);
+        if (nrLateralLinks > 0)
+            memcpy(member->myNode[i].lateral, topology->myNode[i].lateral, nrLateralLinks * sizeof(TlinkedNode));
+
+        if (topology->myNode[i].boundary != NULL)
+        {
+            member->myNode[i].boundary = new (std::nothrow) Tboundary;
+            if (member->myNode[i].boundary == NULL) return(MEMORY_ERROR);
+            *(member->myNode[i].boundary) = *(topology->myNode[i].boundary);
+        }
+    }
+
+    member->nodeData.Se = (double *) malloc(n * sizeof(double));
+    member->nodeData.k = (double *) malloc(n * sizeof(double));
+    member->nodeData.H = (double *) malloc(n * sizeof(double));
+    member->nodeData.oldH = (double *) malloc(n * sizeof(double));
+    member->nodeData.bestH = (double *) malloc(n * sizeof(double));
+    member->nodeData.waterSinkSource = (double *) malloc(n * sizeof(double));
+    member->nodeData.Qw = (double *) malloc(n * sizeof(double));
+    if (member->nodeData.Se == NULL || member->nodeData.k == NULL || member->nodeData.H == NULL
+        || member->nodeData.oldH == NULL || member->nodeData.bestH == NULL
+        || member->nodeData.waterSinkSource == NULL || member->nodeData.Qw == NULL)
+        return(MEMORY_ERROR);
+
+    memcpy(member->nodeData.Se, topology->nodeData.Se, n * sizeof(double));
+    memcpy(member->nodeData.k, topology->nodeData.k, n * sizeof(double));
+    memcpy(member->nodeData.H, topology->nodeData.H, n * sizeof(double));
+    memcpy(member->nodeData.oldH, topology->nodeData.oldH, n * sizeof(double));
+    memcpy(member->nodeData.bestH, topology->nodeData.bestH, n * sizeof(double));
+    memcpy(member->nodeData.waterSinkSource, topology->nodeData.waterSinkSource, n * sizeof(double));
+    memcpy(member->nodeData.Qw, topology->nodeData.Qw, n * sizeof(double));
+
+    /*! system: own values on the shared pattern */
+    member->A.val = (double *) calloc(topology->A.nrElements, sizeof(double));
+    member->b = (double *) calloc(n, sizeof(double));
+    member->C = (double *) calloc(n, sizeof(double));
+    member->X = (double *) calloc(n, sizeof(double));
+    member->invariantFlux = (double *) calloc(n, sizeof(double));
+    if (member->A.val == NULL || member->b == NULL || member->C == NULL
+        || member->X == NULL || member->invariantFlux == NULL)
+        return(MEMORY_ERROR);
+
+    return(CRIT3D_OK);
+}
+
+
+namespace soilFluxes3D {
+
+    /*!
+     * \brief create an ensemble member of a domain.
+     * The member shares read-only the topology of the domain (nodes geometry, links, soils,
+     * matrix pattern and node colors) and starts from a copy of its current water state;
+     * it has its own potentials, sink/source, boundary and link flows, balance and system.
+     * The state of the members can be set with the context functions (e.g. setMatricPotential,
+     * setWaterSinkSource) and computed with computeEnsemblePeriod.
+     * Only water flow is supported. The topology can not be changed or deleted while members exist.
+     * \param topology     a domain with nodes, links and soils already set
+     * \return the member context, NULL on error
+     */
+    TCrit3Dcontext* DLL_EXPORT __STDCALL createEnsembleMember(TCrit3Dcontext *topology)
+ {
+    if (topology == NULL || topology->myNode == NULL) return NULL;
+    if (topology->topology != NULL) return NULL;
+    if (topology->myStructure.computeHeat || topology->myStructure.computeSolutes) return NULL;
+
+    /*! shared matrix pattern and node colors */
+    if (topology->A.rowStart == NULL)
+        if (initializeMatrix(topology) != CRIT3D_OK) return NULL;
+    if (topology->myParameters.nrThreads > 1 && topology->nrColors == 0)
+        computeNodeColors(topology);
+
+    TCrit3Dcontext *member = new (std::nothrow) TCrit3Dcontext();
+    if (member == NULL) return NULL;
+
+    member->topology = topology;
+    member->myStructure = topology->myStructure;
+    member->myParameters = topology->myParameters;
+    member->Soil_List = topology->Soil_List;
+    member->Surface_List = topology->Surface_List;
+
+    member->A.nrRows = topology->A.nrRows;
+    member->A.nrElements = topology->A.nrElements;
+    member->A.rowStart = topology->A.rowStart;
+    member->A.column = topology->A.column;
+
+    member->nrColors = topology->nrColors;
+    member->colorNodeList = topology->colorNodeList;
+    member->colorFirstIndex = topology->colorFirstIndex;
+
+    member->nodeData.volume_area = topology->nodeData.volume_area;
+    member->nodeData.x = topology->nodeData.x;
+    member->nodeData.y = topology->nodeData.y;
+    member->nodeData.z = topology->nodeData.z;
+    member->nodeData.isSurface = topology->nodeData.isSurface;
+
+    member->balanceCurrentTimeStep = topology->balanceCurrentTimeStep;
+    member->balancePreviousTimeStep = topology->balancePreviousTimeStep;
+    member->balanceCurrentPeriod = topology->balanceCurrentPeriod;
+    member->balanceWholePeriod = topology->balanceWholePeriod;
+    resetSolverStatistics(member);
+
+    if (copyMemberState(member, topology) != CRIT3D_OK)
+    {
+        deleteContext(member);
+        return NULL;
+    }
+
+    return member;
+ }
+
+
+    /*!
+     * \brief computes a period of time [s] for all the members of an ensemble,
+     * members are distributed on parallel threads
+     * \param members      ensemble members (may include the topology context)
+     * \param nrMembers
+     * \param myPeriod     [s]
+     * \param nrThreads
+     */
+    void DLL_EXPORT __STDCALL computeEnsemblePeriod(TCrit3Dcontext **members, int nrMembers, double myPeriod, int nrThreads)
+ {
+    if (nrThreads < 1) nrThreads = 1;
+
+    #pragma omp parallel for schedule(dynamic, 1) num_threads(nrThreads)
+    for (int m = 0; m < nrMembers; m++)
+        computePeriod(members[m], myPeriod);
+ }
+
+}
@@ -57,15 +57,15 @@ void initializeExtra(TCrit3DnodeExtra *myNodeExtra, bool computeHeat, bool compu
     }
 }
 
-void initializeNodeHeatFlux(TCrit3DLinkedNodeExtra* myLinkExtra, bool initHeat, bool initWater)
+void initializeNodeHeatFlux(TCrit3Dcontext *ctx, TCrit3DLinkedNodeExtra* myLinkExtra, bool initHeat, bool initWater)
 {
     if (myLinkExtra == NULL) return;
     if (myLinkExtra->heatFlux == NULL) return;
-    if (! myStructure.computeHeat) return;
+    if (! ctx->myStructure.computeHeat) return;
 
-    if (myStructure.saveHeatFluxesType == SAVE_HEATFLUXES_TOTAL && initHeat)
+    if (ctx->myStructure.saveHeatFluxesType == SAVE_HEATFLUXES_TOTAL && initHeat)
         myLinkExtra->heatFlux->fluxes[HEATFLUX_TOTAL] = NODATA;
-    else if (myStructure.saveHeatFluxesType == SAVE_HEATFLUXES_ALL)
+    else if (ctx->myStructure.saveHeatFluxesType == SAVE_HEATFLUXES_ALL)
     {
         if (initHeat)
         {
@@ -87,7 +87,7 @@ void initializeNodeHeatFlux(TCrit3DLinkedNodeExtra* myLinkExtra, bool initHeat,
 
 }
 
-void initializeLinkExtra(TCrit3DLinkedNodeExtra* myLinkedNodeExtra, bool computeHeat, bool computeSolutes)
+void initializeLinkExtra(TCrit3Dcontext *ctx, TCrit3DLinkedNodeExtra* myLinkedNodeExtra, bool computeHeat, bool computeSolutes)
 {
     if (computeHeat)
     {
@@ -96,14 +96,14 @@ void initializeLinkExtra(TCrit3DLinkedNodeExtra* myLinkedNodeExtra, bool compute
         (*myLinkedNodeExtra).heatFlux->waterFlux = 0.;
         (*myLinkedNodeExtra).heatFlux->vaporFlux = 0.;
 
-        if (myStructure.saveHeatFluxesType == SAVE_HEATFLUXES_ALL)
+        if (ctx->myStructure.saveHeatFluxesType == SAVE_HEATFLUXES_ALL)
             (*myLinkedNodeExtra).heatFlux->fluxes = new float[9];
-        else if (myStructure.saveHeatFluxesType == SAVE_HEATFLUXES_TOTAL)
+        else if (ctx->myStructure.saveHeatFluxesType == SAVE_HEATFLUXES_TOTAL)
             (*myLinkedNodeExtra).heatFlux->fluxes = new float[1];
         else
             (*myLinkedNodeExtra).heatFlux->fluxes = NULL;
 
-        initializeNodeHeatFlux(myLinkedNodeExtra, true, true);
+        initializeNodeHeatFlux(ctx, myLinkedNodeExtra, true, true);
 
     }
     else (*myLinkedNodeExtra).heatFlux = NULL;
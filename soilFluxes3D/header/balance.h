@@ -1,13 +1,16 @@
 #ifndef BALANCE_H
 #define BALANCE_H
 
-    void halveTimeStep();
-    bool getForcedHalvedTime();
-    void setForcedHalvedTime(bool isForced);
-    double computeTotalWaterContent();
-    double getMatrixValue(long i, TlinkedNode *link);
-    void InitializeBalanceWater();
-    bool waterBalance(double deltaT, int approxNr);
-    void updateBalanceWaterWholePeriod();
+    struct TCrit3Dcontext;
+
+    void halveTimeStep(TCrit3Dcontext *ctx);
+    void rejectTimeStep(TCrit3Dcontext *ctx, int cause);
+    bool getForcedHalvedTime(TCrit3Dcontext *ctx);
+    void setForcedHalvedTime(TCrit3Dcontext *ctx, bool isForced);
+    double computeTotalWaterContent(TCrit3Dcontext *ctx);
+    double getMatrixValue(TCrit3Dcontext *ctx, long i, TlinkedNode *link);
+    void InitializeBalanceWater(TCrit3Dcontext *ctx);
+    bool waterBalance(TCrit3Dcontext *ctx, double deltaT, int approxNr);
+    void updateBalanceWaterWholePeriod(TCrit3Dcontext *ctx);
 
 #endif  // BALANCE_H
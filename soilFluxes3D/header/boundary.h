@@ -1,10 +1,12 @@
 #ifndef BOUNDARY_H
 #define BOUNDARY_H
 
-    void updateBoundary();
-    void updateBoundaryHeat();
-    void updateBoundaryWater(double deltaT);
-    void initializeBoundary(Tboundary *myBoundary, int myType, float slope);
+    struct TCrit3Dcontext;
+
+    void updateBoundary(TCrit3Dcontext *ctx);
+    void updateBoundaryHeat(TCrit3Dcontext *ctx);
+    void updateBoundaryWater(TCrit3Dcontext *ctx, double deltaT);
+    void initializeBoundary(TCrit3Dcontext *ctx, Tboundary *myBoundary, int myType, float slope);
 
 #endif  // BOUNDARY_H
 
@@ -1,6 +1,8 @@
 #ifndef TYPESEXTRA_H
 #define TYPESEXTRA_H
 
+    struct TCrit3Dcontext;
+
     struct TboundaryHeat{
         double temperature;                     /*!< [K] temperature of the boundary (ex. air temperature) */
         double relativeHumidity;                /*!< [%] relative humidity */
@@ -41,7 +43,7 @@
        } ;
 
     void initializeExtra(TCrit3DnodeExtra *myNodeExtra, bool computeHeat, bool computeSolutes);
-    void initializeLinkExtra(TCrit3DLinkedNodeExtra* myLinkedNodeExtra, bool computeHeat, bool computeSolutes);
-    void initializeNodeHeatFlux(TCrit3DLinkedNodeExtra* myLinkExtra, bool initHeat, bool initWater);
+    void initializeLinkExtra(TCrit3Dcontext *ctx, TCrit3DLinkedNodeExtra* myLinkedNodeExtra, bool computeHeat, bool computeSolutes);
+    void initializeNodeHeatFlux(TCrit3Dcontext *ctx, TCrit3DLinkedNodeExtra* myLinkExtra, bool initHeat, bool initWater);
 
 #endif // TYPESEXTRA_H
@@ -1,23 +1,27 @@
 #ifndef HEAT_H
 #define HEAT_H
 
-bool isHeatNode(long i);
-double ThermalVaporFlux(long i, TlinkedNode *myLink, int myProcess, double timeStep, double timeStepWater);
-double ThermalLiquidFlux(long i, TlinkedNode *myLink, int myProcess, double timeStep, double timeStepWater);
-double IsothermalVaporConductivity(long i, double h, double myT);
-double IsothermalVaporFlux(long i, TlinkedNode *myLink, double timeStep, double timeStepWater);
+struct TCrit3Dcontext;
+
+bool isHeatNode(TCrit3Dcontext *ctx, long i);
+double ThermalVaporFlux(TCrit3Dcontext *ctx, long i, TlinkedNode *myLink, int myProcess, double timeStep, double timeStepWater);
+double ThermalLiquidFlux(TCrit3Dcontext *ctx, long i, TlinkedNode *myLink, int myProcess, double timeStep, double timeStepWater);
+double IsothermalVaporConductivity(TCrit3Dcontext *ctx, long i, double h, double myT);
+double IsothermalVaporFlux(TCrit3Dcontext *ctx, long i, TlinkedNode *myLink, double timeStep, double timeStepWater);
 double SoilRelativeHumidity(double h, double myT);
-double SoilHeatCapacity(long i, double h, double T);
-double SoilHeatConductivity(long i, double T, double h);
+double SoilHeatCapacity(TCrit3Dcontext *ctx, long i, double h, double T);
+double SoilHeatConductivity(TCrit3Dcontext *ctx, long i, double T, double h);
 double VaporFromPsiTemp(double h, double T);
-double VaporThetaV(double h, double T, long i);
-void restoreHeat();
-void initializeBalanceHeat();
-void updateBalanceHeatWholePeriod();
-void initializeHeatFluxes(bool initHeat, bool initWater);
-void saveWaterFluxes(double dtHeat, double timeStepWater);
-void saveHeatFlux(TlinkedNode* myLink, int fluxType, double myValue);
-float readHeatFlux(TlinkedNode* myLink, int fluxType);
-bool HeatComputation(double timeStep, double timeStepWater);
+double VaporThetaV(TCrit3Dcontext *ctx, double h, double T, long i);
+double VaporThetaV(TCrit3Dcontext *ctx, double h, double T, double theta, long i);
+void restoreHeat(TCrit3Dcontext *ctx);
+void initializeBalanceHeat(TCrit3Dcontext *ctx);
+void updateBalanceHeatWholePeriod(TCrit3Dcontext *ctx);
+void initializeHeatFluxes(TCrit3Dcontext *ctx, bool initHeat, bool initWater);
+void saveWaterFluxes(TCrit3Dcontext *ctx, double dtHeat, double timeStepWater);
+void saveHeatFlux(TCrit3Dcontext *ctx, TlinkedNode* myLink, int fluxType, double myValue);
+float readHeatFlux(TCrit3Dcontext *ctx, TlinkedNode* myLink, int fluxType);
+void cleanHeatPropertyCache(TCrit3Dcontext *ctx);
+bool HeatComputation(TCrit3Dcontext *ctx, double timeStep, double timeStepWater);
 
 #endif
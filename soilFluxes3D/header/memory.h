@@ -1,6 +1,15 @@
+struct TCrit3Dcontext;
 
-void cleanArrays();
+void cleanArrays(TCrit3Dcontext *ctx);
 
-void cleanNodes();
+void cleanMatrix(TCrit3Dcontext *ctx);
 
-int initializeArrays();
+int initializeMatrix(TCrit3Dcontext *ctx);
+
+void cleanNodes(TCrit3Dcontext *ctx);
+
+void cleanNodeData(TCrit3Dcontext *ctx);
+
+int initializeNodeData(TCrit3Dcontext *ctx);
+
+int initializeArrays(TCrit3Dcontext *ctx);
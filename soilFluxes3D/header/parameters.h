@@ -6,34 +6,50 @@
     #endif
 
     struct TParameters{
-    int numericalSolutionMethod;
+    int waterSolutionMethod;
+    int heatSolutionMethod;
     double MBRThreshold;
     double ResidualTolerance;
     double delta_t_min;
     double delta_t_max;
     double current_delta_t;
+    int timeStepControl;
+    bool useHeatSubCycling;
     int iterazioni_min;
     int iterazioni_max;
     int maxApproximationsNumber;
     int waterRetentionCurve;
+    bool useSoilTables;
+    double soilTablesTolerance;
+    bool useIncrementalAssembly;
+    double incrementalAssemblyTolerance;
     int meanType;
     float k_lateral_vertical_ratio;
     double heatWeightingFactor;
+    int nrThreads;
 
     void initialize()
         {
-        numericalSolutionMethod = RELAXATION;
+        waterSolutionMethod = RELAXATION;
+        heatSolutionMethod = RELAXATION;
         delta_t_min = 1;
         delta_t_max = 600;
         current_delta_t = delta_t_max;
+        timeStepControl = TIMESTEP_HALVE_DOUBLE;
+        useHeatSubCycling = false;
         iterazioni_max = 200;
         maxApproximationsNumber = 10;
         MBRThreshold = 1E-6;
         ResidualTolerance = 1E-10;
         waterRetentionCurve = MODIFIEDVANGENUCHTEN;
+        useSoilTables = false;
+        soilTablesTolerance = 1E-6;
+        useIncrementalAssembly = false;
+        incrementalAssemblyTolerance = 1E-9;
         meanType = MEAN_LOGARITHMIC;
         k_lateral_vertical_ratio = 10.;
         heatWeightingFactor = 0.5;
+        nrThreads = 1;
         }
     } ;
 
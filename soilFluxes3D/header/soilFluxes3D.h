@@ -16,8 +16,133 @@
         #define __STDCALL
     #endif
 	
+    struct TCrit3Dcontext;
+
     namespace soilFluxes3D {
 
+    //CONTEXT
+    TCrit3Dcontext* DLL_EXPORT __STDCALL createContext();
+    void DLL_EXPORT __STDCALL deleteContext(TCrit3Dcontext *ctx);
+    TCrit3Dcontext* DLL_EXPORT __STDCALL getDefaultContext();
+
+    //ENSEMBLE
+    TCrit3Dcontext* DLL_EXPORT __STDCALL createEnsembleMember(TCrit3Dcontext *topology);
+    void DLL_EXPORT __STDCALL computeEnsemblePeriod(TCrit3Dcontext **members, int nrMembers, double myPeriod, int nrThreads);
+
+    //INITIALIZATION
+    void DLL_EXPORT __STDCALL cleanMemory(TCrit3Dcontext *ctx);
+    int DLL_EXPORT __STDCALL initialize(TCrit3Dcontext *ctx, long nrNodes, int nrLayers, int nrLateralLinks, bool computeWater_, bool computeHeat_, bool computeSolutes_);
+    void DLL_EXPORT __STDCALL initializeHeat(TCrit3Dcontext *ctx, short saveHeatFluxes_, bool computeAdvectiveHeat, bool computeLatentHeat);
+
+    int DLL_EXPORT __STDCALL setNumericalParameters(TCrit3Dcontext *ctx, float minDeltaT, float maxDeltaT,
+                     int maxIterationNumber, int maxApproximationsNumber,
+                     int errorMagnitude, float MBRMagnitude, int nrThreads);
+
+    //LINEAR SOLVER
+    int DLL_EXPORT __STDCALL setSolverMethod(TCrit3Dcontext *ctx, int process, int method);
+    void DLL_EXPORT __STDCALL resetSolverStatistics(TCrit3Dcontext *ctx);
+    long DLL_EXPORT __STDCALL getSolverNrSystems(TCrit3Dcontext *ctx, int process);
+    long DLL_EXPORT __STDCALL getSolverNrIterations(TCrit3Dcontext *ctx, int process);
+    int DLL_EXPORT __STDCALL getSolverLastIterations(TCrit3Dcontext *ctx, int process);
+    double DLL_EXPORT __STDCALL getSolverLastResidual(TCrit3Dcontext *ctx, int process);
+    long DLL_EXPORT __STDCALL getNrAssemblyNodes(TCrit3Dcontext *ctx, bool isReused);
+    long DLL_EXPORT __STDCALL getNrHeatPropertyEvaluations(TCrit3Dcontext *ctx, bool isReused);
+
+    //TIME STEP
+    int DLL_EXPORT __STDCALL setTimeStepControl(TCrit3Dcontext *ctx, int method);
+    void DLL_EXPORT __STDCALL resetTimeStepStatistics(TCrit3Dcontext *ctx);
+    long DLL_EXPORT __STDCALL getNrAcceptedTimeSteps(TCrit3Dcontext *ctx);
+    long DLL_EXPORT __STDCALL getNrRejectedTimeSteps(TCrit3Dcontext *ctx, int cause);
+    double DLL_EXPORT __STDCALL getCurrentTimeStep(TCrit3Dcontext *ctx);
+    void DLL_EXPORT __STDCALL setHeatSubCycling(TCrit3Dcontext *ctx, bool useSubCycling);
+    long DLL_EXPORT __STDCALL getNrHeatTimeSteps(TCrit3Dcontext *ctx, bool isRejected);
+
+    //TOPOLOGY
+    int DLL_EXPORT __STDCALL setNode(TCrit3Dcontext *ctx, long myIndex, float x, float y, float z, double volume_or_area,
+                               bool isSurface, bool isBoundary, int boundaryType, float slope);
+
+    int DLL_EXPORT __STDCALL setNodeLink(TCrit3Dcontext *ctx, long nodeIndex, long linkIndex, int direction, float S0);
+
+    //SOIL
+    int DLL_EXPORT __STDCALL setSoilProperties(TCrit3Dcontext *ctx, int nrSoil, int nrHorizon, double VG_alpha,
+                               double VG_n, double VG_m, double VG_he,
+                               double ThetaR, double ThetaS, double Ksat, double L,
+                               double organicMatter, double clay);
+
+    int DLL_EXPORT __STDCALL setNodeSoil(TCrit3Dcontext *ctx, long nodeIndex, int soilIndex, int horizonIndex);
+
+    //SURFACE
+    int DLL_EXPORT __STDCALL setSurfaceProperties(TCrit3Dcontext *ctx, int surfaceIndex, double Roughness, double minWaterLevelRunoff);
+    int DLL_EXPORT __STDCALL setNodeSurface(TCrit3Dcontext *ctx, long nodeIndex, int surfaceIndex);
+
+    //WATER
+    int DLL_EXPORT __STDCALL setSoilTables(TCrit3Dcontext *ctx, bool useTables, double tolerance);
+    int DLL_EXPORT __STDCALL setIncrementalAssembly(TCrit3Dcontext *ctx, bool useIncremental, double tolerance);
+    int DLL_EXPORT __STDCALL setHydraulicProperties(TCrit3Dcontext *ctx, int waterRetentionCurve, int conductivityMeanType, float horizVertRatioConductivity);
+    int DLL_EXPORT __STDCALL setWaterContent(TCrit3Dcontext *ctx, long index, double myWaterContent);
+    int DLL_EXPORT __STDCALL setMatricPotential(TCrit3Dcontext *ctx, long index, double potential);
+    int DLL_EXPORT __STDCALL setTotalPotential(TCrit3Dcontext *ctx, long index, double totalPotential);
+    int DLL_EXPORT __STDCALL setPrescribedTotalPotential(TCrit3Dcontext *ctx, long index, double prescribedTotalPotential);
+    int DLL_EXPORT __STDCALL setWaterSinkSource(TCrit3Dcontext *ctx, long index, double sinkSource);
+
+    double DLL_EXPORT __STDCALL getWaterContent(TCrit3Dcontext *ctx, long index);
+    double DLL_EXPORT __STDCALL getAvailableWaterContent(TCrit3Dcontext *ctx, long index);
+    double DLL_EXPORT __STDCALL getWaterDeficit(TCrit3Dcontext *ctx, long index, double fieldCapacity);
+    double DLL_EXPORT __STDCALL getTotalWaterContent(TCrit3Dcontext *ctx);
+    double DLL_EXPORT __STDCALL getDegreeOfSaturation(TCrit3Dcontext *ctx, long index);
+    double DLL_EXPORT __STDCALL getBoundaryWaterFlow(TCrit3Dcontext *ctx, long index);
+    double DLL_EXPORT __STDCALL getBoundaryWaterSumFlow(TCrit3Dcontext *ctx, int boundaryType);
+    double DLL_EXPORT __STDCALL getMatricPotential(TCrit3Dcontext *ctx, long index);
+    double DLL_EXPORT __STDCALL getTotalPotential(TCrit3Dcontext *ctx, long index);
+    double DLL_EXPORT __STDCALL getWaterMBR(TCrit3Dcontext *ctx);
+    double DLL_EXPORT __STDCALL getWaterConductivity(TCrit3Dcontext *ctx, long index);
+    double DLL_EXPORT __STDCALL getWaterFlow(TCrit3Dcontext *ctx, long index, short direction);
+    double DLL_EXPORT __STDCALL getSumLateralWaterFlow(TCrit3Dcontext *ctx, long n);
+
+    // HEAT
+    int DLL_EXPORT __STDCALL setHeatSinkSource(TCrit3Dcontext *ctx, long nodeIndex, double myHeatFlow);
+    int DLL_EXPORT __STDCALL setTemperature(TCrit3Dcontext *ctx, long nodeIndex, double myT);
+    int DLL_EXPORT __STDCALL setHeatBoundaryHeightWind(TCrit3Dcontext *ctx, long nodeIndex, double myHeight);
+    int DLL_EXPORT __STDCALL setHeatBoundaryHeightTemperature(TCrit3Dcontext *ctx, long nodeIndex, double myHeight);
+    int DLL_EXPORT __STDCALL setHeatBoundaryTemperature(TCrit3Dcontext *ctx, long nodeIndex, double myTemperature);
+    int DLL_EXPORT __STDCALL setHeatBoundaryRelativeHumidity(TCrit3Dcontext *ctx, long nodeIndex, double myRelativeHumidity);
+    int DLL_EXPORT __STDCALL setHeatBoundaryRoughness(TCrit3Dcontext *ctx, long nodeIndex, double myRoughness);
+    int DLL_EXPORT __STDCALL setHeatBoundaryWindSpeed(TCrit3Dcontext *ctx, long nodeIndex, double myWindSpeed);
+    int DLL_EXPORT __STDCALL setHeatBoundaryNetIrradiance(TCrit3Dcontext *ctx, long nodeIndex, double myNetIrradiance);
+    int DLL_EXPORT __STDCALL setFixedTemperature(TCrit3Dcontext *ctx, long nodeIndex, double myT, double myDepth);
+
+    double DLL_EXPORT __STDCALL getTemperature(TCrit3Dcontext *ctx, long nodeIndex);
+    double DLL_EXPORT __STDCALL getHeatConductivity(TCrit3Dcontext *ctx, long nodeIndex);
+    double DLL_EXPORT __STDCALL getHeat(TCrit3Dcontext *ctx, long nodeIndex, double h);
+    double DLL_EXPORT __STDCALL getNodeVapor(TCrit3Dcontext *ctx, long nodeIndex);
+    float DLL_EXPORT __STDCALL getHeatFlux(TCrit3Dcontext *ctx, long nodeIndex, short myDirection, int fluxType);
+    double DLL_EXPORT __STDCALL getBoundarySensibleFlux(TCrit3Dcontext *ctx, long nodeIndex);
+    double DLL_EXPORT __STDCALL getBoundaryAdvectiveFlux(TCrit3Dcontext *ctx, long nodeIndex);
+    double DLL_EXPORT __STDCALL getBoundaryLatentFlux(TCrit3Dcontext *ctx, long nodeIndex);
+    double DLL_EXPORT __STDCALL getBoundaryRadiativeFlux(TCrit3Dcontext *ctx, long nodeIndex);
+    double DLL_EXPORT __STDCALL getBoundaryAerodynamicConductance(TCrit3Dcontext *ctx, long nodeIndex);
+    double DLL_EXPORT __STDCALL getBoundarySoilConductance(TCrit3Dcontext *ctx, long nodeIndex);
+    double DLL_EXPORT __STDCALL getHeatMBR(TCrit3Dcontext *ctx);
+    double DLL_EXPORT __STDCALL getHeatMBE(TCrit3Dcontext *ctx);
+
+    //SOLUTES
+
+    //COMPUTATION
+    void DLL_EXPORT __STDCALL initializeBalance(TCrit3Dcontext *ctx);
+    void DLL_EXPORT __STDCALL computePeriod(TCrit3Dcontext *ctx, double myPeriod);
+	double DLL_EXPORT __STDCALL computeStep(TCrit3Dcontext *ctx, double maxTime);
+
+    //STATE
+    int DLL_EXPORT __STDCALL saveStateSnapshot(TCrit3Dcontext *ctx, const char *fileName);
+    int DLL_EXPORT __STDCALL loadStateSnapshot(TCrit3Dcontext *ctx, const char *fileName);
+
+
+    //-------------------------------------------------
+    // default context: the same functions applied to
+    // a single process-wide domain
+    //-------------------------------------------------
+
+
     //TEST
     __EXTERN int DLL_EXPORT __STDCALL test();
 
@@ -28,7 +153,26 @@
 
     __EXTERN int DLL_EXPORT __STDCALL setNumericalParameters(float minDeltaT, float maxDeltaT,
                               int maxIterationNumber, int maxApproximationsNumber,
-                              int errorMagnitude, float MBRMagnitude);
+                              int errorMagnitude, float MBRMagnitude, int nrThreads);
+
+    //LINEAR SOLVER
+    __EXTERN int DLL_EXPORT __STDCALL setSolverMethod(int process, int method);
+    __EXTERN void DLL_EXPORT __STDCALL resetSolverStatistics();
+    __EXTERN long DLL_EXPORT __STDCALL getSolverNrSystems(int process);
+    __EXTERN long DLL_EXPORT __STDCALL getSolverNrIterations(int process);
+    __EXTERN int DLL_EXPORT __STDCALL getSolverLastIterations(int process);
+    __EXTERN double DLL_EXPORT __STDCALL getSolverLastResidual(int process);
+    __EXTERN long DLL_EXPORT __STDCALL getNrAssemblyNodes(bool isReused);
+    __EXTERN long DLL_EXPORT __STDCALL getNrHeatPropertyEvaluations(bool isReused);
+
+    //TIME STEP
+    __EXTERN int DLL_EXPORT __STDCALL setTimeStepControl(int method);
+    __EXTERN void DLL_EXPORT __STDCALL resetTimeStepStatistics();
+    __EXTERN long DLL_EXPORT __STDCALL getNrAcceptedTimeSteps();
+    __EXTERN long DLL_EXPORT __STDCALL getNrRejectedTimeSteps(int cause);
+    __EXTERN double DLL_EXPORT __STDCALL getCurrentTimeStep();
+    __EXTERN void DLL_EXPORT __STDCALL setHeatSubCycling(bool useSubCycling);
+    __EXTERN long DLL_EXPORT __STDCALL getNrHeatTimeSteps(bool isRejected);
 
     //TOPOLOGY
     __EXTERN int DLL_EXPORT __STDCALL setNode(long myIndex, float x, float y, float z, double volume_or_area,
@@ -49,6 +193,8 @@
     __EXTERN int DLL_EXPORT __STDCALL setNodeSurface(long nodeIndex, int surfaceIndex);
 
     //WATER
+    __EXTERN int DLL_EXPORT __STDCALL setSoilTables(bool useTables, double tolerance);
+    __EXTERN int DLL_EXPORT __STDCALL setIncrementalAssembly(bool useIncremental, double tolerance);
     __EXTERN int DLL_EXPORT __STDCALL setHydraulicProperties(int waterRetentionCurve, int conductivityMeanType, float horizVertRatioConductivity);
     __EXTERN int DLL_EXPORT __STDCALL setWaterContent(long index, double myWaterContent);
     __EXTERN int DLL_EXPORT __STDCALL setMatricPotential(long index, double potential);
@@ -103,6 +249,10 @@
     __EXTERN void DLL_EXPORT __STDCALL computePeriod(double myPeriod);
 	__EXTERN double DLL_EXPORT __STDCALL computeStep(double maxTime);
 
+    //STATE
+    __EXTERN int DLL_EXPORT __STDCALL saveStateSnapshot(const char *fileName);
+    __EXTERN int DLL_EXPORT __STDCALL loadStateSnapshot(const char *fileName);
+
 }
 
 #endif
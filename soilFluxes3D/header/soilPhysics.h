@@ -2,24 +2,28 @@
 #define SOILPHYSICS_H
 
     struct Tsoil;
+    struct TCrit3Dcontext;
 
-    double computeWaterConductivity(double Se, Tsoil *mySoil);
-    double computeSefromPsi(double myPsi, Tsoil *mySoil);
-    double theta_from_Se(unsigned long myIndex);
-    double theta_from_Se (double Se, unsigned long myIndex);
-    double theta_from_sign_Psi (double myPsi, unsigned long myIndex);
-    double Se_from_theta (unsigned long myIndex, double myTheta);
-    double psi_from_Se(unsigned long myIndex);
-    double computeSe(unsigned long myIndex);
-    double dTheta_dH(unsigned long myIndex);
-    double dThetav_dH(unsigned long myIndex, double temperature, double dTheta_dH);
-    double computeK(unsigned long myIndex);
-    double compute_K_Mualem(double Ksat, double Se, double VG_Sc, double VG_m, double Mualem_L);
-    double getThetaMean(long i);
-    double getTheta(long i, double H);
-    double getHMean(long i);
-    double getPsiMean(long i);
-    double estimateBulkDensity(long i);
-    double getTMean(long i);
+    bool buildSoilTable(TCrit3Dcontext *ctx, Tsoil *mySoil, double tolerance);
+    void cleanSoilTable(Tsoil *mySoil);
+
+    double computeWaterConductivity(TCrit3Dcontext *ctx, double Se, Tsoil *mySoil);
+    double computeSefromPsi(TCrit3Dcontext *ctx, double myPsi, Tsoil *mySoil);
+    double theta_from_Se(TCrit3Dcontext *ctx, unsigned long myIndex);
+    double theta_from_Se (TCrit3Dcontext *ctx, double Se, unsigned long myIndex);
+    double theta_from_sign_Psi (TCrit3Dcontext *ctx, double myPsi, unsigned long myIndex);
+    double Se_from_theta (TCrit3Dcontext *ctx, unsigned long myIndex, double myTheta);
+    double psi_from_Se(TCrit3Dcontext *ctx, unsigned long myIndex);
+    double computeSe(TCrit3Dcontext *ctx, unsigned long myIndex);
+    double dTheta_dH(TCrit3Dcontext *ctx, unsigned long myIndex);
+    double dThetav_dH(TCrit3Dcontext *ctx, unsigned long myIndex, double temperature, double dTheta_dH);
+    double computeK(TCrit3Dcontext *ctx, unsigned long myIndex);
+    double compute_K_Mualem(TCrit3Dcontext *ctx, double Ksat, double Se, double VG_Sc, double VG_m, double Mualem_L);
+    double getThetaMean(TCrit3Dcontext *ctx, long i);
+    double getTheta(TCrit3Dcontext *ctx, long i, double H);
+    double getHMean(TCrit3Dcontext *ctx, long i);
+    double getPsiMean(TCrit3Dcontext *ctx, long i);
+    double estimateBulkDensity(TCrit3Dcontext *ctx, long i);
+    double getTMean(TCrit3Dcontext *ctx, long i);
 
 #endif  // SOILPHYSICS_H
@@ -1,19 +1,29 @@
 #ifndef SOLVER_H
 #define SOLVER_H
 
+    struct TCrit3Dcontext;
+
     inline double square(double x) {return ((x)*(x));}
 
     inline double sign(double x) {return (x/fabs(x));}
 
-    double distance(unsigned long index1, unsigned long index2);
+    double distance(TCrit3Dcontext *ctx, unsigned long index1, unsigned long index2);
 
-    double distance2D(unsigned long index1, unsigned long index2);
+    double distance2D(TCrit3Dcontext *ctx, unsigned long index1, unsigned long index2);
 
-    double computeMean(double v1, double v2);
+    double computeMean(TCrit3Dcontext *ctx, double v1, double v2);
 
     double arithmeticMean(double v1, double v2);
 
-    bool GaussSeidelRelaxation (int myApproximation, double myResidualTolerance, int myProcess);
+    void cleanNodeColors(TCrit3Dcontext *ctx);
+
+    bool computeNodeColors(TCrit3Dcontext *ctx);
+
+    void cleanKrylovArrays(TCrit3Dcontext *ctx);
+
+    bool GaussSeidelRelaxation (TCrit3Dcontext *ctx, int myApproximation, double myResidualTolerance, int myProcess);
+
+    bool solveLinearSystem(TCrit3Dcontext *ctx, int myApproximation, double myResidualTolerance, int myProcess);
 
 #endif  // SOLVER_H
 
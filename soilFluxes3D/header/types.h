@@ -53,6 +53,21 @@
         } ;
 
 
+    /*! tabulated hydraulic functions of a soil horizon
+     *  monotone cubic (Fritsch-Carlson) interpolation on a regular grid of ln(psi) */
+    struct TsoilTable{
+        int waterRetentionCurve;    /*!< curve used to build the table */
+        long nrPoints;
+        double logPsiMin;           /*!< [ln m] first grid point */
+        double logPsiMax;           /*!< [ln m] last grid point */
+        double dLogPsi;             /*!< [ln m] grid step */
+        double *Se;                 /*!< [-] degree of saturation */
+        double *dSe;                /*!< [-] dSe/dln(psi) */
+        double *logK;               /*!< [ln m/sec] water conductivity */
+        double *dLogK;              /*!< [-] dln(K)/dln(psi) */
+        } ;
+
+
     struct Tsoil{
         double VG_alpha;            /*!< [m^-1] Van Genutchen alpha parameter */
         double VG_n;                /*!< [-] Van Genutchen n parameter */
@@ -70,22 +85,13 @@
         //for heat
         double organicMatter;       /*!< [-] fraction of organic matter */
         double clay;                /*!< [-] fraction of clay */
+
+        TsoilTable *table;          /*!< tabulated Se(psi) and K(psi), NULL if not built */
         } ;
 
 
+     /*! node topology and properties (cold data) */
      struct TCrit3Dnode{
-
-        double Se;					/*!< [-] degree of saturation */
-        double k;                   /*!< [m s^-1] soil water conductivity */
-        double H;                   /*!< [m] pressure head */
-        double oldH;				/*!< [m] previous pressure head */
-        double bestH;				/*!< [m] pressure head of best iteration */
-        double waterSinkSource;     /*!< [m^3 s^-1] water sink source */
-        double Qw;                  /*!< [m^3 s^-1] water flow */
-
-        double volume_area;         /*!< [m^3] volume of sub-surface elements : [m^2] area of surface nodes */
-        float x, y, z;              /*!< [m] coordinates of the center of the element */
-
         Tsoil *Soil;                /*!< soil pointer */
         Tboundary *boundary;        /*!< boundary pointer */
         TlinkedNode up;				/*!< upper link */
@@ -93,14 +99,34 @@
         TlinkedNode *lateral;       /*!< lateral link */
 
         TCrit3DnodeExtra* extra;    /*!< extra variables for heat and solutes */
+        } ;
+
+
+     /*! node state and geometry: one contiguous array for each variable [nrNodes] */
+     struct TCrit3DnodeData{
+        double *Se;                 /*!< [-] degree of saturation */
+        double *k;                  /*!< [m s^-1] soil water conductivity */
+        double *H;                  /*!< [m] pressure head */
+        double *oldH;               /*!< [m] previous pressure head */
+        double *bestH;              /*!< [m] pressure head of best iteration */
+        double *waterSinkSource;    /*!< [m^3 s^-1] water sink source */
+        double *Qw;                 /*!< [m^3 s^-1] water flow */
 
-        bool isSurface;
+        double *volume_area;        /*!< [m^3] volume of sub-surface elements : [m^2] area of surface nodes */
+        float *x, *y, *z;           /*!< [m] coordinates of the center of the element */
+
+        bool *isSurface;
         } ;
 
 
-     struct TmatrixElement{
-        long index;
-        double val;
+     /*! system matrix in compressed sparse row format:
+      *  the elements of row i are [rowStart[i], rowStart[i+1]), the first one is the diagonal */
+     struct Tmatrix{
+        long nrRows;
+        long nrElements;
+        long *rowStart;             /*!< [nrRows+1] position of the first element of each row */
+        long *column;               /*!< [nrElements] column index */
+        double *val;                /*!< [nrElements] value */
         } ;
 
 
@@ -115,14 +141,108 @@
         double heatMBR = 1.0;
         } ;
 
-     extern TCrit3DStructure myStructure;
-     extern TParameters myParameters;
-     extern TCrit3Dnode *myNode;
-     extern TmatrixElement **A;
-     extern double *b, *C, *X;
-     extern double *invariantFlux;         //array accessorio per flussi avvettivi e latenti
-     extern double Courant;
+     struct TsolverStatistics{
+        long nrSystems;             /*!< number of linear systems solved */
+        long nrIterations;          /*!< total number of iterations */
+        int lastIterations;         /*!< iterations of the last system */
+        double lastResidual;        /*!< [-] infinity norm of the (scaled) residual of the last system */
+
+        void initialize()
+            {
+                nrSystems = 0;
+                nrIterations = 0;
+                lastIterations = 0;
+                lastResidual = 0.;
+            }
+        } ;
+
+     struct TtimeStepStatistics{
+        long nrAccepted;            /*!< accepted water time steps */
+        long nrRejectedCourant;     /*!< rejected: Courant number > 1 */
+        long nrRejectedSolver;      /*!< rejected: linear system not converging */
+        long nrRejectedBalance;     /*!< rejected: mass balance error too high */
+        long nrHeatAccepted;        /*!< accepted heat time steps */
+        long nrHeatRejected;        /*!< rejected heat time steps (Courant number > 1) */
+
+        void initialize()
+            {
+                nrAccepted = 0;
+                nrRejectedCourant = 0;
+                nrRejectedSolver = 0;
+                nrRejectedBalance = 0;
+                nrHeatAccepted = 0;
+                nrHeatRejected = 0;
+            }
+        } ;
+
+     /*! work vectors of the Krylov solvers */
+     struct TkrylovArrays{
+        long size;
+        double *r, *r0, *p, *v, *s, *t, *x0;
+        } ;
+
+     /*! incremental assembly of the water matrix: state of the last evaluation */
+     struct TassemblyArrays{
+        long nrNodes, nrElements;
+        double *H, *oldH;                   /*!< [m] potentials of the last evaluation of k and C */
+        double *conductance;                /*!< [m^2 s^-1] link conductances, same layout of A */
+        bool *isChanged;                    /*!< k and C recomputed in the current approximation */
+        bool isValid;
+        long nrNodesComputed, nrNodesReused;
+        } ;
+
+
+     /*! soil heat properties of the nodes, valid during the assembly of one heat step:
+      *  T and the average potential of a node do not change until the system is solved */
+     struct TheatPropertyCache{
+        long nrNodes;
+        double *heatCapacity;               /*!< [J m-3 K-1] */
+        double *conductivity;               /*!< [W m-1 K-1] */
+        double *vaporConductivity;          /*!< [kg s m-3] isothermal vapor conductivity */
+        double *latentHeat;                 /*!< [J kg-1] latent heat of vaporization */
+        unsigned char *isComputed;          /*!< flags of the properties already computed */
+        bool isValid;
+        long nrEvaluations, nrReuses;
+        } ;
+
+
+     /*! the complete state of a soilFluxes3D domain:
+      *  independent contexts can be computed concurrently in different threads */
+     struct TCrit3Dcontext{
+        TCrit3DStructure myStructure;
+        TParameters myParameters;
+
+        TCrit3Dnode *myNode;
+        TCrit3DnodeData nodeData;
+        Tmatrix A;
+        double *b, *C, *X;
+        double *invariantFlux;              /*!< array accessorio per flussi avvettivi e latenti */
+
+        double Courant;
+        double CourantHeat, fluxCourant;
+        double heatTimeStart;               /*!< [s] start of the current heat step inside the water step */
+
+        Tbalance balanceCurrentTimeStep, balancePreviousTimeStep, balanceCurrentPeriod, balanceWholePeriod;
+        double bestMBRerror;
+        double previousMBRerror;            /*!< [-] MBR error of the last accepted step (adaptive time step) */
+        bool isHalfTimeStepForced;
+        TtimeStepStatistics timeStepStatistics;
 
-     extern Tbalance balanceCurrentTimeStep, balancePreviousTimeStep, balanceCurrentPeriod, balanceWholePeriod;
+        TsolverStatistics waterSolverStatistics, heatSolverStatistics;
+
+        /*! multicolor ordering: nodes of the same color are not linked, so they can be updated in parallel */
+        int nrColors;
+        long *colorNodeList;                /*!< node indices sorted by color */
+        long *colorFirstIndex;              /*!< [nrColors+1] position of the first node of each color in colorNodeList */
+
+        TkrylovArrays krylov;
+        TassemblyArrays assembly;
+        TheatPropertyCache heatCache;
+
+        Tsoil (*Soil_List)[MAX_HORIZONS];   /*!< [MAX_SOILS][MAX_HORIZONS] */
+        Tsoil *Surface_List;                /*!< [MAX_SURFACES] */
+
+        TCrit3Dcontext *topology;           /*!< ensemble member: context owning the shared topology (NULL otherwise) */
+        } ;
 
 #endif // SOILFLUXES3DTYPES
@@ -1,9 +1,13 @@
 #ifndef WATER_H
 #define WATER_H
 
-    bool waterFlowComputation(double deltaT);
-    double getWaterExchange(long index, TlinkedNode *link, double deltaT);
-    bool computeWater(double maxTime, double *acceptedTime);
-    void restoreWater();
+    struct TCrit3Dcontext;
+
+    bool waterFlowComputation(TCrit3Dcontext *ctx, double deltaT);
+    double getWaterExchange(TCrit3Dcontext *ctx, long index, TlinkedNode *link, double deltaT);
+    bool computeWater(TCrit3Dcontext *ctx, double maxTime, double *acceptedTime);
+    void restoreWater(TCrit3Dcontext *ctx);
+    void cleanAssemblyArrays(TCrit3Dcontext *ctx);
+    void invalidateAssembly(TCrit3Dcontext *ctx);
 
 #endif  // WATER_H
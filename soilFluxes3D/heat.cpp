@@ -40,42 +40,121 @@
 #include "header/soilFluxes3D.h"
 #include "header/boundary.h"
 
-double CourantHeat, fluxCourant;
-
-bool isHeatNode(long i)
+bool isHeatNode(TCrit3Dcontext *ctx, long i)
 {
-    return (myStructure.computeHeat &&
-            myNode != NULL &&
-            myNode[i].extra != NULL &&
-            myNode[i].extra->Heat != NULL &&
-            ! myNode[i].isSurface);
+    return (ctx->myStructure.computeHeat &&
+            ctx->myNode != NULL &&
+            ctx->myNode[i].extra != NULL &&
+            ctx->myNode[i].extra->Heat != NULL &&
+            ! ctx->nodeData.isSurface[i]);
 }
 
-bool isHeatLinkedNode(TlinkedNode* myLink)
+bool isHeatLinkedNode(TCrit3Dcontext *ctx, TlinkedNode* myLink)
 {
-    return (myStructure.computeHeat &&
+    return (ctx->myStructure.computeHeat &&
             myLink != NULL &&
             myLink->linkedExtra != NULL &&
             myLink->linkedExtra->heatFlux != NULL);
 }
 
-double getH_timeStep(long i, double timeStep, double timeStepWater)
+/*!
+ * \brief [m] H at the end of the heat step, linearly interpolated inside the water step
+ * (the heat step starts heatTimeStart seconds after the beginning of the water step)
+ */
+double getH_timeStep(TCrit3Dcontext *ctx, long i, double timeStep, double timeStepWater)
+{
+    return (ctx->nodeData.H[i] - ctx->nodeData.oldH[i]) / timeStepWater * (ctx->heatTimeStart + timeStep) + ctx->nodeData.oldH[i];
+}
+
+/*!
+ * \brief [m] H at the beginning of the heat step
+ */
+double getH_heatStart(TCrit3Dcontext *ctx, long i, double timeStepWater)
+{
+    if (ctx->heatTimeStart == 0.) return ctx->nodeData.oldH[i];
+    return (ctx->nodeData.H[i] - ctx->nodeData.oldH[i]) / timeStepWater * ctx->heatTimeStart + ctx->nodeData.oldH[i];
+}
+
+
+#define HEATCACHE_CONDUCTIVITY 1
+#define HEATCACHE_VAPORCONDUCTIVITY 2
+#define HEATCACHE_LATENTHEAT 4
+
+
+void cleanHeatPropertyCache(TCrit3Dcontext *ctx)
+{
+    if (ctx->heatCache.heatCapacity != NULL) { free(ctx->heatCache.heatCapacity); ctx->heatCache.heatCapacity = NULL; }
+    if (ctx->heatCache.conductivity != NULL) { free(ctx->heatCache.conductivity); ctx->heatCache.conductivity = NULL; }
+    if (ctx->heatCache.vaporConductivity != NULL) { free(ctx->heatCache.vaporConductivity); ctx->heatCache.vaporConductivity = NULL; }
+    if (ctx->heatCache.latentHeat != NULL) { free(ctx->heatCache.latentHeat); ctx->heatCache.latentHeat = NULL; }
+    if (ctx->heatCache.isComputed != NULL) { free(ctx->heatCache.isComputed); ctx->heatCache.isComputed = NULL; }
+    ctx->heatCache.nrNodes = 0;
+    ctx->heatCache.isValid = false;
+}
+
+
+bool initializeHeatPropertyCache(TCrit3Dcontext *ctx)
+{
+    if (ctx->heatCache.nrNodes == ctx->myStructure.nrNodes) return true;
+
+    cleanHeatPropertyCache(ctx);
+    ctx->heatCache.heatCapacity = (double *) calloc(ctx->myStructure.nrNodes, sizeof(double));
+    ctx->heatCache.conductivity = (double *) calloc(ctx->myStructure.nrNodes, sizeof(double));
+    ctx->heatCache.vaporConductivity = (double *) calloc(ctx->myStructure.nrNodes, sizeof(double));
+    ctx->heatCache.latentHeat = (double *) calloc(ctx->myStructure.nrNodes, sizeof(double));
+    ctx->heatCache.isComputed = (unsigned char *) calloc(ctx->myStructure.nrNodes, sizeof(unsigned char));
+
+    if (ctx->heatCache.heatCapacity == NULL || ctx->heatCache.conductivity == NULL
+        || ctx->heatCache.vaporConductivity == NULL || ctx->heatCache.latentHeat == NULL
+        || ctx->heatCache.isComputed == NULL)
+    {
+        cleanHeatPropertyCache(ctx);
+        return false;
+    }
+
+    ctx->heatCache.nrNodes = ctx->myStructure.nrNodes;
+    return true;
+}
+
+
+/*!
+ * \brief property of node i already computed in the current heat assembly
+ * (false if the cache is not in use)
+ */
+inline bool isCachedHeatProperty(TCrit3Dcontext *ctx, long i, unsigned char property)
+{
+    if (! ctx->heatCache.isValid) return false;
+
+    if (ctx->heatCache.isComputed[i] & property)
+    {
+        ctx->heatCache.nrReuses++;
+        return true;
+    }
+    return false;
+}
+
+
+inline void setCachedHeatProperty(TCrit3Dcontext *ctx, long i, unsigned char property, double *values, double value)
 {
-    return (myNode[i].H - myNode[i].oldH) / timeStepWater * timeStep + myNode[i].oldH;
+    if (! ctx->heatCache.isValid) return;
+
+    values[i] = value;
+    ctx->heatCache.isComputed[i] |= property;
+    ctx->heatCache.nrEvaluations++;
 }
 
-double computeHeatStorage(double timeStepHeat, double timeStepWater)
+double computeHeatStorage(TCrit3Dcontext *ctx, double timeStepHeat, double timeStepWater)
 { // [J]
     double myHeatStorage = 0.;
     double myH;
-    for (long i = 1; i < myStructure.nrNodes; i++)
+    for (long i = 1; i < ctx->myStructure.nrNodes; i++)
     {
         if (timeStepHeat != NODATA && timeStepWater != NODATA)
-            myH = getH_timeStep(i, timeStepHeat, timeStepWater);
+            myH = getH_timeStep(ctx, i, timeStepHeat, timeStepWater);
         else
-            myH = myNode[i].H;
+            myH = ctx->nodeData.H[i];
 
-        myHeatStorage += soilFluxes3D::getHeat(i, myH - myNode[i].z);
+        myHeatStorage += soilFluxes3D::getHeat(ctx, i, myH - ctx->nodeData.z[i]);
     }
     return myHeatStorage;
 }
@@ -85,37 +164,37 @@ double computeHeatStorage(double timeStepHeat, double timeStepWater)
  * \param deltaT
  * \return result
  */
-double sumHeatFlow(double deltaT)
+double sumHeatFlow(TCrit3Dcontext *ctx, double deltaT)
 {
     double sum = 0.0;
-    for (long n = 1; n < myStructure.nrNodes; n++)
+    for (long n = 1; n < ctx->myStructure.nrNodes; n++)
     {
-        if (myNode[n].extra->Heat->Qh != 0.)
-            sum += myNode[n].extra->Heat->Qh * deltaT;
+        if (ctx->myNode[n].extra->Heat->Qh != 0.)
+            sum += ctx->myNode[n].extra->Heat->Qh * deltaT;
     }
     return (sum);
 }
 
-void computeHeatBalance(double myTimeStep, double timeStepWater)
+void computeHeatBalance(TCrit3Dcontext *ctx, double myTimeStep, double timeStepWater)
 {
-    balanceCurrentTimeStep.sinkSourceHeat = sumHeatFlow(myTimeStep);
+    ctx->balanceCurrentTimeStep.sinkSourceHeat = sumHeatFlow(ctx, myTimeStep);
 
-    balanceCurrentTimeStep.storageHeat = computeHeatStorage(myTimeStep, timeStepWater);
+    ctx->balanceCurrentTimeStep.storageHeat = computeHeatStorage(ctx, myTimeStep, timeStepWater);
 
-    double deltaHeatStorage = balanceCurrentTimeStep.storageHeat - balancePreviousTimeStep.storageHeat;
-    balanceCurrentTimeStep.heatMBE = deltaHeatStorage - balanceCurrentTimeStep.sinkSourceHeat;
+    double deltaHeatStorage = ctx->balanceCurrentTimeStep.storageHeat - ctx->balancePreviousTimeStep.storageHeat;
+    ctx->balanceCurrentTimeStep.heatMBE = deltaHeatStorage - ctx->balanceCurrentTimeStep.sinkSourceHeat;
 
-    double referenceHeat = max_value(fabs(balanceCurrentTimeStep.sinkSourceHeat), balanceCurrentTimeStep.storageHeat * 1e-6);
-    balanceCurrentTimeStep.heatMBR = 1. - balanceCurrentTimeStep.heatMBE / referenceHeat;
+    double referenceHeat = max_value(fabs(ctx->balanceCurrentTimeStep.sinkSourceHeat), ctx->balanceCurrentTimeStep.storageHeat * 1e-6);
+    ctx->balanceCurrentTimeStep.heatMBR = 1. - ctx->balanceCurrentTimeStep.heatMBE / referenceHeat;
 }
 
-float readHeatFlux(TlinkedNode* myLink, int fluxType)
+float readHeatFlux(TCrit3Dcontext *ctx, TlinkedNode* myLink, int fluxType)
 {
-    if (! isHeatLinkedNode(myLink)) return NODATA;
+    if (! isHeatLinkedNode(ctx, myLink)) return NODATA;
 
-    if (myStructure.saveHeatFluxesType == SAVE_HEATFLUXES_TOTAL && fluxType == HEATFLUX_TOTAL)
+    if (ctx->myStructure.saveHeatFluxesType == SAVE_HEATFLUXES_TOTAL && fluxType == HEATFLUX_TOTAL)
         return myLink->linkedExtra->heatFlux->fluxes[HEATFLUX_TOTAL];
-    else if (myStructure.saveHeatFluxesType == SAVE_HEATFLUXES_ALL && (fluxType == HEATFLUX_TOTAL ||
+    else if (ctx->myStructure.saveHeatFluxesType == SAVE_HEATFLUXES_ALL && (fluxType == HEATFLUX_TOTAL ||
             fluxType == HEATFLUX_DIFFUSIVE ||
             fluxType == HEATFLUX_LATENT_ISOTHERMAL ||
             fluxType == HEATFLUX_LATENT_THERMAL ||
@@ -130,18 +209,18 @@ float readHeatFlux(TlinkedNode* myLink, int fluxType)
         return NODATA;
 }
 
-void saveHeatFlux(TlinkedNode* myLink, int fluxType, double myValue)
+void saveHeatFlux(TCrit3Dcontext *ctx, TlinkedNode* myLink, int fluxType, double myValue)
 {
-    if (! isHeatLinkedNode(myLink)) return;
+    if (! isHeatLinkedNode(ctx, myLink)) return;
 
-    if (myStructure.saveHeatFluxesType == SAVE_HEATFLUXES_NONE) return;
+    if (ctx->myStructure.saveHeatFluxesType == SAVE_HEATFLUXES_NONE) return;
 
     if (myLink->linkedExtra->heatFlux->fluxes[HEATFLUX_TOTAL] == NODATA)
         myLink->linkedExtra->heatFlux->fluxes[HEATFLUX_TOTAL] = float(myValue);
     else
         myLink->linkedExtra->heatFlux->fluxes[HEATFLUX_TOTAL] += float(myValue);
 
-    if (myStructure.saveHeatFluxesType == SAVE_HEATFLUXES_ALL)
+    if (ctx->myStructure.saveHeatFluxesType == SAVE_HEATFLUXES_ALL)
         myLink->linkedExtra->heatFlux->fluxes[fluxType] = float(myValue);
 }
 
@@ -152,11 +231,18 @@ void saveHeatFlux(TlinkedNode* myLink, int fluxType, double myValue)
  * \param i
  * \return result
  */
-double VaporThetaV(double h, double T, long i)
+double VaporThetaV(TCrit3Dcontext *ctx, double h, double T, long i)
+{
+    return VaporThetaV(ctx, h, T, theta_from_sign_Psi(ctx, h, i), i);
+}
+
+/*!
+ * \brief [m3 m-3] vapor volumetric water equivalent, water content already known
+ */
+double VaporThetaV(TCrit3Dcontext *ctx, double h, double T, double theta, long i)
 {
-    double theta = theta_from_sign_Psi(h, i);
     double vaporConc = VaporFromPsiTemp(h, T);
-    return (vaporConc / WATER_DENSITY * (myNode[i].Soil->Theta_s - theta));
+    return (vaporConc / WATER_DENSITY * (ctx->myNode[i].Soil->Theta_s - theta));
 }
 
 /*!
@@ -204,10 +290,10 @@ double SoilRelativeHumidity(double h, double myT)
  * \param myT
  * \return result
  */
-double IsothermalVaporConductivity(long i, double h, double myT)
+double IsothermalVaporConductivity(TCrit3Dcontext *ctx, long i, double h, double myT)
 {
-    double theta = theta_from_sign_Psi(h, i);
-    double Dv = SoilVaporDiffusivity(myNode[i].Soil->Theta_s, theta, myT);
+    double theta = theta_from_sign_Psi(ctx, h, i);
+    double Dv = SoilVaporDiffusivity(ctx->myNode[i].Soil->Theta_s, theta, myT);
     double vapor = VaporFromPsiTemp(h, myT);
     return (Dv * vapor * MH2O / (R_GAS * myT));
 }
@@ -219,17 +305,16 @@ double IsothermalVaporConductivity(long i, double h, double myT)
  * \param T
  * \return result
  */
-double SoilHeatCapacity(long i, double h, double T)
+double SoilHeatCapacity(TCrit3Dcontext *ctx, long i, double h, double T)
 {
     double heatCapacity;
-    double theta = theta_from_sign_Psi(h, i);
-    double thetaV = VaporThetaV(h, T, i);
-    double bulkDensity = estimateBulkDensity(i);
+    double theta = theta_from_sign_Psi(ctx, h, i);
+    double bulkDensity = estimateBulkDensity(ctx, i);
     heatCapacity = bulkDensity / 2.65 * HEAT_CAPACITY_MINERAL +
             theta * HEAT_CAPACITY_WATER;
 
-    if (myStructure.computeHeatVapor)
-        heatCapacity += thetaV * HEAT_CAPACITY_AIR;
+    if (ctx->myStructure.computeHeatVapor)
+        heatCapacity += VaporThetaV(ctx, h, T, theta, i) * HEAT_CAPACITY_AIR;
 
     return heatCapacity;
 }
@@ -298,7 +383,7 @@ double ThermalLiquidConductivity(double temp_celsius, double h, double Klh)
  * \param h (m)
  * \return result
  */
-double ThermalVaporConductivity(long i, double temperature, double h)
+double ThermalVaporConductivity(TCrit3Dcontext *ctx, long i, double temperature, double h)
 {
     double myPressure;				// [Pa] total air pressure
 	double Dv;						// [m2 s-1] vapor diffusivity
@@ -315,12 +400,12 @@ double ThermalVaporConductivity(long i, double temperature, double h)
 
     tempCelsius = temperature - ZEROCELSIUS;
 
-    myPressure = PressureFromAltitude(myNode[i].z);
+    myPressure = PressureFromAltitude(ctx->nodeData.z[i]);
 
-    theta = theta_from_sign_Psi(h, i);
+    theta = theta_from_sign_Psi(ctx, h, i);
 
 	// vapor diffusivity
-    Dv = SoilVaporDiffusivity(myNode[i].Soil->Theta_s, theta, temperature);
+    Dv = SoilVaporDiffusivity(ctx->myNode[i].Soil->Theta_s, theta, temperature);
 
 	// slope of saturation vapor pressure
     svp = SaturationVaporPressure(tempCelsius);
@@ -335,8 +420,8 @@ double ThermalVaporConductivity(long i, double temperature, double h)
 	hr = myVaporPressure / svp;
 
     // enhancement factor (Cass et al. 1984)
-    satDegree = theta / myNode[i].Soil->Theta_s;
-    eta = 9.5 + 3. * satDegree - 8.5 * exp(-pow((1. + 2.6/sqrt(myNode[i].Soil->clay))*satDegree, 4));
+    satDegree = theta / ctx->myNode[i].Soil->Theta_s;
+    eta = 9.5 + 3. * satDegree - 8.5 * exp(-pow((1. + 2.6/sqrt(ctx->myNode[i].Soil->clay))*satDegree, 4));
 
     return (eta * Dv * slopesvc * hr);
 
@@ -349,7 +434,7 @@ double ThermalVaporConductivity(long i, double temperature, double h)
  * \param h: water matric potential [m]
  * \return result
  */
-double AirHeatConductivity(long i, double T, double h)
+double AirHeatConductivity(TCrit3Dcontext *ctx, long i, double T, double h)
 {
     double Kda;						// [W m-1 K-1] thermal conductivity of dry air
     double Ka;						// [W m-1 K-1] thermal conductivity of air
@@ -364,13 +449,13 @@ double AirHeatConductivity(long i, double T, double h)
 
     Ka = Kda;
 
-    if (myStructure.computeWater)
+    if (ctx->myStructure.computeWater)
     {
         myLambda = LatentHeatVaporization(T - ZEROCELSIUS);
 
         coeff= myLambda;
 
-        myKvt = ThermalVaporConductivity(i, T, h);
+        myKvt = ThermalVaporConductivity(ctx, i, T, h);
         Ka += coeff * myKvt;
     }
 
@@ -385,7 +470,7 @@ double AirHeatConductivity(long i, double T, double h)
  * \param h: water matric potential [m]
  * \return result
  */
-double SoilHeatConductivity(long i, double T, double h)
+double SoilHeatConductivity(TCrit3Dcontext *ctx, long i, double T, double h)
 {
 	double ga = 0.088;				// [] deVries shape factor; assume same for all mineral soils
 	double gc;						// [] shape factor
@@ -408,11 +493,11 @@ double SoilHeatConductivity(long i, double T, double h)
 	Kw = 0.554 + 0.0024 * myTCelsiusMean - 0.00000987 * myTCelsiusMean * myTCelsiusMean;
 
 	// air conductivity
-    Ka = AirHeatConductivity(i, T, h);
+    Ka = AirHeatConductivity(ctx, i, T, h);
 
-    xw = theta_from_sign_Psi(h, i);
+    xw = theta_from_sign_Psi(ctx, h, i);
 
-    fw = WaterReturnFlowFactor(xw, myNode[i].Soil->clay, myTCelsiusMean + ZEROCELSIUS);
+    fw = WaterReturnFlowFactor(xw, ctx->myNode[i].Soil->clay, myTCelsiusMean + ZEROCELSIUS);
 	Kf = Ka + fw * (Kw - Ka);
 
 	gc = 1. - 2. * ga;
@@ -421,8 +506,8 @@ double SoilHeatConductivity(long i, double T, double h)
 	ew = (2. / (1 + (Kw / Kf - 1) * ga) + 1 / (1 + (Kw / Kf - 1) * gc)) / 3.;
     es = (2. / (1 + (KH_mineral / Kf - 1) * ga) + 1 / (1 + (KH_mineral / Kf - 1) * gc)) / 3.;
 
-	xs = 1. - myNode[i].Soil->Theta_s;
-	xa = myNode[i].Soil->Theta_s - xw;
+	xs = 1. - ctx->myNode[i].Soil->Theta_s;
+	xa = ctx->myNode[i].Soil->Theta_s - xw;
 
     myConductivity = (xw * ew * Kw + xa * ea * Ka + xs * es * KH_mineral) / (ew * xw + ea * xa + es * xs);
     return myConductivity;
@@ -434,7 +519,7 @@ double SoilHeatConductivity(long i, double T, double h)
  * \param myLink
  * \return result
  */
-double ThermalLiquidFlux(long i, TlinkedNode *myLink, int myProcess, double timeStep, double timeStepWater)
+double ThermalLiquidFlux(TCrit3Dcontext *ctx, long i, TlinkedNode *myLink, int myProcess, double timeStep, double timeStepWater)
 {
     //TODO: inserire time step water per calcolo più preciso
 
@@ -442,30 +527,30 @@ double ThermalLiquidFlux(long i, TlinkedNode *myLink, int myProcess, double time
 
     // temperatures (K) and water potential (m)
     double tavg, tavgLink, havg, havgLink;
-    if (myProcess == PROCESS_WATER && myStructure.computeWater)
+    if (myProcess == PROCESS_WATER && ctx->myStructure.computeWater)
     {
-        tavg = getTMean(i);
-        tavgLink = getTMean(j);
-        havg = myNode[i].H - myNode[i].z;
-        havgLink = myNode[j].H - myNode[j].z;
+        tavg = getTMean(ctx, i);
+        tavgLink = getTMean(ctx, j);
+        havg = ctx->nodeData.H[i] - ctx->nodeData.z[i];
+        havgLink = ctx->nodeData.H[j] - ctx->nodeData.z[j];
     }
-    else if (myProcess = PROCESS_HEAT && myStructure.computeHeat)
+    else if (myProcess = PROCESS_HEAT && ctx->myStructure.computeHeat)
     {
-        tavg = myNode[i].extra->Heat->T;
-        tavgLink = myNode[j].extra->Heat->T;
-        havg = arithmeticMean(getH_timeStep(i, timeStep, timeStepWater), myNode[i].oldH) - myNode[i].z;
-        havgLink = arithmeticMean(getH_timeStep(j, timeStep, timeStepWater), myNode[j].oldH) - myNode[j].z;
+        tavg = ctx->myNode[i].extra->Heat->T;
+        tavgLink = ctx->myNode[j].extra->Heat->T;
+        havg = arithmeticMean(getH_timeStep(ctx, i, timeStep, timeStepWater), getH_heatStart(ctx, i, timeStepWater)) - ctx->nodeData.z[i];
+        havgLink = arithmeticMean(getH_timeStep(ctx, j, timeStep, timeStepWater), getH_heatStart(ctx, j, timeStepWater)) - ctx->nodeData.z[j];
     }
     else
         return NODATA;
 
     // m2 K-1 s-1
-    double Klt = ThermalLiquidConductivity(tavg - ZEROCELSIUS, havg, myNode[i].k);
-    double KltLink = ThermalLiquidConductivity(tavgLink - ZEROCELSIUS, havgLink, myNode[j].k);
-    double meanKlt = computeMean(Klt, KltLink);
+    double Klt = ThermalLiquidConductivity(tavg - ZEROCELSIUS, havg, ctx->nodeData.k[i]);
+    double KltLink = ThermalLiquidConductivity(tavgLink - ZEROCELSIUS, havgLink, ctx->nodeData.k[j]);
+    double meanKlt = computeMean(ctx, Klt, KltLink);
 
     // m s-1
-    double myFlowDensity = meanKlt * (tavgLink - tavg) / distance(i, j);
+    double myFlowDensity = meanKlt * (tavgLink - tavg) / distance(ctx, i, j);
 
     // m3 s-1
     double myFlow = myFlowDensity * (*myLink).area;
@@ -479,7 +564,7 @@ double ThermalLiquidFlux(long i, TlinkedNode *myLink, int myProcess, double time
  * \param myLink
  * \return result
  */
-double ThermalVaporFlux(long i, TlinkedNode *myLink, int myProcess, double timeStep, double timeStepWater)
+double ThermalVaporFlux(TCrit3Dcontext *ctx, long i, TlinkedNode *myLink, int myProcess, double timeStep, double timeStepWater)
 {
     //TODO: inserire time step water per calcolo più preciso
 
@@ -487,30 +572,30 @@ double ThermalVaporFlux(long i, TlinkedNode *myLink, int myProcess, double timeS
 
     // temperatures (K) and water potential (m)
     double tavg, tavgLink, havg, havgLink;
-    if (myProcess == PROCESS_WATER && myStructure.computeWater)
+    if (myProcess == PROCESS_WATER && ctx->myStructure.computeWater)
     {
-        tavg = getTMean(i);
-        tavgLink = getTMean(j);
-        havg = myNode[i].H - myNode[i].z;
-        havgLink = myNode[j].H - myNode[j].z;
+        tavg = getTMean(ctx, i);
+        tavgLink = getTMean(ctx, j);
+        havg = ctx->nodeData.H[i] - ctx->nodeData.z[i];
+        havgLink = ctx->nodeData.H[j] - ctx->nodeData.z[j];
     }
-    else if (myProcess = PROCESS_HEAT && myStructure.computeHeat)
+    else if (myProcess = PROCESS_HEAT && ctx->myStructure.computeHeat)
     {
-        tavg = myNode[i].extra->Heat->T;
-        tavgLink = myNode[j].extra->Heat->T;
-        havg = arithmeticMean(getH_timeStep(i, timeStep, timeStepWater), myNode[i].oldH) - myNode[i].z;
-        havgLink = arithmeticMean(getH_timeStep(j, timeStep, timeStepWater), myNode[j].oldH) - myNode[j].z;
+        tavg = ctx->myNode[i].extra->Heat->T;
+        tavgLink = ctx->myNode[j].extra->Heat->T;
+        havg = arithmeticMean(getH_timeStep(ctx, i, timeStep, timeStepWater), getH_heatStart(ctx, i, timeStepWater)) - ctx->nodeData.z[i];
+        havgLink = arithmeticMean(getH_timeStep(ctx, j, timeStep, timeStepWater), getH_heatStart(ctx, j, timeStepWater)) - ctx->nodeData.z[j];
     }
     else
         return NODATA;
 
     // kg m-1 s-1 K-1
-    double Kvt = ThermalVaporConductivity(i, tavg, havg);
-    double KvtLink = ThermalVaporConductivity(j, tavgLink, havgLink);
-    double meanKv = computeMean(Kvt, KvtLink);
+    double Kvt = ThermalVaporConductivity(ctx, i, tavg, havg);
+    double KvtLink = ThermalVaporConductivity(ctx, j, tavgLink, havgLink);
+    double meanKv = computeMean(ctx, Kvt, KvtLink);
 
     // kg m-2 s-1
-    double myFlowDensity = meanKv * (tavgLink - tavg) / distance(i, j);
+    double myFlowDensity = meanKv * (tavgLink - tavg) / distance(ctx, i, j);
 
     // kg s-1
     double myFlow = myFlowDensity * (*myLink).area;
@@ -518,13 +603,54 @@ double ThermalVaporFlux(long i, TlinkedNode *myLink, int myProcess, double timeS
     return (myFlow);
 }
 
+/*!
+ * \brief [kg s m-3] isothermal vapor conductivity of node i at its current temperature
+ * \param h [m] average matric potential of the heat step
+ */
+double nodeIsothermalVaporConductivity(TCrit3Dcontext *ctx, long i, double h)
+{
+    if (isCachedHeatProperty(ctx, i, HEATCACHE_VAPORCONDUCTIVITY))
+        return ctx->heatCache.vaporConductivity[i];
+
+    double Kv = IsothermalVaporConductivity(ctx, i, h, ctx->myNode[i].extra->Heat->T);
+    setCachedHeatProperty(ctx, i, HEATCACHE_VAPORCONDUCTIVITY, ctx->heatCache.vaporConductivity, Kv);
+    return Kv;
+}
+
+/*!
+ * \brief [J kg-1] latent heat of vaporization of node i at its current temperature
+ */
+double nodeLatentHeatVaporization(TCrit3Dcontext *ctx, long i)
+{
+    if (isCachedHeatProperty(ctx, i, HEATCACHE_LATENTHEAT))
+        return ctx->heatCache.latentHeat[i];
+
+    double lambda = LatentHeatVaporization(ctx->myNode[i].extra->Heat->T - ZEROCELSIUS);
+    setCachedHeatProperty(ctx, i, HEATCACHE_LATENTHEAT, ctx->heatCache.latentHeat, lambda);
+    return lambda;
+}
+
+/*!
+ * \brief [W m-1 K-1] heat conductivity of node i at its current temperature
+ * \param h [m] average matric potential of the heat step
+ */
+double nodeHeatConductivity(TCrit3Dcontext *ctx, long i, double h)
+{
+    if (isCachedHeatProperty(ctx, i, HEATCACHE_CONDUCTIVITY))
+        return ctx->heatCache.conductivity[i];
+
+    double lambda = SoilHeatConductivity(ctx, i, ctx->myNode[i].extra->Heat->T, h);
+    setCachedHeatProperty(ctx, i, HEATCACHE_CONDUCTIVITY, ctx->heatCache.conductivity, lambda);
+    return lambda;
+}
+
 /*!
  * \brief isothermal vapor flux
  * \param i
  * \param myLink
  * \return isothermal vapor flux [kg s-1]
  */
-double IsothermalVaporFlux(long i, TlinkedNode *myLink, double timeStep, double timeStepWater)
+double IsothermalVaporFlux(TCrit3Dcontext *ctx, long i, TlinkedNode *myLink, double timeStep, double timeStepWater)
 {
     double myKvi;								// [kg s m-3] vapor conductivity
     double psi, psiLink;                        // [J kg-1 = m2 s-2] water matric potential
@@ -535,19 +661,19 @@ double IsothermalVaporFlux(long i, TlinkedNode *myLink, double timeStep, double
 
     long j = (*myLink).index;
 
-    havg = arithmeticMean(getH_timeStep(i, timeStep, timeStepWater), myNode[i].oldH) - myNode[i].z;
-    havglink = arithmeticMean(getH_timeStep(j, timeStep, timeStepWater), myNode[j].oldH) - myNode[j].z;
+    havg = arithmeticMean(getH_timeStep(ctx, i, timeStep, timeStepWater), getH_heatStart(ctx, i, timeStepWater)) - ctx->nodeData.z[i];
+    havglink = arithmeticMean(getH_timeStep(ctx, j, timeStep, timeStepWater), getH_heatStart(ctx, j, timeStepWater)) - ctx->nodeData.z[j];
 
-    Kvi = IsothermalVaporConductivity(i, havg, myNode[i].extra->Heat->T);
-    KviLink = IsothermalVaporConductivity(j, havglink, myNode[j].extra->Heat->T);
-    myKvi = computeMean(Kvi, KviLink);
+    Kvi = nodeIsothermalVaporConductivity(ctx, i, havg);
+    KviLink = nodeIsothermalVaporConductivity(ctx, j, havglink);
+    myKvi = computeMean(ctx, Kvi, KviLink);
 
     psi = havg * GRAVITY;
     psiLink = havglink * GRAVITY;
 
     deltaPsi = (psiLink - psi);
 
-    myFlux = myKvi * deltaPsi / distance(i, j) * myLink->area;
+    myFlux = myKvi * deltaPsi / distance(ctx, i, j) * myLink->area;
 
     return (myFlux);
 }
@@ -558,18 +684,18 @@ double IsothermalVaporFlux(long i, TlinkedNode *myLink, double timeStep, double
  * \param myLink
  * \return isothermal latent heat flux [W]
  */
-double IsothermalLatentHeatFlux(long i, TlinkedNode *myLink, double timeStep, double timeStepWater)
+double IsothermalLatentHeatFlux(TCrit3Dcontext *ctx, long i, TlinkedNode *myLink, double timeStep, double timeStepWater)
 {
     double lambda, lambdaLink, avgLambda;       // [J kg-1] latent heat of vaporization
     double myLatentFlux;						// [J s-1] latent heat flow
 
     long j = (*myLink).index;
 
-    lambda = LatentHeatVaporization(myNode[i].extra->Heat->T - ZEROCELSIUS);
-    lambdaLink = LatentHeatVaporization(myNode[j].extra->Heat->T - ZEROCELSIUS);
+    lambda = nodeLatentHeatVaporization(ctx, i);
+    lambdaLink = nodeLatentHeatVaporization(ctx, j);
     avgLambda = arithmeticMean(lambda, lambdaLink);
 
-    myLatentFlux = avgLambda * IsothermalVaporFlux(i, myLink, timeStep, timeStepWater);
+    myLatentFlux = avgLambda * IsothermalVaporFlux(ctx, i, myLink, timeStep, timeStepWater);
 
     return (myLatentFlux);
 }
@@ -580,7 +706,7 @@ double IsothermalLatentHeatFlux(long i, TlinkedNode *myLink, double timeStep, do
  * \param myLink
  * \return advective liquid water heat flux [W]
  */
-double AdvectiveFlux(long i, TlinkedNode *myLink)
+double AdvectiveFlux(TCrit3Dcontext *ctx, long i, TlinkedNode *myLink)
 {
     double TliqAdv, TvapAdv;
     double liqWaterFlux, vapWaterFlux;
@@ -589,29 +715,29 @@ double AdvectiveFlux(long i, TlinkedNode *myLink)
     liqWaterFlux = (*myLink).linkedExtra->heatFlux->waterFlux;
 
     if (liqWaterFlux < 0.)
-        TliqAdv = myNode[i].extra->Heat->T;
+        TliqAdv = ctx->myNode[i].extra->Heat->T;
     else
-        TliqAdv = myNode[myLink->index].extra->Heat->T;
+        TliqAdv = ctx->myNode[myLink->index].extra->Heat->T;
 
-    fluxCourant += HEAT_CAPACITY_WATER * liqWaterFlux;
-    advection = fluxCourant * TliqAdv;
+    ctx->fluxCourant += HEAT_CAPACITY_WATER * liqWaterFlux;
+    advection = ctx->fluxCourant * TliqAdv;
 
     vapWaterFlux = (*myLink).linkedExtra->heatFlux->vaporFlux;
 
     if (vapWaterFlux < 0.)
-        TvapAdv = myNode[i].extra->Heat->T;
+        TvapAdv = ctx->myNode[i].extra->Heat->T;
     else
-        TvapAdv = myNode[myLink->index].extra->Heat->T;
+        TvapAdv = ctx->myNode[myLink->index].extra->Heat->T;
 
     double fluxCourantVap = HEAT_CAPACITY_WATER_VAPOR * vapWaterFlux;
-    fluxCourant += fluxCourantVap;
+    ctx->fluxCourant += fluxCourantVap;
     advection += fluxCourantVap * TvapAdv;
 
     return (advection);
 }
 
 
-double Conduction(long i, TlinkedNode *myLink, double timeStep, double timeStepWater)
+double Conduction(TCrit3Dcontext *ctx, long i, TlinkedNode *myLink, double timeStep, double timeStepWater)
 {
 	double myConductivity, linkConductivity, meanKh;
     double zeta;
@@ -619,23 +745,23 @@ double Conduction(long i, TlinkedNode *myLink, double timeStep, double timeStepW
     double myH, myHLink;
 
     long j = (*myLink).index;
-    double myDistance = distance(i, j);
+    double myDistance = distance(ctx, i, j);
 
     zeta = myLink->area / myDistance;
 
-    myH = getH_timeStep(i, timeStep, timeStepWater);
-    myHLink = getH_timeStep(j, timeStep, timeStepWater);
-    hAvg = arithmeticMean(myH, myNode[i].oldH) - myNode[i].z;
-    hLinkAvg = arithmeticMean(myHLink, myNode[j].oldH) - myNode[j].z;
+    myH = getH_timeStep(ctx, i, timeStep, timeStepWater);
+    myHLink = getH_timeStep(ctx, j, timeStep, timeStepWater);
+    hAvg = arithmeticMean(myH, getH_heatStart(ctx, i, timeStepWater)) - ctx->nodeData.z[i];
+    hLinkAvg = arithmeticMean(myHLink, getH_heatStart(ctx, j, timeStepWater)) - ctx->nodeData.z[j];
 
-    myConductivity = SoilHeatConductivity(i, myNode[i].extra->Heat->T, hAvg);
-    linkConductivity = SoilHeatConductivity(j, myNode[j].extra->Heat->T, hLinkAvg);
-    meanKh = computeMean(myConductivity, linkConductivity);
+    myConductivity = nodeHeatConductivity(ctx, i, hAvg);
+    linkConductivity = nodeHeatConductivity(ctx, j, hLinkAvg);
+    meanKh = computeMean(ctx, myConductivity, linkConductivity);
 
     return (zeta * meanKh);
 }
 
-bool computeHeatFlux(long i, int myMatrixIndex, TlinkedNode *myLink, double timeStep, double timeStepWater)
+bool computeHeatFlux(TCrit3Dcontext *ctx, long i, long myMatrixIndex, TlinkedNode *myLink, double timeStep, double timeStepWater)
 {
     if (myLink == NULL) return false;
     if ((*myLink).index == NOLINK) return false;
@@ -644,45 +770,49 @@ bool computeHeatFlux(long i, int myMatrixIndex, TlinkedNode *myLink, double time
     double myConduction, myAdvectiveFlux, myLatentFlux;
     double nodeDistance;
 
-    if (! isHeatNode(myLinkIndex)) return false;
+    // link with a node without heat (surface): no exchange, but the element is in the matrix pattern
+    if (! isHeatNode(ctx, myLinkIndex))
+    {
+        ctx->A.val[myMatrixIndex] = 0.;
+        return true;
+    }
 
     myConduction = 0.;
     myAdvectiveFlux = 0.;
     myLatentFlux = 0.;
-    fluxCourant = 0.;
+    ctx->fluxCourant = 0.;
 
-    myConduction = Conduction(i, myLink, timeStep, timeStepWater);
-    if (myStructure.computeWater)
+    myConduction = Conduction(ctx, i, myLink, timeStep, timeStepWater);
+    if (ctx->myStructure.computeWater)
     {
-        if (myStructure.computeHeatVapor)
+        if (ctx->myStructure.computeHeatVapor)
         {
-            myLatentFlux = IsothermalLatentHeatFlux(i, myLink, timeStep, timeStepWater);
-            saveHeatFlux(myLink, HEATFLUX_LATENT_ISOTHERMAL, myLatentFlux);
+            myLatentFlux = IsothermalLatentHeatFlux(ctx, i, myLink, timeStep, timeStepWater);
+            saveHeatFlux(ctx, myLink, HEATFLUX_LATENT_ISOTHERMAL, myLatentFlux);
         }
 
-        if (myStructure.computeHeatAdvection)
+        if (ctx->myStructure.computeHeatAdvection)
         {
-            myAdvectiveFlux = AdvectiveFlux(i, myLink);
-            saveHeatFlux(myLink, HEATFLUX_ADVECTIVE, myAdvectiveFlux);
+            myAdvectiveFlux = AdvectiveFlux(ctx, i, myLink);
+            saveHeatFlux(ctx, myLink, HEATFLUX_ADVECTIVE, myAdvectiveFlux);
         }
     }
 
-    A[i][myMatrixIndex].index = myLinkIndex;
-    A[i][myMatrixIndex].val = myConduction;
+    ctx->A.val[myMatrixIndex] = myConduction;
 
-    invariantFlux[i] += myAdvectiveFlux + myLatentFlux;
+    ctx->invariantFlux[i] += myAdvectiveFlux + myLatentFlux;
 
-    if (fluxCourant != 0)
+    if (ctx->fluxCourant != 0)
     {
-        nodeDistance = distance(i, myLinkIndex);
-        CourantHeat = max_value(CourantHeat, fabs(fluxCourant) * timeStep / (C[i] * nodeDistance));
+        nodeDistance = distance(ctx, i, myLinkIndex);
+        ctx->CourantHeat = max_value(ctx->CourantHeat, fabs(ctx->fluxCourant) * timeStep / (ctx->C[i] * nodeDistance));
     }
 
     return (true);
 }
 
 // should be called only BEFORE heat computation, since A matrix should contain water flux values
-void saveNodeWaterFlux(long i, TlinkedNode *link, double timeStepHeat, double timeStepWater)
+void saveNodeWaterFlux(TCrit3Dcontext *ctx, long i, TlinkedNode *link, double timeStepHeat, double timeStepWater)
 {
     if (link == NULL) return;
 
@@ -694,23 +824,23 @@ void saveNodeWaterFlux(long i, TlinkedNode *link, double timeStepHeat, double ti
     double thermVapFlux = 0.;
 
     double avgH, avgHLink;
-    avgH = getH_timeStep(i, timeStepHeat, timeStepWater);
-    avgHLink = getH_timeStep(link->index, timeStepHeat, timeStepWater);
+    avgH = getH_timeStep(ctx, i, timeStepHeat, timeStepWater);
+    avgHLink = getH_timeStep(ctx, link->index, timeStepHeat, timeStepWater);
 
-    double matrixValue = getMatrixValue(i, link);
+    double matrixValue = getMatrixValue(ctx, i, link);
     if (matrixValue != INDEX_ERROR) isothLiqFlux = matrixValue * (avgH - avgHLink);
 
-    if (!myNode[i].isSurface && ! myNode[link->index].isSurface)
+    if (!ctx->nodeData.isSurface[i] && ! ctx->nodeData.isSurface[link->index])
     {
         // compute isothermal vapor flux and subtract from total water flux
         // (because fluxLiquid is computed from A matrix which include isothermal vapor flux component)
-        isothVapFlux = IsothermalVaporFlux(i, link, timeStepHeat, timeStepWater);
+        isothVapFlux = IsothermalVaporFlux(ctx, i, link, timeStepHeat, timeStepWater);
 
         // thermal liquid flux
-        thermLiqFlux = ThermalLiquidFlux(i, link, PROCESS_HEAT, timeStepHeat, timeStepWater);
+        thermLiqFlux = ThermalLiquidFlux(ctx, i, link, PROCESS_HEAT, timeStepHeat, timeStepWater);
 
         // thermal vapor flux
-        thermVapFlux = ThermalVaporFlux(i, link, PROCESS_HEAT, timeStepHeat, timeStepWater);
+        thermVapFlux = ThermalVaporFlux(ctx, i, link, PROCESS_HEAT, timeStepHeat, timeStepWater);
     }
 
     fluxLiquid = isothLiqFlux - isothVapFlux / WATER_DENSITY + thermLiqFlux;
@@ -719,7 +849,7 @@ void saveNodeWaterFlux(long i, TlinkedNode *link, double timeStepHeat, double ti
     link->linkedExtra->heatFlux->waterFlux = (float)fluxLiquid;
     link->linkedExtra->heatFlux->vaporFlux = (float)fluxVapor;
 
-    if (myStructure.saveHeatFluxesType == SAVE_HEATFLUXES_ALL)
+    if (ctx->myStructure.saveHeatFluxesType == SAVE_HEATFLUXES_ALL)
     {
         link->linkedExtra->heatFlux->fluxes[WATERFLUX_LIQUID_ISOTHERMAL] = (float)isothLiqFlux;
         link->linkedExtra->heatFlux->fluxes[WATERFLUX_LIQUID_THERMAL] = (float)thermLiqFlux;
@@ -730,269 +860,302 @@ void saveNodeWaterFlux(long i, TlinkedNode *link, double timeStepHeat, double ti
     return;
 }
 
-void saveWaterFluxes(double dtHeat, double dtWater)
+void saveWaterFluxes(TCrit3Dcontext *ctx, double dtHeat, double dtWater)
 {
-    for (long i = 0; i < myStructure.nrNodes; i++)
+    for (long i = 0; i < ctx->myStructure.nrNodes; i++)
         {
-            if (&myNode[i].up != NULL)
-                if (myNode[i].up.linkedExtra != NULL)
-                    saveNodeWaterFlux(i, &myNode[i].up, dtHeat, dtWater);
+            if (&ctx->myNode[i].up != NULL)
+                if (ctx->myNode[i].up.linkedExtra != NULL)
+                    saveNodeWaterFlux(ctx, i, &ctx->myNode[i].up, dtHeat, dtWater);
 
-            if (&myNode[i].down != NULL)
-                if (myNode[i].down.linkedExtra != NULL)
-                    saveNodeWaterFlux(i, &myNode[i].down, dtHeat, dtWater);
+            if (&ctx->myNode[i].down != NULL)
+                if (ctx->myNode[i].down.linkedExtra != NULL)
+                    saveNodeWaterFlux(ctx, i, &ctx->myNode[i].down, dtHeat, dtWater);
 
-            for (short j = 0; j < myStructure.nrLateralLinks; j++)
-                if (&myNode[i].lateral[j] != NULL)
-                    if (myNode[i].lateral[j].linkedExtra != NULL)
-                        saveNodeWaterFlux(i, &myNode[i].lateral[j], dtHeat, dtWater);
+            for (short j = 0; j < ctx->myStructure.nrLateralLinks; j++)
+                if (&ctx->myNode[i].lateral[j] != NULL)
+                    if (ctx->myNode[i].lateral[j].linkedExtra != NULL)
+                        saveNodeWaterFlux(ctx, i, &ctx->myNode[i].lateral[j], dtHeat, dtWater);
 
         }
 }
 
-void saveNodeHeatFlux(long myIndex, TlinkedNode *myLink, double timeStep, double timeStepWater)
+void saveNodeHeatFlux(TCrit3Dcontext *ctx, long myIndex, TlinkedNode *myLink, double timeStep, double timeStepWater)
 // [W] heat flow between node myNode[myIndex] and link node myLink
 {
-   if (! isHeatLinkedNode(myLink)) return;
+   if (! isHeatLinkedNode(ctx, myLink)) return;
 
     long myLinkIndex = (*myLink).index;
     double myDiffHeat, myA;
 
-    int j = 1;
-    while ((j < myStructure.maxNrColumns) && (A[myIndex][j].index != NOLINK) && (A[myIndex][j].index != myLinkIndex)) j++;
+    if (! isHeatNode(ctx, myLinkIndex)) return;
 
-    if (A[myIndex][j].index == myLinkIndex)
+    long k = ctx->A.rowStart[myIndex] + 1;
+    while ((k < ctx->A.rowStart[myIndex+1]) && (ctx->A.column[k] != myLinkIndex)) k++;
+
+    if (k < ctx->A.rowStart[myIndex+1])
     {
-        myA = (A[myIndex][j].val * A[myIndex][0].val);
-        myDiffHeat = myA * (myNode[myIndex].extra->Heat->T - myNode[myLinkIndex].extra->Heat->T) * myParameters.heatWeightingFactor;
-        myDiffHeat += myA * (myNode[myIndex].extra->Heat->oldT - myNode[myLinkIndex].extra->Heat->oldT) * (1. - myParameters.heatWeightingFactor);
+        myA = (ctx->A.val[k] * ctx->A.val[ctx->A.rowStart[myIndex]]);
+        myDiffHeat = myA * (ctx->myNode[myIndex].extra->Heat->T - ctx->myNode[myLinkIndex].extra->Heat->T) * ctx->myParameters.heatWeightingFactor;
+        myDiffHeat += myA * (ctx->myNode[myIndex].extra->Heat->oldT - ctx->myNode[myLinkIndex].extra->Heat->oldT) * (1. - ctx->myParameters.heatWeightingFactor);
 
         // when saving separate fluxes, thermal latent heat has to be subtracted from diffusive,
         // where is incorporated (see AirHeatConductivity)
-        if (myStructure.saveHeatFluxesType == SAVE_HEATFLUXES_ALL)
+        if (ctx->myStructure.saveHeatFluxesType == SAVE_HEATFLUXES_ALL)
         {
-            if (myStructure.computeHeatVapor)
+            if (ctx->myStructure.computeHeatVapor)
             {
-                double thermalLatentFlux = ThermalVaporFlux(myIndex, myLink, PROCESS_HEAT, timeStep, timeStepWater);
-                thermalLatentFlux *= LatentHeatVaporization(myNode[myIndex].extra->Heat->T - ZEROCELSIUS);
-                saveHeatFlux(myLink, HEATFLUX_LATENT_THERMAL, thermalLatentFlux);
-                saveHeatFlux(myLink, HEATFLUX_DIFFUSIVE, myDiffHeat - thermalLatentFlux);
+                double thermalLatentFlux = ThermalVaporFlux(ctx, myIndex, myLink, PROCESS_HEAT, timeStep, timeStepWater);
+                thermalLatentFlux *= LatentHeatVaporization(ctx->myNode[myIndex].extra->Heat->T - ZEROCELSIUS);
+                saveHeatFlux(ctx, myLink, HEATFLUX_LATENT_THERMAL, thermalLatentFlux);
+                saveHeatFlux(ctx, myLink, HEATFLUX_DIFFUSIVE, myDiffHeat - thermalLatentFlux);
             }
             else
-                saveHeatFlux(myLink, HEATFLUX_DIFFUSIVE, myDiffHeat);
+                saveHeatFlux(ctx, myLink, HEATFLUX_DIFFUSIVE, myDiffHeat);
 
         }
         else
         {
-            saveHeatFlux(myLink, HEATFLUX_TOTAL, myDiffHeat);
+            saveHeatFlux(ctx, myLink, HEATFLUX_TOTAL, myDiffHeat);
         }
     }
 }
 
-void updateHeatFluxes(double timeStep, double timeStepWater)
+void updateHeatFluxes(TCrit3Dcontext *ctx, double timeStep, double timeStepWater)
 {
-    if (myStructure.saveHeatFluxesType == SAVE_HEATFLUXES_NONE) return;
+    if (ctx->myStructure.saveHeatFluxesType == SAVE_HEATFLUXES_NONE) return;
 
-    for (long i = 1; i < myStructure.nrNodes; i++)
+    for (long i = 1; i < ctx->myStructure.nrNodes; i++)
     {
-        if (myNode[i].up.index != NOLINK)
-            if (myNode[i].up.linkedExtra->heatFlux != NULL)
-                saveNodeHeatFlux(i, &(myNode[i].up), timeStep, timeStepWater);
-
-        if (myNode[i].down.index != NOLINK)
-            if (myNode[i].down.linkedExtra->heatFlux != NULL)
-                saveNodeHeatFlux(i, &(myNode[i].down), timeStep, timeStepWater);
-
-        for (short j = 0; j < myStructure.nrLateralLinks; j++)
-            if (myNode[i].lateral[j].index != NOLINK)
-                if (myNode[i].lateral[j].linkedExtra->heatFlux != NULL)
-                    saveNodeHeatFlux(i, &(myNode[i].lateral[j]), timeStep, timeStepWater);
+        if (ctx->myNode[i].up.index != NOLINK)
+            if (ctx->myNode[i].up.linkedExtra->heatFlux != NULL)
+                saveNodeHeatFlux(ctx, i, &(ctx->myNode[i].up), timeStep, timeStepWater);
+
+        if (ctx->myNode[i].down.index != NOLINK)
+            if (ctx->myNode[i].down.linkedExtra->heatFlux != NULL)
+                saveNodeHeatFlux(ctx, i, &(ctx->myNode[i].down), timeStep, timeStepWater);
+
+        for (short j = 0; j < ctx->myStructure.nrLateralLinks; j++)
+            if (ctx->myNode[i].lateral[j].index != NOLINK)
+                if (ctx->myNode[i].lateral[j].linkedExtra->heatFlux != NULL)
+                    saveNodeHeatFlux(ctx, i, &(ctx->myNode[i].lateral[j]), timeStep, timeStepWater);
     }
 }
 
-void updateBalanceHeat()
+void updateBalanceHeat(TCrit3Dcontext *ctx)
 {
-    balancePreviousTimeStep.storageHeat = balanceCurrentTimeStep.storageHeat;
-    balancePreviousTimeStep.sinkSourceHeat = balanceCurrentTimeStep.sinkSourceHeat;
-    balanceCurrentPeriod.sinkSourceHeat += balanceCurrentTimeStep.sinkSourceHeat;
+    ctx->balancePreviousTimeStep.storageHeat = ctx->balanceCurrentTimeStep.storageHeat;
+    ctx->balancePreviousTimeStep.sinkSourceHeat = ctx->balanceCurrentTimeStep.sinkSourceHeat;
+    ctx->balanceCurrentPeriod.sinkSourceHeat += ctx->balanceCurrentTimeStep.sinkSourceHeat;
 }
 
-bool heatBalance(double timeStep, double timeStepWater)
+bool heatBalance(TCrit3Dcontext *ctx, double timeStep, double timeStepWater)
 {
-    computeHeatBalance(timeStep, timeStepWater);
-    return ((fabs(1.-balanceCurrentTimeStep.heatMBR) < myParameters.MBRThreshold));
+    computeHeatBalance(ctx, timeStep, timeStepWater);
+    return ((fabs(1.-ctx->balanceCurrentTimeStep.heatMBR) < ctx->myParameters.MBRThreshold));
 }
 
-void initializeBalanceHeat()
+void initializeBalanceHeat(TCrit3Dcontext *ctx)
 {
-     balanceCurrentTimeStep.sinkSourceHeat = 0.;
-     balancePreviousTimeStep.sinkSourceHeat = 0.;
-     balanceCurrentPeriod.sinkSourceHeat = 0.;
-     balanceWholePeriod.sinkSourceHeat = 0.;
-
-     balanceCurrentTimeStep.heatMBE = 0.;
-     balanceCurrentPeriod.heatMBE = 0.;
-     balanceWholePeriod.waterMBE = 0.;
-
-     balanceCurrentTimeStep.heatMBR = 1.;
-     balanceCurrentPeriod.heatMBR = 1.;
-     balanceWholePeriod.heatMBR = 1.;
-
-     balanceWholePeriod.storageHeat = computeHeatStorage(NODATA, NODATA);
-     balanceCurrentTimeStep.storageHeat = balanceWholePeriod.storageHeat;
-     balancePreviousTimeStep.storageHeat = balanceWholePeriod.storageHeat;
-     balanceCurrentPeriod.storageHeat = balanceWholePeriod.storageHeat;
+     ctx->balanceCurrentTimeStep.sinkSourceHeat = 0.;
+     ctx->balancePreviousTimeStep.sinkSourceHeat = 0.;
+     ctx->balanceCurrentPeriod.sinkSourceHeat = 0.;
+     ctx->balanceWholePeriod.sinkSourceHeat = 0.;
+
+     ctx->balanceCurrentTimeStep.heatMBE = 0.;
+     ctx->balanceCurrentPeriod.heatMBE = 0.;
+     ctx->balanceWholePeriod.waterMBE = 0.;
+
+     ctx->balanceCurrentTimeStep.heatMBR = 1.;
+     ctx->balanceCurrentPeriod.heatMBR = 1.;
+     ctx->balanceWholePeriod.heatMBR = 1.;
+
+     ctx->balanceWholePeriod.storageHeat = computeHeatStorage(ctx, NODATA, NODATA);
+     ctx->balanceCurrentTimeStep.storageHeat = ctx->balanceWholePeriod.storageHeat;
+     ctx->balancePreviousTimeStep.storageHeat = ctx->balanceWholePeriod.storageHeat;
+     ctx->balanceCurrentPeriod.storageHeat = ctx->balanceWholePeriod.storageHeat;
 }
 
-void updateBalanceHeatWholePeriod()
+void updateBalanceHeatWholePeriod(TCrit3Dcontext *ctx)
 {
     /*! update the flows in the balance (balanceWholePeriod) */
-    balanceWholePeriod.sinkSourceHeat  += balanceCurrentPeriod.sinkSourceHeat;
+    ctx->balanceWholePeriod.sinkSourceHeat  += ctx->balanceCurrentPeriod.sinkSourceHeat;
 
-    double deltaStoragePeriod = balanceCurrentTimeStep.storageHeat - balanceCurrentPeriod.storageHeat;
-    double deltaStorageHistorical = balanceCurrentTimeStep.storageHeat - balanceWholePeriod.storageHeat;
+    double deltaStoragePeriod = ctx->balanceCurrentTimeStep.storageHeat - ctx->balanceCurrentPeriod.storageHeat;
+    double deltaStorageHistorical = ctx->balanceCurrentTimeStep.storageHeat - ctx->balanceWholePeriod.storageHeat;
 
     /*! compute MBE and MBR */
-    balanceCurrentPeriod.heatMBE = deltaStoragePeriod - balanceCurrentPeriod.sinkSourceHeat;
-    balanceWholePeriod.heatMBE = deltaStorageHistorical - balanceWholePeriod.sinkSourceHeat;
-    if ((balanceWholePeriod.storageHeat == 0.) && (balanceWholePeriod.sinkSourceHeat == 0.)) balanceWholePeriod.heatMBR = 1.;
-    else if (balanceCurrentTimeStep.storageHeat > fabs(balanceWholePeriod.sinkSourceHeat))
-        balanceWholePeriod.heatMBR = balanceCurrentTimeStep.storageHeat / (balanceWholePeriod.storageHeat + balanceWholePeriod.sinkSourceHeat);
+    ctx->balanceCurrentPeriod.heatMBE = deltaStoragePeriod - ctx->balanceCurrentPeriod.sinkSourceHeat;
+    ctx->balanceWholePeriod.heatMBE = deltaStorageHistorical - ctx->balanceWholePeriod.sinkSourceHeat;
+    if ((ctx->balanceWholePeriod.storageHeat == 0.) && (ctx->balanceWholePeriod.sinkSourceHeat == 0.)) ctx->balanceWholePeriod.heatMBR = 1.;
+    else if (ctx->balanceCurrentTimeStep.storageHeat > fabs(ctx->balanceWholePeriod.sinkSourceHeat))
+        ctx->balanceWholePeriod.heatMBR = ctx->balanceCurrentTimeStep.storageHeat / (ctx->balanceWholePeriod.storageHeat + ctx->balanceWholePeriod.sinkSourceHeat);
     else
-        balanceWholePeriod.heatMBR = deltaStorageHistorical / balanceWholePeriod.sinkSourceHeat;
+        ctx->balanceWholePeriod.heatMBR = deltaStorageHistorical / ctx->balanceWholePeriod.sinkSourceHeat;
 
     /*! update storageWater in balanceCurrentPeriod */
-    balanceCurrentPeriod.storageHeat = balanceCurrentTimeStep.storageHeat;
+    ctx->balanceCurrentPeriod.storageHeat = ctx->balanceCurrentTimeStep.storageHeat;
 }
 
-void restoreHeat()
+void restoreHeat(TCrit3Dcontext *ctx)
 {
-    for (long i = 1; i < myStructure.nrNodes; i++)
-        myNode[i].extra->Heat->T = myNode[i].extra->Heat->oldT;
+    for (long i = 1; i < ctx->myStructure.nrNodes; i++)
+        ctx->myNode[i].extra->Heat->T = ctx->myNode[i].extra->Heat->oldT;
 }
 
-void initializeHeatFluxes(bool initHeat, bool initWater)
+void initializeHeatFluxes(TCrit3Dcontext *ctx, bool initHeat, bool initWater)
 {
-    for (long n = 0; n < myStructure.nrNodes; n++)
+    for (long n = 0; n < ctx->myStructure.nrNodes; n++)
     {
-        initializeNodeHeatFlux(myNode[n].up.linkedExtra, initHeat, initWater);
-        initializeNodeHeatFlux(myNode[n].down.linkedExtra, initHeat, initWater);
-        for (short i = 1; i < myStructure.nrLateralLinks; i++)
-           initializeNodeHeatFlux(myNode[n].lateral[i].linkedExtra, initHeat, initWater);
+        initializeNodeHeatFlux(ctx, ctx->myNode[n].up.linkedExtra, initHeat, initWater);
+        initializeNodeHeatFlux(ctx, ctx->myNode[n].down.linkedExtra, initHeat, initWater);
+        for (short i = 1; i < ctx->myStructure.nrLateralLinks; i++)
+           initializeNodeHeatFlux(ctx, ctx->myNode[n].lateral[i].linkedExtra, initHeat, initWater);
     }
 }
 
-double computeMaximumDeltaT()
+double computeMaximumDeltaT(TCrit3Dcontext *ctx)
 {
     double maxDeltaT = 0.;
-    for (long i = 1; i < myStructure.nrNodes; i++)
-        maxDeltaT = max_value(maxDeltaT, fabs(myNode[i].extra->Heat->T - myNode[i].extra->Heat->oldT));
+    for (long i = 1; i < ctx->myStructure.nrNodes; i++)
+        maxDeltaT = max_value(maxDeltaT, fabs(ctx->myNode[i].extra->Heat->T - ctx->myNode[i].extra->Heat->oldT));
 
     return maxDeltaT;
 }
 
-bool HeatComputation(double timeStep, double timeStepWater)
+bool HeatComputation(TCrit3Dcontext *ctx, double timeStep, double timeStepWater)
 {
 
-	long i, j;
+	long i, k, first, last;
     double sum = 0;
     double sumFlow0 = 0;
     double myDeltaTemp0;
     double avgh;
     double heatCapacityVar;
     double dtheta, dthetav;
+    double theta, oldTheta;
+    double heatCapacity;
     double myH;
 
-    initializeHeatFluxes(true, false);
-    CourantHeat = 0.;
+    initializeHeatFluxes(ctx, true, false);
+    ctx->CourantHeat = 0.;
 
-    for (i = 1; i < myStructure.nrNodes; i++)
+    /*! T and the average potentials do not change until the system is solved:
+     *  the node properties are computed once for all the links of the node */
+    if (initializeHeatPropertyCache(ctx))
     {
-        A[i][0].index = i;
-        X[i] = myNode[i].extra->Heat->T;
-        myNode[i].extra->Heat->oldT = myNode[i].extra->Heat->T;
+        for (i = 0; i < ctx->myStructure.nrNodes; i++)
+            ctx->heatCache.isComputed[i] = 0;
+        ctx->heatCache.isValid = true;
+    }
+
+    for (i = 1; i < ctx->myStructure.nrNodes; i++)
+    {
+        ctx->X[i] = ctx->myNode[i].extra->Heat->T;
+        ctx->myNode[i].extra->Heat->oldT = ctx->myNode[i].extra->Heat->T;
 
-        myH = getH_timeStep(i, timeStep, timeStepWater);
-        avgh = arithmeticMean(myNode[i].oldH, myH) - myNode[i].z;
-        C[i] = SoilHeatCapacity(i, avgh, myNode[i].extra->Heat->T) * myNode[i].volume_area;
+        myH = getH_timeStep(ctx, i, timeStep, timeStepWater);
+        avgh = arithmeticMean(getH_heatStart(ctx, i, timeStepWater), myH) - ctx->nodeData.z[i];
+        heatCapacity = SoilHeatCapacity(ctx, i, avgh, ctx->myNode[i].extra->Heat->T);
+        if (ctx->heatCache.isValid)
+        {
+            ctx->heatCache.heatCapacity[i] = heatCapacity;
+            ctx->heatCache.nrEvaluations++;
+        }
+        ctx->C[i] = heatCapacity * ctx->nodeData.volume_area[i];
     }
 
-    for (i = 1; i < myStructure.nrNodes; i++)
+    for (i = 1; i < ctx->myStructure.nrNodes; i++)
     {
-        invariantFlux[i] = 0.;
+        ctx->invariantFlux[i] = 0.;
 
-        myH = getH_timeStep(i, timeStep, timeStepWater);
+        myH = getH_timeStep(ctx, i, timeStep, timeStepWater);
 
         // compute heat capacity temporal variation
         // due to changes in water and vapor
-        dtheta = theta_from_sign_Psi(myH - myNode[i].z, i) -
-                theta_from_sign_Psi(myNode[i].oldH - myNode[i].z, i);
+        theta = theta_from_sign_Psi(ctx, myH - ctx->nodeData.z[i], i);
+        oldTheta = theta_from_sign_Psi(ctx, getH_heatStart(ctx, i, timeStepWater) - ctx->nodeData.z[i], i);
+        dtheta = theta - oldTheta;
 
-        heatCapacityVar = dtheta * HEAT_CAPACITY_WATER * myNode[i].extra->Heat->T;
+        heatCapacityVar = dtheta * HEAT_CAPACITY_WATER * ctx->myNode[i].extra->Heat->T;
 
-        if (myStructure.computeHeatVapor)
+        if (ctx->myStructure.computeHeatVapor)
         {
-            dthetav = VaporThetaV(myH - myNode[i].z, myNode[i].extra->Heat->T, i) -
-                    VaporThetaV(myNode[i].oldH - myNode[i].z, myNode[i].extra->Heat->oldT, i);
-            heatCapacityVar += dthetav * HEAT_CAPACITY_AIR * myNode[i].extra->Heat->T;
-            heatCapacityVar += dthetav * LatentHeatVaporization(myNode[i].extra->Heat->T - ZEROCELSIUS) * WATER_DENSITY;
+            dthetav = VaporThetaV(ctx, myH - ctx->nodeData.z[i], ctx->myNode[i].extra->Heat->T, theta, i) -
+                    VaporThetaV(ctx, getH_heatStart(ctx, i, timeStepWater) - ctx->nodeData.z[i], ctx->myNode[i].extra->Heat->oldT, oldTheta, i);
+            heatCapacityVar += dthetav * HEAT_CAPACITY_AIR * ctx->myNode[i].extra->Heat->T;
+            heatCapacityVar += dthetav * nodeLatentHeatVaporization(ctx, i) * WATER_DENSITY;
         }
 
-        heatCapacityVar *= myNode[i].volume_area;
+        heatCapacityVar *= ctx->nodeData.volume_area[i];
 
-        j = 1;
-        if (computeHeatFlux(i, j, &(myNode[i].up), timeStep, timeStepWater)) j++;
-        for (short l = 0; l < myStructure.nrLateralLinks; l++)
-            if (computeHeatFlux(i, j, &(myNode[i].lateral[l]), timeStep, timeStepWater)) j++;
-        if (computeHeatFlux(i, j, &(myNode[i].down), timeStep, timeStepWater)) j++;
+        first = ctx->A.rowStart[i];
+        last = ctx->A.rowStart[i+1];
 
-        // closure
-        while (j < myStructure.maxNrColumns)
-            A[i][j++].index = NOLINK;
+        k = first + 1;
+        if (computeHeatFlux(ctx, i, k, &(ctx->myNode[i].up), timeStep, timeStepWater)) k++;
+        for (short l = 0; l < ctx->myStructure.nrLateralLinks; l++)
+            if (computeHeatFlux(ctx, i, k, &(ctx->myNode[i].lateral[l]), timeStep, timeStepWater)) k++;
+        if (computeHeatFlux(ctx, i, k, &(ctx->myNode[i].down), timeStep, timeStepWater)) k++;
 
-        j = 1;
         sum = 0.;
         sumFlow0 = 0;
         myDeltaTemp0 = 0;
 
-        while ((j < myStructure.maxNrColumns) && (A[i][j].index != NOLINK))
+        for (k = first + 1; k < last; k++)
         {
-            sum += A[i][j].val * myParameters.heatWeightingFactor;
-            myDeltaTemp0 = myNode[A[i][j].index].extra->Heat->oldT - myNode[i].extra->Heat->oldT;
-            sumFlow0 += A[i][j].val * (1. - myParameters.heatWeightingFactor) * myDeltaTemp0;
-            A[i][j++].val *= -(myParameters.heatWeightingFactor);
+            if (ctx->A.val[k] == 0.) continue;
+            sum += ctx->A.val[k] * ctx->myParameters.heatWeightingFactor;
+            myDeltaTemp0 = ctx->myNode[ctx->A.column[k]].extra->Heat->oldT - ctx->myNode[i].extra->Heat->oldT;
+            sumFlow0 += ctx->A.val[k] * (1. - ctx->myParameters.heatWeightingFactor) * myDeltaTemp0;
+            ctx->A.val[k] *= -(ctx->myParameters.heatWeightingFactor);
         }
 
         /*! sum of diagonal elements */
-        avgh = arithmeticMean(myNode[i].oldH, myH) - myNode[i].z;
-        A[i][0].val = SoilHeatCapacity(i, avgh, myNode[i].extra->Heat->T) * myNode[i].volume_area / timeStep + sum;
+        if (ctx->heatCache.isValid)
+        {
+            heatCapacity = ctx->heatCache.heatCapacity[i];
+            ctx->heatCache.nrReuses++;
+        }
+        else
+        {
+            avgh = arithmeticMean(getH_heatStart(ctx, i, timeStepWater), myH) - ctx->nodeData.z[i];
+            heatCapacity = SoilHeatCapacity(ctx, i, avgh, ctx->myNode[i].extra->Heat->T);
+        }
+        ctx->A.val[first] = heatCapacity * ctx->nodeData.volume_area[i] / timeStep + sum;
 
         /*! b vector (constant terms) */
-        b[i] = C[i] * myNode[i].extra->Heat->oldT / timeStep - heatCapacityVar / timeStep + myNode[i].extra->Heat->Qh + invariantFlux[i] + sumFlow0;
+        ctx->b[i] = ctx->C[i] * ctx->myNode[i].extra->Heat->oldT / timeStep - heatCapacityVar / timeStep + ctx->myNode[i].extra->Heat->Qh + ctx->invariantFlux[i] + sumFlow0;
 
         // preconditioning
-        if (A[i][0].val > 0)
+        if (ctx->A.val[first] > 0)
         {
-            b[i] /= A[i][0].val;
-            j = 1;
-            while ((j < myStructure.maxNrColumns) && (A[i][j].index != NOLINK))
-                A[i][j++].val /= A[i][0].val;
+            ctx->b[i] /= ctx->A.val[first];
+            for (k = first + 1; k < last; k++)
+                ctx->A.val[k] /= ctx->A.val[first];
         }
     }
 
+    ctx->heatCache.isValid = false;
+
     // avoiding oscillations (Courant number)
-    if (CourantHeat > 1.0)
-        if (timeStep > myParameters.delta_t_min)
+    if (ctx->CourantHeat > 1.0)
+        if (timeStep > ctx->myParameters.delta_t_min)
         {
-            halveTimeStep();
-            setForcedHalvedTime(true);
+            ctx->timeStepStatistics.nrHeatRejected++;
+
+            // sub-cycling: only the heat step is reduced (see computeStep)
+            if (ctx->myParameters.useHeatSubCycling) return (false);
+
+            halveTimeStep(ctx);
+            setForcedHalvedTime(ctx, true);
             return (false);
         }
 
-    GaussSeidelRelaxation(0, myParameters.ResidualTolerance, PROCESS_HEAT);
+    solveLinearSystem(ctx, 0, ctx->myParameters.ResidualTolerance, PROCESS_HEAT);
 
-    for (i = 1; i < myStructure.nrNodes; i++)
-        myNode[i].extra->Heat->T = X[i];
+    for (i = 1; i < ctx->myStructure.nrNodes; i++)
+        ctx->myNode[i].extra->Heat->T = ctx->X[i];
 
     // avoiding oscillations (maximum temperature change allowed)
     /*double maxDeltaT = computeMaximumDeltaT();
@@ -1008,14 +1171,16 @@ bool HeatComputation(double timeStep, double timeStepWater)
         if (myParameters.current_delta_t > myParameters.delta_t_min) return false;
     }*/
 
-    heatBalance(timeStep, timeStepWater);
-    updateBalanceHeat();
+    heatBalance(ctx, timeStep, timeStepWater);
+    updateBalanceHeat(ctx);
 
-    updateHeatFluxes(timeStep, timeStepWater);
+    updateHeatFluxes(ctx, timeStep, timeStepWater);
 
 	// save old temperatures
-    for (long n = 1; n < myStructure.nrNodes; n++)
-        myNode[n].extra->Heat->oldT = myNode[n].extra->Heat->T;
+    for (long n = 1; n < ctx->myStructure.nrNodes; n++)
+        ctx->myNode[n].extra->Heat->oldT = ctx->myNode[n].extra->Heat->T;
+
+    ctx->timeStepStatistics.nrHeatAccepted++;
 
     return (true);
 }
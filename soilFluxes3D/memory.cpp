@@ -27,83 +27,224 @@
 
 
 #include <stdio.h>
+#include <math.h>
 #include <malloc.h>
 #include "header/types.h"
+#include "header/solver.h"
+#include "header/memory.h"
+#include "header/water.h"
+#include "header/heat.h"
 
 
-void cleanArrays()
+/*! the matrix pattern, node colors and node geometry of an ensemble member
+ *  belong to its topology context */
+inline bool isSharedTopology(TCrit3Dcontext *ctx)
 {
-    /*! free matrix A */
-    if (A != NULL)
+    return (ctx->topology != NULL);
+}
+
+
+void cleanMatrix(TCrit3Dcontext *ctx)
+{
+    if (isSharedTopology(ctx))
     {
-            for (long i=0; i < myStructure.nrNodes; i++)
-                if (A[i] != NULL) free(A[i]);
-            free(A);
-            A = NULL;
+        ctx->A.rowStart = NULL;
+        ctx->A.column = NULL;
     }
+    if (ctx->A.rowStart != NULL) { free(ctx->A.rowStart); ctx->A.rowStart = NULL; }
+    if (ctx->A.column != NULL) { free(ctx->A.column); ctx->A.column = NULL; }
+    if (ctx->A.val != NULL) { free(ctx->A.val); ctx->A.val = NULL; }
+    ctx->A.nrRows = 0;
+    ctx->A.nrElements = 0;
+
+    invalidateAssembly(ctx);
+}
+
+
+void cleanArrays(TCrit3Dcontext *ctx)
+{
+    /*! free matrix A */
+    cleanMatrix(ctx);
 
     /*! free arrays */
-    if (b != NULL){ free(b); b = NULL; }
-    if (C != NULL){ free(C); C = NULL; }
-    if (invariantFlux != NULL){ free(invariantFlux); invariantFlux = NULL; }
-    if (X != NULL) { free(X); X = NULL; }
+    if (ctx->b != NULL){ free(ctx->b); ctx->b = NULL; }
+    if (ctx->C != NULL){ free(ctx->C); ctx->C = NULL; }
+    if (ctx->invariantFlux != NULL){ free(ctx->invariantFlux); ctx->invariantFlux = NULL; }
+    if (ctx->X != NULL) { free(ctx->X); ctx->X = NULL; }
+
+    cleanNodeColors(ctx);
+    cleanKrylovArrays(ctx);
+    cleanAssemblyArrays(ctx);
+    cleanHeatPropertyCache(ctx);
     }
 
 
-void cleanNodes()
+void cleanNodes(TCrit3Dcontext *ctx)
 {
-    if (myNode != NULL)
+    if (ctx->myNode != NULL)
     {
-        for (long i = 0; i < myStructure.nrNodes; i++)
+        for (long i = 0; i < ctx->myStructure.nrNodes; i++)
         {
-			if (myNode[i].boundary != NULL) free(myNode[i].boundary);
-			free(myNode[i].lateral);
+			if (ctx->myNode[i].boundary != NULL) delete ctx->myNode[i].boundary;
+			free(ctx->myNode[i].lateral);
         }
-        free(myNode);
-        myNode = NULL;
+        free(ctx->myNode);
+        ctx->myNode = NULL;
+    }
+
+    cleanNodeData(ctx);
+}
+
+
+void cleanNodeData(TCrit3Dcontext *ctx)
+{
+    if (ctx->nodeData.Se != NULL) { free(ctx->nodeData.Se); ctx->nodeData.Se = NULL; }
+    if (ctx->nodeData.k != NULL) { free(ctx->nodeData.k); ctx->nodeData.k = NULL; }
+    if (ctx->nodeData.H != NULL) { free(ctx->nodeData.H); ctx->nodeData.H = NULL; }
+    if (ctx->nodeData.oldH != NULL) { free(ctx->nodeData.oldH); ctx->nodeData.oldH = NULL; }
+    if (ctx->nodeData.bestH != NULL) { free(ctx->nodeData.bestH); ctx->nodeData.bestH = NULL; }
+    if (ctx->nodeData.waterSinkSource != NULL) { free(ctx->nodeData.waterSinkSource); ctx->nodeData.waterSinkSource = NULL; }
+    if (ctx->nodeData.Qw != NULL) { free(ctx->nodeData.Qw); ctx->nodeData.Qw = NULL; }
+
+    if (isSharedTopology(ctx))
+    {
+        ctx->nodeData.volume_area = NULL;
+        ctx->nodeData.x = NULL;
+        ctx->nodeData.y = NULL;
+        ctx->nodeData.z = NULL;
+        ctx->nodeData.isSurface = NULL;
     }
+    if (ctx->nodeData.volume_area != NULL) { free(ctx->nodeData.volume_area); ctx->nodeData.volume_area = NULL; }
+    if (ctx->nodeData.x != NULL) { free(ctx->nodeData.x); ctx->nodeData.x = NULL; }
+    if (ctx->nodeData.y != NULL) { free(ctx->nodeData.y); ctx->nodeData.y = NULL; }
+    if (ctx->nodeData.z != NULL) { free(ctx->nodeData.z); ctx->nodeData.z = NULL; }
+    if (ctx->nodeData.isSurface != NULL) { free(ctx->nodeData.isSurface); ctx->nodeData.isSurface = NULL; }
 }
 
 
 /*!
- * \brief initialize matrix and arrays
+ * \brief allocate the node state arrays (zero initialized)
  * \return OK/ERROR
  */
-int initializeArrays()
+int initializeNodeData(TCrit3Dcontext *ctx)
 {
-    long i, j, n;
+    long n = ctx->myStructure.nrNodes;
+
+    cleanNodeData(ctx);
+
+    ctx->nodeData.Se = (double *) calloc(n, sizeof(double));
+    ctx->nodeData.k = (double *) calloc(n, sizeof(double));
+    ctx->nodeData.H = (double *) calloc(n, sizeof(double));
+    ctx->nodeData.oldH = (double *) calloc(n, sizeof(double));
+    ctx->nodeData.bestH = (double *) calloc(n, sizeof(double));
+    ctx->nodeData.waterSinkSource = (double *) calloc(n, sizeof(double));
+    ctx->nodeData.Qw = (double *) calloc(n, sizeof(double));
+    ctx->nodeData.volume_area = (double *) calloc(n, sizeof(double));
+    ctx->nodeData.x = (float *) calloc(n, sizeof(float));
+    ctx->nodeData.y = (float *) calloc(n, sizeof(float));
+    ctx->nodeData.z = (float *) calloc(n, sizeof(float));
+    ctx->nodeData.isSurface = (bool *) calloc(n, sizeof(bool));
+
+    if (ctx->nodeData.Se == NULL || ctx->nodeData.k == NULL || ctx->nodeData.H == NULL || ctx->nodeData.oldH == NULL
+        || ctx->nodeData.bestH == NULL || ctx->nodeData.waterSinkSource == NULL || ctx->nodeData.Qw == NULL
+        || ctx->nodeData.volume_area == NULL || ctx->nodeData.x == NULL || ctx->nodeData.y == NULL
+        || ctx->nodeData.z == NULL || ctx->nodeData.isSurface == NULL)
+    {
+        cleanNodeData(ctx);
+        return(MEMORY_ERROR);
+    }
 
-    /*! clean previous arrays */
-    cleanArrays();
+    return(CRIT3D_OK);
+}
 
-    /*! matrix solver: rows */
-    A = (TmatrixElement **) calloc(myStructure.nrNodes, sizeof(TmatrixElement *));
 
-    /*! matrix solver: columns */
-    for (i = 0; i < myStructure.nrNodes; i++)
-            A[i] = (TmatrixElement *) calloc(myStructure.maxNrColumns, sizeof(TmatrixElement));
+inline void addMatrixColumn(TCrit3Dcontext *ctx, TlinkedNode *link, long *k)
+{
+    if (link->index != NOLINK)
+    {
+        if (ctx->A.column != NULL) ctx->A.column[*k] = link->index;
+        (*k)++;
+    }
+}
 
-    /*! initialize matrix solver */
-    for (i = 0; i < myStructure.nrNodes; i++)
-        for (j = 0; j < (myStructure.nrLateralLinks + 2); j++)
-        {
-            A[i][j].index   = NOLINK;
-            A[i][j].val     = 0.;
-        }
 
-    b = (double *) calloc(myStructure.nrNodes, sizeof(double));
-    for (n = 0; n < myStructure.nrNodes; n++) b[n] = 0.;
+/*!
+ * \brief build the sparsity pattern of matrix A from the current topology
+ * row i: diagonal, up link, lateral links, down link (same order of the matrix assembly)
+ * \return OK/ERROR
+ */
+int initializeMatrix(TCrit3Dcontext *ctx)
+{
+    long i, k;
+    short l;
+
+    cleanMatrix(ctx);
+    if (ctx->myNode == NULL) return(MEMORY_ERROR);
+
+    ctx->A.nrRows = ctx->myStructure.nrNodes;
+    ctx->A.rowStart = (long *) calloc(ctx->A.nrRows + 1, sizeof(long));
+    if (ctx->A.rowStart == NULL) return(MEMORY_ERROR);
+
+    /*! count elements */
+    k = 0;
+    for (i = 0; i < ctx->A.nrRows; i++)
+    {
+        ctx->A.rowStart[i] = k++;
+        addMatrixColumn(ctx, &(ctx->myNode[i].up), &k);
+        for (l = 0; l < ctx->myStructure.nrLateralLinks; l++)
+            addMatrixColumn(ctx, &(ctx->myNode[i].lateral[l]), &k);
+        addMatrixColumn(ctx, &(ctx->myNode[i].down), &k);
+    }
+    ctx->A.rowStart[ctx->A.nrRows] = k;
+    ctx->A.nrElements = k;
+
+    ctx->A.column = (long *) calloc(ctx->A.nrElements, sizeof(long));
+    ctx->A.val = (double *) calloc(ctx->A.nrElements, sizeof(double));
+    if (ctx->A.column == NULL || ctx->A.val == NULL) return(MEMORY_ERROR);
+
+    /*! column indices */
+    for (i = 0; i < ctx->A.nrRows; i++)
+    {
+        k = ctx->A.rowStart[i];
+        ctx->A.column[k++] = i;
+        addMatrixColumn(ctx, &(ctx->myNode[i].up), &k);
+        for (l = 0; l < ctx->myStructure.nrLateralLinks; l++)
+            addMatrixColumn(ctx, &(ctx->myNode[i].lateral[l]), &k);
+        addMatrixColumn(ctx, &(ctx->myNode[i].down), &k);
+    }
+
+    return(CRIT3D_OK);
+}
+
+
+/*!
+ * \brief initialize matrix and arrays
+ * \return OK/ERROR
+ */
+int initializeArrays(TCrit3Dcontext *ctx)
+{
+    long n;
+
+    /*! clean previous arrays */
+    cleanArrays(ctx);
+
+    /*! matrix solver */
+    int result = initializeMatrix(ctx);
+    if (result != CRIT3D_OK) return(result);
+
+    ctx->b = (double *) calloc(ctx->myStructure.nrNodes, sizeof(double));
+    for (n = 0; n < ctx->myStructure.nrNodes; n++) ctx->b[n] = 0.;
 
-    X = (double *) calloc(myStructure.nrNodes, sizeof(double));
+    ctx->X = (double *) calloc(ctx->myStructure.nrNodes, sizeof(double));
 
     /*! mass diagonal matrix */
-    C = (double *) calloc(myStructure.nrNodes, sizeof(double));
-    for (n = 0; n < myStructure.nrNodes; n++) C[n] = 0.;
+    ctx->C = (double *) calloc(ctx->myStructure.nrNodes, sizeof(double));
+    for (n = 0; n < ctx->myStructure.nrNodes; n++) ctx->C[n] = 0.;
 
     /*! mass diagonal matrix */
-    invariantFlux = (double *) calloc(myStructure.nrNodes, sizeof(double));
-    for (n = 0; n < myStructure.nrNodes; n++) invariantFlux[n] = 0.;
+    ctx->invariantFlux = (double *) calloc(ctx->myStructure.nrNodes, sizeof(double));
+    for (n = 0; n < ctx->myStructure.nrNodes; n++) ctx->invariantFlux[n] = 0.;
 
-    if (A == NULL) return(MEMORY_ERROR);
+    if (ctx->b == NULL || ctx->X == NULL || ctx->C == NULL || ctx->invariantFlux == NULL) return(MEMORY_ERROR);
     else return(CRIT3D_OK);
 }
@@ -0,0 +1,599 @@
+/*!
+    \name snapshot.cpp
+    \copyright (C) 2011 Fausto Tomei, Gabriele Antolini, Antonio Volta,
+                        Alberto Pistocchi, Marco Bittelli
+
+    This file is part of CRITERIA3D.
+    CRITERIA3D has been developed under contract issued by A.R.P.A. Emilia-Romagna
+
+    CRITERIA3D is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CRITERIA3D is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with CRITERIA3D.  If not, see <http://www.gnu.org/licenses/>.
+
+    contacts:
+    fausto.tomei@gmail.com
+    ftomei@arpae.emr.it
+    gantolini@arpae.emr.it
+*/
+
+/*!
+ * binary snapshot of the state of a domain
+ *
+ * layout (native byte order):
+ *   Tsnapshot header (fixed size) with the offset of each section
+ *   sections: contiguous arrays aligned to 8 bytes, [nrNodes] or [nrNodes * n] values
+ * the topology (nodes, links, soils) is not saved: the snapshot is restored
+ * on the same domain, and the header is checked against it.
+ */
+
+/*! 64-bit file positions with fseeko/ftello (off_t) */
+#ifndef _FILE_OFFSET_BITS
+    #define _FILE_OFFSET_BITS 64
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "../mathFunctions/commonConstants.h"
+#include "header/types.h"
+#include "header/water.h"
+#include "header/soilFluxes3D.h"
+
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_MAX_SECTIONS 16
+
+#define SNAPSHOT_NODE_H 0
+#define SNAPSHOT_NODE_OLDH 1
+#define SNAPSHOT_NODE_BESTH 2
+#define SNAPSHOT_NODE_SE 3
+#define SNAPSHOT_NODE_K 4
+#define SNAPSHOT_NODE_SINKSOURCE 5
+#define SNAPSHOT_NODE_QW 6
+#define SNAPSHOT_LINK_SUMFLOW 7
+#define SNAPSHOT_BOUNDARY_WATER 8
+#define SNAPSHOT_SOLVER 9
+#define SNAPSHOT_NODE_HEAT 10
+#define SNAPSHOT_BOUNDARY_HEAT 11
+#define SNAPSHOT_LINK_HEATFLUX 12
+#define SNAPSHOT_NR_SECTIONS 13
+
+/*! node arrays are the first sections: SNAPSHOT_NODE_H ... SNAPSHOT_NODE_QW */
+#define SNAPSHOT_NODE_ARRAYS 7
+
+#define SNAPSHOT_BOUNDARY_WATER_FIELDS 4
+#define SNAPSHOT_BOUNDARY_HEAT_FIELDS 15
+#define SNAPSHOT_NODE_HEAT_FIELDS 4
+#define SNAPSHOT_BALANCE_FIELDS 8
+#define SNAPSHOT_SOLVER_FIELDS (4 * SNAPSHOT_BALANCE_FIELDS + 7)
+
+
+struct TsnapshotSection{
+    int64_t offset;                 /*!< [byte] from the beginning of the file, 0 = not saved */
+    int64_t nrValues;
+    int32_t valueSize;              /*!< [byte] */
+    int32_t reserved;
+} ;
+
+struct Tsnapshot{
+    char magic[8];                  /*!< "CRIT3DSS" */
+    int32_t version;
+    int32_t headerSize;
+    int64_t nrNodes;
+    int64_t nrLayers;
+    int32_t nrLateralLinks;
+    int32_t computeHeat;
+    int32_t computeHeatVapor;
+    int32_t saveHeatFluxesType;
+    TsnapshotSection section[SNAPSHOT_MAX_SECTIONS];
+} ;
+
+
+/*! file position and seek with 64-bit offsets: long is 32-bit on Windows */
+inline int64_t tellFile(FILE *fp)
+{
+#ifdef _MSC_VER
+    return int64_t(_ftelli64(fp));
+#else
+    return int64_t(ftello(fp));
+#endif
+}
+
+
+inline int seekFile(FILE *fp, int64_t offset, int origin)
+{
+#ifdef _MSC_VER
+    return _fseeki64(fp, offset, origin);
+#else
+    return fseeko(fp, off_t(offset), origin);
+#endif
+}
+
+
+/*! number of links stored for each node: up, down, lateral */
+inline long nrNodeLinks(TCrit3Dcontext *ctx)
+{
+    return 2 + ctx->myStructure.nrLateralLinks;
+}
+
+
+inline TlinkedNode* getNodeLink(TCrit3Dcontext *ctx, long i, long l)
+{
+    if (l == 0) return &(ctx->myNode[i].up);
+    if (l == 1) return &(ctx->myNode[i].down);
+    return &(ctx->myNode[i].lateral[l-2]);
+}
+
+
+inline long nrHeatFluxValues(TCrit3Dcontext *ctx)
+{
+    if (ctx->myStructure.saveHeatFluxesType == SAVE_HEATFLUXES_ALL) return 2 + 9;
+    if (ctx->myStructure.saveHeatFluxesType == SAVE_HEATFLUXES_TOTAL) return 2 + 1;
+    return 2;
+}
+
+
+void balanceToArray(Tbalance *myBalance, double *v)
+{
+    v[0] = myBalance->storageWater;
+    v[1] = myBalance->sinkSourceWater;
+    v[2] = myBalance->waterMBE;
+    v[3] = myBalance->waterMBR;
+    v[4] = myBalance->storageHeat;
+    v[5] = myBalance->sinkSourceHeat;
+    v[6] = myBalance->heatMBE;
+    v[7] = myBalance->heatMBR;
+}
+
+
+void arrayToBalance(double *v, Tbalance *myBalance)
+{
+    myBalance->storageWater = v[0];
+    myBalance->sinkSourceWater = v[1];
+    myBalance->waterMBE = v[2];
+    myBalance->waterMBR = v[3];
+    myBalance->storageHeat = v[4];
+    myBalance->sinkSourceHeat = v[5];
+    myBalance->heatMBE = v[6];
+    myBalance->heatMBR = v[7];
+}
+
+
+void heatBoundaryToArray(TboundaryHeat *myHeat, double *v)
+{
+    v[0] = myHeat->temperature;
+    v[1] = myHeat->relativeHumidity;
+    v[2] = myHeat->windSpeed;
+    v[3] = myHeat->netIrradiance;
+    v[4] = myHeat->heightWind;
+    v[5] = myHeat->heightTemperature;
+    v[6] = myHeat->roughnessHeight;
+    v[7] = myHeat->sensibleFlux;
+    v[8] = myHeat->latentFlux;
+    v[9] = myHeat->radiativeFlux;
+    v[10] = myHeat->advectiveHeatFlux;
+    v[11] = myHeat->aerodynamicConductance;
+    v[12] = myHeat->soilConductance;
+    v[13] = myHeat->fixedTemperature;
+    v[14] = myHeat->fixedTemperatureDepth;
+}
+
+
+void arrayToHeatBoundary(double *v, TboundaryHeat *myHeat)
+{
+    myHeat->temperature = v[0];
+    myHeat->relativeHumidity = v[1];
+    myHeat->windSpeed = v[2];
+    myHeat->netIrradiance = v[3];
+    myHeat->heightWind = v[4];
+    myHeat->heightTemperature = v[5];
+    myHeat->roughnessHeight = v[6];
+    myHeat->sensibleFlux = v[7];
+    myHeat->latentFlux = v[8];
+    myHeat->radiativeFlux = v[9];
+    myHeat->advectiveHeatFlux = v[10];
+    myHeat->aerodynamicConductance = v[11];
+    myHeat->soilConductance = v[12];
+    myHeat->fixedTemperature = v[13];
+    myHeat->fixedTemperatureDepth = v[14];
+}
+
+
+/*!
+ * \brief writes a section at the end of the file (8 bytes aligned) and records it in the header
+ * \return true if written
+ */
+bool writeSection(FILE *fp, Tsnapshot *header, int id, const void *values, int valueSize, int64_t nrValues)
+{
+    if (seekFile(fp, 0, SEEK_END) != 0) return false;
+    int64_t position = tellFile(fp);
+    if (position < 0) return false;
+    static const char padding[8] = {0};
+    int64_t nrPadding = (8 - position % 8) % 8;
+    if (nrPadding > 0 && fwrite(padding, 1, size_t(nrPadding), fp) != size_t(nrPadding)) return false;
+
+    header->section[id].offset = position + nrPadding;
+    header->section[id].nrValues = nrValues;
+    header->section[id].valueSize = valueSize;
+
+    return (fwrite(values, size_t(valueSize), size_t(nrValues), fp) == size_t(nrValues));
+}
+
+
+/*!
+ * \brief reads a section, checking its size
+ * \return CRIT3D_OK, FILE_ERROR, TOPOGRAPHY_ERROR (different size)
+ */
+int readSection(FILE *fp, Tsnapshot *header, int id, void *values, int valueSize, int64_t nrValues)
+{
+    if (header->section[id].offset == 0) return(FILE_ERROR);
+    if (header->section[id].valueSize != valueSize || header->section[id].nrValues != nrValues)
+        return(TOPOGRAPHY_ERROR);
+
+    if (seekFile(fp, header->section[id].offset, SEEK_SET) != 0) return(FILE_ERROR);
+    if (fread(values, size_t(valueSize), size_t(nrValues), fp) != size_t(nrValues)) return(FILE_ERROR);
+
+    return(CRIT3D_OK);
+}
+
+
+int writeSnapshot(TCrit3Dcontext *ctx, FILE *fp)
+{
+    int64_t n = ctx->myStructure.nrNodes;
+    int64_t nrLinks = nrNodeLinks(ctx);
+    int64_t i, l;
+
+    Tsnapshot header;
+    memset(&header, 0, sizeof(Tsnapshot));
+    memcpy(header.magic, "CRIT3DSS", 8);
+    header.version = SNAPSHOT_VERSION;
+    header.headerSize = sizeof(Tsnapshot);
+    header.nrNodes = n;
+    header.nrLayers = ctx->myStructure.nrLayers;
+    header.nrLateralLinks = ctx->myStructure.nrLateralLinks;
+    header.computeHeat = ctx->myStructure.computeHeat;
+    header.computeHeatVapor = ctx->myStructure.computeHeatVapor;
+    header.saveHeatFluxesType = ctx->myStructure.saveHeatFluxesType;
+
+    /*! placeholder, rewritten with the section offsets */
+    if (fwrite(&header, sizeof(Tsnapshot), 1, fp) != 1) return(FILE_ERROR);
+
+    bool isOk = writeSection(fp, &header, SNAPSHOT_NODE_H, ctx->nodeData.H, sizeof(double), n)
+            && writeSection(fp, &header, SNAPSHOT_NODE_OLDH, ctx->nodeData.oldH, sizeof(double), n)
+            && writeSection(fp, &header, SNAPSHOT_NODE_BESTH, ctx->nodeData.bestH, sizeof(double), n)
+            && writeSection(fp, &header, SNAPSHOT_NODE_SE, ctx->nodeData.Se, sizeof(double), n)
+            && writeSection(fp, &header, SNAPSHOT_NODE_K, ctx->nodeData.k, sizeof(double), n)
+            && writeSection(fp, &header, SNAPSHOT_NODE_SINKSOURCE, ctx->nodeData.waterSinkSource, sizeof(double), n)
+            && writeSection(fp, &header, SNAPSHOT_NODE_QW, ctx->nodeData.Qw, sizeof(double), n);
+    if (! isOk) return(FILE_ERROR);
+
+    /*! link flows */
+    float *linkValues = (float *) malloc(size_t(n * nrLinks) * sizeof(float));
+    if (linkValues == NULL) return(MEMORY_ERROR);
+    for (i = 0; i < n; i++)
+        for (l = 0; l < nrLinks; l++)
+            linkValues[i * nrLinks + l] = getNodeLink(ctx, i, l)->sumFlow;
+    isOk = writeSection(fp, &header, SNAPSHOT_LINK_SUMFLOW, linkValues, sizeof(float), n * nrLinks);
+    free(linkValues);
+    if (! isOk) return(FILE_ERROR);
+
+    /*! boundaries: type (BOUNDARY_NONE without boundary), water flow, sum of flow, prescribed potential */
+    double *boundaryValues = (double *) malloc(size_t(n * SNAPSHOT_BOUNDARY_WATER_FIELDS) * sizeof(double));
+    if (boundaryValues == NULL) return(MEMORY_ERROR);
+    for (i = 0; i < n; i++)
+    {
+        double *v = &boundaryValues[i * SNAPSHOT_BOUNDARY_WATER_FIELDS];
+        Tboundary *myBoundary = ctx->myNode[i].boundary;
+        v[0] = (myBoundary == NULL) ? BOUNDARY_NONE : myBoundary->type;
+        v[1] = (myBoundary == NULL) ? 0. : myBoundary->waterFlow;
+        v[2] = (myBoundary == NULL) ? 0. : myBoundary->sumBoundaryWaterFlow;
+        v[3] = (myBoundary == NULL) ? NODATA : myBoundary->prescribedTotalPotential;
+    }
+    isOk = writeSection(fp, &header, SNAPSHOT_BOUNDARY_WATER, boundaryValues, sizeof(double), n * SNAPSHOT_BOUNDARY_WATER_FIELDS);
+    free(boundaryValues);
+    if (! isOk) return(FILE_ERROR);
+
+    /*! balance accumulators and time step */
+    double solverValues[SNAPSHOT_SOLVER_FIELDS];
+    balanceToArray(&ctx->balanceCurrentTimeStep, &solverValues[0]);
+    balanceToArray(&ctx->balancePreviousTimeStep, &solverValues[SNAPSHOT_BALANCE_FIELDS]);
+    balanceToArray(&ctx->balanceCurrentPeriod, &solverValues[2 * SNAPSHOT_BALANCE_FIELDS]);
+    balanceToArray(&ctx->balanceWholePeriod, &solverValues[3 * SNAPSHOT_BALANCE_FIELDS]);
+    double *v = &solverValues[4 * SNAPSHOT_BALANCE_FIELDS];
+    v[0] = ctx->myParameters.current_delta_t;
+    v[1] = ctx->bestMBRerror;
+    v[2] = ctx->previousMBRerror;
+    v[3] = ctx->isHalfTimeStepForced ? 1. : 0.;
+    v[4] = ctx->Courant;
+    v[5] = ctx->CourantHeat;
+    v[6] = ctx->fluxCourant;
+    if (! writeSection(fp, &header, SNAPSHOT_SOLVER, solverValues, sizeof(double), SNAPSHOT_SOLVER_FIELDS))
+        return(FILE_ERROR);
+
+    if (ctx->myStructure.computeHeat)
+    {
+        /*! node temperatures and heat flows */
+        double *heatValues = (double *) calloc(size_t(n * SNAPSHOT_BOUNDARY_HEAT_FIELDS), sizeof(double));
+        if (heatValues == NULL) return(MEMORY_ERROR);
+        for (i = 0; i < n; i++)
+        {
+            TCrit3DNodeHeat *myHeat = (ctx->myNode[i].extra != NULL) ? ctx->myNode[i].extra->Heat : NULL;
+            double *h = &heatValues[i * SNAPSHOT_NODE_HEAT_FIELDS];
+            h[0] = (myHeat == NULL) ? NODATA : myHeat->T;
+            h[1] = (myHeat == NULL) ? NODATA : myHeat->oldT;
+            h[2] = (myHeat == NULL) ? NODATA : myHeat->Qh;
+            h[3] = (myHeat == NULL) ? NODATA : myHeat->sinkSource;
+        }
+        isOk = writeSection(fp, &header, SNAPSHOT_NODE_HEAT, heatValues, sizeof(double), n * SNAPSHOT_NODE_HEAT_FIELDS);
+
+        /*! heat boundaries (NODATA where missing) */
+        for (i = 0; i < n && isOk; i++)
+        {
+            double *h = &heatValues[i * SNAPSHOT_BOUNDARY_HEAT_FIELDS];
+            Tboundary *myBoundary = ctx->myNode[i].boundary;
+            if (myBoundary != NULL && myBoundary->Heat != NULL)
+                heatBoundaryToArray(myBoundary->Heat, h);
+            else
+                for (int f = 0; f < SNAPSHOT_BOUNDARY_HEAT_FIELDS; f++) h[f] = NODATA;
+        }
+        isOk = isOk && writeSection(fp, &header, SNAPSHOT_BOUNDARY_HEAT, heatValues, sizeof(double), n * SNAPSHOT_BOUNDARY_HEAT_FIELDS);
+        free(heatValues);
+        if (! isOk) return(FILE_ERROR);
+
+        /*! link heat fluxes: water flux, vapor flux, saved fluxes */
+        int64_t nrFluxValues = nrHeatFluxValues(ctx);
+        float *fluxValues = (float *) malloc(size_t(n * nrLinks * nrFluxValues) * sizeof(float));
+        if (fluxValues == NULL) return(MEMORY_ERROR);
+        for (i = 0; i < n; i++)
+            for (l = 0; l < nrLinks; l++)
+            {
+                float *f = &fluxValues[(i * nrLinks + l) * nrFluxValues];
+                TlinkedNode *myLink = getNodeLink(ctx, i, l);
+                THeatFlux *myFlux = (myLink->linkedExtra != NULL) ? myLink->linkedExtra->heatFlux : NULL;
+                for (long k = 0; k < nrFluxValues; k++)
+                {
+                    if (myFlux == NULL) f[k] = NODATA;
+                    else if (k == 0) f[k] = myFlux->waterFlux;
+                    else if (k == 1) f[k] = myFlux->vaporFlux;
+                    else f[k] = (myFlux->fluxes != NULL) ? myFlux->fluxes[k-2] : NODATA;
+                }
+            }
+        isOk = writeSection(fp, &header, SNAPSHOT_LINK_HEATFLUX, fluxValues, sizeof(float), n * nrLinks * nrFluxValues);
+        free(fluxValues);
+        if (! isOk) return(FILE_ERROR);
+    }
+
+    /*! header with the section offsets */
+    if (seekFile(fp, 0, SEEK_SET) != 0) return(FILE_ERROR);
+    if (fwrite(&header, sizeof(Tsnapshot), 1, fp) != 1) return(FILE_ERROR);
+
+    return(CRIT3D_OK);
+}
+
+
+int readSnapshot(TCrit3Dcontext *ctx, FILE *fp)
+{
+    int64_t n = ctx->myStructure.nrNodes;
+    int64_t nrLinks = nrNodeLinks(ctx);
+    int64_t nrFluxValues = nrHeatFluxValues(ctx);
+    bool isHeat = ctx->myStructure.computeHeat;
+    int64_t i, l;
+    int id, result;
+
+    Tsnapshot header;
+    if (fread(&header, sizeof(Tsnapshot), 1, fp) != 1) return(FILE_ERROR);
+    if (memcmp(header.magic, "CRIT3DSS", 8) != 0) return(FILE_ERROR);
+    if (header.version != SNAPSHOT_VERSION || header.headerSize != int32_t(sizeof(Tsnapshot)))
+        return(PARAMETER_ERROR);
+
+    /*! same domain */
+    if (header.nrNodes != n || header.nrLayers != ctx->myStructure.nrLayers
+        || header.nrLateralLinks != ctx->myStructure.nrLateralLinks
+        || header.computeHeat != int32_t(ctx->myStructure.computeHeat)
+        || header.computeHeatVapor != int32_t(ctx->myStructure.computeHeatVapor)
+        || header.saveHeatFluxesType != ctx->myStructure.saveHeatFluxesType)
+        return(TOPOGRAPHY_ERROR);
+
+    /*! all the sections are read and checked before changing the state:
+     *  a truncated or different snapshot leaves the domain unchanged */
+    double *nodeArrays[SNAPSHOT_NODE_ARRAYS] = {ctx->nodeData.H, ctx->nodeData.oldH, ctx->nodeData.bestH, ctx->nodeData.Se,
+                                                ctx->nodeData.k, ctx->nodeData.waterSinkSource, ctx->nodeData.Qw};
+    double solverValues[SNAPSHOT_SOLVER_FIELDS];
+    double *nodeValues = (double *) malloc(size_t(n * SNAPSHOT_NODE_ARRAYS) * sizeof(double));
+    double *boundaryValues = (double *) malloc(size_t(n * SNAPSHOT_BOUNDARY_WATER_FIELDS) * sizeof(double));
+    float *linkValues = (float *) malloc(size_t(n * nrLinks) * sizeof(float));
+    double *heatValues = NULL;
+    double *heatBoundaryValues = NULL;
+    float *fluxValues = NULL;
+    if (isHeat)
+    {
+        heatValues = (double *) malloc(size_t(n * SNAPSHOT_NODE_HEAT_FIELDS) * sizeof(double));
+        heatBoundaryValues = (double *) malloc(size_t(n * SNAPSHOT_BOUNDARY_HEAT_FIELDS) * sizeof(double));
+        fluxValues = (float *) malloc(size_t(n * nrLinks * nrFluxValues) * sizeof(float));
+    }
+
+    result = CRIT3D_OK;
+    if (nodeValues == NULL || boundaryValues == NULL || linkValues == NULL
+        || (isHeat && (heatValues == NULL || heatBoundaryValues == NULL || fluxValues == NULL)))
+        result = MEMORY_ERROR;
+
+    for (id = SNAPSHOT_NODE_H; id < SNAPSHOT_NODE_ARRAYS && result == CRIT3D_OK; id++)
+        result = readSection(fp, &header, id, &nodeValues[id * n], sizeof(double), n);
+
+    if (result == CRIT3D_OK)
+        result = readSection(fp, &header, SNAPSHOT_BOUNDARY_WATER, boundaryValues, sizeof(double), n * SNAPSHOT_BOUNDARY_WATER_FIELDS);
+    for (i = 0; i < n && result == CRIT3D_OK; i++)
+    {
+        int myType = (ctx->myNode[i].boundary == NULL) ? BOUNDARY_NONE : ctx->myNode[i].boundary->type;
+        if (int(boundaryValues[i * SNAPSHOT_BOUNDARY_WATER_FIELDS]) != myType) result = TOPOGRAPHY_ERROR;
+    }
+
+    if (result == CRIT3D_OK)
+        result = readSection(fp, &header, SNAPSHOT_LINK_SUMFLOW, linkValues, sizeof(float), n * nrLinks);
+    if (result == CRIT3D_OK)
+        result = readSection(fp, &header, SNAPSHOT_SOLVER, solverValues, sizeof(double), SNAPSHOT_SOLVER_FIELDS);
+
+    if (isHeat)
+    {
+        if (result == CRIT3D_OK)
+            result = readSection(fp, &header, SNAPSHOT_NODE_HEAT, heatValues, sizeof(double), n * SNAPSHOT_NODE_HEAT_FIELDS);
+        if (result == CRIT3D_OK)
+            result = readSection(fp, &header, SNAPSHOT_BOUNDARY_HEAT, heatBoundaryValues, sizeof(double), n * SNAPSHOT_BOUNDARY_HEAT_FIELDS);
+        if (result == CRIT3D_OK)
+            result = readSection(fp, &header, SNAPSHOT_LINK_HEATFLUX, fluxValues, sizeof(float), n * nrLinks * nrFluxValues);
+    }
+
+    if (result == CRIT3D_OK)
+    {
+        for (id = SNAPSHOT_NODE_H; id < SNAPSHOT_NODE_ARRAYS; id++)
+            memcpy(nodeArrays[id], &nodeValues[id * n], size_t(n) * sizeof(double));
+
+        for (i = 0; i < n; i++)
+        {
+            Tboundary *myBoundary = ctx->myNode[i].boundary;
+            if (myBoundary == NULL) continue;
+            double *v = &boundaryValues[i * SNAPSHOT_BOUNDARY_WATER_FIELDS];
+            myBoundary->waterFlow = v[1];
+            myBoundary->sumBoundaryWaterFlow = v[2];
+            myBoundary->prescribedTotalPotential = v[3];
+        }
+
+        /*! link flows */
+        for (i = 0; i < n; i++)
+            for (l = 0; l < nrLinks; l++)
+                getNodeLink(ctx, i, l)->sumFlow = linkValues[i * nrLinks + l];
+
+        /*! balance accumulators and time step */
+        arrayToBalance(&solverValues[0], &ctx->balanceCurrentTimeStep);
+        arrayToBalance(&solverValues[SNAPSHOT_BALANCE_FIELDS], &ctx->balancePreviousTimeStep);
+        arrayToBalance(&solverValues[2 * SNAPSHOT_BALANCE_FIELDS], &ctx->balanceCurrentPeriod);
+        arrayToBalance(&solverValues[3 * SNAPSHOT_BALANCE_FIELDS], &ctx->balanceWholePeriod);
+        double *v = &solverValues[4 * SNAPSHOT_BALANCE_FIELDS];
+        ctx->myParameters.current_delta_t = v[0];
+        ctx->bestMBRerror = v[1];
+        ctx->previousMBRerror = v[2];
+        ctx->isHalfTimeStepForced = (v[3] != 0.);
+        ctx->Courant = v[4];
+        ctx->CourantHeat = v[5];
+        ctx->fluxCourant = v[6];
+
+        if (isHeat)
+        {
+            for (i = 0; i < n; i++)
+            {
+                TCrit3DNodeHeat *myHeat = (ctx->myNode[i].extra != NULL) ? ctx->myNode[i].extra->Heat : NULL;
+                if (myHeat == NULL) continue;
+                double *h = &heatValues[i * SNAPSHOT_NODE_HEAT_FIELDS];
+                myHeat->T = h[0];
+                myHeat->oldT = h[1];
+                myHeat->Qh = h[2];
+                myHeat->sinkSource = h[3];
+            }
+
+            for (i = 0; i < n; i++)
+            {
+                Tboundary *myBoundary = ctx->myNode[i].boundary;
+                if (myBoundary != NULL && myBoundary->Heat != NULL)
+                    arrayToHeatBoundary(&heatBoundaryValues[i * SNAPSHOT_BOUNDARY_HEAT_FIELDS], myBoundary->Heat);
+            }
+
+            for (i = 0; i < n; i++)
+                for (l = 0; l < nrLinks; l++)
+                {
+                    TlinkedNode *myLink = getNodeLink(ctx, i, l);
+                    THeatFlux *myFlux = (myLink->linkedExtra != NULL) ? myLink->linkedExtra->heatFlux : NULL;
+                    if (myFlux == NULL) continue;
+                    float *f = &fluxValues[(i * nrLinks + l) * nrFluxValues];
+                    myFlux->waterFlux = f[0];
+                    myFlux->vaporFlux = f[1];
+                    if (myFlux->fluxes != NULL)
+                        for (long k = 2; k < nrFluxValues; k++) myFlux->fluxes[k-2] = f[k];
+                }
+        }
+
+        invalidateAssembly(ctx);
+    }
+
+    free(nodeValues);
+    free(boundaryValues);
+    free(linkValues);
+    free(heatValues);
+    free(heatBoundaryValues);
+    free(fluxValues);
+
+    return(result);
+}
+
+
+namespace soilFluxes3D {
+
+    /*!
+     * \brief save the complete state of the domain (water, heat, boundaries, link flows,
+     * balance accumulators and current time step) in a binary snapshot.
+     * The snapshot is written in fileName.tmp and then renamed: an interrupted write
+     * does not leave a truncated snapshot with the final name
+     * \param fileName
+     * \return OK/ERROR
+     */
+    int DLL_EXPORT __STDCALL saveStateSnapshot(TCrit3Dcontext *ctx, const char *fileName)
+ {
+    if (ctx->myNode == NULL || ctx->nodeData.H == NULL) return(MEMORY_ERROR);
+
+    size_t nameLength = strlen(fileName);
+    char *tmpFileName = (char *) malloc(nameLength + 5);
+    if (tmpFileName == NULL) return(MEMORY_ERROR);
+    memcpy(tmpFileName, fileName, nameLength);
+    memcpy(tmpFileName + nameLength, ".tmp", 5);
+
+    int result = FILE_ERROR;
+    FILE *fp = fopen(tmpFileName, "wb");
+    if (fp != NULL)
+    {
+        result = writeSnapshot(ctx, fp);
+        if (fclose(fp) != 0 && result == CRIT3D_OK) result = FILE_ERROR;
+
+        if (result == CRIT3D_OK)
+        {
+            // rename does not replace an existing file on Windows
+            remove(fileName);
+            if (rename(tmpFileName, fileName) != 0) result = FILE_ERROR;
+        }
+        if (result != CRIT3D_OK) remove(tmpFileName);
+    }
+
+    free(tmpFileName);
+    return(result);
+ }
+
+
+    /*!
+     * \brief restore the state of the domain from a binary snapshot saved on the same domain;
+     * the following computation is identical to the one of the saved domain
+     * \param fileName
+     * \return OK/ERROR (TOPOGRAPHY_ERROR: snapshot of a different domain,
+     * PARAMETER_ERROR: different snapshot version)
+     */
+    int DLL_EXPORT __STDCALL loadStateSnapshot(TCrit3Dcontext *ctx, const char *fileName)
+ {
+    if (ctx->myNode == NULL || ctx->nodeData.H == NULL) return(MEMORY_ERROR);
+
+    FILE *fp = fopen(fileName, "rb");
+    if (fp == NULL) return(FILE_ERROR);
+
+    int result = readSnapshot(ctx, fp);
+    fclose(fp);
+
+    return(result);
+ }
+
+}
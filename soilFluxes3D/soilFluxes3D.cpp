@@ -28,6 +28,7 @@
 #include <stdio.h>
 #include <math.h>
 #include <malloc.h>
+#include <new>
 
 #include <qdebug.h>
 
@@ -43,24 +44,6 @@
 #include "header/heat.h"
 #include "header/extra.h"
 
-/*! global variables */
-
-TParameters myParameters;
-TCrit3DStructure myStructure;
-
-TCrit3Dnode *myNode = NULL;
-TmatrixElement **A = NULL;
-
-double *invariantFlux = NULL;
-double *C = NULL;
-double *X = NULL;
-double *b = NULL;
-
-Tsoil Soil_List[MAX_SOILS][MAX_HORIZONS];
-Tsoil Surface_List[MAX_SURFACES];
-
-
-
 namespace soilFluxes3D {
 
 	int DLL_EXPORT __STDCALL test()
@@ -68,110 +51,418 @@ namespace soilFluxes3D {
         return(CRIT3D_OK);
 	}
 
-	void DLL_EXPORT __STDCALL cleanMemory()
+	void DLL_EXPORT __STDCALL cleanMemory(TCrit3Dcontext *ctx)
 	{
-        cleanNodes();
-        cleanArrays();
+        cleanNodes(ctx);
+        cleanArrays(ctx);
         //clean balance
 	}
 
-    void DLL_EXPORT __STDCALL initializeHeat(short myType, bool computeAdvectiveHeat, bool computeLatentHeat)
+    /*!
+     * \brief create an empty context (an independent domain)
+     * \return context pointer, NULL if out of memory
+     */
+    TCrit3Dcontext* DLL_EXPORT __STDCALL createContext()
+ {
+    TCrit3Dcontext *ctx = new (std::nothrow) TCrit3Dcontext();
+    if (ctx == NULL) return NULL;
+
+    ctx->Soil_List = (Tsoil (*)[MAX_HORIZONS]) calloc(MAX_SOILS, sizeof(Tsoil[MAX_HORIZONS]));
+    ctx->Surface_List = (Tsoil *) calloc(MAX_SURFACES, sizeof(Tsoil));
+    if (ctx->Soil_List == NULL || ctx->Surface_List == NULL)
+    {
+        deleteContext(ctx);
+        return NULL;
+    }
+
+    ctx->myParameters.initialize();
+    ctx->myStructure.initialize();
+    resetSolverStatistics(ctx);
+    resetTimeStepStatistics(ctx);
+
+    return ctx;
+ }
+
+    void DLL_EXPORT __STDCALL deleteContext(TCrit3Dcontext *ctx)
+ {
+    if (ctx == NULL) return;
+
+    cleanMemory(ctx);
+
+    /*! the soils of an ensemble member belong to its topology */
+    if (ctx->topology == NULL)
+    {
+        if (ctx->Soil_List != NULL)
+        {
+            for (int i = 0; i < MAX_SOILS; i++)
+                for (int j = 0; j < MAX_HORIZONS; j++)
+                    cleanSoilTable(&(ctx->Soil_List[i][j]));
+            free(ctx->Soil_List);
+        }
+        if (ctx->Surface_List != NULL) free(ctx->Surface_List);
+    }
+
+    delete ctx;
+ }
+
+    void DLL_EXPORT __STDCALL initializeHeat(TCrit3Dcontext *ctx, short myType, bool computeAdvectiveHeat, bool computeLatentHeat)
 {
-    myStructure.saveHeatFluxesType = myType;
-    myStructure.computeHeatAdvection = computeAdvectiveHeat;
-    myStructure.computeHeatVapor = computeLatentHeat;
+    ctx->myStructure.saveHeatFluxesType = myType;
+    ctx->myStructure.computeHeatAdvection = computeAdvectiveHeat;
+    ctx->myStructure.computeHeatVapor = computeLatentHeat;
 }
 
-    int DLL_EXPORT __STDCALL initialize(long nrNodes, int nrLayers, int nrLateralLinks,
+    int DLL_EXPORT __STDCALL initialize(TCrit3Dcontext *ctx, long nrNodes, int nrLayers, int nrLateralLinks,
                                         bool computeWater_, bool computeHeat_, bool computeSolutes_)
 {
+    /*! an ensemble member can not change its (shared) topology */
+    if (ctx->topology != NULL) return(TOPOGRAPHY_ERROR);
+
     /*! clean the old data structures */
-    cleanMemory();
+    cleanMemory(ctx);
 
-    myParameters.initialize();
-    myStructure.initialize();   
+    ctx->myParameters.initialize();
+    ctx->myStructure.initialize();   
+    resetSolverStatistics(ctx);
+    resetTimeStepStatistics(ctx);
 
-    myStructure.computeWater = computeWater_;
-    myStructure.computeHeat = computeHeat_;
+    ctx->myStructure.computeWater = computeWater_;
+    ctx->myStructure.computeHeat = computeHeat_;
     if (computeHeat_)
     {
-        myStructure.computeHeatVapor = true;
-        myStructure.computeHeatAdvection = true;
+        ctx->myStructure.computeHeatVapor = true;
+        ctx->myStructure.computeHeatAdvection = true;
     }
-    myStructure.computeSolutes = computeSolutes_;
+    ctx->myStructure.computeSolutes = computeSolutes_;
 
-    myStructure.nrNodes = nrNodes;
-    myStructure.nrLayers = nrLayers;
-    myStructure.nrLateralLinks = nrLateralLinks;
+    ctx->myStructure.nrNodes = nrNodes;
+    ctx->myStructure.nrLayers = nrLayers;
+    ctx->myStructure.nrLateralLinks = nrLateralLinks;
     /*! max nr columns = nr. of lateral links + 2 columns for up and down link + 1 column for diagonal */
-    myStructure.maxNrColumns = nrLateralLinks + 2 + 1;
+    ctx->myStructure.maxNrColumns = nrLateralLinks + 2 + 1;
 
     /*! build the nodes vector */
-    myNode = (TCrit3Dnode *) calloc(myStructure.nrNodes, sizeof(TCrit3Dnode));
-	for (long i = 0; i < myStructure.nrNodes; i++)
+    ctx->myNode = (TCrit3Dnode *) calloc(ctx->myStructure.nrNodes, sizeof(TCrit3Dnode));
+	for (long i = 0; i < ctx->myStructure.nrNodes; i++)
 	{
-		myNode[i].Soil = NULL;
-		myNode[i].boundary = NULL;
-		myNode[i].up.index = NOLINK;
-		myNode[i].down.index = myNode[i].up.index = NOLINK;
+		ctx->myNode[i].Soil = NULL;
+		ctx->myNode[i].boundary = NULL;
+		ctx->myNode[i].up.index = NOLINK;
+		ctx->myNode[i].down.index = ctx->myNode[i].up.index = NOLINK;
 
-        myNode[i].lateral = (TlinkedNode *) calloc(myStructure.nrLateralLinks, sizeof(TlinkedNode));
-        for (short l = 0; l < myStructure.nrLateralLinks; l++)
+        ctx->myNode[i].lateral = (TlinkedNode *) calloc(ctx->myStructure.nrLateralLinks, sizeof(TlinkedNode));
+        for (short l = 0; l < ctx->myStructure.nrLateralLinks; l++)
         {
-            myNode[i].lateral[l].index = NOLINK;
-            if (myStructure.computeHeat || myStructure.computeSolutes)
-                myNode[i].lateral[l].linkedExtra = new(TCrit3DLinkedNodeExtra);
+            ctx->myNode[i].lateral[l].index = NOLINK;
+            if (ctx->myStructure.computeHeat || ctx->myStructure.computeSolutes)
+                ctx->myNode[i].lateral[l].linkedExtra = new(TCrit3DLinkedNodeExtra);
         }
     }
 
+    if (ctx->myNode == NULL) return(MEMORY_ERROR);
+
+    /*! node state arrays */
+    int result = initializeNodeData(ctx);
+    if (result != CRIT3D_OK) return(result);
+
     /*! build the matrix */
-    if (myNode == NULL)
-        {return(MEMORY_ERROR);}
-    else
-		{return(initializeArrays());}
+    return(initializeArrays(ctx));
  }
 
-	int DLL_EXPORT __STDCALL setNumericalParameters(float minDeltaT, float maxDeltaT, int maxIterationNumber,
-                        int maxApproximationsNumber, int ResidualTolerance, float MBRThreshold)
+	int DLL_EXPORT __STDCALL setNumericalParameters(TCrit3Dcontext *ctx, float minDeltaT, float maxDeltaT, int maxIterationNumber,
+                        int maxApproximationsNumber, int ResidualTolerance, float MBRThreshold, int nrThreads)
  {
      /*!
         \brief Set numerical solution parameters
+        nrThreads > 1: multicolor Gauss-Seidel, each color is swept in parallel
      */
 
         if (minDeltaT < 0.1) minDeltaT = float(0.1);
         if (minDeltaT > 3600) minDeltaT = 3600;
-        myParameters.delta_t_min = minDeltaT;
+        ctx->myParameters.delta_t_min = minDeltaT;
 
         if (maxDeltaT < 60) maxDeltaT = 60;
         if (maxDeltaT > 3600) maxDeltaT = 3600;
         if (maxDeltaT < minDeltaT) maxDeltaT = minDeltaT;
-        myParameters.delta_t_max = maxDeltaT;
+        ctx->myParameters.delta_t_max = maxDeltaT;
 
-        myParameters.current_delta_t = myParameters.delta_t_max;
+        ctx->myParameters.current_delta_t = ctx->myParameters.delta_t_max;
 
         if (maxIterationNumber < 10) maxIterationNumber = 10;
         if (maxIterationNumber > MAX_NUMBER_ITERATIONS) maxIterationNumber = MAX_NUMBER_ITERATIONS;
-        myParameters.iterazioni_max = maxIterationNumber;
+        ctx->myParameters.iterazioni_max = maxIterationNumber;
 
         if (maxApproximationsNumber < 1) maxApproximationsNumber = 1;
 
 		if (maxApproximationsNumber > MAX_NUMBER_APPROXIMATIONS)
 				maxApproximationsNumber = MAX_NUMBER_APPROXIMATIONS;
 
-        myParameters.maxApproximationsNumber = maxApproximationsNumber;
+        ctx->myParameters.maxApproximationsNumber = maxApproximationsNumber;
 
         if (ResidualTolerance < 4) ResidualTolerance = 4;
         if (ResidualTolerance > 16) ResidualTolerance = 16;
-        myParameters.ResidualTolerance = pow(double(10.), -ResidualTolerance);
+        ctx->myParameters.ResidualTolerance = pow(double(10.), -ResidualTolerance);
 
         if (MBRThreshold < 1.) MBRThreshold = 1.;
         if (MBRThreshold > 6.) MBRThreshold = 6.;
-        myParameters.MBRThreshold = pow(double(10.), double(-MBRThreshold));
+        ctx->myParameters.MBRThreshold = pow(double(10.), double(-MBRThreshold));
+
+        if (nrThreads < 1) nrThreads = 1;
+        ctx->myParameters.nrThreads = nrThreads;
 
         return(CRIT3D_OK);
  }
 
 
+    /*!
+     * \brief Set the linear solver of a process
+     * \param process PROCESS_WATER or PROCESS_HEAT
+     * \param method RELAXATION (Gauss-Seidel), BICGSTAB or CONJUGATE_GRADIENT
+     * \return OK/ERROR
+     */
+    int DLL_EXPORT __STDCALL setSolverMethod(TCrit3Dcontext *ctx, int process, int method)
+ {
+    if ((method != RELAXATION) && (method != BICGSTAB) && (method != CONJUGATE_GRADIENT))
+        return(PARAMETER_ERROR);
+
+    if (process == PROCESS_WATER)
+        ctx->myParameters.waterSolutionMethod = method;
+    else if (process == PROCESS_HEAT)
+        ctx->myParameters.heatSolutionMethod = method;
+    else
+        return(PARAMETER_ERROR);
+
+    return(CRIT3D_OK);
+ }
+
+
+    void DLL_EXPORT __STDCALL resetSolverStatistics(TCrit3Dcontext *ctx)
+ {
+    ctx->waterSolverStatistics.initialize();
+    ctx->heatSolverStatistics.initialize();
+    ctx->assembly.nrNodesComputed = 0;
+    ctx->assembly.nrNodesReused = 0;
+    ctx->heatCache.nrEvaluations = 0;
+    ctx->heatCache.nrReuses = 0;
+ }
+
+
+    /*!
+     * \brief Set the incremental assembly of the water matrix:
+     * k and dTheta/dH of a subsurface node, and the conductances of its subsurface links,
+     * are recomputed only if its potential (current or previous) moved more than tolerance
+     * since their last evaluation; surface links, the diagonal and the constant terms
+     * are always computed. Not used with heat.
+     * default: useIncremental = false (full assembly at every approximation)
+     * \param useIncremental
+     * \param tolerance [m] (0 = reuse only unchanged values)
+     * \return OK/ERROR
+     */
+    int DLL_EXPORT __STDCALL setIncrementalAssembly(TCrit3Dcontext *ctx, bool useIncremental, double tolerance)
+ {
+    if (tolerance < 0.) return(PARAMETER_ERROR);
+
+    ctx->myParameters.useIncrementalAssembly = useIncremental;
+    ctx->myParameters.incrementalAssemblyTolerance = tolerance;
+    invalidateAssembly(ctx);
+
+    return(CRIT3D_OK);
+ }
+
+
+    /*!
+     * \brief number of subsurface nodes evaluated (isReused = false) or reused (isReused = true)
+     * by the incremental assembly since the last reset of the solver statistics
+     */
+    long DLL_EXPORT __STDCALL getNrAssemblyNodes(TCrit3Dcontext *ctx, bool isReused)
+ {
+    return isReused ? ctx->assembly.nrNodesReused : ctx->assembly.nrNodesComputed;
+ }
+
+
+    /*!
+     * \brief number of node heat properties (heat capacity, conductivity, vapor conductivity,
+     * latent heat) computed (isReused = false) or reused within the same heat step (isReused = true)
+     * since the last reset of the solver statistics
+     */
+    long DLL_EXPORT __STDCALL getNrHeatPropertyEvaluations(TCrit3Dcontext *ctx, bool isReused)
+ {
+    return isReused ? ctx->heatCache.nrReuses : ctx->heatCache.nrEvaluations;
+ }
+
+
+    /*!
+     * \brief Set the control of the water time step
+     * \param method TIMESTEP_HALVE_DOUBLE (default): the step is halved when rejected
+     * and doubled when the system is stable; TIMESTEP_ADAPTIVE: the next step is predicted
+     * from the mass balance error trend, the Courant number and the number of iterations
+     * \return OK/ERROR
+     */
+    int DLL_EXPORT __STDCALL setTimeStepControl(TCrit3Dcontext *ctx, int method)
+ {
+    if ((method != TIMESTEP_HALVE_DOUBLE) && (method != TIMESTEP_ADAPTIVE))
+        return(PARAMETER_ERROR);
+
+    ctx->myParameters.timeStepControl = method;
+    return(CRIT3D_OK);
+ }
+
+
+    /*!
+     * \brief Set the heat sub-cycling: when the heat Courant number is > 1
+     * the heat equation is integrated with smaller internal steps inside the
+     * accepted water step (H linearly interpolated), instead of halving the
+     * water time step
+     * default: useSubCycling = false
+     */
+    void DLL_EXPORT __STDCALL setHeatSubCycling(TCrit3Dcontext *ctx, bool useSubCycling)
+ {
+    ctx->myParameters.useHeatSubCycling = useSubCycling;
+ }
+
+
+    void DLL_EXPORT __STDCALL resetTimeStepStatistics(TCrit3Dcontext *ctx)
+ {
+    ctx->timeStepStatistics.initialize();
+    ctx->previousMBRerror = 0.;
+ }
+
+
+    /*!
+     * \brief number of accepted water time steps since the last reset
+     */
+    long DLL_EXPORT __STDCALL getNrAcceptedTimeSteps(TCrit3Dcontext *ctx)
+ {
+    return ctx->timeStepStatistics.nrAccepted;
+ }
+
+
+    /*!
+     * \brief number of rejected water time steps since the last reset
+     * \param cause REJECTED_ALL, REJECTED_COURANT, REJECTED_SOLVER or REJECTED_BALANCE
+     */
+    long DLL_EXPORT __STDCALL getNrRejectedTimeSteps(TCrit3Dcontext *ctx, int cause)
+ {
+    switch (cause)
+    {
+        case REJECTED_ALL:
+            return ctx->timeStepStatistics.nrRejectedCourant + ctx->timeStepStatistics.nrRejectedSolver
+                    + ctx->timeStepStatistics.nrRejectedBalance;
+        case REJECTED_COURANT:
+            return ctx->timeStepStatistics.nrRejectedCourant;
+        case REJECTED_SOLVER:
+            return ctx->timeStepStatistics.nrRejectedSolver;
+        case REJECTED_BALANCE:
+            return ctx->timeStepStatistics.nrRejectedBalance;
+        default:
+            return(PARAMETER_ERROR);
+    }
+ }
+
+
+    /*!
+     * \brief [s] current water time step
+     */
+    double DLL_EXPORT __STDCALL getCurrentTimeStep(TCrit3Dcontext *ctx)
+ {
+    return ctx->myParameters.current_delta_t;
+ }
+
+
+    /*!
+     * \brief number of accepted (isRejected = false) or rejected (isRejected = true)
+     * heat time steps since the last reset
+     */
+    long DLL_EXPORT __STDCALL getNrHeatTimeSteps(TCrit3Dcontext *ctx, bool isRejected)
+ {
+    return isRejected ? ctx->timeStepStatistics.nrHeatRejected : ctx->timeStepStatistics.nrHeatAccepted;
+ }
+
+
+    /*!
+     * \brief number of linear systems solved since the last reset
+     */
+    long DLL_EXPORT __STDCALL getSolverNrSystems(TCrit3Dcontext *ctx, int process)
+ {
+    if (process == PROCESS_WATER) return ctx->waterSolverStatistics.nrSystems;
+    else if (process == PROCESS_HEAT) return ctx->heatSolverStatistics.nrSystems;
+    else return(PARAMETER_ERROR);
+ }
+
+
+    /*!
+     * \brief total number of solver iterations since the last reset
+     */
+    long DLL_EXPORT __STDCALL getSolverNrIterations(TCrit3Dcontext *ctx, int process)
+ {
+    if (process == PROCESS_WATER) return ctx->waterSolverStatistics.nrIterations;
+    else if (process == PROCESS_HEAT) return ctx->heatSolverStatistics.nrIterations;
+    else return(PARAMETER_ERROR);
+ }
+
+
+    int DLL_EXPORT __STDCALL getSolverLastIterations(TCrit3Dcontext *ctx, int process)
+ {
+    if (process == PROCESS_WATER) return ctx->waterSolverStatistics.lastIterations;
+    else if (process == PROCESS_HEAT) return ctx->heatSolverStatistics.lastIterations;
+    else return(PARAMETER_ERROR);
+ }
+
+
+    /*!
+     * \brief infinity norm of the residual of the last system
+     * (for relaxation: last iteration change)
+     */
+    double DLL_EXPORT __STDCALL getSolverLastResidual(TCrit3Dcontext *ctx, int process)
+ {
+    if (process == PROCESS_WATER) return ctx->waterSolverStatistics.lastResidual;
+    else if (process == PROCESS_HEAT) return ctx->heatSolverStatistics.lastResidual;
+    else return(PARAMETER_ERROR);
+ }
+
+
+    /*!
+     * \brief (re)build the tables of all the defined soil horizons
+     */
+    void buildSoilTables(TCrit3Dcontext *ctx)
+ {
+    /*! the soils of an ensemble member belong to its topology */
+    if (ctx->topology != NULL) return;
+
+    for (int i = 0; i < MAX_SOILS; i++)
+        for (int j = 0; j < MAX_HORIZONS; j++)
+            if (ctx->Soil_List[i][j].VG_alpha > 0.)
+                buildSoilTable(ctx, &ctx->Soil_List[i][j], ctx->myParameters.soilTablesTolerance);
+ }
+
+
+    /*!
+     * \brief Set the tabulated evaluation of the hydraulic functions (Se, K, dTheta/dH)
+     * tables are built for each soil horizon, log-spaced in psi, and refined until the
+     * interpolation error is below tolerance (absolute on Se, relative on K);
+     * where the accuracy can not be reached the exact formulas are used.
+     * default: useTables = false (exact Van Genutchen - Mualem formulas)
+     * \param useTables
+     * \param tolerance [-]
+     * \return OK/ERROR (TOPOGRAPHY_ERROR on an ensemble member: the tables belong to the topology)
+     */
+    int DLL_EXPORT __STDCALL setSoilTables(TCrit3Dcontext *ctx, bool useTables, double tolerance)
+ {
+    /*! an ensemble member uses the soil tables of its (shared) topology */
+    if (ctx->topology != NULL) return(TOPOGRAPHY_ERROR);
+    if (useTables && tolerance <= 0.) return(PARAMETER_ERROR);
+
+    ctx->myParameters.useSoilTables = useTables;
+    if (! useTables) return(CRIT3D_OK);
+
+    ctx->myParameters.soilTablesTolerance = tolerance;
+    buildSoilTables(ctx);
+    invalidateAssembly(ctx);
+
+    return(CRIT3D_OK);
+ }
+
+
     /*!
      * \brief Set hydraulic properties
      *  default values:
@@ -184,22 +475,26 @@ namespace soilFluxes3D {
      * \return OK/ERROR
      */
 
-	int DLL_EXPORT __STDCALL setHydraulicProperties(int waterRetentionCurve,
+	int DLL_EXPORT __STDCALL setHydraulicProperties(TCrit3Dcontext *ctx, int waterRetentionCurve,
                         int conductivityMeanType, float horizVertRatioConductivity)
  {
+    bool isCurveChanged = (waterRetentionCurve != ctx->myParameters.waterRetentionCurve);
+    invalidateAssembly(ctx);
 
-	myParameters.waterRetentionCurve = waterRetentionCurve;
+	ctx->myParameters.waterRetentionCurve = waterRetentionCurve;
 
-    myParameters.meanType = conductivityMeanType;
+    if (isCurveChanged && ctx->myParameters.useSoilTables) buildSoilTables(ctx);
+
+    ctx->myParameters.meanType = conductivityMeanType;
 
 	if  ((horizVertRatioConductivity >= 1) && (horizVertRatioConductivity <= 100))
     {
-        myParameters.k_lateral_vertical_ratio = horizVertRatioConductivity;
+        ctx->myParameters.k_lateral_vertical_ratio = horizVertRatioConductivity;
         return(CRIT3D_OK);
     }
 	else
 	{
-	    myParameters.k_lateral_vertical_ratio = 10.;
+	    ctx->myParameters.k_lateral_vertical_ratio = 10.;
 	    return(PARAMETER_ERROR);
 	}
  }
@@ -217,86 +512,92 @@ namespace soilFluxes3D {
      * \param slope
      * \return
      */
-	int DLL_EXPORT __STDCALL setNode(long myIndex, float x, float y, float z, double volume_or_area, bool isSurface,
+	int DLL_EXPORT __STDCALL setNode(TCrit3Dcontext *ctx, long myIndex, float x, float y, float z, double volume_or_area, bool isSurface,
                         bool isBoundary, int boundaryType, float slope)
  {
 
 
-    if (myNode == NULL) return(MEMORY_ERROR);
-    if ((myIndex < 0) || (myIndex >= myStructure.nrNodes)) return(INDEX_ERROR);
+    if (ctx->myNode == NULL) return(MEMORY_ERROR);
+    if (ctx->topology != NULL) return(TOPOGRAPHY_ERROR);
+    if ((myIndex < 0) || (myIndex >= ctx->myStructure.nrNodes)) return(INDEX_ERROR);
 
 	if (isBoundary)
 	{
-		myNode[myIndex].boundary = new(Tboundary);
-		initializeBoundary(myNode[myIndex].boundary, boundaryType, slope);
+		ctx->myNode[myIndex].boundary = new(Tboundary);
+		initializeBoundary(ctx, ctx->myNode[myIndex].boundary, boundaryType, slope);
 	}
 
-    if ((myStructure.computeHeat || myStructure.computeSolutes) && ! isSurface)
+    if ((ctx->myStructure.computeHeat || ctx->myStructure.computeSolutes) && ! isSurface)
     {
-        myNode[myIndex].extra = new(TCrit3DnodeExtra);
-        initializeExtra(myNode[myIndex].extra, myStructure.computeHeat, myStructure.computeSolutes);
+        ctx->myNode[myIndex].extra = new(TCrit3DnodeExtra);
+        initializeExtra(ctx->myNode[myIndex].extra, ctx->myStructure.computeHeat, ctx->myStructure.computeSolutes);
     }
 
-    myNode[myIndex].x = x;
-    myNode[myIndex].y = y;
-    myNode[myIndex].z = z;
-    myNode[myIndex].volume_area = volume_or_area;   /*!< area on surface elements, volume on sub-surface */
+    ctx->nodeData.x[myIndex] = x;
+    ctx->nodeData.y[myIndex] = y;
+    ctx->nodeData.z[myIndex] = z;
+    ctx->nodeData.volume_area[myIndex] = volume_or_area;   /*!< area on surface elements, volume on sub-surface */
 
-	myNode[myIndex].isSurface = isSurface;
+	ctx->nodeData.isSurface[myIndex] = isSurface;
 
-    myNode[myIndex].waterSinkSource = 0.;
+    ctx->nodeData.waterSinkSource[myIndex] = 0.;
 
     return(CRIT3D_OK);
  }
 
 
-	int DLL_EXPORT __STDCALL setNodeLink(long n, long linkIndex, int direction, float interfaceArea)
+	int DLL_EXPORT __STDCALL setNodeLink(TCrit3Dcontext *ctx, long n, long linkIndex, int direction, float interfaceArea)
  {
     /*! error check */
-    if (myNode == NULL) return(MEMORY_ERROR);
+    if (ctx->myNode == NULL) return(MEMORY_ERROR);
+    if (ctx->topology != NULL) return(TOPOGRAPHY_ERROR);
 
-    if ((n < 0) || (n >= myStructure.nrNodes) || (linkIndex < 0) || (linkIndex >= myStructure.nrNodes))
+    if ((n < 0) || (n >= ctx->myStructure.nrNodes) || (linkIndex < 0) || (linkIndex >= ctx->myStructure.nrNodes))
         return(INDEX_ERROR);
 
+    /*! topology is changed: matrix pattern and node colors have to be recomputed */
+    cleanMatrix(ctx);
+    cleanNodeColors(ctx);
+
     short j;
     switch (direction)
     {
         case UP :
-                    myNode[n].up.index = linkIndex;
-                    myNode[n].up.area = interfaceArea;
-                    myNode[n].up.sumFlow = 0;
+                    ctx->myNode[n].up.index = linkIndex;
+                    ctx->myNode[n].up.area = interfaceArea;
+                    ctx->myNode[n].up.sumFlow = 0;
 
-                    if (myStructure.computeHeat || myStructure.computeSolutes)
+                    if (ctx->myStructure.computeHeat || ctx->myStructure.computeSolutes)
                     {
-                        myNode[n].up.linkedExtra = new(TCrit3DLinkedNodeExtra);
-                        initializeLinkExtra(myNode[n].up.linkedExtra, myStructure.computeHeat, myStructure.computeSolutes);
+                        ctx->myNode[n].up.linkedExtra = new(TCrit3DLinkedNodeExtra);
+                        initializeLinkExtra(ctx, ctx->myNode[n].up.linkedExtra, ctx->myStructure.computeHeat, ctx->myStructure.computeSolutes);
                     }
 
                     break;
         case DOWN :
-                    myNode[n].down.index = linkIndex;
-                    myNode[n].down.area = interfaceArea;
-					myNode[n].down.sumFlow = 0;
+                    ctx->myNode[n].down.index = linkIndex;
+                    ctx->myNode[n].down.area = interfaceArea;
+					ctx->myNode[n].down.sumFlow = 0;
 
-                    if (myStructure.computeHeat || myStructure.computeSolutes)
+                    if (ctx->myStructure.computeHeat || ctx->myStructure.computeSolutes)
                     {
-                        myNode[n].down.linkedExtra = new(TCrit3DLinkedNodeExtra);
-                        initializeLinkExtra(myNode[n].down.linkedExtra, myStructure.computeHeat, myStructure.computeSolutes);
+                        ctx->myNode[n].down.linkedExtra = new(TCrit3DLinkedNodeExtra);
+                        initializeLinkExtra(ctx, ctx->myNode[n].down.linkedExtra, ctx->myStructure.computeHeat, ctx->myStructure.computeSolutes);
                     }
 
                     break;
         case LATERAL :
                     j = 0;
-                    while ((j < myStructure.nrLateralLinks) && (myNode[n].lateral[j].index != NOLINK)) j++;
-                    if (j == myStructure.nrLateralLinks) return (TOPOGRAPHY_ERROR);
-                    myNode[n].lateral[j].index = linkIndex;
-                    myNode[n].lateral[j].area = interfaceArea;
-					myNode[n].lateral[j].sumFlow = 0;
+                    while ((j < ctx->myStructure.nrLateralLinks) && (ctx->myNode[n].lateral[j].index != NOLINK)) j++;
+                    if (j == ctx->myStructure.nrLateralLinks) return (TOPOGRAPHY_ERROR);
+                    ctx->myNode[n].lateral[j].index = linkIndex;
+                    ctx->myNode[n].lateral[j].area = interfaceArea;
+					ctx->myNode[n].lateral[j].sumFlow = 0;
 
-                    if (myStructure.computeHeat || myStructure.computeSolutes)
+                    if (ctx->myStructure.computeHeat || ctx->myStructure.computeSolutes)
                     {
-                        myNode[n].lateral[j].linkedExtra = new(TCrit3DLinkedNodeExtra);
-                        initializeLinkExtra(myNode[n].lateral[j].linkedExtra, myStructure.computeHeat, myStructure.computeSolutes);
+                        ctx->myNode[n].lateral[j].linkedExtra = new(TCrit3DLinkedNodeExtra);
+                        initializeLinkExtra(ctx, ctx->myNode[n].lateral[j].linkedExtra, ctx->myStructure.computeHeat, ctx->myStructure.computeSolutes);
                     }
 
                     break;
@@ -313,13 +614,14 @@ namespace soilFluxes3D {
      * \param surfaceIndex
      * \return
      */
-	int DLL_EXPORT __STDCALL setNodeSurface(long nodeIndex, int surfaceIndex)
+	int DLL_EXPORT __STDCALL setNodeSurface(TCrit3Dcontext *ctx, long nodeIndex, int surfaceIndex)
  {
-	if (myNode == NULL) return(MEMORY_ERROR);
-    if ((nodeIndex < 0) || (! myNode[nodeIndex].isSurface)) return(INDEX_ERROR);
+	if (ctx->myNode == NULL) return(MEMORY_ERROR);
+    if (ctx->topology != NULL) return(TOPOGRAPHY_ERROR);
+    if ((nodeIndex < 0) || (! ctx->nodeData.isSurface[nodeIndex])) return(INDEX_ERROR);
     if ((surfaceIndex < 0) || (surfaceIndex >= MAX_SURFACES)) return(PARAMETER_ERROR);
 
-    myNode[nodeIndex].Soil = &Surface_List[surfaceIndex];
+    ctx->myNode[nodeIndex].Soil = &ctx->Surface_List[surfaceIndex];
 
     return(CRIT3D_OK);
  }
@@ -332,14 +634,16 @@ namespace soilFluxes3D {
      * \param horizonIndex
      * \return
      */
-	int DLL_EXPORT __STDCALL setNodeSoil(long nodeIndex, int soilIndex, int horizonIndex)
+	int DLL_EXPORT __STDCALL setNodeSoil(TCrit3Dcontext *ctx, long nodeIndex, int soilIndex, int horizonIndex)
  {
-	if (myNode == NULL) return(MEMORY_ERROR);
-    if ((nodeIndex < 0) || (nodeIndex >= myStructure.nrNodes)) return(INDEX_ERROR);
+	if (ctx->myNode == NULL) return(MEMORY_ERROR);
+    if (ctx->topology != NULL) return(TOPOGRAPHY_ERROR);
+    if ((nodeIndex < 0) || (nodeIndex >= ctx->myStructure.nrNodes)) return(INDEX_ERROR);
     if ((soilIndex < 0) || (soilIndex >= MAX_SOILS)) return(PARAMETER_ERROR);
     if ((horizonIndex < 0) || (horizonIndex >= MAX_HORIZONS)) return(PARAMETER_ERROR);
 
-    myNode[nodeIndex].Soil = &Soil_List[soilIndex][horizonIndex];
+    ctx->myNode[nodeIndex].Soil = &ctx->Soil_List[soilIndex][horizonIndex];
+    invalidateAssembly(ctx);
 
     return(CRIT3D_OK);
  }
@@ -359,11 +663,13 @@ namespace soilFluxes3D {
      * \param L         [-]         tortuosity (Mualem formula)
      * \return OK/ERROR
      */
-    int DLL_EXPORT __STDCALL setSoilProperties(int nSoil, int nHorizon, double VG_alpha, double VG_n, double VG_m,
+    int DLL_EXPORT __STDCALL setSoilProperties(TCrit3Dcontext *ctx, int nSoil, int nHorizon, double VG_alpha, double VG_n, double VG_m,
                         double VG_he, double ThetaR, double ThetaS, double Ksat, double L, double organicMatter, double clay)
  {
 
 
+    if (ctx->topology != NULL) return(TOPOGRAPHY_ERROR);
+
 	if ((nSoil < 0) || (nSoil >= MAX_SOILS)) return(INDEX_ERROR);
 
     if ((nHorizon < 0) || (nHorizon >= MAX_HORIZONS)) return(INDEX_ERROR);
@@ -372,32 +678,40 @@ namespace soilFluxes3D {
     || (ThetaS <= 0.) || (ThetaS > 1.) || (ThetaR > ThetaS))
         return(PARAMETER_ERROR);
 
-    Soil_List[nSoil][nHorizon].VG_alpha  = VG_alpha;
-    Soil_List[nSoil][nHorizon].VG_n  = VG_n;
-	Soil_List[nSoil][nHorizon].VG_m =  VG_m;
+    ctx->Soil_List[nSoil][nHorizon].VG_alpha  = VG_alpha;
+    ctx->Soil_List[nSoil][nHorizon].VG_n  = VG_n;
+	ctx->Soil_List[nSoil][nHorizon].VG_m =  VG_m;
 
-    Soil_List[nSoil][nHorizon].VG_he = VG_he;
-    Soil_List[nSoil][nHorizon].VG_Sc = pow(1. + pow(VG_alpha * VG_he, VG_n), -VG_m);
+    ctx->Soil_List[nSoil][nHorizon].VG_he = VG_he;
+    ctx->Soil_List[nSoil][nHorizon].VG_Sc = pow(1. + pow(VG_alpha * VG_he, VG_n), -VG_m);
 
-    Soil_List[nSoil][nHorizon].Theta_r = ThetaR;
-    Soil_List[nSoil][nHorizon].Theta_s = ThetaS;
-    Soil_List[nSoil][nHorizon].K_sat = Ksat;
-    Soil_List[nSoil][nHorizon].Mualem_L = L;
+    ctx->Soil_List[nSoil][nHorizon].Theta_r = ThetaR;
+    ctx->Soil_List[nSoil][nHorizon].Theta_s = ThetaS;
+    ctx->Soil_List[nSoil][nHorizon].K_sat = Ksat;
+    ctx->Soil_List[nSoil][nHorizon].Mualem_L = L;
 
-    Soil_List[nSoil][nHorizon].organicMatter = organicMatter;
-    Soil_List[nSoil][nHorizon].clay = clay;
+    ctx->Soil_List[nSoil][nHorizon].organicMatter = organicMatter;
+    ctx->Soil_List[nSoil][nHorizon].clay = clay;
+
+    if (ctx->myParameters.useSoilTables)
+        buildSoilTable(ctx, &ctx->Soil_List[nSoil][nHorizon], ctx->myParameters.soilTablesTolerance);
+    else
+        cleanSoilTable(&ctx->Soil_List[nSoil][nHorizon]);
+
+    invalidateAssembly(ctx);
 
     return(CRIT3D_OK);
  }
 
 
-	int DLL_EXPORT __STDCALL setSurfaceProperties(int surfaceIndex, double roughness, double surfacePond)
+	int DLL_EXPORT __STDCALL setSurfaceProperties(TCrit3Dcontext *ctx, int surfaceIndex, double roughness, double surfacePond)
  {
+    if (ctx->topology != NULL) return(TOPOGRAPHY_ERROR);
     if ((surfaceIndex < 0) || (surfaceIndex >= MAX_SURFACES)) return(INDEX_ERROR);
     if ((roughness < 0.) || (surfacePond < 0.)) return(PARAMETER_ERROR);
 
-    Surface_List[surfaceIndex].Roughness = roughness;
-    Surface_List[surfaceIndex].Pond = surfacePond;
+    ctx->Surface_List[surfaceIndex].Roughness = roughness;
+    ctx->Surface_List[surfaceIndex].Pond = surfacePond;
 
     return(CRIT3D_OK);
  }
@@ -409,27 +723,27 @@ namespace soilFluxes3D {
      * \param potential [m]
      * \return OK/ERROR
      */
-	int DLL_EXPORT __STDCALL setMatricPotential(long nodeIndex, double potential)
+	int DLL_EXPORT __STDCALL setMatricPotential(TCrit3Dcontext *ctx, long nodeIndex, double potential)
  {
 
 
-     if (myNode == NULL)
+     if (ctx->myNode == NULL)
          return(MEMORY_ERROR);
-     if ((nodeIndex < 0) || (nodeIndex >= myStructure.nrNodes))
+     if ((nodeIndex < 0) || (nodeIndex >= ctx->myStructure.nrNodes))
          return(INDEX_ERROR);
 
-     myNode[nodeIndex].H = potential + myNode[nodeIndex].z;
-     myNode[nodeIndex].oldH = myNode[nodeIndex].H;
+     ctx->nodeData.H[nodeIndex] = potential + ctx->nodeData.z[nodeIndex];
+     ctx->nodeData.oldH[nodeIndex] = ctx->nodeData.H[nodeIndex];
 
-     if (myNode[nodeIndex].isSurface)
+     if (ctx->nodeData.isSurface[nodeIndex])
      {
-         myNode[nodeIndex].Se = 1.;
-         myNode[nodeIndex].k = NODATA;
+         ctx->nodeData.Se[nodeIndex] = 1.;
+         ctx->nodeData.k[nodeIndex] = NODATA;
      }
      else
      {
-         myNode[nodeIndex].Se = computeSe(nodeIndex);
-         myNode[nodeIndex].k = computeK(nodeIndex);
+         ctx->nodeData.Se[nodeIndex] = computeSe(ctx, nodeIndex);
+         ctx->nodeData.k[nodeIndex] = computeK(ctx, nodeIndex);
      }
 
      return(CRIT3D_OK);
@@ -442,27 +756,27 @@ namespace soilFluxes3D {
      * \param totalPotential [m]
      * \return OK/ERROR
      */
-	int DLL_EXPORT __STDCALL setTotalPotential(long nodeIndex, double totalPotential)
+	int DLL_EXPORT __STDCALL setTotalPotential(TCrit3Dcontext *ctx, long nodeIndex, double totalPotential)
  {
 
-	 if (myNode == NULL)
+	 if (ctx->myNode == NULL)
 		 return(MEMORY_ERROR);
 
-	 if ((nodeIndex < 0) || (nodeIndex >= myStructure.nrNodes))
+	 if ((nodeIndex < 0) || (nodeIndex >= ctx->myStructure.nrNodes))
 		 return(INDEX_ERROR);
 
-     myNode[nodeIndex].H = totalPotential;
-	 myNode[nodeIndex].oldH = myNode[nodeIndex].H;
+     ctx->nodeData.H[nodeIndex] = totalPotential;
+	 ctx->nodeData.oldH[nodeIndex] = ctx->nodeData.H[nodeIndex];
 
-	 if (myNode[nodeIndex].isSurface)
+	 if (ctx->nodeData.isSurface[nodeIndex])
 	 {
-		 myNode[nodeIndex].Se = 1.;
-		 myNode[nodeIndex].k = NODATA;
+		 ctx->nodeData.Se[nodeIndex] = 1.;
+		 ctx->nodeData.k[nodeIndex] = NODATA;
 	 }
 	 else
 	 {
-         myNode[nodeIndex].Se = computeSe(nodeIndex);
-         myNode[nodeIndex].k = computeK(nodeIndex);
+         ctx->nodeData.Se[nodeIndex] = computeSe(ctx, nodeIndex);
+         ctx->nodeData.k[nodeIndex] = computeK(ctx, nodeIndex);
 	 }
 
 	 return(CRIT3D_OK);
@@ -475,31 +789,31 @@ namespace soilFluxes3D {
      * \param waterContent [m^3 m^-3]
      * \return OK/ERROR
      */
-	int DLL_EXPORT __STDCALL setWaterContent(long nodeIndex, double waterContent)
+	int DLL_EXPORT __STDCALL setWaterContent(TCrit3Dcontext *ctx, long nodeIndex, double waterContent)
  {
 
 
-    if (myNode == NULL) return(MEMORY_ERROR);
+    if (ctx->myNode == NULL) return(MEMORY_ERROR);
 
-    if ((nodeIndex < 0) || (nodeIndex >= myStructure.nrNodes)) return(INDEX_ERROR);
+    if ((nodeIndex < 0) || (nodeIndex >= ctx->myStructure.nrNodes)) return(INDEX_ERROR);
 
     if (waterContent < 0.) return(PARAMETER_ERROR);
 
-    if (myNode[nodeIndex].isSurface)
+    if (ctx->nodeData.isSurface[nodeIndex])
             {
             /*! surface */
-            myNode[nodeIndex].H = myNode[nodeIndex].z + waterContent;
-            myNode[nodeIndex].oldH = myNode[nodeIndex].H;
-            myNode[nodeIndex].Se = 1.;
-            myNode[nodeIndex].k = 0.;
+            ctx->nodeData.H[nodeIndex] = ctx->nodeData.z[nodeIndex] + waterContent;
+            ctx->nodeData.oldH[nodeIndex] = ctx->nodeData.H[nodeIndex];
+            ctx->nodeData.Se[nodeIndex] = 1.;
+            ctx->nodeData.k[nodeIndex] = 0.;
             }
     else
             {
             if (waterContent > 1.0) return(PARAMETER_ERROR);
-            myNode[nodeIndex].Se = Se_from_theta(nodeIndex, waterContent);
-            myNode[nodeIndex].H = myNode[nodeIndex].z - psi_from_Se(nodeIndex);
-            myNode[nodeIndex].oldH = myNode[nodeIndex].H;
-            myNode[nodeIndex].k = computeK(nodeIndex);
+            ctx->nodeData.Se[nodeIndex] = Se_from_theta(ctx, nodeIndex, waterContent);
+            ctx->nodeData.H[nodeIndex] = ctx->nodeData.z[nodeIndex] - psi_from_Se(ctx, nodeIndex);
+            ctx->nodeData.oldH[nodeIndex] = ctx->nodeData.H[nodeIndex];
+            ctx->nodeData.k[nodeIndex] = computeK(ctx, nodeIndex);
             }
 
     return(CRIT3D_OK);
@@ -512,13 +826,13 @@ namespace soilFluxes3D {
      * \param waterSinkSource [m^3/sec] flow
      * \return OK/ERROR
      */
-	int DLL_EXPORT __STDCALL setWaterSinkSource(long nodeIndex, double waterSinkSource)
+	int DLL_EXPORT __STDCALL setWaterSinkSource(TCrit3Dcontext *ctx, long nodeIndex, double waterSinkSource)
  {
 
-    if (myNode == NULL) return(MEMORY_ERROR);
-    if ((nodeIndex < 0) || (nodeIndex >= myStructure.nrNodes)) return(INDEX_ERROR);
+    if (ctx->myNode == NULL) return(MEMORY_ERROR);
+    if ((nodeIndex < 0) || (nodeIndex >= ctx->myStructure.nrNodes)) return(INDEX_ERROR);
 
-    myNode[nodeIndex].waterSinkSource = waterSinkSource;
+    ctx->nodeData.waterSinkSource[nodeIndex] = waterSinkSource;
 
     return(CRIT3D_OK);
  }
@@ -530,15 +844,15 @@ namespace soilFluxes3D {
      * \param prescribedTotalPotential [m]
      * \return OK/ERROR
      */
-	int DLL_EXPORT __STDCALL setPrescribedTotalPotential(long nodeIndex, double prescribedTotalPotential)
+	int DLL_EXPORT __STDCALL setPrescribedTotalPotential(TCrit3Dcontext *ctx, long nodeIndex, double prescribedTotalPotential)
  {
 
-    if (myNode == NULL) return(MEMORY_ERROR);
-    if ((nodeIndex < 0) || (nodeIndex >= myStructure.nrNodes)) return(INDEX_ERROR);
-    if (myNode[nodeIndex].boundary == NULL) return(BOUNDARY_ERROR);
-	if (myNode[nodeIndex].boundary->type != BOUNDARY_PRESCRIBEDTOTALPOTENTIAL) return(BOUNDARY_ERROR);
+    if (ctx->myNode == NULL) return(MEMORY_ERROR);
+    if ((nodeIndex < 0) || (nodeIndex >= ctx->myStructure.nrNodes)) return(INDEX_ERROR);
+    if (ctx->myNode[nodeIndex].boundary == NULL) return(BOUNDARY_ERROR);
+	if (ctx->myNode[nodeIndex].boundary->type != BOUNDARY_PRESCRIBEDTOTALPOTENTIAL) return(BOUNDARY_ERROR);
 
-    myNode[nodeIndex].boundary->prescribedTotalPotential = prescribedTotalPotential;
+    ctx->myNode[nodeIndex].boundary->prescribedTotalPotential = prescribedTotalPotential;
 
     return(CRIT3D_OK);
  }
@@ -549,18 +863,18 @@ namespace soilFluxes3D {
      * \param nodeIndex
      * \return  surface: [m] surface water height , sub-surface: [m^3 m^-3] volumetric water content
      */
-	double DLL_EXPORT __STDCALL getWaterContent(long nodeIndex)
+	double DLL_EXPORT __STDCALL getWaterContent(TCrit3Dcontext *ctx, long nodeIndex)
 
  {
-        if (myNode == NULL) return(MEMORY_ERROR);
-        if ((nodeIndex < 0) || (nodeIndex >= myStructure.nrNodes)) return(INDEX_ERROR);
+        if (ctx->myNode == NULL) return(MEMORY_ERROR);
+        if ((nodeIndex < 0) || (nodeIndex >= ctx->myStructure.nrNodes)) return(INDEX_ERROR);
 
-        if  (myNode[nodeIndex].isSurface)
+        if  (ctx->nodeData.isSurface[nodeIndex])
             /*! surface */
-            return (myNode[nodeIndex].H - myNode[nodeIndex].z);
+            return (ctx->nodeData.H[nodeIndex] - ctx->nodeData.z[nodeIndex]);
         else
             /*! sub-surface */
-            return (theta_from_Se(nodeIndex));
+            return (theta_from_Se(ctx, nodeIndex));
  }
 
 
@@ -569,17 +883,17 @@ namespace soilFluxes3D {
      * \param index
      * \return  surface: [m] 0-1 water presence, sub-surface: [m^3 m^-3] awc
      */
-	double DLL_EXPORT __STDCALL getAvailableWaterContent(long index)
+	double DLL_EXPORT __STDCALL getAvailableWaterContent(TCrit3Dcontext *ctx, long index)
  {
-        if (myNode == NULL) return(MEMORY_ERROR);
-        if ((index < 0) || (index >= myStructure.nrNodes)) return(INDEX_ERROR);
+        if (ctx->myNode == NULL) return(MEMORY_ERROR);
+        if ((index < 0) || (index >= ctx->myStructure.nrNodes)) return(INDEX_ERROR);
 
-        if  (myNode[index].isSurface)
+        if  (ctx->nodeData.isSurface[index])
             /*! surface */
-            return (myNode[index].H - myNode[index].z);
+            return (ctx->nodeData.H[index] - ctx->nodeData.z[index]);
         else
             /*! sub-surface */
-            return max_value(0.0, theta_from_Se(index) - theta_from_sign_Psi(-160, index));
+            return max_value(0.0, theta_from_Se(ctx, index) - theta_from_sign_Psi(ctx, -160, index));
  }
 
 
@@ -589,17 +903,17 @@ namespace soilFluxes3D {
      * \param fieldCapacity
      * \return surface:	0, sub-surface: [m^3 m^-3]
      */
-	double DLL_EXPORT __STDCALL getWaterDeficit(long index, double fieldCapacity)
+	double DLL_EXPORT __STDCALL getWaterDeficit(TCrit3Dcontext *ctx, long index, double fieldCapacity)
  {
-        if (myNode == NULL) return(MEMORY_ERROR);
-        if ((index < 0) || (index >= myStructure.nrNodes)) return(INDEX_ERROR);
+        if (ctx->myNode == NULL) return(MEMORY_ERROR);
+        if ((index < 0) || (index >= ctx->myStructure.nrNodes)) return(INDEX_ERROR);
 
-        if  (myNode[index].isSurface)
+        if  (ctx->nodeData.isSurface[index])
             /*! surface */
             return (0.0);
         else
             /*! sub-surface */
-            return (theta_from_sign_Psi(-fieldCapacity, index) - theta_from_Se(index));
+            return (theta_from_sign_Psi(ctx, -fieldCapacity, index) - theta_from_Se(ctx, index));
  }
 
 
@@ -609,20 +923,20 @@ namespace soilFluxes3D {
   * \param nodeIndex
   * \return surface: [-] water presence 0-100 , sub-surface: [%] degree of saturation
   */
- double DLL_EXPORT __STDCALL getDegreeOfSaturation(long nodeIndex)
+ double DLL_EXPORT __STDCALL getDegreeOfSaturation(TCrit3Dcontext *ctx, long nodeIndex)
  {
-        if (myNode == NULL) return(MEMORY_ERROR);
-        if ((nodeIndex < 0) || (nodeIndex >= myStructure.nrNodes)) return(INDEX_ERROR);
+        if (ctx->myNode == NULL) return(MEMORY_ERROR);
+        if ((nodeIndex < 0) || (nodeIndex >= ctx->myStructure.nrNodes)) return(INDEX_ERROR);
 
-        if  (myNode[nodeIndex].isSurface)
+        if  (ctx->nodeData.isSurface[nodeIndex])
         {
-            if ((myNode[nodeIndex].H - myNode[nodeIndex].z) > 0.0001)
+            if ((ctx->nodeData.H[nodeIndex] - ctx->nodeData.z[nodeIndex]) > 0.0001)
                 return(100.0);
             else
                 return(0.0);
         }
         else
-            return (myNode[nodeIndex].Se*100.0);
+            return (ctx->nodeData.Se[nodeIndex]*100.0);
  }
 
 
@@ -630,9 +944,9 @@ namespace soilFluxes3D {
   * \brief computes total water content          [m^3]
   * \return result
   */
- double DLL_EXPORT __STDCALL getTotalWaterContent()
+ double DLL_EXPORT __STDCALL getTotalWaterContent(TCrit3Dcontext *ctx)
  {
-    return(computeTotalWaterContent());
+    return(computeTotalWaterContent(ctx));
  }
 
 
@@ -641,13 +955,13 @@ namespace soilFluxes3D {
   * \param nodeIndex
   * \return result
   */
- double DLL_EXPORT __STDCALL getWaterConductivity(long nodeIndex)
+ double DLL_EXPORT __STDCALL getWaterConductivity(TCrit3Dcontext *ctx, long nodeIndex)
  {
     /*! error check */
-    if (myNode == NULL) return(MEMORY_ERROR);
-    if ((nodeIndex < 0) || (nodeIndex >= myStructure.nrNodes)) return(INDEX_ERROR);
+    if (ctx->myNode == NULL) return(MEMORY_ERROR);
+    if ((nodeIndex < 0) || (nodeIndex >= ctx->myStructure.nrNodes)) return(INDEX_ERROR);
 
-    return (myNode[nodeIndex].k);
+    return (ctx->nodeData.k[nodeIndex]);
  }
 
 
@@ -656,12 +970,12 @@ namespace soilFluxes3D {
   * \param nodeIndex [-]
   * \return result
   */
- double DLL_EXPORT __STDCALL getMatricPotential(long nodeIndex)
+ double DLL_EXPORT __STDCALL getMatricPotential(TCrit3Dcontext *ctx, long nodeIndex)
  {
-    if (myNode == NULL) return(MEMORY_ERROR);
-    if ((nodeIndex < 0) || (nodeIndex >= myStructure.nrNodes)) return(INDEX_ERROR);
+    if (ctx->myNode == NULL) return(MEMORY_ERROR);
+    if ((nodeIndex < 0) || (nodeIndex >= ctx->myStructure.nrNodes)) return(INDEX_ERROR);
 
-    return (myNode[nodeIndex].H - myNode[nodeIndex].z);
+    return (ctx->nodeData.H[nodeIndex] - ctx->nodeData.z[nodeIndex]);
  }
 
 
@@ -670,12 +984,12 @@ namespace soilFluxes3D {
   * \param nodeIndex
   * \return result
   */
- double DLL_EXPORT __STDCALL getTotalPotential(long nodeIndex)
+ double DLL_EXPORT __STDCALL getTotalPotential(TCrit3Dcontext *ctx, long nodeIndex)
  {
-	 if (myNode == NULL) return(MEMORY_ERROR);
-	 if ((nodeIndex < 0) || (nodeIndex >= myStructure.nrNodes)) return(INDEX_ERROR);
+	 if (ctx->myNode == NULL) return(MEMORY_ERROR);
+	 if ((nodeIndex < 0) || (nodeIndex >= ctx->myStructure.nrNodes)) return(INDEX_ERROR);
 
-	 return (myNode[nodeIndex].H);
+	 return (ctx->nodeData.H[nodeIndex]);
  }
 
 
@@ -685,28 +999,28 @@ namespace soilFluxes3D {
   * \param direction
   * \return result
   */
- double DLL_EXPORT __STDCALL getWaterFlow(long n, short direction)
+ double DLL_EXPORT __STDCALL getWaterFlow(TCrit3Dcontext *ctx, long n, short direction)
  {
-    if (myNode == NULL) return MEMORY_ERROR;
-    if ((n < 0) || (n >= myStructure.nrNodes)) return INDEX_ERROR;
+    if (ctx->myNode == NULL) return MEMORY_ERROR;
+    if ((n < 0) || (n >= ctx->myStructure.nrNodes)) return INDEX_ERROR;
 
 	double maxFlow = 0.0;
 
 	switch (direction) {
         case UP:
-            if (myNode[n].up.index != NOLINK) return (myNode[n].up.sumFlow);
+            if (ctx->myNode[n].up.index != NOLINK) return (ctx->myNode[n].up.sumFlow);
             else return INDEX_ERROR;
             break;
 		case DOWN:
-            if (myNode[n].down.index != NOLINK) return (myNode[n].down.sumFlow);
+            if (ctx->myNode[n].down.index != NOLINK) return (ctx->myNode[n].down.sumFlow);
             else return INDEX_ERROR;
             break;
 		case LATERAL:
 			
-            for (short i = 0; i < myStructure.nrLateralLinks; i++)
-                if (myNode[n].lateral[i].index != NOLINK)
-                    if (fabs(myNode[n].lateral[i].sumFlow) > maxFlow)
-                        maxFlow = myNode[n].lateral[i].sumFlow;
+            for (short i = 0; i < ctx->myStructure.nrLateralLinks; i++)
+                if (ctx->myNode[n].lateral[i].index != NOLINK)
+                    if (fabs(ctx->myNode[n].lateral[i].sumFlow) > maxFlow)
+                        maxFlow = ctx->myNode[n].lateral[i].sumFlow;
             return maxFlow;
             break;
         default:
@@ -721,39 +1035,39 @@ namespace soilFluxes3D {
   * \param n
   * \return result
   */
- double DLL_EXPORT __STDCALL getSumLateralWaterFlow(long n)
+ double DLL_EXPORT __STDCALL getSumLateralWaterFlow(TCrit3Dcontext *ctx, long n)
  {
-    if (myNode == NULL) return MEMORY_ERROR;
-    if ((n < 0) || (n >= myStructure.nrNodes)) return INDEX_ERROR;
+    if (ctx->myNode == NULL) return MEMORY_ERROR;
+    if ((n < 0) || (n >= ctx->myStructure.nrNodes)) return INDEX_ERROR;
 
     double sumLateralFlow = 0.0;
-    for (short i = 0; i < myStructure.nrLateralLinks; i++)
-        if (myNode[n].lateral[i].index != NOLINK)
-			sumLateralFlow += myNode[n].lateral[i].sumFlow;
+    for (short i = 0; i < ctx->myStructure.nrLateralLinks; i++)
+        if (ctx->myNode[n].lateral[i].index != NOLINK)
+			sumLateralFlow += ctx->myNode[n].lateral[i].sumFlow;
 	return sumLateralFlow;
  }
 
 
- void DLL_EXPORT __STDCALL initializeBalance()
+ void DLL_EXPORT __STDCALL initializeBalance(TCrit3Dcontext *ctx)
 {
-    InitializeBalanceWater();
-    if (myStructure.computeHeat)
-        initializeBalanceHeat();
+    InitializeBalanceWater(ctx);
+    if (ctx->myStructure.computeHeat)
+        initializeBalanceHeat(ctx);
 }
 
- double DLL_EXPORT __STDCALL getWaterMBR()
+ double DLL_EXPORT __STDCALL getWaterMBR(TCrit3Dcontext *ctx)
  {
-    return (balanceWholePeriod.waterMBR);
+    return (ctx->balanceWholePeriod.waterMBR);
  }
 
- double DLL_EXPORT __STDCALL getHeatMBR()
+ double DLL_EXPORT __STDCALL getHeatMBR(TCrit3Dcontext *ctx)
   {
-     return (balanceWholePeriod.heatMBR);
+     return (ctx->balanceWholePeriod.heatMBR);
   }
 
- double DLL_EXPORT __STDCALL getHeatMBE()
+ double DLL_EXPORT __STDCALL getHeatMBE(TCrit3Dcontext *ctx)
   {
-     return (balanceWholePeriod.heatMBE);
+     return (ctx->balanceWholePeriod.heatMBE);
   }
 
  /*!
@@ -761,15 +1075,15 @@ namespace soilFluxes3D {
   * \param nodeIndex
   * \return result
   */
- double DLL_EXPORT __STDCALL getBoundaryWaterFlow(long nodeIndex)
+ double DLL_EXPORT __STDCALL getBoundaryWaterFlow(TCrit3Dcontext *ctx, long nodeIndex)
  {
 
-    if (myNode == NULL) return(MEMORY_ERROR);
-    if ((nodeIndex < 0) || (nodeIndex >= myStructure.nrNodes)) return(INDEX_ERROR);
+    if (ctx->myNode == NULL) return(MEMORY_ERROR);
+    if ((nodeIndex < 0) || (nodeIndex >= ctx->myStructure.nrNodes)) return(INDEX_ERROR);
 
-	if (myNode[nodeIndex].boundary == NULL) return(BOUNDARY_ERROR);
+	if (ctx->myNode[nodeIndex].boundary == NULL) return(BOUNDARY_ERROR);
 
-    return(myNode[nodeIndex].boundary->sumBoundaryWaterFlow);
+    return(ctx->myNode[nodeIndex].boundary->sumBoundaryWaterFlow);
  }
 
 
@@ -778,15 +1092,15 @@ namespace soilFluxes3D {
   * \param boundaryType
   * \return result
   */
- double DLL_EXPORT __STDCALL getBoundaryWaterSumFlow(int boundaryType)
+ double DLL_EXPORT __STDCALL getBoundaryWaterSumFlow(TCrit3Dcontext *ctx, int boundaryType)
  {
 
     double sumBoundaryFlow = 0.0;
 
-    for (long n = 0; n < myStructure.nrNodes; n++)
-        if (myNode[n].boundary != NULL)
-            if (myNode[n].boundary->type == boundaryType)
-				sumBoundaryFlow += myNode[n].boundary->sumBoundaryWaterFlow;
+    for (long n = 0; n < ctx->myStructure.nrNodes; n++)
+        if (ctx->myNode[n].boundary != NULL)
+            if (ctx->myNode[n].boundary->type == boundaryType)
+				sumBoundaryFlow += ctx->myNode[n].boundary->sumBoundaryWaterFlow;
 
 	return(sumBoundaryFlow);
  }
@@ -796,69 +1110,121 @@ namespace soilFluxes3D {
   * \brief computes a period of time [s]
   * \param myPeriod
   */
- void DLL_EXPORT __STDCALL computePeriod(double myPeriod)
+ void DLL_EXPORT __STDCALL computePeriod(TCrit3Dcontext *ctx, double myPeriod)
     {
 		double deltaT, ResidualTime, sumTime = 0.0;
 
-        balanceCurrentPeriod.sinkSourceWater = 0.;
-        balanceCurrentPeriod.sinkSourceHeat = 0.;
+        ctx->balanceCurrentPeriod.sinkSourceWater = 0.;
+        ctx->balanceCurrentPeriod.sinkSourceHeat = 0.;
+
+        if (ctx->A.rowStart == NULL)
+            if (initializeMatrix(ctx) != CRIT3D_OK) return;
+
+        /*! the state may have been changed by the setters */
+        invalidateAssembly(ctx);
 
 		while (sumTime < myPeriod)
         {
 			ResidualTime = myPeriod - sumTime;
-			deltaT = computeStep(ResidualTime);
+			deltaT = computeStep(ctx, ResidualTime);
 			sumTime += deltaT;
 
-            //qDebug() << "H0=" << myNode[0].H << "H1=" << myNode[1].H;
+            //qDebug() << "H0=" << nodeData.H[0] << "H1=" << nodeData.H[1];
             //qDebug() << "T1=" << myNode[1].extra->Heat->T << "T2=" << myNode[2].extra->Heat->T;
         }
 
-        if (myStructure.computeWater) updateBalanceWaterWholePeriod();
-        if (myStructure.computeHeat) updateBalanceHeatWholePeriod();
+        if (ctx->myStructure.computeWater) updateBalanceWaterWholePeriod(ctx);
+        if (ctx->myStructure.computeHeat) updateBalanceHeatWholePeriod(ctx);
 
     }
 
 
+ /*!
+ * \brief heat sub-cycling: integrates heat over the accepted water step dtWater
+ * with internal steps reduced by the heat Courant number; the water solution is kept
+ */
+void computeHeatSubCycles(TCrit3Dcontext *ctx, double dtWater)
+{
+    double dtHeat = dtWater;
+    double dtHeatCurrent;
+    bool isLastStep;
+
+    saveWaterFluxes(ctx, dtHeat, dtWater);
+
+    ctx->heatTimeStart = 0.;
+    while (ctx->heatTimeStart < dtWater)
+    {
+        isLastStep = (dtHeat >= dtWater - ctx->heatTimeStart);
+        dtHeatCurrent = isLastStep ? (dtWater - ctx->heatTimeStart) : dtHeat;
+
+        updateBoundaryHeat(ctx);
+
+        if (HeatComputation(ctx, dtHeatCurrent, dtWater))
+        {
+            if (isLastStep)
+                ctx->heatTimeStart = dtWater;
+            else
+                ctx->heatTimeStart += dtHeatCurrent;
+        }
+        else
+        {
+            restoreHeat(ctx);
+            dtHeat = max_value(dtHeatCurrent / ceil(ctx->CourantHeat), ctx->myParameters.delta_t_min);
+        }
+    }
+    ctx->heatTimeStart = 0.;
+}
+
+
  /*!
  * \brief computes a single step of time [s]
  * \param maxTime
  * \return result
  */
-double DLL_EXPORT __STDCALL computeStep(double maxTime)
+double DLL_EXPORT __STDCALL computeStep(TCrit3Dcontext *ctx, double maxTime)
 {
     double dtWater, dtHeat;
 
-    if (myStructure.computeHeat) initializeHeatFluxes(false, true);
-    updateBoundary();
+    /*! build the matrix pattern after topology changes */
+    if (ctx->A.rowStart == NULL) initializeMatrix(ctx);
+
+    if (ctx->myStructure.computeHeat) initializeHeatFluxes(ctx, false, true);
+    updateBoundary(ctx);
 
-    if (myStructure.computeWater)
-        computeWater(maxTime, &dtWater);
+    if (ctx->myStructure.computeWater)
+        computeWater(ctx, maxTime, &dtWater);
     else
-        dtWater = min_value(maxTime, myParameters.delta_t_max);
+        dtWater = min_value(maxTime, ctx->myParameters.delta_t_max);
 
     dtHeat = dtWater;
 
-    if (myStructure.computeHeat)
+    if (ctx->myStructure.computeHeat && ctx->myParameters.useHeatSubCycling)
+    {
+        computeHeatSubCycles(ctx, dtWater);
+        return dtWater;
+    }
+
+    if (ctx->myStructure.computeHeat)
     {
         double dtHeatCurrent = dtHeat;
 
-        saveWaterFluxes(dtHeatCurrent, dtWater);
+        saveWaterFluxes(ctx, dtHeatCurrent, dtWater);
 
         double dtHeatSum = 0;
         while (dtHeatSum < dtWater)
         {
             dtHeatCurrent = min_value(dtHeat, dtWater - dtHeatSum);
 
-            updateBoundaryHeat();
+            updateBoundaryHeat(ctx);
 
-            if (HeatComputation(dtHeatCurrent, dtWater))
+            if (HeatComputation(ctx, dtHeatCurrent, dtWater))
             {
                 dtHeatSum += dtHeat;
             }
             else
             {
-                restoreHeat();
-                dtHeat = myParameters.current_delta_t;
+                restoreHeat(ctx);
+                dtHeat = ctx->myParameters.current_delta_t;
             }
         }
     }
@@ -872,7 +1238,7 @@ double DLL_EXPORT __STDCALL computeStep(double maxTime)
  * \param myT [K]
  * \return OK/ERROR
  */
-int DLL_EXPORT __STDCALL setTemperature(long nodeIndex, double myT)
+int DLL_EXPORT __STDCALL setTemperature(TCrit3Dcontext *ctx, long nodeIndex, double myT)
 {
    //----------------------------------------------------------------------------------------------
    // Set current temperature of node
@@ -880,16 +1246,16 @@ int DLL_EXPORT __STDCALL setTemperature(long nodeIndex, double myT)
    // myT              [K] temperature
    //----------------------------------------------------------------------------------------------
 
-   if (myNode == NULL) return(MEMORY_ERROR);
+   if (ctx->myNode == NULL) return(MEMORY_ERROR);
 
-   if ((nodeIndex < 0) || (nodeIndex >= myStructure.nrNodes)) return(INDEX_ERROR);
+   if ((nodeIndex < 0) || (nodeIndex >= ctx->myStructure.nrNodes)) return(INDEX_ERROR);
 
    if ((myT < 200) && (myT > 500)) return(PARAMETER_ERROR);
 
-   if (! isHeatNode(nodeIndex)) return(MEMORY_ERROR);
+   if (! isHeatNode(ctx, nodeIndex)) return(MEMORY_ERROR);
 
-   myNode[nodeIndex].extra->Heat->T = myT;
-   myNode[nodeIndex].extra->Heat->oldT = myT;
+   ctx->myNode[nodeIndex].extra->Heat->T = myT;
+   ctx->myNode[nodeIndex].extra->Heat->oldT = myT;
 
    return(CRIT3D_OK);
 }
@@ -900,17 +1266,17 @@ int DLL_EXPORT __STDCALL setTemperature(long nodeIndex, double myT)
  * \param myT [K]
  * \return OK/ERROR
  */
-int DLL_EXPORT __STDCALL setFixedTemperature(long nodeIndex, double myT, double myDepth)
+int DLL_EXPORT __STDCALL setFixedTemperature(TCrit3Dcontext *ctx, long nodeIndex, double myT, double myDepth)
 {
-   if (myNode == NULL) return(MEMORY_ERROR);
-   if ((nodeIndex < 0) || (nodeIndex >= myStructure.nrNodes)) return(INDEX_ERROR);
-   if (myNode[nodeIndex].boundary == NULL) return(BOUNDARY_ERROR);
-   if (myNode[nodeIndex].boundary->Heat == NULL) return(BOUNDARY_ERROR);
-   if (myNode[nodeIndex].boundary->type != BOUNDARY_PRESCRIBEDTOTALPOTENTIAL &&
-           myNode[nodeIndex].boundary->type != BOUNDARY_FREEDRAINAGE) return(BOUNDARY_ERROR);
+   if (ctx->myNode == NULL) return(MEMORY_ERROR);
+   if ((nodeIndex < 0) || (nodeIndex >= ctx->myStructure.nrNodes)) return(INDEX_ERROR);
+   if (ctx->myNode[nodeIndex].boundary == NULL) return(BOUNDARY_ERROR);
+   if (ctx->myNode[nodeIndex].boundary->Heat == NULL) return(BOUNDARY_ERROR);
+   if (ctx->myNode[nodeIndex].boundary->type != BOUNDARY_PRESCRIBEDTOTALPOTENTIAL &&
+           ctx->myNode[nodeIndex].boundary->type != BOUNDARY_FREEDRAINAGE) return(BOUNDARY_ERROR);
 
-   myNode[nodeIndex].boundary->Heat->fixedTemperatureDepth = myDepth;
-   myNode[nodeIndex].boundary->Heat->fixedTemperature = myT;
+   ctx->myNode[nodeIndex].boundary->Heat->fixedTemperatureDepth = myDepth;
+   ctx->myNode[nodeIndex].boundary->Heat->fixedTemperature = myT;
 
    return(CRIT3D_OK);
 }
@@ -921,16 +1287,16 @@ int DLL_EXPORT __STDCALL setFixedTemperature(long nodeIndex, double myT, double
  * \param myWindSpeed [m s-1]
  * \return OK/ERROR
  */
-int DLL_EXPORT __STDCALL setHeatBoundaryWindSpeed(long nodeIndex, double myWindSpeed)
+int DLL_EXPORT __STDCALL setHeatBoundaryWindSpeed(TCrit3Dcontext *ctx, long nodeIndex, double myWindSpeed)
 {
-   if (myNode == NULL) return(MEMORY_ERROR);
-   if ((nodeIndex < 0) || (nodeIndex >= myStructure.nrNodes)) return(INDEX_ERROR);
+   if (ctx->myNode == NULL) return(MEMORY_ERROR);
+   if ((nodeIndex < 0) || (nodeIndex >= ctx->myStructure.nrNodes)) return(INDEX_ERROR);
    if ((myWindSpeed < 0) && (myWindSpeed > 1000)) return(PARAMETER_ERROR);
 
-   if (myNode[nodeIndex].boundary == NULL || myNode[nodeIndex].boundary->Heat == NULL)
+   if (ctx->myNode[nodeIndex].boundary == NULL || ctx->myNode[nodeIndex].boundary->Heat == NULL)
        return (BOUNDARY_ERROR);
 
-   myNode[nodeIndex].boundary->Heat->windSpeed = myWindSpeed;
+   ctx->myNode[nodeIndex].boundary->Heat->windSpeed = myWindSpeed;
 
    return(CRIT3D_OK);
 }
@@ -941,16 +1307,16 @@ int DLL_EXPORT __STDCALL setHeatBoundaryWindSpeed(long nodeIndex, double myWindS
  * \param myRoughness [m]
  * \return OK/ERROR
  */
-int DLL_EXPORT __STDCALL setHeatBoundaryRoughness(long nodeIndex, double myRoughness)
+int DLL_EXPORT __STDCALL setHeatBoundaryRoughness(TCrit3Dcontext *ctx, long nodeIndex, double myRoughness)
 {
-   if (myNode == NULL) return(MEMORY_ERROR);
-   if ((nodeIndex < 0) || (nodeIndex >= myStructure.nrNodes)) return(INDEX_ERROR);
+   if (ctx->myNode == NULL) return(MEMORY_ERROR);
+   if ((nodeIndex < 0) || (nodeIndex >= ctx->myStructure.nrNodes)) return(INDEX_ERROR);
    if (myRoughness < 0) return(PARAMETER_ERROR);
 
-   if (myNode[nodeIndex].boundary == NULL || myNode[nodeIndex].boundary->Heat == NULL)
+   if (ctx->myNode[nodeIndex].boundary == NULL || ctx->myNode[nodeIndex].boundary->Heat == NULL)
        return (BOUNDARY_ERROR);
 
-   myNode[nodeIndex].boundary->Heat->roughnessHeight = myRoughness;
+   ctx->myNode[nodeIndex].boundary->Heat->roughnessHeight = myRoughness;
 
    return(CRIT3D_OK);
 }
@@ -961,15 +1327,15 @@ int DLL_EXPORT __STDCALL setHeatBoundaryRoughness(long nodeIndex, double myRough
  * \param myHeatFlow [W]
  * \return OK/ERROR
  */
-int DLL_EXPORT __STDCALL setHeatSinkSource(long nodeIndex, double myHeatFlow)
+int DLL_EXPORT __STDCALL setHeatSinkSource(TCrit3Dcontext *ctx, long nodeIndex, double myHeatFlow)
 {
-   if (myNode == NULL)
+   if (ctx->myNode == NULL)
        return(MEMORY_ERROR);
 
-   if ((nodeIndex < 0) || (nodeIndex >= myStructure.nrNodes))
+   if ((nodeIndex < 0) || (nodeIndex >= ctx->myStructure.nrNodes))
        return(INDEX_ERROR);
 
-   myNode[nodeIndex].extra->Heat->sinkSource = myHeatFlow;
+   ctx->myNode[nodeIndex].extra->Heat->sinkSource = myHeatFlow;
 
    return(CRIT3D_OK);
 }
@@ -980,18 +1346,18 @@ int DLL_EXPORT __STDCALL setHeatSinkSource(long nodeIndex, double myHeatFlow)
  * \param myTemperature [K]
  * \return OK/ERROR
  */
-int DLL_EXPORT __STDCALL setHeatBoundaryTemperature(long nodeIndex, double myTemperature)
+int DLL_EXPORT __STDCALL setHeatBoundaryTemperature(TCrit3Dcontext *ctx, long nodeIndex, double myTemperature)
 {
-   if (myNode == NULL)
+   if (ctx->myNode == NULL)
        return(MEMORY_ERROR);
 
-   if ((nodeIndex < 0) || (nodeIndex >= myStructure.nrNodes))
+   if ((nodeIndex < 0) || (nodeIndex >= ctx->myStructure.nrNodes))
        return(INDEX_ERROR);
 
-   if (myNode[nodeIndex].boundary == NULL || myNode[nodeIndex].boundary->Heat == NULL)
+   if (ctx->myNode[nodeIndex].boundary == NULL || ctx->myNode[nodeIndex].boundary->Heat == NULL)
        return (BOUNDARY_ERROR);
 
-   myNode[nodeIndex].boundary->Heat->temperature = myTemperature;
+   ctx->myNode[nodeIndex].boundary->Heat->temperature = myTemperature;
 
    return(CRIT3D_OK);
 }
@@ -1002,18 +1368,18 @@ int DLL_EXPORT __STDCALL setHeatBoundaryTemperature(long nodeIndex, double myTem
  * \param myNetIrradiance [W m-2]
  * \return OK/ERROR
  */
-int DLL_EXPORT __STDCALL setHeatBoundaryNetIrradiance(long nodeIndex, double myNetIrradiance)
+int DLL_EXPORT __STDCALL setHeatBoundaryNetIrradiance(TCrit3Dcontext *ctx, long nodeIndex, double myNetIrradiance)
 {
-   if (myNode == NULL)
+   if (ctx->myNode == NULL)
        return(MEMORY_ERROR);
 
-   if ((nodeIndex < 0) || (nodeIndex >= myStructure.nrNodes))
+   if ((nodeIndex < 0) || (nodeIndex >= ctx->myStructure.nrNodes))
        return(INDEX_ERROR);
 
-   if (myNode[nodeIndex].boundary == NULL || myNode[nodeIndex].boundary->Heat == NULL)
+   if (ctx->myNode[nodeIndex].boundary == NULL || ctx->myNode[nodeIndex].boundary->Heat == NULL)
        return (BOUNDARY_ERROR);
 
-   myNode[nodeIndex].boundary->Heat->netIrradiance = myNetIrradiance;
+   ctx->myNode[nodeIndex].boundary->Heat->netIrradiance = myNetIrradiance;
 
    return(CRIT3D_OK);
 }
@@ -1024,18 +1390,18 @@ int DLL_EXPORT __STDCALL setHeatBoundaryNetIrradiance(long nodeIndex, double myN
  * \param myRelativeHumidity [%]
  * \return OK/ERROR
  */
-int DLL_EXPORT __STDCALL setHeatBoundaryRelativeHumidity(long nodeIndex, double myRelativeHumidity)
+int DLL_EXPORT __STDCALL setHeatBoundaryRelativeHumidity(TCrit3Dcontext *ctx, long nodeIndex, double myRelativeHumidity)
 {
-   if (myNode == NULL)
+   if (ctx->myNode == NULL)
        return(MEMORY_ERROR);
 
-   if ((nodeIndex < 0) || (nodeIndex >= myStructure.nrNodes))
+   if ((nodeIndex < 0) || (nodeIndex >= ctx->myStructure.nrNodes))
        return(INDEX_ERROR);
 
-   if (myNode[nodeIndex].boundary == NULL || myNode[nodeIndex].boundary->Heat == NULL)
+   if (ctx->myNode[nodeIndex].boundary == NULL || ctx->myNode[nodeIndex].boundary->Heat == NULL)
        return (BOUNDARY_ERROR);
 
-   myNode[nodeIndex].boundary->Heat->relativeHumidity = myRelativeHumidity;
+   ctx->myNode[nodeIndex].boundary->Heat->relativeHumidity = myRelativeHumidity;
 
    return(CRIT3D_OK);
 }
@@ -1046,15 +1412,15 @@ int DLL_EXPORT __STDCALL setHeatBoundaryRelativeHumidity(long nodeIndex, double
  * \param myHeight [m]
  * \return OK/ERROR
  */
-int DLL_EXPORT __STDCALL setHeatBoundaryHeightWind(long nodeIndex, double myHeight)
+int DLL_EXPORT __STDCALL setHeatBoundaryHeightWind(TCrit3Dcontext *ctx, long nodeIndex, double myHeight)
 {
-   if (myNode == NULL) return(MEMORY_ERROR);
-   if ((nodeIndex < 0) || (nodeIndex >= myStructure.nrNodes)) return(INDEX_ERROR);
+   if (ctx->myNode == NULL) return(MEMORY_ERROR);
+   if ((nodeIndex < 0) || (nodeIndex >= ctx->myStructure.nrNodes)) return(INDEX_ERROR);
 
-   if (myNode[nodeIndex].boundary == NULL || myNode[nodeIndex].boundary->Heat == NULL)
+   if (ctx->myNode[nodeIndex].boundary == NULL || ctx->myNode[nodeIndex].boundary->Heat == NULL)
        return (BOUNDARY_ERROR);
 
-   myNode[nodeIndex].boundary->Heat->heightWind = myHeight;
+   ctx->myNode[nodeIndex].boundary->Heat->heightWind = myHeight;
 
    return(CRIT3D_OK);
 }
@@ -1066,15 +1432,15 @@ int DLL_EXPORT __STDCALL setHeatBoundaryHeightWind(long nodeIndex, double myHeig
  * \param myHeight [m]
  * \return OK/ERROR
  */
-int DLL_EXPORT __STDCALL setHeatBoundaryHeightTemperature(long nodeIndex, double myHeight)
+int DLL_EXPORT __STDCALL setHeatBoundaryHeightTemperature(TCrit3Dcontext *ctx, long nodeIndex, double myHeight)
 {
-   if (myNode == NULL) return(MEMORY_ERROR);
-   if ((nodeIndex < 0) || (nodeIndex >= myStructure.nrNodes)) return(INDEX_ERROR);
+   if (ctx->myNode == NULL) return(MEMORY_ERROR);
+   if ((nodeIndex < 0) || (nodeIndex >= ctx->myStructure.nrNodes)) return(INDEX_ERROR);
 
-   if (myNode[nodeIndex].boundary == NULL || myNode[nodeIndex].boundary->Heat == NULL)
+   if (ctx->myNode[nodeIndex].boundary == NULL || ctx->myNode[nodeIndex].boundary->Heat == NULL)
        return (BOUNDARY_ERROR);
 
-   myNode[nodeIndex].boundary->Heat->heightTemperature = myHeight;
+   ctx->myNode[nodeIndex].boundary->Heat->heightTemperature = myHeight;
 
    return(CRIT3D_OK);
 }
@@ -1084,13 +1450,13 @@ int DLL_EXPORT __STDCALL setHeatBoundaryHeightTemperature(long nodeIndex, double
  * \param nodeIndex
  * \return temperature [K]
 */
-double DLL_EXPORT __STDCALL getTemperature(long nodeIndex)
+double DLL_EXPORT __STDCALL getTemperature(TCrit3Dcontext *ctx, long nodeIndex)
 {
-    if (myNode == NULL) return(TOPOGRAPHY_ERROR);
-    if ((nodeIndex >= myStructure.nrNodes)) return(INDEX_ERROR);
-    if (! isHeatNode(nodeIndex)) return (MEMORY_ERROR);
+    if (ctx->myNode == NULL) return(TOPOGRAPHY_ERROR);
+    if ((nodeIndex >= ctx->myStructure.nrNodes)) return(INDEX_ERROR);
+    if (! isHeatNode(ctx, nodeIndex)) return (MEMORY_ERROR);
 
-    return (myNode[nodeIndex].extra->Heat->T);
+    return (ctx->myNode[nodeIndex].extra->Heat->T);
 }
 
 /*!
@@ -1098,13 +1464,13 @@ double DLL_EXPORT __STDCALL getTemperature(long nodeIndex)
  * \param nodeIndex
  * \return conductivity [W m-1 s-1]
  */
-double DLL_EXPORT __STDCALL getHeatConductivity(long nodeIndex)
+double DLL_EXPORT __STDCALL getHeatConductivity(TCrit3Dcontext *ctx, long nodeIndex)
 {
-    if (myNode == NULL) return(TOPOGRAPHY_ERROR);
-    if ((nodeIndex >= myStructure.nrNodes)) return(INDEX_ERROR);
-    if (! isHeatNode(nodeIndex)) return (MEMORY_ERROR);
+    if (ctx->myNode == NULL) return(TOPOGRAPHY_ERROR);
+    if ((nodeIndex >= ctx->myStructure.nrNodes)) return(INDEX_ERROR);
+    if (! isHeatNode(ctx, nodeIndex)) return (MEMORY_ERROR);
 
-   return SoilHeatConductivity(nodeIndex, myNode[nodeIndex].extra->Heat->T, myNode[nodeIndex].H - myNode[nodeIndex].z);
+   return SoilHeatConductivity(ctx, nodeIndex, ctx->myNode[nodeIndex].extra->Heat->T, ctx->nodeData.H[nodeIndex] - ctx->nodeData.z[nodeIndex]);
 }
 
 /*!
@@ -1113,11 +1479,11 @@ double DLL_EXPORT __STDCALL getHeatConductivity(long nodeIndex)
  * \param myDirection
  * \return heat flux [W]
 */
-float DLL_EXPORT __STDCALL getHeatFlux(long nodeIndex, short myDirection, int fluxType)
+float DLL_EXPORT __STDCALL getHeatFlux(TCrit3Dcontext *ctx, long nodeIndex, short myDirection, int fluxType)
 {
-    if (myNode == NULL) return(TOPOGRAPHY_ERROR);
-    if ((nodeIndex >= myStructure.nrNodes)) return(INDEX_ERROR);
-    if (! isHeatNode(nodeIndex)) return (MEMORY_ERROR);
+    if (ctx->myNode == NULL) return(TOPOGRAPHY_ERROR);
+    if ((nodeIndex >= ctx->myStructure.nrNodes)) return(INDEX_ERROR);
+    if (! isHeatNode(ctx, nodeIndex)) return (MEMORY_ERROR);
 
     float myMaxFlux = 0.;
     float myFlux;
@@ -1125,17 +1491,17 @@ float DLL_EXPORT __STDCALL getHeatFlux(long nodeIndex, short myDirection, int fl
     switch (myDirection)
     {
     case UP:
-        return readHeatFlux(&(myNode[nodeIndex].up), fluxType);
+        return readHeatFlux(ctx, &(ctx->myNode[nodeIndex].up), fluxType);
         break;
 
     case DOWN:
-        return readHeatFlux(&(myNode[nodeIndex].down), fluxType);
+        return readHeatFlux(ctx, &(ctx->myNode[nodeIndex].down), fluxType);
         break;
 
     case LATERAL:
-        for (short i = 0; i < myStructure.nrLateralLinks; i++)
+        for (short i = 0; i < ctx->myStructure.nrLateralLinks; i++)
         {
-            myFlux = readHeatFlux(&(myNode[nodeIndex].lateral[i]), fluxType);
+            myFlux = readHeatFlux(ctx, &(ctx->myNode[nodeIndex].lateral[i]), fluxType);
             if (myFlux != NODATA && myFlux > fabs(myMaxFlux))
                 myMaxFlux = myFlux;
         }
@@ -1151,16 +1517,16 @@ float DLL_EXPORT __STDCALL getHeatFlux(long nodeIndex, short myDirection, int fl
  * \param nodeIndex
  * \return sensbile latent heat flux [W m-2]
 */
-double DLL_EXPORT __STDCALL getBoundarySensibleFlux(long nodeIndex)
+double DLL_EXPORT __STDCALL getBoundarySensibleFlux(TCrit3Dcontext *ctx, long nodeIndex)
 {
-    if (myNode == NULL) return (TOPOGRAPHY_ERROR);
-    if (nodeIndex >= myStructure.nrNodes) return (INDEX_ERROR);
-    if (! myStructure.computeHeat) return (MISSING_DATA_ERROR);
-    if (myNode[nodeIndex].boundary == NULL) return (INDEX_ERROR);
-    if (myNode[nodeIndex].boundary->type != BOUNDARY_HEAT_SURFACE) return (INDEX_ERROR);
+    if (ctx->myNode == NULL) return (TOPOGRAPHY_ERROR);
+    if (nodeIndex >= ctx->myStructure.nrNodes) return (INDEX_ERROR);
+    if (! ctx->myStructure.computeHeat) return (MISSING_DATA_ERROR);
+    if (ctx->myNode[nodeIndex].boundary == NULL) return (INDEX_ERROR);
+    if (ctx->myNode[nodeIndex].boundary->type != BOUNDARY_HEAT_SURFACE) return (INDEX_ERROR);
 
     // boundary sensible heat flow density
-    return (myNode[nodeIndex].boundary->Heat->sensibleFlux);
+    return (ctx->myNode[nodeIndex].boundary->Heat->sensibleFlux);
 }
 
 
@@ -1169,16 +1535,16 @@ double DLL_EXPORT __STDCALL getBoundarySensibleFlux(long nodeIndex)
  * \param nodeIndex
  * \return latent heat flux [W m-2]
 */
-double DLL_EXPORT __STDCALL getBoundaryLatentFlux(long nodeIndex)
+double DLL_EXPORT __STDCALL getBoundaryLatentFlux(TCrit3Dcontext *ctx, long nodeIndex)
 {
-    if (myNode == NULL) return (TOPOGRAPHY_ERROR);
-    if (nodeIndex >= myStructure.nrNodes) return (INDEX_ERROR);
-    if (! myStructure.computeHeat || ! myStructure.computeWater || ! myStructure.computeHeatVapor) return (MISSING_DATA_ERROR);
-    if (myNode[nodeIndex].boundary == NULL) return (INDEX_ERROR);
-    if (myNode[nodeIndex].boundary->type != BOUNDARY_HEAT_SURFACE) return (INDEX_ERROR);
+    if (ctx->myNode == NULL) return (TOPOGRAPHY_ERROR);
+    if (nodeIndex >= ctx->myStructure.nrNodes) return (INDEX_ERROR);
+    if (! ctx->myStructure.computeHeat || ! ctx->myStructure.computeWater || ! ctx->myStructure.computeHeatVapor) return (MISSING_DATA_ERROR);
+    if (ctx->myNode[nodeIndex].boundary == NULL) return (INDEX_ERROR);
+    if (ctx->myNode[nodeIndex].boundary->type != BOUNDARY_HEAT_SURFACE) return (INDEX_ERROR);
 
     // boundary latent heat flow density
-    return (myNode[nodeIndex].boundary->Heat->latentFlux);
+    return (ctx->myNode[nodeIndex].boundary->Heat->latentFlux);
 }
 
 /*!
@@ -1186,17 +1552,17 @@ double DLL_EXPORT __STDCALL getBoundaryLatentFlux(long nodeIndex)
  * \param nodeIndex
  * \return advective heat flux [W m-2]
 */
-double DLL_EXPORT __STDCALL getBoundaryAdvectiveFlux(long nodeIndex)
+double DLL_EXPORT __STDCALL getBoundaryAdvectiveFlux(TCrit3Dcontext *ctx, long nodeIndex)
 {
-    if (myNode == NULL) return (TOPOGRAPHY_ERROR);
-    if (nodeIndex >= myStructure.nrNodes) return (INDEX_ERROR);
-    if (! myStructure.computeHeat || ! myStructure.computeWater || ! myStructure.computeHeatAdvection) return (MISSING_DATA_ERROR);
-    if (myNode[nodeIndex].boundary == NULL) return (BOUNDARY_ERROR);
-    if (myNode[nodeIndex].boundary->Heat == NULL) return (BOUNDARY_ERROR);
-    if (myNode[nodeIndex].boundary->type != BOUNDARY_HEAT_SURFACE) return (BOUNDARY_ERROR);
+    if (ctx->myNode == NULL) return (TOPOGRAPHY_ERROR);
+    if (nodeIndex >= ctx->myStructure.nrNodes) return (INDEX_ERROR);
+    if (! ctx->myStructure.computeHeat || ! ctx->myStructure.computeWater || ! ctx->myStructure.computeHeatAdvection) return (MISSING_DATA_ERROR);
+    if (ctx->myNode[nodeIndex].boundary == NULL) return (BOUNDARY_ERROR);
+    if (ctx->myNode[nodeIndex].boundary->Heat == NULL) return (BOUNDARY_ERROR);
+    if (ctx->myNode[nodeIndex].boundary->type != BOUNDARY_HEAT_SURFACE) return (BOUNDARY_ERROR);
 
     // boundary advective heat flow density
-    return (myNode[nodeIndex].boundary->Heat->advectiveHeatFlux);
+    return (ctx->myNode[nodeIndex].boundary->Heat->advectiveHeatFlux);
 }
 
 /*!
@@ -1204,16 +1570,16 @@ double DLL_EXPORT __STDCALL getBoundaryAdvectiveFlux(long nodeIndex)
  * \param nodeIndex
  * \return radiative heat flux [W m-2]
 */
-double DLL_EXPORT __STDCALL getBoundaryRadiativeFlux(long nodeIndex)
+double DLL_EXPORT __STDCALL getBoundaryRadiativeFlux(TCrit3Dcontext *ctx, long nodeIndex)
 {
-    if (myNode == NULL) return (TOPOGRAPHY_ERROR);
-    if (nodeIndex >= myStructure.nrNodes) return (INDEX_ERROR);
-    if (! myStructure.computeHeat) return (MISSING_DATA_ERROR);
-    if (myNode[nodeIndex].boundary == NULL) return (INDEX_ERROR);
-    if (myNode[nodeIndex].boundary->type != BOUNDARY_HEAT_SURFACE) return (INDEX_ERROR);
+    if (ctx->myNode == NULL) return (TOPOGRAPHY_ERROR);
+    if (nodeIndex >= ctx->myStructure.nrNodes) return (INDEX_ERROR);
+    if (! ctx->myStructure.computeHeat) return (MISSING_DATA_ERROR);
+    if (ctx->myNode[nodeIndex].boundary == NULL) return (INDEX_ERROR);
+    if (ctx->myNode[nodeIndex].boundary->type != BOUNDARY_HEAT_SURFACE) return (INDEX_ERROR);
 
     // boundary net radiative heat flow density
-    return (myNode[nodeIndex].boundary->Heat->radiativeFlux);
+    return (ctx->myNode[nodeIndex].boundary->Heat->radiativeFlux);
 }
 
 /*!
@@ -1221,16 +1587,16 @@ double DLL_EXPORT __STDCALL getBoundaryRadiativeFlux(long nodeIndex)
  * \param nodeIndex
  * \return aerodynamic conductance [m s-1]
 */
-double DLL_EXPORT __STDCALL getBoundaryAerodynamicConductance(long nodeIndex)
+double DLL_EXPORT __STDCALL getBoundaryAerodynamicConductance(TCrit3Dcontext *ctx, long nodeIndex)
 {
-    if (myNode == NULL) return (TOPOGRAPHY_ERROR);
-    if (nodeIndex >= myStructure.nrNodes) return (INDEX_ERROR);
-    if (! myStructure.computeHeat) return (MISSING_DATA_ERROR);
-    if (myNode[nodeIndex].boundary == NULL) return (INDEX_ERROR);
-    if (myNode[nodeIndex].boundary->type != BOUNDARY_HEAT_SURFACE) return (INDEX_ERROR);
+    if (ctx->myNode == NULL) return (TOPOGRAPHY_ERROR);
+    if (nodeIndex >= ctx->myStructure.nrNodes) return (INDEX_ERROR);
+    if (! ctx->myStructure.computeHeat) return (MISSING_DATA_ERROR);
+    if (ctx->myNode[nodeIndex].boundary == NULL) return (INDEX_ERROR);
+    if (ctx->myNode[nodeIndex].boundary->type != BOUNDARY_HEAT_SURFACE) return (INDEX_ERROR);
 
     // boundary aerodynamic resistance
-    return (myNode[nodeIndex].boundary->Heat->aerodynamicConductance);
+    return (ctx->myNode[nodeIndex].boundary->Heat->aerodynamicConductance);
 }
 
 
@@ -1259,16 +1625,16 @@ double DLL_EXPORT getBoundaryAerodynamicConductanceOpenWater(long nodeIndex)
  * \param nodeIndex
  * \return soil conductance [m s-1]
 */
-double DLL_EXPORT __STDCALL getBoundarySoilConductance(long nodeIndex)
+double DLL_EXPORT __STDCALL getBoundarySoilConductance(TCrit3Dcontext *ctx, long nodeIndex)
 {
-    if (myNode == NULL) return (TOPOGRAPHY_ERROR);
-    if (nodeIndex >= myStructure.nrNodes) return (INDEX_ERROR);
-    if (! myStructure.computeHeat) return (MISSING_DATA_ERROR);
-    if (myNode[nodeIndex].boundary == NULL) return (INDEX_ERROR);
-    if (myNode[nodeIndex].boundary->type != BOUNDARY_HEAT_SURFACE) return (INDEX_ERROR);
+    if (ctx->myNode == NULL) return (TOPOGRAPHY_ERROR);
+    if (nodeIndex >= ctx->myStructure.nrNodes) return (INDEX_ERROR);
+    if (! ctx->myStructure.computeHeat) return (MISSING_DATA_ERROR);
+    if (ctx->myNode[nodeIndex].boundary == NULL) return (INDEX_ERROR);
+    if (ctx->myNode[nodeIndex].boundary->type != BOUNDARY_HEAT_SURFACE) return (INDEX_ERROR);
 
     // boundary soil conductance
-    return (myNode[nodeIndex].boundary->Heat->soilConductance);
+    return (ctx->myNode[nodeIndex].boundary->Heat->soilConductance);
 }
 
 /*!
@@ -1276,14 +1642,14 @@ double DLL_EXPORT __STDCALL getBoundarySoilConductance(long nodeIndex)
  * \param nodeIndex
  * \return vapor concentration [kg m-3]
 */
-double DLL_EXPORT __STDCALL getNodeVapor(long i)
+double DLL_EXPORT __STDCALL getNodeVapor(TCrit3Dcontext *ctx, long i)
 {
-    if (myNode == NULL) return(TOPOGRAPHY_ERROR);
-    if (i >= myStructure.nrNodes) return(INDEX_ERROR);
-    if (! myStructure.computeHeat || ! myStructure.computeWater || ! myStructure.computeHeatVapor) return (MISSING_DATA_ERROR);
+    if (ctx->myNode == NULL) return(TOPOGRAPHY_ERROR);
+    if (i >= ctx->myStructure.nrNodes) return(INDEX_ERROR);
+    if (! ctx->myStructure.computeHeat || ! ctx->myStructure.computeWater || ! ctx->myStructure.computeHeatVapor) return (MISSING_DATA_ERROR);
 
-    double h = myNode[i].H - myNode[i].z;
-    double T = myNode[i].extra->Heat->T;
+    double h = ctx->nodeData.H[i] - ctx->nodeData.z[i];
+    double T = ctx->myNode[i].extra->Heat->T;
 
     return VaporFromPsiTemp(h, T);
 }
@@ -1293,20 +1659,20 @@ double DLL_EXPORT __STDCALL getNodeVapor(long i)
  * \param nodeIndex
  * \return heat storage [J]
 */
-double DLL_EXPORT __STDCALL getHeat(long i, double h)
+double DLL_EXPORT __STDCALL getHeat(TCrit3Dcontext *ctx, long i, double h)
 {
-    if (myNode == NULL) return(TOPOGRAPHY_ERROR);
-    if (i >= myStructure.nrNodes) return(INDEX_ERROR);
-    if (! myStructure.computeHeat) return (MISSING_DATA_ERROR);
-    if (myNode[i].extra->Heat == NULL) return MISSING_DATA_ERROR;
-    if (myNode[i].extra->Heat->T == NODATA) return MISSING_DATA_ERROR;
+    if (ctx->myNode == NULL) return(TOPOGRAPHY_ERROR);
+    if (i >= ctx->myStructure.nrNodes) return(INDEX_ERROR);
+    if (! ctx->myStructure.computeHeat) return (MISSING_DATA_ERROR);
+    if (ctx->myNode[i].extra->Heat == NULL) return MISSING_DATA_ERROR;
+    if (ctx->myNode[i].extra->Heat->T == NODATA) return MISSING_DATA_ERROR;
 
-    double myHeat = SoilHeatCapacity(i, h, myNode[i].extra->Heat->T) * myNode[i].volume_area  * myNode[i].extra->Heat->T;
+    double myHeat = SoilHeatCapacity(ctx, i, h, ctx->myNode[i].extra->Heat->T) * ctx->nodeData.volume_area[i]  * ctx->myNode[i].extra->Heat->T;
 
-    if (myStructure.computeWater && myStructure.computeHeatVapor)
+    if (ctx->myStructure.computeWater && ctx->myStructure.computeHeatVapor)
     {
-        double thetaV = VaporThetaV(h, myNode[i].extra->Heat->T, i);
-        myHeat += thetaV * LatentHeatVaporization(myNode[i].extra->Heat->T - ZEROCELSIUS) * WATER_DENSITY * myNode[i].volume_area;
+        double thetaV = VaporThetaV(ctx, h, ctx->myNode[i].extra->Heat->T, i);
+        myHeat += thetaV * LatentHeatVaporization(ctx->myNode[i].extra->Heat->T - ZEROCELSIUS) * WATER_DENSITY * ctx->nodeData.volume_area[i];
     }
 
     return (myHeat);
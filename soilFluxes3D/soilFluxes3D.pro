@@ -15,6 +15,10 @@ TARGET = soilFluxes3D
 TEMPLATE = lib
 CONFIG += staticlib
 
+# multicolor Gauss-Seidel (parallel relaxation)
+win32-msvc*: QMAKE_CXXFLAGS += -openmp
+else: QMAKE_CXXFLAGS += -fopenmp
+
 SOURCES +=  \
     boundary.cpp \
     balance.cpp \
@@ -23,6 +27,9 @@ SOURCES +=  \
     memory.cpp \
     soilPhysics.cpp \
     soilFluxes3D.cpp \
+    defaultContext.cpp \
+    ensemble.cpp \
+    snapshot.cpp \
     heat.cpp \
     extra.cpp
 
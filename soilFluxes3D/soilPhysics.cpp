@@ -26,6 +26,7 @@
 */
 
 #include <math.h>
+#include <stdlib.h>
 #include "../mathFunctions/commonConstants.h"
 #include "../mathFunctions/physics.h"
 #include "header/types.h"
@@ -34,14 +35,20 @@
 #include "header/heat.h"
 #include "header/extra.h"
 
+#define SOILTABLE_PSI_MIN 1E-6      /*!< [m] lower bound of the soil tables */
+#define SOILTABLE_PSI_MAX 1E5       /*!< [m] upper bound of the soil tables */
+#define SOILTABLE_MIN_K 1E-20       /*!< [-] minimum tabulated K / Ksat */
+#define SOILTABLE_MIN_POINTS 16     /*!< initial points per decade */
+#define SOILTABLE_MAX_POINTS 4096   /*!< maximum points per decade */
+
      /*!
      * \brief Computes volumetric water content from current degree of saturation
      * \param myIndex
      * \return result
      */
-	double theta_from_Se (unsigned long myIndex)
+	double theta_from_Se (TCrit3Dcontext *ctx, unsigned long myIndex)
 	{
-		return ((myNode[myIndex].Se * (myNode[myIndex].Soil->Theta_s - myNode[myIndex].Soil->Theta_r)) + myNode[myIndex].Soil->Theta_r);
+		return ((ctx->nodeData.Se[myIndex] * (ctx->myNode[myIndex].Soil->Theta_s - ctx->myNode[myIndex].Soil->Theta_r)) + ctx->myNode[myIndex].Soil->Theta_r);
 	}
 
     /*!
@@ -50,9 +57,9 @@
      * \param myIndex
      * \return result
      */
-	double theta_from_Se (double Se, unsigned long myIndex)
+	double theta_from_Se (TCrit3Dcontext *ctx, double Se, unsigned long myIndex)
 	{
-		return ((Se * (myNode[myIndex].Soil->Theta_s - myNode[myIndex].Soil->Theta_r)) + myNode[myIndex].Soil->Theta_r);
+		return ((Se * (ctx->myNode[myIndex].Soil->Theta_s - ctx->myNode[myIndex].Soil->Theta_r)) + ctx->myNode[myIndex].Soil->Theta_r);
 	}
 
     /*!
@@ -61,19 +68,19 @@
      * \param index
      * \return result
      */
-    double theta_from_sign_Psi (double signPsi, unsigned long index)
+    double theta_from_sign_Psi (TCrit3Dcontext *ctx, double signPsi, unsigned long index)
 	{
-        if (myNode[index].isSurface) return 1.;
+        if (ctx->nodeData.isSurface[index]) return 1.;
 
         if (signPsi >= 0.0)
         {
             /*! saturated */
-            return myNode[index].Soil->Theta_s;
+            return ctx->myNode[index].Soil->Theta_s;
         }
 		else
         {
-            double Se = computeSefromPsi(fabs(signPsi),myNode[index].Soil);
-            return theta_from_Se(Se, index);
+            double Se = computeSefromPsi(ctx, fabs(signPsi),ctx->myNode[index].Soil);
+            return theta_from_Se(ctx, Se, index);
         }
 	}
 
@@ -84,12 +91,12 @@
      * \param theta
      * \return result
      */
-	double Se_from_theta (unsigned long myIndex, double theta)
+	double Se_from_theta (TCrit3Dcontext *ctx, unsigned long myIndex, double theta)
 	{
         /*! check range */
-		if (theta >= myNode[myIndex].Soil->Theta_s) return(1.);
-		else if (theta <= myNode[myIndex].Soil->Theta_r) return(0.);
-		else return ((theta - myNode[myIndex].Soil->Theta_r) / (myNode[myIndex].Soil->Theta_s - myNode[myIndex].Soil->Theta_r));
+		if (theta >= ctx->myNode[myIndex].Soil->Theta_s) return(1.);
+		else if (theta <= ctx->myNode[myIndex].Soil->Theta_r) return(0.);
+		else return ((theta - ctx->myNode[myIndex].Soil->Theta_r) / (ctx->myNode[myIndex].Soil->Theta_s - ctx->myNode[myIndex].Soil->Theta_r));
 	}
 
     /*!
@@ -98,11 +105,11 @@
      * \param mySoil
      * \return result Se
      */
-    double computeSefromPsi(double myPsi, Tsoil *mySoil)
+    double computeSefromPsi_exact(TCrit3Dcontext *ctx, double myPsi, Tsoil *mySoil)
 	{
 		double Se = NODATA;
 
-		if (myParameters.waterRetentionCurve == MODIFIEDVANGENUCHTEN)
+		if (ctx->myParameters.waterRetentionCurve == MODIFIEDVANGENUCHTEN)
 			if (myPsi <=  mySoil->VG_he)
 				Se = 1.;
 			else
@@ -110,25 +117,95 @@
                 Se = pow(1. + pow(mySoil->VG_alpha * myPsi, mySoil->VG_n), - mySoil->VG_m);
 				Se *= (1. / mySoil->VG_Sc);
 				}
-		else if (myParameters.waterRetentionCurve == VANGENUCHTEN)
+		else if (ctx->myParameters.waterRetentionCurve == VANGENUCHTEN)
             Se = pow(1. + pow(mySoil->VG_alpha * myPsi, mySoil->VG_n), - mySoil->VG_m);
 
 		return Se;
 	}
 
+
+    /*!
+     * \brief true if the tabulated hydraulic functions of the soil can be used
+     */
+    inline bool isSoilTableActive(TCrit3Dcontext *ctx, Tsoil *mySoil)
+    {
+        return (ctx->myParameters.useSoilTables && mySoil->table != NULL
+                && mySoil->table->waterRetentionCurve == ctx->myParameters.waterRetentionCurve);
+    }
+
+
+    /*!
+     * \brief cubic Hermite interpolation of a tabulated function of ln(psi)
+     * \param myTable
+     * \param y        tabulated values
+     * \param dy       tabulated derivatives dy/dln(psi)
+     * \param myPsi    [m] (positive)
+     * \param value    interpolated value
+     * \param derivative interpolated dy/dln(psi) (may be NULL)
+     * \return false if psi is outside the table
+     */
+    bool interpolateSoilTable(const TsoilTable *myTable, const double *y, const double *dy,
+                              double myPsi, double *value, double *derivative)
+    {
+        if (myPsi <= 0.) return false;
+
+        double x = log(myPsi);
+        if (x < myTable->logPsiMin || x > myTable->logPsiMax) return false;
+
+        double h = myTable->dLogPsi;
+        double t = (x - myTable->logPsiMin) / h;
+        long j = long(t);
+        if (j > myTable->nrPoints - 2) j = myTable->nrPoints - 2;
+        double u = t - double(j);
+        double u2 = u * u;
+        double u3 = u2 * u;
+
+        *value = (2.*u3 - 3.*u2 + 1.) * y[j] + (u3 - 2.*u2 + u) * h * dy[j]
+               + (3.*u2 - 2.*u3) * y[j+1] + (u3 - u2) * h * dy[j+1];
+
+        if (derivative != NULL)
+            *derivative = (6.*u2 - 6.*u) * (y[j] - y[j+1]) / h
+                        + (3.*u2 - 4.*u + 1.) * dy[j] + (3.*u2 - 2.*u) * dy[j+1];
+
+        return true;
+    }
+
+
+    /*!
+     * \brief Computes degree of saturation from matric potential
+     * uses the soil table if active, the Van Genutchen formulas otherwise
+     * \param myPsi
+     * \param mySoil
+     * \return result Se
+     */
+    double computeSefromPsi(TCrit3Dcontext *ctx, double myPsi, Tsoil *mySoil)
+    {
+        if (isSoilTableActive(ctx, mySoil))
+        {
+            if (ctx->myParameters.waterRetentionCurve == MODIFIEDVANGENUCHTEN && myPsi <= mySoil->VG_he)
+                return 1.;
+
+            double Se;
+            if (interpolateSoilTable(mySoil->table, mySoil->table->Se, mySoil->table->dSe, myPsi, &Se, NULL))
+                return Se;
+        }
+
+        return computeSefromPsi_exact(ctx, myPsi, mySoil);
+    }
+
     /*!
      * \brief Computes current degree of saturation
      * \param myIndex
      * \return result
      */
-    double computeSe(unsigned long myIndex)
+    double computeSe(TCrit3Dcontext *ctx, unsigned long myIndex)
     {
         /*! saturated */
-        if (myNode[myIndex].H >= myNode[myIndex].z) return 1.;
+        if (ctx->nodeData.H[myIndex] >= ctx->nodeData.z[myIndex]) return 1.;
 
-        double psi = fabs(myNode[myIndex].H - myNode[myIndex].z);   /*!< [m] */
+        double psi = fabs(ctx->nodeData.H[myIndex] - ctx->nodeData.z[myIndex]);   /*!< [m] */
 
-        return computeSefromPsi(psi, myNode[myIndex].Soil);
+        return computeSefromPsi(ctx, psi, ctx->myNode[myIndex].Soil);
     }
 
 
@@ -140,17 +217,17 @@
      * \param mySoil Tsoil pointer
      * \return result
      */
-    double computeWaterConductivity(double Se, Tsoil *mySoil)
+    double computeWaterConductivity(TCrit3Dcontext *ctx, double Se, Tsoil *mySoil)
 	{
 		if (Se >= 1.) return(mySoil->K_sat );
 
 		double myTmp = NODATA;
-		if (myParameters.waterRetentionCurve == MODIFIEDVANGENUCHTEN)
+		if (ctx->myParameters.waterRetentionCurve == MODIFIEDVANGENUCHTEN)
 		{
 			double myNumerator = 1. - pow(1. - pow(Se*mySoil->VG_Sc, 1./mySoil->VG_m), mySoil->VG_m);
 			myTmp = myNumerator / (1. - pow(1. - pow(mySoil->VG_Sc, 1./mySoil->VG_m), mySoil->VG_m));
 		}
-		else if (myParameters.waterRetentionCurve == VANGENUCHTEN)
+		else if (ctx->myParameters.waterRetentionCurve == VANGENUCHTEN)
 			myTmp = 1. - pow(1. - pow(Se, 1./mySoil->VG_m), mySoil->VG_m);
 
 		return (mySoil->K_sat * pow(Se, mySoil->Mualem_L) * pow(myTmp , 2.));
@@ -168,17 +245,17 @@
      * \param Mualem_L
      * \return result
      */
-    double compute_K_Mualem(double Ksat, double Se, double VG_Sc, double, double VG_m, double Mualem_L)
+    double compute_K_Mualem(TCrit3Dcontext *ctx, double Ksat, double Se, double VG_Sc, double, double VG_m, double Mualem_L)
 	{
 		if (Se >= 1.) return(Ksat);
 		double temp= NODATA;
 
-		if (myParameters.waterRetentionCurve == MODIFIEDVANGENUCHTEN)
+		if (ctx->myParameters.waterRetentionCurve == MODIFIEDVANGENUCHTEN)
         {
             double num = 1. - pow(1. - pow(Se*VG_Sc, 1./VG_m), VG_m);
             temp = num / (1. - pow(1. - pow(VG_Sc, 1./VG_m), VG_m));
         }
-		else if (myParameters.waterRetentionCurve == VANGENUCHTEN)
+		else if (ctx->myParameters.waterRetentionCurve == VANGENUCHTEN)
         {
 			temp = 1. - pow(1. - pow(Se, 1./VG_m), VG_m);
         }
@@ -192,17 +269,26 @@
      * \param myIndex
      * \return result
      */
-    double computeK(unsigned long myIndex)
+    double computeK(TCrit3Dcontext *ctx, unsigned long myIndex)
     {
-        double k = compute_K_Mualem(myNode[myIndex].Soil->K_sat, myNode[myIndex].Se,
-                                myNode[myIndex].Soil->VG_Sc, myNode[myIndex].Soil->VG_n,
-                                myNode[myIndex].Soil->VG_m, myNode[myIndex].Soil->Mualem_L);
+        Tsoil *mySoil = ctx->myNode[myIndex].Soil;
+        double k, logK;
+
+        if (ctx->nodeData.Se[myIndex] >= 1.)
+            k = mySoil->K_sat;
+        else if (isSoilTableActive(ctx, mySoil)
+                 && interpolateSoilTable(mySoil->table, mySoil->table->logK, mySoil->table->dLogK,
+                                         ctx->nodeData.z[myIndex] - ctx->nodeData.H[myIndex], &logK, NULL))
+            k = exp(logK);
+        else
+            k = compute_K_Mualem(ctx, mySoil->K_sat, ctx->nodeData.Se[myIndex], mySoil->VG_Sc,
+                                 mySoil->VG_n, mySoil->VG_m, mySoil->Mualem_L);
 
         // vapor isothermal flow
-        if (myStructure.computeHeat && myStructure.computeHeatVapor)
+        if (ctx->myStructure.computeHeat && ctx->myStructure.computeHeatVapor)
         {
-            double avgT = getTMean(myIndex);
-            double kv = IsothermalVaporConductivity(myIndex, myNode[myIndex].H - myNode[myIndex].z, avgT);
+            double avgT = getTMean(ctx, myIndex);
+            double kv = IsothermalVaporConductivity(ctx, myIndex, ctx->nodeData.H[myIndex] - ctx->nodeData.z[myIndex], avgT);
             // from kg s m-3 to m s-1
             kv *= (GRAVITY / WATER_DENSITY);
 
@@ -218,17 +304,17 @@
      * \param myIndex
      * \return result
      */
-    double psi_from_Se(unsigned long myIndex)
+    double psi_from_Se(TCrit3Dcontext *ctx, unsigned long myIndex)
 	{
-		double m = myNode[myIndex].Soil->VG_m;
+		double m = ctx->myNode[myIndex].Soil->VG_m;
 		double temp = NODATA;
 
-		if (myParameters.waterRetentionCurve == MODIFIEDVANGENUCHTEN)
-				temp = pow(1./ (myNode[myIndex].Se * myNode[myIndex].Soil->VG_Sc) , 1./ m ) - 1.;
-        else if (myParameters.waterRetentionCurve == VANGENUCHTEN)
-				temp = pow(1./ myNode[myIndex].Se, 1./ m ) - 1.;
+		if (ctx->myParameters.waterRetentionCurve == MODIFIEDVANGENUCHTEN)
+				temp = pow(1./ (ctx->nodeData.Se[myIndex] * ctx->myNode[myIndex].Soil->VG_Sc) , 1./ m ) - 1.;
+        else if (ctx->myParameters.waterRetentionCurve == VANGENUCHTEN)
+				temp = pow(1./ ctx->nodeData.Se[myIndex], 1./ m ) - 1.;
 
-        return((1./ myNode[myIndex].Soil->VG_alpha) * pow(temp, 1./ myNode[myIndex].Soil->VG_n));
+        return((1./ ctx->myNode[myIndex].Soil->VG_alpha) * pow(temp, 1./ ctx->myNode[myIndex].Soil->VG_n));
 	}
 
     /*!
@@ -236,15 +322,15 @@
      * \param myIndex
      * \return derivative of vapor volumetric content with respect to H
      */
-    double dThetav_dH(unsigned long i, double temperature, double dTheta_dH)
+    double dThetav_dH(TCrit3Dcontext *ctx, unsigned long i, double temperature, double dTheta_dH)
     {
-        double h = myNode[i].H - myNode[i].z;
+        double h = ctx->nodeData.H[i] - ctx->nodeData.z[i];
         double hr = SoilRelativeHumidity(h, temperature);
         double satVapPressure = SaturationVaporPressure(temperature - ZEROCELSIUS);
         double satVapConc = VaporConcentrationFromPressure(satVapPressure, temperature);
-        double theta = theta_from_sign_Psi(h, i);
+        double theta = theta_from_sign_Psi(ctx, h, i);
         double dThetav_dPsi = (satVapConc * hr / WATER_DENSITY) *
-                ((myNode[i].Soil->Theta_s - theta) * MH2O / (R_GAS * temperature) - dTheta_dH / GRAVITY);
+                ((ctx->myNode[i].Soil->Theta_s - theta) * MH2O / (R_GAS * temperature) - dTheta_dH / GRAVITY);
         return dThetav_dPsi * GRAVITY;
     }
 
@@ -255,79 +341,237 @@
      * \param myIndex
      * \return derivative of water volumetric content with respect to H
      */
-	double dTheta_dH(unsigned long myIndex)
+	double dTheta_dH(TCrit3Dcontext *ctx, unsigned long myIndex)
 	 {
-     double alfa = myNode[myIndex].Soil->VG_alpha;
-	 double n    = myNode[myIndex].Soil->VG_n;
-	 double m    = myNode[myIndex].Soil->VG_m;
+     double alfa = ctx->myNode[myIndex].Soil->VG_alpha;
+	 double n    = ctx->myNode[myIndex].Soil->VG_n;
+	 double m    = ctx->myNode[myIndex].Soil->VG_m;
 	 double dSe_dH;
 
-     double psi = fabs(min_value(myNode[myIndex].H - myNode[myIndex].z, 0.));
-     double psiPrevious = fabs(min_value(myNode[myIndex].oldH - myNode[myIndex].z, 0.));
+     double psi = fabs(min_value(ctx->nodeData.H[myIndex] - ctx->nodeData.z[myIndex], 0.));
+     double psiPrevious = fabs(min_value(ctx->nodeData.oldH[myIndex] - ctx->nodeData.z[myIndex], 0.));
 
-	if (myParameters.waterRetentionCurve == MODIFIEDVANGENUCHTEN)
-		{ if ((psi <= myNode[myIndex].Soil->VG_he) && (psiPrevious <= myNode[myIndex].Soil->VG_he)) return 0.;}
-	else if (myParameters.waterRetentionCurve == VANGENUCHTEN)
+	if (ctx->myParameters.waterRetentionCurve == MODIFIEDVANGENUCHTEN)
+		{ if ((psi <= ctx->myNode[myIndex].Soil->VG_he) && (psiPrevious <= ctx->myNode[myIndex].Soil->VG_he)) return 0.;}
+	else if (ctx->myParameters.waterRetentionCurve == VANGENUCHTEN)
 		{ if ((psi == 0.) && (psiPrevious == 0.)) return 0.;}
 
 	 if (psi == psiPrevious)
 			{
+            double Se, dSe_dLogPsi;
+            if (isSoilTableActive(ctx, ctx->myNode[myIndex].Soil)
+                && interpolateSoilTable(ctx->myNode[myIndex].Soil->table, ctx->myNode[myIndex].Soil->table->Se,
+                                        ctx->myNode[myIndex].Soil->table->dSe, psi, &Se, &dSe_dLogPsi))
+                return (-dSe_dLogPsi / psi) * (ctx->myNode[myIndex].Soil->Theta_s - ctx->myNode[myIndex].Soil->Theta_r);
+
 			dSe_dH = alfa * n * m * pow(1. + pow(alfa * psi, n), -(m + 1.)) * pow(alfa * psi, n - 1.);
-			if (myParameters.waterRetentionCurve == MODIFIEDVANGENUCHTEN)
-					dSe_dH *= (1. / myNode[myIndex].Soil->VG_Sc);
+			if (ctx->myParameters.waterRetentionCurve == MODIFIEDVANGENUCHTEN)
+					dSe_dH *= (1. / ctx->myNode[myIndex].Soil->VG_Sc);
 			}
 	 else
 			{
-            double theta = computeSefromPsi(psi, myNode[myIndex].Soil);
-            double thetaPrevious = computeSefromPsi(psiPrevious, myNode[myIndex].Soil);
-			double delta_H = myNode[myIndex].H - myNode[myIndex].oldH;
+            double theta = computeSefromPsi(ctx, psi, ctx->myNode[myIndex].Soil);
+            double thetaPrevious = computeSefromPsi(ctx, psiPrevious, ctx->myNode[myIndex].Soil);
+			double delta_H = ctx->nodeData.H[myIndex] - ctx->nodeData.oldH[myIndex];
 			dSe_dH = fabs((theta - thetaPrevious) / delta_H);
 			}
 
-	 return (dSe_dH * (myNode[myIndex].Soil->Theta_s - myNode[myIndex].Soil->Theta_r));
+	 return (dSe_dH * (ctx->myNode[myIndex].Soil->Theta_s - ctx->myNode[myIndex].Soil->Theta_r));
 	 }
 
-    double getThetaMean(long i)
+    /*!
+     * \brief monotone slopes (Fritsch-Carlson) of a function tabulated on a regular grid
+     * \param y        values
+     * \param dy       [output] derivatives
+     * \param n        number of points (>= 2)
+     * \param h        grid step
+     */
+    void computeMonotoneSlopes(const double *y, double *dy, long n, double h)
+    {
+        long j;
+        double delta, deltaLeft, alpha, beta, sum, tau;
+
+        dy[0] = (y[1] - y[0]) / h;
+        dy[n-1] = (y[n-1] - y[n-2]) / h;
+        for (j = 1; j < n-1; j++)
+        {
+            deltaLeft = (y[j] - y[j-1]) / h;
+            delta = (y[j+1] - y[j]) / h;
+            if (deltaLeft * delta <= 0.)
+                dy[j] = 0.;
+            else
+                dy[j] = 0.5 * (deltaLeft + delta);
+        }
+
+        /*! limit the slopes to preserve monotonicity */
+        for (j = 0; j < n-1; j++)
+        {
+            delta = (y[j+1] - y[j]) / h;
+            if (delta == 0.)
+            {
+                dy[j] = 0.;
+                dy[j+1] = 0.;
+            }
+            else
+            {
+                alpha = dy[j] / delta;
+                beta = dy[j+1] / delta;
+                sum = alpha*alpha + beta*beta;
+                if (sum > 9.)
+                {
+                    tau = 3. / sqrt(sum);
+                    dy[j] = tau * alpha * delta;
+                    dy[j+1] = tau * beta * delta;
+                }
+            }
+        }
+    }
+
+
+    void cleanSoilTable(Tsoil *mySoil)
+    {
+        if (mySoil->table == NULL) return;
+
+        free(mySoil->table->Se);
+        free(mySoil->table->dSe);
+        free(mySoil->table->logK);
+        free(mySoil->table->dLogK);
+        free(mySoil->table);
+        mySoil->table = NULL;
+    }
+
+
+    /*!
+     * \brief [ln m/sec] tabulated water conductivity, bounded below by SOILTABLE_MIN_K * Ksat
+     */
+    double soilTableLogK(TCrit3Dcontext *ctx, double Se, Tsoil *mySoil)
+    {
+        double k = compute_K_Mualem(ctx, mySoil->K_sat, Se, mySoil->VG_Sc, mySoil->VG_n, mySoil->VG_m, mySoil->Mualem_L);
+        return log(max_value(k, SOILTABLE_MIN_K * mySoil->K_sat));
+    }
+
+
+    /*!
+     * \brief builds the tables of Se(psi) and K(psi) of a soil horizon for the current water retention curve.
+     * The grid (log-spaced in psi) is refined until the interpolation error, checked between the grid points,
+     * is below tolerance: absolute on Se, relative on K (only above SOILTABLE_MIN_K * Ksat).
+     * \param mySoil
+     * \param tolerance
+     * \return false if the accuracy is not reached (the exact formulas will be used)
+     */
+    bool buildSoilTable(TCrit3Dcontext *ctx, Tsoil *mySoil, double tolerance)
+    {
+        cleanSoilTable(mySoil);
+
+        if (mySoil->VG_alpha <= 0. || mySoil->K_sat <= 0. || tolerance <= 0.) return false;
+
+        double psiMin = SOILTABLE_PSI_MIN;
+        if (ctx->myParameters.waterRetentionCurve == MODIFIEDVANGENUCHTEN)
+            psiMin = max_value(psiMin, mySoil->VG_he);
+        double psiMax = SOILTABLE_PSI_MAX;
+        if (psiMin >= psiMax) return false;
+
+        double logPsiMin = log(psiMin);
+        double logPsiMax = log(psiMax);
+        double nrDecades = log10(psiMax / psiMin);
+        double minK = SOILTABLE_MIN_K * mySoil->K_sat;
+
+        TsoilTable *myTable = (TsoilTable *) calloc(1, sizeof(TsoilTable));
+        if (myTable == NULL) return false;
+        myTable->waterRetentionCurve = ctx->myParameters.waterRetentionCurve;
+        myTable->logPsiMin = logPsiMin;
+        myTable->logPsiMax = logPsiMax;
+        mySoil->table = myTable;
+
+        for (int pointsPerDecade = SOILTABLE_MIN_POINTS; pointsPerDecade <= SOILTABLE_MAX_POINTS; pointsPerDecade *= 2)
+        {
+            long n = long(ceil(nrDecades * pointsPerDecade)) + 1;
+            double h = (logPsiMax - logPsiMin) / double(n - 1);
+
+            myTable->nrPoints = n;
+            myTable->dLogPsi = h;
+            myTable->Se = (double *) realloc(myTable->Se, n * sizeof(double));
+            myTable->dSe = (double *) realloc(myTable->dSe, n * sizeof(double));
+            myTable->logK = (double *) realloc(myTable->logK, n * sizeof(double));
+            myTable->dLogK = (double *) realloc(myTable->dLogK, n * sizeof(double));
+            if (myTable->Se == NULL || myTable->dSe == NULL || myTable->logK == NULL || myTable->dLogK == NULL)
+                break;
+
+            for (long j = 0; j < n; j++)
+            {
+                double psi = exp(logPsiMin + j * h);
+                myTable->Se[j] = computeSefromPsi_exact(ctx, psi, mySoil);
+                myTable->logK[j] = soilTableLogK(ctx, myTable->Se[j], mySoil);
+            }
+            computeMonotoneSlopes(myTable->Se, myTable->dSe, n, h);
+            computeMonotoneSlopes(myTable->logK, myTable->dLogK, n, h);
+
+            /*! check accuracy between grid points */
+            bool isAccurate = true;
+            for (long j = 0; j < n-1 && isAccurate; j++)
+                for (int q = 1; q <= 3 && isAccurate; q++)
+                {
+                    double psi = exp(logPsiMin + (j + 0.25 * q) * h);
+                    double Se, logK;
+                    interpolateSoilTable(myTable, myTable->Se, myTable->dSe, psi, &Se, NULL);
+                    interpolateSoilTable(myTable, myTable->logK, myTable->dLogK, psi, &logK, NULL);
+
+                    double exactSe = computeSefromPsi_exact(ctx, psi, mySoil);
+                    double exactK = exp(soilTableLogK(ctx, exactSe, mySoil));
+                    if (fabs(Se - exactSe) > tolerance
+                        || fabs(exp(logK) - exactK) > tolerance * max_value(exactK, minK))
+                        isAccurate = false;
+                }
+
+            if (isAccurate) return true;
+        }
+
+        cleanSoilTable(mySoil);
+        return false;
+    }
+
+
+    double getThetaMean(TCrit3Dcontext *ctx, long i)
 	{
-        double myHMean = getHMean(i);
+        double myHMean = getHMean(ctx, i);
 
-		if (myNode[i].isSurface)
+		if (ctx->nodeData.isSurface[i])
 		{
-            double mySurfaceWater = max_value(myHMean - myNode[i].z, 0.);		//[m]
+            double mySurfaceWater = max_value(myHMean - ctx->nodeData.z[i], 0.);		//[m]
             return (min_value(mySurfaceWater / 0.01, 1.));
 		}
 		else
 		{
             /*! sub-surface */
-            return (getTheta(i, myHMean));
+            return (getTheta(ctx, i, myHMean));
 		}
 	}
 
-    double getTheta(long i, double H)
+    double getTheta(TCrit3Dcontext *ctx, long i, double H)
     {
-        double psi = H - myNode[i].z;
-        return (theta_from_sign_Psi(psi, i));
+        double psi = H - ctx->nodeData.z[i];
+        return (theta_from_sign_Psi(ctx, psi, i));
     }
 
-    double getTMean(long i)
+    double getTMean(TCrit3Dcontext *ctx, long i)
     {
-        if (myStructure.computeHeat && myNode[i].extra->Heat != NULL)
-            return arithmeticMean(myNode[i].extra->Heat->oldT, myNode[i].extra->Heat->T);
+        if (ctx->myStructure.computeHeat && ctx->myNode[i].extra->Heat != NULL)
+            return arithmeticMean(ctx->myNode[i].extra->Heat->oldT, ctx->myNode[i].extra->Heat->T);
         else
             return NODATA;
     }
 
-    double getHMean(long i)
+    double getHMean(TCrit3Dcontext *ctx, long i)
     {
         // is there any efficient way to compute a geometric mean of H?
-        return arithmeticMean(myNode[i].oldH, myNode[i].H);
+        return arithmeticMean(ctx->nodeData.oldH[i], ctx->nodeData.H[i]);
     }
 
-    double getPsiMean(long i)
+    double getPsiMean(TCrit3Dcontext *ctx, long i)
 	{
         double Psi;
-        double meanH = getHMean(i);
-        Psi = min_value(0., (meanH - myNode[i].z));
+        double meanH = getHMean(ctx, i);
+        Psi = min_value(0., (meanH - ctx->nodeData.z[i]));
         return Psi;
 	}
 
@@ -350,17 +594,17 @@
      * \param i
      * \return bulk density (Mg m-3)
      */
-    double estimateBulkDensity(long i)
+    double estimateBulkDensity(TCrit3Dcontext *ctx, long i)
     {
         double particleDensity;
         double totalPorosity;
 
-        particleDensity = ParticleDensity(myNode[i].Soil->organicMatter);
+        particleDensity = ParticleDensity(ctx->myNode[i].Soil->organicMatter);
 
-        totalPorosity = myNode[i].Soil->Theta_s;
+        totalPorosity = ctx->myNode[i].Soil->Theta_s;
 
         // very small pores not water fillable
-        if (myNode[i].Soil->clay > 40)
+        if (ctx->myNode[i].Soil->clay > 40)
             totalPorosity *= 1.03;
         else
             totalPorosity *= 1.05;
@@ -33,17 +33,17 @@
 #include "header/types.h"
 #include "header/solver.h"
 
-double distance(unsigned long i, unsigned long j)
+double distance(TCrit3Dcontext *ctx, unsigned long i, unsigned long j)
 {
-    return (sqrt(square(fabs(myNode[i].x - myNode[j].x))
-        + square(fabs(myNode[i].y - myNode[j].y))
-        + square(fabs(myNode[i].z - myNode[j].z))));
+    return (sqrt(square(fabs(ctx->nodeData.x[i] - ctx->nodeData.x[j]))
+        + square(fabs(ctx->nodeData.y[i] - ctx->nodeData.y[j]))
+        + square(fabs(ctx->nodeData.z[i] - ctx->nodeData.z[j]))));
 }
 
 
-double distance2D(unsigned long i, unsigned long j)
+double distance2D(TCrit3Dcontext *ctx, unsigned long i, unsigned long j)
 {
-    return (sqrt(square(fabs(myNode[i].x - myNode[j].x)) + square(fabs(myNode[i].y - myNode[j].y))));
+    return (sqrt(square(fabs(ctx->nodeData.x[i] - ctx->nodeData.x[j])) + square(fabs(ctx->nodeData.y[i] - ctx->nodeData.y[j]))));
 }
 
 double arithmeticMean(double v1, double v2)
@@ -64,11 +64,11 @@ double geometricMean(double v1, double v2)
     return sign(v1)*sqrt(v1 * v2);
 }
 
-double computeMean(double v1, double v2)
+double computeMean(TCrit3Dcontext *ctx, double v1, double v2)
 {
-    if (myParameters.meanType == MEAN_LOGARITHMIC)
+    if (ctx->myParameters.meanType == MEAN_LOGARITHMIC)
         return(logarithmicMean(v1, v2));
-    else if (myParameters.meanType == MEAN_GEOMETRIC)
+    else if (ctx->myParameters.meanType == MEAN_GEOMETRIC)
         return(geometricMean(v1, v2));
     else
         //default: logarithmic
@@ -76,128 +76,313 @@ double computeMean(double v1, double v2)
 }
 
 
-TlinkedNode* getLink(long i, long j)
+TlinkedNode* getLink(TCrit3Dcontext *ctx, long i, long j)
 {
-    if (myNode[i].up.index == j) return &(myNode[i].up);
+    if (ctx->myNode[i].up.index == j) return &(ctx->myNode[i].up);
 
-    if (myNode[i].down.index == j) return &(myNode[i].down);
+    if (ctx->myNode[i].down.index == j) return &(ctx->myNode[i].down);
 
-    for (short l = 0; l < myStructure.nrLateralLinks; l++)
-         if (myNode[i].lateral[l].index == j) return &(myNode[i].lateral[l]);
+    for (short l = 0; l < ctx->myStructure.nrLateralLinks; l++)
+         if (ctx->myNode[i].lateral[l].index == j) return &(ctx->myNode[i].lateral[l]);
 
     return(NULL);
 }
 
 
-int calcola_iterazioni_max(int num_approssimazione)
+int calcola_iterazioni_max(TCrit3Dcontext *ctx, int num_approssimazione)
 {
- float max_iterazioni = (float)myParameters.iterazioni_max / (float)myParameters.maxApproximationsNumber * (float)(num_approssimazione + 1);
+ float max_iterazioni = (float)ctx->myParameters.iterazioni_max / (float)ctx->myParameters.maxApproximationsNumber * (float)(num_approssimazione + 1);
  return(max_value(20, int(max_iterazioni)));
 }
 
 
-double GaussSeidelIterationWater(int direction)
+void cleanNodeColors(TCrit3Dcontext *ctx)
+{
+    /*! shared with the topology context */
+    if (ctx->topology != NULL)
+    {
+        ctx->colorNodeList = NULL;
+        ctx->colorFirstIndex = NULL;
+    }
+    if (ctx->colorNodeList != NULL) { free(ctx->colorNodeList); ctx->colorNodeList = NULL; }
+    if (ctx->colorFirstIndex != NULL) { free(ctx->colorFirstIndex); ctx->colorFirstIndex = NULL; }
+    ctx->nrColors = 0;
+}
+
+
+inline void forbidLinkColor(TlinkedNode *link, short *nodeColor, unsigned long long *forbidden, unsigned long long *mask, short color)
+{
+    if (link->index == NOLINK) return;
+
+    /*! already colored neighbour */
+    if (nodeColor[link->index] != NODATA) *mask |= (1ULL << nodeColor[link->index]);
+
+    /*! the neighbour will not take this color (links may be not symmetric) */
+    if (color != NODATA) forbidden[link->index] |= (1ULL << color);
+}
+
+
+/*!
+ * \brief greedy coloring of the node graph (up, down and lateral links)
+ * \return true if nodes are colored, false if the graph needs more than 64 colors
+ */
+bool computeNodeColors(TCrit3Dcontext *ctx)
+{
+    const short MAX_COLORS = 64;
+
+    /*! ensemble members use the colors of their topology */
+    if (ctx->topology != NULL) return false;
+
+    long i, n;
+    short l, color;
+    unsigned long long mask;
+
+    cleanNodeColors(ctx);
+    if (ctx->myNode == NULL) return false;
+
+    short *nodeColor = (short *) malloc(ctx->myStructure.nrNodes * sizeof(short));
+    unsigned long long *forbidden = (unsigned long long *) calloc(ctx->myStructure.nrNodes, sizeof(unsigned long long));
+    for (i = 0; i < ctx->myStructure.nrNodes; i++) nodeColor[i] = NODATA;
+
+    for (i = 0; i < ctx->myStructure.nrNodes; i++)
+    {
+        /*! colors of the neighbours */
+        mask = forbidden[i];
+        forbidLinkColor(&(ctx->myNode[i].up), nodeColor, forbidden, &mask, NODATA);
+        forbidLinkColor(&(ctx->myNode[i].down), nodeColor, forbidden, &mask, NODATA);
+        for (l = 0; l < ctx->myStructure.nrLateralLinks; l++)
+            forbidLinkColor(&(ctx->myNode[i].lateral[l]), nodeColor, forbidden, &mask, NODATA);
+
+        /*! first free color */
+        color = 0;
+        while ((color < MAX_COLORS) && (mask & (1ULL << color))) color++;
+        if (color == MAX_COLORS)
+        {
+            free(nodeColor);
+            free(forbidden);
+            return false;
+        }
+
+        nodeColor[i] = color;
+        ctx->nrColors = max_value(ctx->nrColors, color + 1);
+
+        forbidLinkColor(&(ctx->myNode[i].up), nodeColor, forbidden, &mask, color);
+        forbidLinkColor(&(ctx->myNode[i].down), nodeColor, forbidden, &mask, color);
+        for (l = 0; l < ctx->myStructure.nrLateralLinks; l++)
+            forbidLinkColor(&(ctx->myNode[i].lateral[l]), nodeColor, forbidden, &mask, color);
+    }
+
+    /*! counting sort of the nodes by color (ascending index inside each color) */
+    ctx->colorFirstIndex = (long *) calloc(ctx->nrColors + 1, sizeof(long));
+    ctx->colorNodeList = (long *) malloc(ctx->myStructure.nrNodes * sizeof(long));
+
+    for (i = 0; i < ctx->myStructure.nrNodes; i++) ctx->colorFirstIndex[nodeColor[i] + 1]++;
+    for (color = 0; color < ctx->nrColors; color++) ctx->colorFirstIndex[color + 1] += ctx->colorFirstIndex[color];
+
+    long *position = (long *) malloc(ctx->nrColors * sizeof(long));
+    for (color = 0; color < ctx->nrColors; color++) position[color] = ctx->colorFirstIndex[color];
+    for (i = 0; i < ctx->myStructure.nrNodes; i++)
+    {
+        n = position[nodeColor[i]]++;
+        ctx->colorNodeList[n] = i;
+    }
+
+    free(position);
+    free(nodeColor);
+    free(forbidden);
+    return true;
+}
+
+
+/*!
+ * \brief updates X[i] (water)
+ * \return norm of the change
+ */
+inline double GaussSeidelNodeWater(TCrit3Dcontext *ctx, long i)
+{
+    double psi, norm;
+    double newX = ctx->b[i];
+    for (long k = ctx->A.rowStart[i] + 1; k < ctx->A.rowStart[i+1]; k++)
+        newX -= ctx->A.val[k] * ctx->X[ctx->A.column[k]];
+
+    /*! surface check */
+    if (ctx->nodeData.isSurface[i])
+        if (newX < ctx->nodeData.z[i])
+            newX = ctx->nodeData.z[i];
+
+    /*! water potential [m] */
+    psi = fabs(newX - ctx->nodeData.z[i]);
+
+    /*! infinity norm (normalized if psi > 1m) */
+    if (psi > 1.0)
+        norm = (fabs(newX - ctx->X[i])) / psi;
+    else
+        norm = fabs(newX - ctx->X[i]);
+
+    ctx->X[i] = newX;
+    return(norm);
+}
+
+
+/*!
+ * \brief updates X[i] (heat): surface nodes and empty rows are skipped
+ * \return absolute change
+ */
+inline double GaussSeidelNodeHeat(TCrit3Dcontext *ctx, long i)
+{
+    if (ctx->nodeData.isSurface[i] || ctx->A.val[ctx->A.rowStart[i]] == 0.) return(0.);
+
+    double new_x = ctx->b[i];
+    for (long k = ctx->A.rowStart[i] + 1; k < ctx->A.rowStart[i+1]; k++)
+        new_x -= ctx->A.val[k] * ctx->X[ctx->A.column[k]];
+
+    double delta = fabs(new_x - ctx->X[i]);
+    ctx->X[i] = new_x;
+    return(delta);
+}
+
+
+double GaussSeidelIterationWater(TCrit3Dcontext *ctx, int direction)
  {
-    double psi = 0.0, newX = 0.0;
     double norm = 0.0, infinityNorm = 0.0;
-    short j;
     long i, firstIndex, lastIndex;
 
     if (direction == UP)
     {
         firstIndex = 0;
-        lastIndex = myStructure.nrNodes;
+        lastIndex = ctx->myStructure.nrNodes;
     }
     else
     {
-        firstIndex = myStructure.nrNodes -1;
+        firstIndex = ctx->myStructure.nrNodes -1;
         lastIndex = -1;
     }
 
     i = firstIndex;
     while (i != lastIndex)
     {
-        newX = b[i];
-        j = 1;
-        while ((A[i][j].index != NOLINK) && (j < myStructure.maxNrColumns))
-        {
-            newX -= A[i][j].val * X[A[i][j].index];
-            j++;
-        }
-
-        /*! surface check */
-        if (myNode[i].isSurface)
-            if (newX < myNode[i].z)
-                newX = myNode[i].z;
-
-        /*! water potential [m] */
-        psi = fabs(newX - myNode[i].z);
-
-        /*! infinity norm (normalized if psi > 1m) */
-        if (psi > 1.0)
-            norm = (fabs(newX - X[i])) / psi;
-        else
-            norm = fabs(newX - X[i]);
-
+        norm = GaussSeidelNodeWater(ctx, i);
         if (norm > infinityNorm) infinityNorm = norm;
 
-        X[i] = newX;
-
         (direction == UP)? i++ : i--;
     }
     return(infinityNorm);
  }
 
-double GaussSeidelIterationHeat()
+double GaussSeidelIterationHeat(TCrit3Dcontext *ctx)
+{
+    double delta, norma_inf = 0.;
+
+    for (long i = 1; i < ctx->myStructure.nrNodes; i++)
+    {
+        delta = GaussSeidelNodeHeat(ctx, i);
+        if (delta > norma_inf) norma_inf = delta;
+    }
+
+    return(norma_inf);
+ }
+
+
+/*!
+ * \brief multicolor Gauss-Seidel iteration: colors are swept in sequence
+ * (reversed order if direction == DOWN), nodes of each color in parallel
+ * \return infinity norm
+ */
+double GaussSeidelIterationColored(TCrit3Dcontext *ctx, int myProcess, int direction)
 {
-    double delta, new_x, norma_inf = 0.;
-    short j;
+    double infinityNorm = 0.;
 
-    for (long i = 1; i < myStructure.nrNodes; i++)
-        if (!myNode[i].isSurface)
+    #pragma omp parallel num_threads(ctx->myParameters.nrThreads)
+    {
+        double norm, threadNorm = 0.;
+        long first, last, n, i;
+        int color;
+
+        for (int k = 0; k < ctx->nrColors; k++)
         {
-            if (A[i][0].val != 0.)
+            color = (direction == DOWN)? (ctx->nrColors - 1 - k) : k;
+            first = ctx->colorFirstIndex[color];
+            last = ctx->colorFirstIndex[color + 1];
+
+            #pragma omp for schedule(static)
+            for (n = first; n < last; n++)
             {
-                j = 1;
-                new_x = b[i];
-                while ((A[i][j].index != NOLINK) && (j < myStructure.maxNrColumns))
-                {
-                    new_x -= A[i][j].val * X[A[i][j].index];
-                    j++;
-                }
-
-                delta = fabs(new_x - X[i]);
-                if (delta > norma_inf) norma_inf = delta;
-                X[i] = new_x;
+                i = ctx->colorNodeList[n];
+                if (myProcess == PROCESS_WATER)
+                    norm = GaussSeidelNodeWater(ctx, i);
+                else if (i > 0)
+                    norm = GaussSeidelNodeHeat(ctx, i);
+                else
+                    norm = 0.;
+
+                if (norm > threadNorm) threadNorm = norm;
             }
         }
 
-    return(norma_inf);
- }
+        #pragma omp critical
+        {
+            if (threadNorm > infinityNorm) infinityNorm = threadNorm;
+        }
+    }
+
+    return(infinityNorm);
+}
+
+
+TsolverStatistics* getSolverStatistics(TCrit3Dcontext *ctx, int process)
+{
+    if (process == PROCESS_HEAT)
+        return &ctx->heatSolverStatistics;
+    else
+        return &ctx->waterSolverStatistics;
+}
+
 
-bool GaussSeidelRelaxation (int approximation, double residualTolerance, int process)
+void updateSolverStatistics(TCrit3Dcontext *ctx, int process, int nrIterations, double residual)
+{
+    TsolverStatistics* statistics = getSolverStatistics(ctx, process);
+    statistics->nrIterations += nrIterations;
+    statistics->lastIterations = nrIterations;
+    statistics->lastResidual = residual;
+}
+
+
+bool GaussSeidelRelaxation (TCrit3Dcontext *ctx, int approximation, double residualTolerance, int process)
 {
     const double MAX_NORM = 1.0;
     double norm = MAX_NORM;
     double bestNorm = MAX_NORM;
     int iteration = 0;
 
-    int maxIterationsNr = calcola_iterazioni_max(approximation);
+    int maxIterationsNr = calcola_iterazioni_max(ctx, approximation);
+
+    bool isColored = false;
+    if (ctx->myParameters.nrThreads > 1)
+        isColored = (ctx->nrColors > 0 || computeNodeColors(ctx));
 
     while ((norm > residualTolerance) && (iteration < maxIterationsNr))
 	{
         if (process == PROCESS_HEAT)
-            norm = GaussSeidelIterationHeat();
+        {
+            if (isColored)
+                norm = GaussSeidelIterationColored(ctx, PROCESS_HEAT, UP);
+            else
+                norm = GaussSeidelIterationHeat(ctx);
+        }
 
         else if (process == PROCESS_WATER)
         {
-            if (iteration%2 == 0)
-                norm = GaussSeidelIterationWater(DOWN);
+            int direction = (iteration%2 == 0)? DOWN : UP;
+            if (isColored)
+                norm = GaussSeidelIterationColored(ctx, PROCESS_WATER, direction);
             else
-                norm = GaussSeidelIterationWater(UP);
+                norm = GaussSeidelIterationWater(ctx, direction);
 
             if (norm > (bestNorm * 10.0))
+            {
+                updateSolverStatistics(ctx, process, iteration + 1, norm);
                 return(false);                    //not converging
+            }
             else if (norm < bestNorm)
                 bestNorm = norm;
         }
@@ -205,5 +390,321 @@ bool GaussSeidelRelaxation (int approximation, double residualTolerance, int pro
         iteration++;
 	}
 
+    updateSolverStatistics(ctx, process, iteration, norm);
 	return(true);
 }
+
+
+void cleanKrylovArrays(TCrit3Dcontext *ctx)
+{
+    if (ctx->krylov.r != NULL) { free(ctx->krylov.r); ctx->krylov.r = NULL; }
+    if (ctx->krylov.r0 != NULL) { free(ctx->krylov.r0); ctx->krylov.r0 = NULL; }
+    if (ctx->krylov.p != NULL) { free(ctx->krylov.p); ctx->krylov.p = NULL; }
+    if (ctx->krylov.v != NULL) { free(ctx->krylov.v); ctx->krylov.v = NULL; }
+    if (ctx->krylov.s != NULL) { free(ctx->krylov.s); ctx->krylov.s = NULL; }
+    if (ctx->krylov.t != NULL) { free(ctx->krylov.t); ctx->krylov.t = NULL; }
+    if (ctx->krylov.x0 != NULL) { free(ctx->krylov.x0); ctx->krylov.x0 = NULL; }
+    ctx->krylov.size = 0;
+}
+
+
+bool initializeKrylovArrays(TCrit3Dcontext *ctx)
+{
+    if (ctx->krylov.size == ctx->myStructure.nrNodes) return true;
+
+    cleanKrylovArrays(ctx);
+    ctx->krylov.r = (double *) calloc(ctx->myStructure.nrNodes, sizeof(double));
+    ctx->krylov.r0 = (double *) calloc(ctx->myStructure.nrNodes, sizeof(double));
+    ctx->krylov.p = (double *) calloc(ctx->myStructure.nrNodes, sizeof(double));
+    ctx->krylov.v = (double *) calloc(ctx->myStructure.nrNodes, sizeof(double));
+    ctx->krylov.s = (double *) calloc(ctx->myStructure.nrNodes, sizeof(double));
+    ctx->krylov.t = (double *) calloc(ctx->myStructure.nrNodes, sizeof(double));
+    ctx->krylov.x0 = (double *) calloc(ctx->myStructure.nrNodes, sizeof(double));
+
+    if (ctx->krylov.r == NULL || ctx->krylov.r0 == NULL || ctx->krylov.p == NULL || ctx->krylov.v == NULL
+        || ctx->krylov.s == NULL || ctx->krylov.t == NULL || ctx->krylov.x0 == NULL)
+    {
+        cleanKrylovArrays(ctx);
+        return false;
+    }
+
+    ctx->krylov.size = ctx->myStructure.nrNodes;
+    return true;
+}
+
+
+/*!
+ * \brief rows of the system: heat skips node 0, surface nodes and empty rows (as GaussSeidelIterationHeat)
+ */
+inline bool isActiveRow(TCrit3Dcontext *ctx, long i, int process)
+{
+    if (process == PROCESS_WATER) return true;
+    return (i > 0 && ! ctx->nodeData.isSurface[i] && ctx->A.val[ctx->A.rowStart[i]] != 0.);
+}
+
+
+/*!
+ * \brief y = A x
+ * A is the preconditioned matrix (unit diagonal) if isScaled, the original one otherwise.
+ * Inactive rows are identity rows.
+ */
+void matrixProduct(TCrit3Dcontext *ctx, double *x, double *y, int process, bool isScaled)
+{
+    long i;
+
+    #pragma omp parallel for num_threads(ctx->myParameters.nrThreads) schedule(static)
+    for (i = 0; i < ctx->myStructure.nrNodes; i++)
+    {
+        if (! isActiveRow(ctx, i, process))
+        {
+            y[i] = x[i];
+            continue;
+        }
+
+        double sum = x[i];
+        for (long k = ctx->A.rowStart[i] + 1; k < ctx->A.rowStart[i+1]; k++)
+            sum += ctx->A.val[k] * x[ctx->A.column[k]];
+
+        y[i] = isScaled ? sum : sum * ctx->A.val[ctx->A.rowStart[i]];
+    }
+}
+
+
+double dotProduct(TCrit3Dcontext *ctx, double *x, double *y)
+{
+    double sum = 0.;
+    long i;
+
+    #pragma omp parallel for num_threads(ctx->myParameters.nrThreads) reduction(+:sum) schedule(static)
+    for (i = 0; i < ctx->myStructure.nrNodes; i++)
+        sum += x[i] * y[i];
+
+    return sum;
+}
+
+
+/*!
+ * \brief infinity norm of the residual r, scaled by the diagonal if ! isScaled
+ */
+double residualNorm(TCrit3Dcontext *ctx, double *r, int process, bool isScaled)
+{
+    double norm = 0.;
+    for (long i = 0; i < ctx->myStructure.nrNodes; i++)
+        if (isActiveRow(ctx, i, process))
+        {
+            double value = isScaled ? fabs(r[i]) : fabs(r[i] / ctx->A.val[ctx->A.rowStart[i]]);
+            if (value > norm) norm = value;
+        }
+    return norm;
+}
+
+
+/*!
+ * \brief BiCGStab on the Jacobi preconditioned system (X is the initial guess)
+ * \return nr of iterations, NO_CONVERGENCE on breakdown
+ */
+int BiCGStab(TCrit3Dcontext *ctx, double tolerance, int maxIterations, int process, double *residual)
+{
+    const double EPSILON = 1e-300;
+    double rho = 1., rhoPrevious = 1., alpha = 1., omega = 1., beta;
+    double *r = ctx->krylov.r, *r0 = ctx->krylov.r0, *p = ctx->krylov.p;
+    double *v = ctx->krylov.v, *s = ctx->krylov.s, *t = ctx->krylov.t;
+    long i;
+
+    /*! r = b - A x (identity rows: b = x) */
+    matrixProduct(ctx, ctx->X, r, process, true);
+    for (i = 0; i < ctx->myStructure.nrNodes; i++)
+    {
+        r[i] = isActiveRow(ctx, i, process) ? (ctx->b[i] - r[i]) : 0.;
+        r0[i] = r[i];
+        p[i] = 0.;
+        v[i] = 0.;
+    }
+
+    *residual = residualNorm(ctx, r, process, true);
+    if (*residual <= tolerance) return 0;
+
+    for (int iteration = 1; iteration <= maxIterations; iteration++)
+    {
+        rho = dotProduct(ctx, r0, r);
+        if (fabs(rho) < EPSILON) return NO_CONVERGENCE;
+
+        if (iteration == 1)
+            for (i = 0; i < ctx->myStructure.nrNodes; i++) p[i] = r[i];
+        else
+        {
+            beta = (rho / rhoPrevious) * (alpha / omega);
+            for (i = 0; i < ctx->myStructure.nrNodes; i++)
+                p[i] = r[i] + beta * (p[i] - omega * v[i]);
+        }
+
+        matrixProduct(ctx, p, v, process, true);
+        double r0v = dotProduct(ctx, r0, v);
+        if (fabs(r0v) < EPSILON) return NO_CONVERGENCE;
+        alpha = rho / r0v;
+
+        for (i = 0; i < ctx->myStructure.nrNodes; i++)
+            s[i] = r[i] - alpha * v[i];
+
+        *residual = residualNorm(ctx, s, process, true);
+        if (*residual <= tolerance)
+        {
+            for (i = 0; i < ctx->myStructure.nrNodes; i++)
+                ctx->X[i] += alpha * p[i];
+            return iteration;
+        }
+
+        matrixProduct(ctx, s, t, process, true);
+        double tt = dotProduct(ctx, t, t);
+        if (tt < EPSILON) return NO_CONVERGENCE;
+        omega = dotProduct(ctx, t, s) / tt;
+        if (fabs(omega) < EPSILON) return NO_CONVERGENCE;
+
+        for (i = 0; i < ctx->myStructure.nrNodes; i++)
+        {
+            ctx->X[i] += alpha * p[i] + omega * s[i];
+            r[i] = s[i] - omega * t[i];
+        }
+
+        *residual = residualNorm(ctx, r, process, true);
+        if (*residual <= tolerance) return iteration;
+
+        rhoPrevious = rho;
+    }
+
+    return maxIterations;
+}
+
+
+/*!
+ * \brief Jacobi preconditioned conjugate gradient on the original (symmetric) system
+ * \return nr of iterations, NO_CONVERGENCE on breakdown
+ */
+int conjugateGradient(TCrit3Dcontext *ctx, double tolerance, int maxIterations, int process, double *residual)
+{
+    const double EPSILON = 1e-300;
+    double *r = ctx->krylov.r, *z = ctx->krylov.s, *p = ctx->krylov.p, *q = ctx->krylov.v;
+    double rz, rzPrevious, alpha, beta, pq;
+    long i;
+
+    /*! r = A (b - x) for active rows, zero for the other ones */
+    matrixProduct(ctx, ctx->X, r, process, false);
+    for (i = 0; i < ctx->myStructure.nrNodes; i++)
+    {
+        if (isActiveRow(ctx, i, process))
+        {
+            r[i] = ctx->b[i] * ctx->A.val[ctx->A.rowStart[i]] - r[i];
+            z[i] = r[i] / ctx->A.val[ctx->A.rowStart[i]];
+        }
+        else
+        {
+            r[i] = 0.;
+            z[i] = 0.;
+        }
+        p[i] = z[i];
+    }
+
+    *residual = residualNorm(ctx, r, process, false);
+    if (*residual <= tolerance) return 0;
+
+    rz = dotProduct(ctx, r, z);
+
+    for (int iteration = 1; iteration <= maxIterations; iteration++)
+    {
+        matrixProduct(ctx, p, q, process, false);
+        for (i = 0; i < ctx->myStructure.nrNodes; i++)
+            if (! isActiveRow(ctx, i, process)) q[i] = 0.;
+
+        pq = dotProduct(ctx, p, q);
+        if (pq <= EPSILON) return NO_CONVERGENCE;       // not positive definite
+        alpha = rz / pq;
+
+        for (i = 0; i < ctx->myStructure.nrNodes; i++)
+        {
+            ctx->X[i] += alpha * p[i];
+            r[i] -= alpha * q[i];
+            z[i] = isActiveRow(ctx, i, process) ? r[i] / ctx->A.val[ctx->A.rowStart[i]] : 0.;
+        }
+
+        *residual = residualNorm(ctx, r, process, false);
+        if (*residual <= tolerance) return iteration;
+
+        rzPrevious = rz;
+        rz = dotProduct(ctx, r, z);
+        beta = rz / rzPrevious;
+
+        for (i = 0; i < ctx->myStructure.nrNodes; i++)
+            p[i] = z[i] + beta * p[i];
+    }
+
+    return maxIterations;
+}
+
+
+/*!
+ * \brief solves the current system A X = b with the method selected for the process.
+ * Krylov methods are followed by Gauss-Seidel relaxation, that applies the surface
+ * constraint (water) and completes the solution if the Krylov method is not converged
+ * \return false if the solution is not converging
+ */
+bool solveLinearSystem(TCrit3Dcontext *ctx, int approximation, double residualTolerance, int process)
+{
+    int method = (process == PROCESS_HEAT)? ctx->myParameters.heatSolutionMethod : ctx->myParameters.waterSolutionMethod;
+    TsolverStatistics* statistics = getSolverStatistics(ctx, process);
+    statistics->nrSystems++;
+
+    if (method == RELAXATION || ! initializeKrylovArrays(ctx))
+        return GaussSeidelRelaxation(ctx, approximation, residualTolerance, process);
+
+    int maxIterationsNr = calcola_iterazioni_max(ctx, approximation);
+    double residual, initialResidual;
+    int nrIterations;
+    long i;
+
+    for (i = 0; i < ctx->myStructure.nrNodes; i++)
+        ctx->krylov.x0[i] = ctx->X[i];
+
+    /*! initial residual (scaled system) */
+    matrixProduct(ctx, ctx->X, ctx->krylov.r, process, true);
+    for (i = 0; i < ctx->myStructure.nrNodes; i++)
+        ctx->krylov.r[i] = isActiveRow(ctx, i, process) ? (ctx->b[i] - ctx->krylov.r[i]) : 0.;
+    initialResidual = residualNorm(ctx, ctx->krylov.r, process, true);
+
+    if (method == CONJUGATE_GRADIENT)
+        nrIterations = conjugateGradient(ctx, residualTolerance, maxIterationsNr, process, &residual);
+    else
+        nrIterations = BiCGStab(ctx, residualTolerance, maxIterationsNr, process, &residual);
+
+    bool isConverged = (nrIterations != NO_CONVERGENCE && residual <= residualTolerance);
+
+    /*! breakdown or divergence: restart from the initial guess */
+    if (nrIterations == NO_CONVERGENCE || residual > initialResidual)
+    {
+        for (i = 0; i < ctx->myStructure.nrNodes; i++)
+            ctx->X[i] = ctx->krylov.x0[i];
+        nrIterations = 0;
+        isConverged = false;
+    }
+
+    if (process == PROCESS_WATER)
+    {
+        /*! surface constraint */
+        for (i = 0; i < ctx->myStructure.nrNodes; i++)
+            if (ctx->nodeData.isSurface[i] && ctx->X[i] < ctx->nodeData.z[i])
+            {
+                ctx->X[i] = ctx->nodeData.z[i];
+                isConverged = false;
+            }
+    }
+
+    if (isConverged)
+    {
+        updateSolverStatistics(ctx, process, nrIterations, residual);
+        return true;
+    }
+
+    bool isOk = GaussSeidelRelaxation(ctx, approximation, residualTolerance, process);
+    statistics->nrIterations += nrIterations;
+    statistics->lastIterations += nrIterations;
+    return isOk;
+}
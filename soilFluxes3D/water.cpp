@@ -48,12 +48,12 @@
  * \param deltaT
  * \return result
  */
-double getWaterExchange(long i, TlinkedNode *link, double deltaT)
+double getWaterExchange(TCrit3Dcontext *ctx, long i, TlinkedNode *link, double deltaT)
 {
 	if (link != NULL)
         {
-		double matrixValue = getMatrixValue(i, link);
-		double flow = matrixValue * (myNode[i].H - myNode[link->index].H) * deltaT;
+		double matrixValue = getMatrixValue(ctx, i, link);
+		double flow = matrixValue * (ctx->nodeData.H[i] - ctx->nodeData.H[link->index]) * deltaT;
         return (flow);
         }
 	else
@@ -72,70 +72,70 @@ double getWaterExchange(long i, TlinkedNode *link, double deltaT)
  * \param approximationNr
  * \return result
  */
-double runoff(long i, long j, TlinkedNode *link, double deltaT, unsigned long approximationNr)
+double runoff(TCrit3Dcontext *ctx, long i, long j, TlinkedNode *link, double deltaT, unsigned long approximationNr)
 {
     double Hi, Hj;
     double const EPSILON_mm = 0.0001;
 
     if (approximationNr == 0)
     {
-        double flux_i = (myNode[i].Qw * deltaT) / myNode[i].volume_area;
-        double flux_j = (myNode[j].Qw * deltaT) / myNode[j].volume_area;
-        Hi = myNode[i].oldH + flux_i;
-        Hj = myNode[j].oldH + flux_j;
+        double flux_i = (ctx->nodeData.Qw[i] * deltaT) / ctx->nodeData.volume_area[i];
+        double flux_j = (ctx->nodeData.Qw[j] * deltaT) / ctx->nodeData.volume_area[j];
+        Hi = ctx->nodeData.oldH[i] + flux_i;
+        Hj = ctx->nodeData.oldH[j] + flux_j;
     }
     else
     {
 		
-		Hi = myNode[i].H;
-		Hj = myNode[j].H;
+		Hi = ctx->nodeData.H[i];
+		Hj = ctx->nodeData.H[j];
 		/*
-		Hi = (myNode[i].H + myNode[i].oldH) / 2.0;
-        Hj = (myNode[j].H + myNode[j].oldH) / 2.0;
+		Hi = (nodeData.H[i] + nodeData.oldH[i]) / 2.0;
+        Hj = (nodeData.H[j] + nodeData.oldH[j]) / 2.0;
 		*/
     }
 
 
     double H = max_value(Hi, Hj);
-    double z = max_value(myNode[i].z + myNode[i].Soil->Pond, myNode[j].z + myNode[j].Soil->Pond);
+    double z = max_value(ctx->nodeData.z[i] + ctx->myNode[i].Soil->Pond, ctx->nodeData.z[j] + ctx->myNode[j].Soil->Pond);
     double Hs = H - z;
     if (Hs <= 0.) return(0.);
 
     double dH = fabs(Hi - Hj);
-    double cellDistance = distance2D(i,j);
+    double cellDistance = distance2D(ctx, i,j);
     if ((dH/cellDistance) < EPSILON_mm) return(0.);
 
-    double roughness = (myNode[i].Soil->Roughness + myNode[j].Soil->Roughness) / 2.;
+    double roughness = (ctx->myNode[i].Soil->Roughness + ctx->myNode[j].Soil->Roughness) / 2.;
 
     //Manning
     double v = pow(Hs, 2.0/3.0) * sqrt(dH/cellDistance) / roughness;
     double flowArea = link->area * Hs;
 
-    Courant = max_value(Courant, v * deltaT / cellDistance);
+    ctx->Courant = max_value(ctx->Courant, v * deltaT / cellDistance);
     return (v * flowArea) / dH;
 }
 
 
 
-double infiltration(long sup, long inf, TlinkedNode *link, double deltaT)
+double infiltration(TCrit3Dcontext *ctx, long sup, long inf, TlinkedNode *link, double deltaT)
 {
- double cellDistance = (myNode[sup].z - myNode[inf].z) * 2.0;
+ double cellDistance = (ctx->nodeData.z[sup] - ctx->nodeData.z[inf]) * 2.0;
 
  /*! unsaturated */
- if (myNode[inf].H < myNode[sup].z)
+ if (ctx->nodeData.H[inf] < ctx->nodeData.z[sup])
         {
         /*! surface water content [m] */
-        // double surfaceH = (myNode[sup].H + myNode[sup].oldH) * 0.5;
-		double surfaceH = myNode[sup].H;
+        // double surfaceH = (nodeData.H[sup] + nodeData.oldH[sup]) * 0.5;
+		double surfaceH = ctx->nodeData.H[sup];
 
         /*! maximum water infiltration rate [m/s] */
-        double maxInfiltrationRate = (surfaceH - myNode[sup].z) / deltaT;
+        double maxInfiltrationRate = (surfaceH - ctx->nodeData.z[sup]) / deltaT;
         if (maxInfiltrationRate <= 0.0) return(0.0);
 
         /*! first soil layer: mean between current k and k_sat */
-        double meanK = computeMean(myNode[inf].k, myNode[inf].Soil->K_sat);
+        double meanK = computeMean(ctx, ctx->nodeData.k[inf], ctx->myNode[inf].Soil->K_sat);
 
-        double dH = myNode[sup].H - myNode[inf].H;
+        double dH = ctx->nodeData.H[sup] - ctx->nodeData.H[inf];
         double maxK = maxInfiltrationRate * (cellDistance / dH);
 
         double k = min_value(meanK , maxK);
@@ -146,116 +146,212 @@ double infiltration(long sup, long inf, TlinkedNode *link, double deltaT)
  /*! saturated */
  else
     {
-        return(myNode[inf].Soil->K_sat * link->area) / cellDistance;
+        return(ctx->myNode[inf].Soil->K_sat * link->area) / cellDistance;
     }
 
 }
 
 
-double redistribution(long i, TlinkedNode *link, int linkType)
+double redistribution(TCrit3Dcontext *ctx, long i, TlinkedNode *link, int linkType)
 {
     double cellDistance;
-    double k1 = myNode[i].k;
-    double k2 = myNode[(*link).index].k;
+    double k1 = ctx->nodeData.k[i];
+    double k2 = ctx->nodeData.k[(*link).index];
 
     /*! horizontal */
     if (linkType == LATERAL)
     {
-        cellDistance = distance(i, (*link).index);
-        k1 *= myParameters.k_lateral_vertical_ratio;
-        k2 *= myParameters.k_lateral_vertical_ratio;
+        cellDistance = distance(ctx, i, (*link).index);
+        k1 *= ctx->myParameters.k_lateral_vertical_ratio;
+        k2 *= ctx->myParameters.k_lateral_vertical_ratio;
     }
     else
     {
-        cellDistance = fabs(myNode[i].z - myNode[(*link).index].z);
+        cellDistance = fabs(ctx->nodeData.z[i] - ctx->nodeData.z[(*link).index]);
     }
-    double k = computeMean(k1, k2);
+    double k = computeMean(ctx, k1, k2);
 
     return (k * link->area) / cellDistance;
 }
 
 
 
-bool computeFlux(long i, int matrixIndex, TlinkedNode *link, double deltaT, unsigned long myApprox, int linkType)
+bool computeFlux(TCrit3Dcontext *ctx, long i, long matrixIndex, TlinkedNode *link, double deltaT, unsigned long myApprox, int linkType)
 {
 	if ((*link).index == NOLINK) return (false);
 
     double val;
     long j = (*link).index;
 
-    if (myNode[i].isSurface)
+    if (ctx->nodeData.isSurface[i])
     {
-        if (myNode[j].isSurface)
-            val = runoff(i, j, link, deltaT, myApprox);
+        if (ctx->nodeData.isSurface[j])
+            val = runoff(ctx, i, j, link, deltaT, myApprox);
         else
-            val = infiltration(i, j, link, deltaT);
+            val = infiltration(ctx, i, j, link, deltaT);
     }
     else
     {
-        if (myNode[j].isSurface)
-            val = infiltration(j, i, link, deltaT);
+        if (ctx->nodeData.isSurface[j])
+            val = infiltration(ctx, j, i, link, deltaT);
         else
-            val = redistribution(i, link, linkType);
+            val = redistribution(ctx, i, link, linkType);
     }
 
-    A[i][matrixIndex].index = j;
-    A[i][matrixIndex].val = val;
+    ctx->A.val[matrixIndex] = val;
 
-    if (myStructure.computeHeat &&
-        ! myNode[i].isSurface && ! myNode[j].isSurface)
+    if (ctx->myStructure.computeHeat &&
+        ! ctx->nodeData.isSurface[i] && ! ctx->nodeData.isSurface[j])
     {
-        if (myStructure.computeHeatVapor)
+        if (ctx->myStructure.computeHeatVapor)
         {
             double vaporThermal;
-            vaporThermal = ThermalVaporFlux(i, link, PROCESS_WATER, NODATA, NODATA) / WATER_DENSITY;
-            invariantFlux[i] += vaporThermal;
+            vaporThermal = ThermalVaporFlux(ctx, i, link, PROCESS_WATER, NODATA, NODATA) / WATER_DENSITY;
+            ctx->invariantFlux[i] += vaporThermal;
         }
 
         double liquidThermal;
-        liquidThermal = ThermalLiquidFlux(i, link, PROCESS_WATER, NODATA, NODATA);
-        invariantFlux[i] += liquidThermal;
+        liquidThermal = ThermalLiquidFlux(ctx, i, link, PROCESS_WATER, NODATA, NODATA);
+        ctx->invariantFlux[i] += liquidThermal;
     }
 
     return (true);
 }
 
 
-bool waterFlowComputation(double deltaT)
+void cleanAssemblyArrays(TCrit3Dcontext *ctx)
+{
+    if (ctx->assembly.H != NULL) { free(ctx->assembly.H); ctx->assembly.H = NULL; }
+    if (ctx->assembly.oldH != NULL) { free(ctx->assembly.oldH); ctx->assembly.oldH = NULL; }
+    if (ctx->assembly.conductance != NULL) { free(ctx->assembly.conductance); ctx->assembly.conductance = NULL; }
+    if (ctx->assembly.isChanged != NULL) { free(ctx->assembly.isChanged); ctx->assembly.isChanged = NULL; }
+    ctx->assembly.nrNodes = 0;
+    ctx->assembly.nrElements = 0;
+    ctx->assembly.isValid = false;
+}
+
+
+/*!
+ * \brief the next assembly recomputes all the nodes and links
+ * (soil, hydraulic properties or topology changed)
+ */
+void invalidateAssembly(TCrit3Dcontext *ctx)
+{
+    ctx->assembly.isValid = false;
+}
+
+
+bool initializeAssemblyArrays(TCrit3Dcontext *ctx)
+{
+    if (ctx->assembly.nrNodes == ctx->myStructure.nrNodes && ctx->assembly.nrElements == ctx->A.nrElements)
+        return true;
+
+    cleanAssemblyArrays(ctx);
+    ctx->assembly.H = (double *) calloc(ctx->myStructure.nrNodes, sizeof(double));
+    ctx->assembly.oldH = (double *) calloc(ctx->myStructure.nrNodes, sizeof(double));
+    ctx->assembly.conductance = (double *) calloc(ctx->A.nrElements, sizeof(double));
+    ctx->assembly.isChanged = (bool *) calloc(ctx->myStructure.nrNodes, sizeof(bool));
+
+    if (ctx->assembly.H == NULL || ctx->assembly.oldH == NULL
+        || ctx->assembly.conductance == NULL || ctx->assembly.isChanged == NULL)
+    {
+        cleanAssemblyArrays(ctx);
+        return false;
+    }
+
+    ctx->assembly.nrNodes = ctx->myStructure.nrNodes;
+    ctx->assembly.nrElements = ctx->A.nrElements;
+    return true;
+}
+
+
+/*!
+ * \brief incremental assembly: k and C of node i have to be recomputed
+ * if H or oldH moved more than the tolerance since their last evaluation
+ */
+inline bool isNodeToBeComputed(TCrit3Dcontext *ctx, long i)
+{
+    if (! ctx->assembly.isValid) return true;
+
+    double tolerance = ctx->myParameters.incrementalAssemblyTolerance;
+    return (fabs(ctx->nodeData.H[i] - ctx->assembly.H[i]) > tolerance
+            || fabs(ctx->nodeData.oldH[i] - ctx->assembly.oldH[i]) > tolerance);
+}
+
+
+/*!
+ * \brief computes the matrix element of a link; in incremental assembly the conductance
+ * between two subsurface nodes depends only on their k and is reused if both are unchanged
+ * (surface links depend on deltaT and on the approximation: they are always computed)
+ */
+inline bool assembleLink(TCrit3Dcontext *ctx, long i, long matrixIndex, TlinkedNode *link, double deltaT,
+                         unsigned long myApprox, int linkType, bool isIncremental)
+{
+    if (! isIncremental)
+        return computeFlux(ctx, i, matrixIndex, link, deltaT, myApprox, linkType);
+
+    long j = (*link).index;
+    if (j == NOLINK) return false;
+
+    if (ctx->assembly.isValid && ! ctx->nodeData.isSurface[i] && ! ctx->nodeData.isSurface[j]
+        && ! ctx->assembly.isChanged[i] && ! ctx->assembly.isChanged[j])
+    {
+        ctx->A.val[matrixIndex] = ctx->assembly.conductance[matrixIndex];
+        return true;
+    }
+
+    computeFlux(ctx, i, matrixIndex, link, deltaT, myApprox, linkType);
+    ctx->assembly.conductance[matrixIndex] = ctx->A.val[matrixIndex];
+    return true;
+}
+
+
+bool waterFlowComputation(TCrit3Dcontext *ctx, double deltaT)
  {
      bool isValidStep;
      long i = 0;
-     short j = 0;
+     long k, first, last;
      double dThetadH, dthetavdh;
      double avgTemperature;
 
+     /*! incremental assembly: not with heat (k, C and the thermal fluxes depend on temperature) */
+     bool isIncremental = ctx->myParameters.useIncrementalAssembly && ! ctx->myStructure.computeHeat
+                          && initializeAssemblyArrays(ctx);
+
      int approximationNr = 0;
      do
      {
-        Courant = 0.0;
-        if (approximationNr == 0)
+        ctx->Courant = 0.0;
+
+        /*! hydraulic conductivity and theta derivative */
+        for (i = 0; i < ctx->myStructure.nrNodes; i++)
         {
-            for (i = 0; i < myStructure.nrNodes; i++)
+            ctx->invariantFlux[i] = 0.;
+            if (isIncremental && !ctx->nodeData.isSurface[i])
             {
-                A[i][0].index = i;
+                ctx->assembly.isChanged[i] = isNodeToBeComputed(ctx, i);
+                if (! ctx->assembly.isChanged[i])
+                {
+                    ctx->assembly.nrNodesReused++;
+                    continue;
+                }
+                ctx->assembly.H[i] = ctx->nodeData.H[i];
+                ctx->assembly.oldH[i] = ctx->nodeData.oldH[i];
+                ctx->assembly.nrNodesComputed++;
             }
-        }
 
-        /*! hydraulic conductivity and theta derivative */
-        for (i = 0; i < myStructure.nrNodes; i++)
-        {
-            invariantFlux[i] = 0.;
-            if (!myNode[i].isSurface)
+            if (!ctx->nodeData.isSurface[i])
             {
-                 myNode[i].k = computeK(i);
-                 dThetadH = dTheta_dH(i);
-                 C[i] = myNode[i].volume_area  * dThetadH;
+                 ctx->nodeData.k[i] = computeK(ctx, i);
+                 dThetadH = dTheta_dH(ctx, i);
+                 ctx->C[i] = ctx->nodeData.volume_area[i]  * dThetadH;
 
                  // vapor capacity term
-                 if (myStructure.computeHeat && myStructure.computeHeatVapor)
+                 if (ctx->myStructure.computeHeat && ctx->myStructure.computeHeatVapor)
                  {
-                     avgTemperature = getTMean(i);
-                     dthetavdh = dThetav_dH(i, avgTemperature, dThetadH);
-                     C[i] += myNode[i].volume_area  * dthetavdh;
+                     avgTemperature = getTMean(ctx, i);
+                     dthetavdh = dThetav_dH(ctx, i, avgTemperature, dThetadH);
+                     ctx->C[i] += ctx->nodeData.volume_area[i]  * dthetavdh;
                  }
             }
         }
@@ -264,68 +360,66 @@ bool waterFlowComputation(double deltaT)
         // updateBoundaryWater(deltaT);
 
         /*! computes the matrix elements */
-        for (i = 0; i < myStructure.nrNodes; i++)
+        for (i = 0; i < ctx->myStructure.nrNodes; i++)
         {
-            j = 1;
-            if (computeFlux(i, j, &(myNode[i].up), deltaT, approximationNr, UP)) j++;
-            for (short l = 0; l < myStructure.nrLateralLinks; l++)
-                    if (computeFlux(i, j, &(myNode[i].lateral[l]), deltaT, approximationNr, LATERAL)) j++;
-            if (computeFlux(i, j, &(myNode[i].down), deltaT, approximationNr, DOWN)) j++;
+            first = ctx->A.rowStart[i];
+            last = ctx->A.rowStart[i+1];
 
-            /*! closure */
-            while (j < myStructure.maxNrColumns) A[i][j++].index = NOLINK;
+            k = first + 1;
+            if (assembleLink(ctx, i, k, &(ctx->myNode[i].up), deltaT, approximationNr, UP, isIncremental)) k++;
+            for (short l = 0; l < ctx->myStructure.nrLateralLinks; l++)
+                    if (assembleLink(ctx, i, k, &(ctx->myNode[i].lateral[l]), deltaT, approximationNr, LATERAL, isIncremental)) k++;
+            if (assembleLink(ctx, i, k, &(ctx->myNode[i].down), deltaT, approximationNr, DOWN, isIncremental)) k++;
 
-            j = 1;
             double sum = 0.;
-            while ((j < myStructure.maxNrColumns) && (A[i][j].index != NOLINK))
+            for (k = first + 1; k < last; k++)
             {
-                sum += A[i][j].val;
-                A[i][j].val *= -1.0;
-                j++;
+                sum += ctx->A.val[k];
+                ctx->A.val[k] *= -1.0;
             }
 
             /*! sum of the diagonal elements */
-            A[i][0].val = C[i]/deltaT + sum;
+            ctx->A.val[first] = ctx->C[i]/deltaT + sum;
 
             /*! b vector(vector of constant terms) */
-            b[i] = ((C[i] / deltaT) * myNode[i].oldH) + myNode[i].Qw + invariantFlux[i];
+            ctx->b[i] = ((ctx->C[i] / deltaT) * ctx->nodeData.oldH[i]) + ctx->nodeData.Qw[i] + ctx->invariantFlux[i];
 
             /*! preconditioning */
-            j = 1;
-            while ((j < myStructure.maxNrColumns) && (A[i][j].index != NOLINK))
-                    A[i][j++].val /= A[i][0].val;
-            b[i] /= A[i][0].val;
+            for (k = first + 1; k < last; k++)
+                    ctx->A.val[k] /= ctx->A.val[first];
+            ctx->b[i] /= ctx->A.val[first];
         }
+        if (isIncremental) ctx->assembly.isValid = true;
 
-        if (Courant > 1.0)
-            if (deltaT > myParameters.delta_t_min)
+        if (ctx->Courant > 1.0)
+            if (deltaT > ctx->myParameters.delta_t_min)
             {
-                halveTimeStep();
-                setForcedHalvedTime(true);
+                rejectTimeStep(ctx, REJECTED_COURANT);
+                setForcedHalvedTime(ctx, true);
                 return (false);
             }
 
-        if (! GaussSeidelRelaxation(approximationNr, myParameters.ResidualTolerance, PROCESS_WATER))
-            if (deltaT > myParameters.delta_t_min)
+        if (! solveLinearSystem(ctx, approximationNr, ctx->myParameters.ResidualTolerance, PROCESS_WATER))
+            if (deltaT > ctx->myParameters.delta_t_min)
             {
-                halveTimeStep();
-                setForcedHalvedTime(true);
+                rejectTimeStep(ctx, REJECTED_SOLVER);
+                setForcedHalvedTime(ctx, true);
                 return (false);
             }
 
         /*! set new potential - compute new degree of saturation */
-        for (i = 0; i < myStructure.nrNodes; i++)
+        for (i = 0; i < ctx->myStructure.nrNodes; i++)
         {
-            myNode[i].H = X[i];
-            if (!myNode[i].isSurface)
-                myNode[i].Se = computeSe(i);
+            ctx->nodeData.H[i] = ctx->X[i];
+            if (!ctx->nodeData.isSurface[i])
+                ctx->nodeData.Se[i] = computeSe(ctx, i);
         }
 
         /*! water balance */
-        isValidStep = waterBalance(deltaT, approximationNr);
-        if (getForcedHalvedTime()) return (false);
+        isValidStep = waterBalance(ctx, deltaT, approximationNr);
+        if (getForcedHalvedTime(ctx)) return (false);
         }
-    while ((!isValidStep) && (++approximationNr < myParameters.maxApproximationsNumber));
+    while ((!isValidStep) && (++approximationNr < ctx->myParameters.maxApproximationsNumber));
 
     return (isValidStep);
  }
@@ -339,38 +433,38 @@ bool waterFlowComputation(double deltaT)
   * \param acceptedTime [s] current seconds for simulation step
   * \return
   */
- bool computeWater(double maxTime, double *acceptedTime)
+ bool computeWater(TCrit3Dcontext *ctx, double maxTime, double *acceptedTime)
 {
  bool isStepOK = false;
 
  while (!isStepOK)
  {
-        *acceptedTime = min_value(myParameters.current_delta_t, maxTime);
+        *acceptedTime = min_value(ctx->myParameters.current_delta_t, maxTime);
 
         /*! save the instantaneous H values - Prepare the solutions vector (X = H) */
-        for (long n = 0; n < myStructure.nrNodes; n++)
+        for (long n = 0; n < ctx->myStructure.nrNodes; n++)
                 {
-                myNode[n].oldH = myNode[n].H;
-                X[n] = myNode[n].H;
+                ctx->nodeData.oldH[n] = ctx->nodeData.H[n];
+                ctx->X[n] = ctx->nodeData.H[n];
                 }
 
         /*! assign Theta_e
             for the surface nodes C = area */
-        for (long n = 0; n < myStructure.nrNodes; n++)
+        for (long n = 0; n < ctx->myStructure.nrNodes; n++)
         {
-            if (myNode[n].isSurface)
-                C[n] = myNode[n].volume_area;
+            if (ctx->nodeData.isSurface[n])
+                ctx->C[n] = ctx->nodeData.volume_area[n];
             else
-                myNode[n].Se = computeSe(n);
+                ctx->nodeData.Se[n] = computeSe(ctx, n);
         }
 
         /*! update boundary conditions */
-        updateBoundary();
-        updateBoundaryWater(*acceptedTime);
+        updateBoundary(ctx);
+        updateBoundaryWater(ctx, *acceptedTime);
 
-        isStepOK = waterFlowComputation(*acceptedTime);
+        isStepOK = waterFlowComputation(ctx, *acceptedTime);
 
-		if (!isStepOK) restoreWater();
+		if (!isStepOK) restoreWater(ctx);
   }
 
  return (isStepOK);
@@ -378,10 +472,10 @@ bool waterFlowComputation(double deltaT)
 }
 
 
-void restoreWater()
+void restoreWater(TCrit3Dcontext *ctx)
 {
 
-    for (long n = 0; n < myStructure.nrNodes; n++)
-         myNode[n].H = myNode[n].oldH;
+    for (long n = 0; n < ctx->myStructure.nrNodes; n++)
+         ctx->nodeData.H[n] = ctx->nodeData.oldH[n];
 
 }
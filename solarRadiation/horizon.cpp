@@ -0,0 +1,281 @@
+/*!
+    \name horizon.cpp
+    \copyright 2011 Fausto Tomei, Gabriele Antolini
+
+    This library is part of CRITERIA3D.
+    CRITERIA3D has been developed under contract issued by A.R.P.A. Emilia-Romagna
+
+    CRITERIA3D is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CRITERIA3D is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with CRITERIA3D.  If not, see <http://www.gnu.org/licenses/>.
+
+    contacts:
+    fausto.tomei@gmail.com
+    ftomei@arpae.it
+    gantolini@arpae.it
+*/
+
+#include <math.h>
+#include <fstream>
+
+#include "commonConstants.h"
+#include "horizon.h"
+
+#define HORIZON_FILE_ID "CRITERIA3D_HORIZON_1"
+
+using namespace std;
+
+
+Crit3DHorizonMap::Crit3DHorizonMap()
+{
+    clear();
+}
+
+
+void Crit3DHorizonMap::clear()
+{
+    nrSectors = 0;
+    distanceFactor = NODATA;
+    nrRows = 0;
+    nrCols = 0;
+    cellSize = NODATA;
+    xll = NODATA;
+    yll = NODATA;
+    dtmChecksum = 0;
+    angle.clear();
+}
+
+
+bool Crit3DHorizonMap::isLoaded() const
+{
+    return (nrSectors > 0 && ! angle.empty());
+}
+
+
+/*!
+ * \brief true if the map was computed on a DTM with the same header, with the same parameters
+ * (the values of the DTM are checked only when the map is read from file)
+ */
+bool Crit3DHorizonMap::isValid(const gis::Crit3DRasterGrid& myDtm, int myNrSectors, float myDistanceFactor) const
+{
+    if (! isLoaded() || myNrSectors != nrSectors || myDistanceFactor != distanceFactor) return false;
+
+    return (myDtm.header->nrRows == nrRows && myDtm.header->nrCols == nrCols
+            && myDtm.header->cellSize == cellSize
+            && myDtm.header->llCorner->x == xll && myDtm.header->llCorner->y == yll);
+}
+
+
+/*!
+ * \brief maximum elevation angle of the terrain seen from the cell in the azimuth direction:
+ * same steps of the ray marching (shadowDistanceFactor * cellSize) up to the border of the DTM;
+ * the walk stops when even the highest point of the DTM could not raise the horizon
+ * \return horizon angle [deg] (not lower than HORIZON_MIN_ANGLE)
+ */
+float Crit3DHorizonMap::computeCellHorizon(const gis::Crit3DRasterGrid& myDtm, int row, int col, float azimuth) const
+{
+    double x, y;
+    int r, c;
+
+    gis::getUtmXYFromRowCol(myDtm, row, col, &x, &y);
+    float z = myDtm.value[row][col];
+
+    double step = distanceFactor * myDtm.header->cellSize;
+    double stepX = step * sin(azimuth * DEG_TO_RAD);
+    double stepY = step * cos(azimuth * DEG_TO_RAD);
+
+    double maxTangent = tan(HORIZON_MIN_ANGLE * DEG_TO_RAD);
+    double distance = 0;
+
+    while (true)
+    {
+        x += stepX;
+        y += stepY;
+        distance += step;
+
+        if ((myDtm.maximum - z) / distance <= maxTangent) break;
+
+        gis::getRowColFromXY(myDtm, x, y, &r, &c);
+        if (gis::isOutOfGridRowCol(r, c, myDtm)) break;
+
+        float height = myDtm.value[r][c];
+        if (height == myDtm.header->flag) break;
+
+        double tangent = (height - z) / distance;
+        if (tangent > maxTangent) maxTangent = tangent;
+    }
+
+    return float(atan(maxTangent) * RAD_TO_DEG);
+}
+
+
+/*!
+ * \brief horizon of all the valid cells of the DTM (rows in parallel)
+ * \param myNrSectors number of azimuth directions (e.g. 36: every 10 degrees)
+ * \param myDistanceFactor step of the walk in cells (as the shadowDistanceFactor of the radiation settings)
+ */
+bool Crit3DHorizonMap::build(const gis::Crit3DRasterGrid& myDtm, int myNrSectors, float myDistanceFactor, int nrThreads)
+{
+    clear();
+    if (! myDtm.isLoaded || myNrSectors < 1 || myDistanceFactor <= 0) return false;
+
+    nrSectors = myNrSectors;
+    distanceFactor = myDistanceFactor;
+    nrRows = myDtm.header->nrRows;
+    nrCols = myDtm.header->nrCols;
+    cellSize = myDtm.header->cellSize;
+    xll = myDtm.header->llCorner->x;
+    yll = myDtm.header->llCorner->y;
+    dtmChecksum = gis::getRasterChecksum(myDtm);
+
+    angle.resize(unsigned(nrRows * nrCols * nrSectors));
+
+    #pragma omp parallel for schedule(dynamic, 4) num_threads(maxValue(nrThreads, 1))
+    for (int row = 0; row < nrRows; row++)
+        for (int col = 0; col < nrCols; col++)
+        {
+            unsigned int first = unsigned((row * nrCols + col) * nrSectors);
+            for (int i = 0; i < nrSectors; i++)
+            {
+                float myAngle = HORIZON_MIN_ANGLE;
+                if (myDtm.value[row][col] != myDtm.header->flag)
+                    myAngle = computeCellHorizon(myDtm, row, col, i * 360.f / nrSectors);
+                angle[first + unsigned(i)] = short(lround(myAngle * 100));
+            }
+        }
+
+    return true;
+}
+
+
+/*!
+ * \brief write the map in a binary file, with the parameters and the checksum of the DTM
+ */
+bool Crit3DHorizonMap::writeFile(const string& fileName, string* myError) const
+{
+    if (! isLoaded())
+    {
+        *myError = "Horizon map not computed";
+        return false;
+    }
+
+    ofstream myFile(fileName.c_str(), ios::out | ios::binary);
+    if (! myFile.is_open())
+    {
+        *myError = "Cannot write file: " + fileName;
+        return false;
+    }
+
+    char fileId[] = HORIZON_FILE_ID;
+    myFile.write(fileId, sizeof(fileId));
+    myFile.write(reinterpret_cast<const char*>(&nrSectors), sizeof(nrSectors));
+    myFile.write(reinterpret_cast<const char*>(&distanceFactor), sizeof(distanceFactor));
+    myFile.write(reinterpret_cast<const char*>(&dtmChecksum), sizeof(dtmChecksum));
+    myFile.write(reinterpret_cast<const char*>(angle.data()), long(angle.size() * sizeof(short)));
+    myFile.close();
+
+    return true;
+}
+
+
+/*!
+ * \brief read the map computed on the same DTM (checksum) with the same parameters
+ * \return false if the file does not exist or is not valid for the DTM
+ */
+bool Crit3DHorizonMap::readFile(const string& fileName, const gis::Crit3DRasterGrid& myDtm,
+                                int myNrSectors, float myDistanceFactor, string* myError)
+{
+    clear();
+
+    ifstream myFile(fileName.c_str(), ios::in | ios::binary);
+    if (! myFile.is_open())
+    {
+        *myError = "Missing file: " + fileName;
+        return false;
+    }
+
+    char fileId[] = HORIZON_FILE_ID;
+    char readId[sizeof(fileId)];
+    int readNrSectors;
+    float readDistanceFactor;
+    unsigned long long readChecksum;
+
+    myFile.read(readId, sizeof(readId));
+    myFile.read(reinterpret_cast<char*>(&readNrSectors), sizeof(readNrSectors));
+    myFile.read(reinterpret_cast<char*>(&readDistanceFactor), sizeof(readDistanceFactor));
+    myFile.read(reinterpret_cast<char*>(&readChecksum), sizeof(readChecksum));
+
+    if (! myFile.good() || string(readId, sizeof(readId)) != string(fileId, sizeof(fileId)))
+    {
+        *myError = "Wrong horizon file: " + fileName;
+        return false;
+    }
+
+    if (readNrSectors != myNrSectors || readDistanceFactor != myDistanceFactor
+        || readChecksum != gis::getRasterChecksum(myDtm))
+    {
+        *myError = "Horizon file computed on a different DTM or settings: " + fileName;
+        return false;
+    }
+
+    angle.resize(unsigned(myDtm.header->nrRows * myDtm.header->nrCols * myNrSectors));
+    myFile.read(reinterpret_cast<char*>(angle.data()), long(angle.size() * sizeof(short)));
+    if (! myFile.good())
+    {
+        angle.clear();
+        *myError = "Wrong horizon file: " + fileName;
+        return false;
+    }
+
+    nrSectors = myNrSectors;
+    distanceFactor = myDistanceFactor;
+    nrRows = myDtm.header->nrRows;
+    nrCols = myDtm.header->nrCols;
+    cellSize = myDtm.header->cellSize;
+    xll = myDtm.header->llCorner->x;
+    yll = myDtm.header->llCorner->y;
+    dtmChecksum = readChecksum;
+
+    return true;
+}
+
+
+/*!
+ * \brief horizon angle of the cell [deg], linear interpolation between the two nearest sectors
+ */
+float Crit3DHorizonMap::getHorizonAngle(int row, int col, float azimuth) const
+{
+    float sectorWidth = 360.f / nrSectors;
+    float position = azimuth / sectorWidth;
+    int sector0 = int(floor(position));
+    float weight = position - sector0;
+
+    sector0 = ((sector0 % nrSectors) + nrSectors) % nrSectors;
+    int sector1 = (sector0 + 1) % nrSectors;
+
+    unsigned int first = unsigned((row * nrCols + col) * nrSectors);
+    return ((1 - weight) * angle[first + unsigned(sector0)] + weight * angle[first + unsigned(sector1)]) / 100.f;
+}
+
+
+/*!
+ * \brief terrain shadow on the point (same meaning of radiation::computeShadow)
+ * \param sunAzimuth, sunElevation [deg] (elevation without refraction)
+ */
+bool Crit3DHorizonMap::isShadow(double x, double y, float sunAzimuth, float sunElevation) const
+{
+    int row = (nrRows - 1) - int(floor((y - yll) / cellSize));
+    int col = int(floor((x - xll) / cellSize));
+    if (row < 0 || row >= nrRows || col < 0 || col >= nrCols) return false;
+
+    return (sunElevation < getHorizonAngle(row, col, sunAzimuth));
+}
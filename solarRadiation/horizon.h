@@ -0,0 +1,55 @@
+#ifndef HORIZON_H
+#define HORIZON_H
+
+    #ifndef VECTOR_H
+        #include <vector>
+    #endif
+    #ifndef STRING_H
+        #include <string>
+    #endif
+    #ifndef GIS_H
+        #include "gis.h"
+    #endif
+
+    /*! number of azimuth sectors of the horizon map (Crit3DRadiationSettings::setHorizonSectors).
+     *  0: exact terrain shadow by ray marching on the DTM (default).
+     *  With sectors (e.g. 36) the horizon is interpolated between sectors: about 1% of the
+     *  shadow cells change on a rough DTM, and the map is saved in <dtm>.horizon next to the DTM */
+    #define HORIZON_SECTORS_DEFAULT 0
+    /*! lower limit of the stored angles [deg]: the sun is never visible below */
+    #define HORIZON_MIN_ANGLE -2.f
+
+    /*! horizon angle of each cell of a DTM for nrSectors azimuth directions (N=0, clockwise):
+     *  the terrain shadow becomes a comparison between the sun elevation and the horizon
+     *  interpolated at the sun azimuth, without ray marching on the DTM.
+     *  Angles are stored in hundredths of degree */
+    class Crit3DHorizonMap
+    {
+    private:
+        int nrSectors;
+        float distanceFactor;
+        int nrRows, nrCols;
+        double cellSize, xll, yll;
+        unsigned long long dtmChecksum;
+
+        std::vector <short> angle;          /*!< [nrRows*nrCols*nrSectors] horizon angle [deg/100] */
+
+        float computeCellHorizon(const gis::Crit3DRasterGrid& myDtm, int row, int col, float azimuth) const;
+
+    public:
+        Crit3DHorizonMap();
+
+        void clear();
+        bool isLoaded() const;
+        bool isValid(const gis::Crit3DRasterGrid& myDtm, int myNrSectors, float myDistanceFactor) const;
+
+        bool build(const gis::Crit3DRasterGrid& myDtm, int myNrSectors, float myDistanceFactor, int nrThreads);
+        bool writeFile(const std::string& fileName, std::string* myError) const;
+        bool readFile(const std::string& fileName, const gis::Crit3DRasterGrid& myDtm,
+                      int myNrSectors, float myDistanceFactor, std::string* myError);
+
+        float getHorizonAngle(int row, int col, float azimuth) const;
+        bool isShadow(double x, double y, float sunAzimuth, float sunElevation) const;
+    };
+
+#endif // HORIZON_H
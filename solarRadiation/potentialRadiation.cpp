@@ -0,0 +1,281 @@
+/*!
+    \name potentialRadiation.cpp
+    \copyright 2011 Fausto Tomei, Gabriele Antolini
+
+    This library is part of CRITERIA3D.
+    CRITERIA3D has been developed under contract issued by A.R.P.A. Emilia-Romagna
+
+    CRITERIA3D is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CRITERIA3D is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with CRITERIA3D.  If not, see <http://www.gnu.org/licenses/>.
+
+    contacts:
+    fausto.tomei@gmail.com
+    ftomei@arpae.it
+    gantolini@arpae.it
+*/
+
+#include <fstream>
+#include <cstdio>
+
+#include "commonConstants.h"
+#include "potentialRadiation.h"
+
+#define POTENTIAL_FILE_ID "CRITERIA3D_POTENTIAL_1"
+
+#define CELL_COMPUTED 1
+#define CELL_ILLUMINATED 2
+#define CELL_SHADOW 4
+
+using namespace std;
+
+
+Crit3DPotentialRadiationMap::Crit3DPotentialRadiationMap()
+{
+    clear();
+}
+
+
+void Crit3DPotentialRadiationMap::clear()
+{
+    nrRows = 0;
+    nrCols = 0;
+    dtmChecksum = 0;
+    settingsChecksum = 0;
+    dayOfYear = NODATA;
+    seconds = NODATA;
+
+    azimuth.clear();
+    elevation.clear();
+    elevationRefr.clear();
+    incidence.clear();
+    extraIrradianceNormal.clear();
+    extraIrradianceHorizontal.clear();
+    beamHorizontal.clear();
+    diffuseHorizontal.clear();
+    flag.clear();
+}
+
+
+bool Crit3DPotentialRadiationMap::isLoaded() const
+{
+    return (nrRows > 0 && nrCols > 0 && ! flag.empty());
+}
+
+
+/*!
+ * \brief empty map (no cell computed) for the DTM, the settings and the time of the day
+ */
+void Crit3DPotentialRadiationMap::initialize(int myNrRows, int myNrCols, unsigned long long myDtmChecksum,
+                                             unsigned long long mySettingsChecksum, int myDayOfYear, int mySeconds)
+{
+    clear();
+    if (myNrRows < 1 || myNrCols < 1) return;
+
+    nrRows = myNrRows;
+    nrCols = myNrCols;
+    dtmChecksum = myDtmChecksum;
+    settingsChecksum = mySettingsChecksum;
+    dayOfYear = myDayOfYear;
+    seconds = mySeconds;
+
+    unsigned int nrCells = unsigned(nrRows * nrCols);
+    azimuth.resize(nrCells);
+    elevation.resize(nrCells);
+    elevationRefr.resize(nrCells);
+    incidence.resize(nrCells);
+    extraIrradianceNormal.resize(nrCells);
+    extraIrradianceHorizontal.resize(nrCells);
+    beamHorizontal.resize(nrCells, 0);
+    diffuseHorizontal.resize(nrCells, 0);
+    flag.resize(nrCells, 0);
+}
+
+
+/*!
+ * \brief store the potential radiation of the cell (cells are independent: rows can be set in parallel)
+ */
+void Crit3DPotentialRadiationMap::setCell(int row, int col, const TsunPosition& mySunPosition, bool isIlluminated,
+                                          float beamHorizontalClearSky, float diffuseHorizontalClearSky)
+{
+    unsigned int i = unsigned(row * nrCols + col);
+
+    azimuth[i] = mySunPosition.azimuth;
+    elevation[i] = mySunPosition.elevation;
+    elevationRefr[i] = mySunPosition.elevationRefr;
+    incidence[i] = mySunPosition.incidence;
+    extraIrradianceNormal[i] = mySunPosition.extraIrradianceNormal;
+    extraIrradianceHorizontal[i] = mySunPosition.extraIrradianceHorizontal;
+    if (isIlluminated)
+    {
+        beamHorizontal[i] = beamHorizontalClearSky;
+        diffuseHorizontal[i] = diffuseHorizontalClearSky;
+    }
+
+    flag[i] = CELL_COMPUTED;
+    if (isIlluminated) flag[i] |= CELL_ILLUMINATED;
+    if (mySunPosition.shadow) flag[i] |= CELL_SHADOW;
+}
+
+
+/*!
+ * \brief potential radiation of the cell: only the fields used by the real sky radiation are restored
+ * \return false if the cell was not computed
+ */
+bool Crit3DPotentialRadiationMap::getCell(int row, int col, TsunPosition* mySunPosition, bool* isIlluminated,
+                                          float* beamHorizontalClearSky, float* diffuseHorizontalClearSky) const
+{
+    unsigned int i = unsigned(row * nrCols + col);
+    if (! (flag[i] & CELL_COMPUTED)) return false;
+
+    mySunPosition->hourDecimal = NODATA;
+    mySunPosition->rise = NODATA;
+    mySunPosition->set = NODATA;
+    mySunPosition->relOptAirMass = NODATA;
+    mySunPosition->relOptAirMassCorr = NODATA;
+
+    mySunPosition->azimuth = azimuth[i];
+    mySunPosition->elevation = elevation[i];
+    mySunPosition->elevationRefr = elevationRefr[i];
+    mySunPosition->incidence = incidence[i];
+    mySunPosition->extraIrradianceNormal = extraIrradianceNormal[i];
+    mySunPosition->extraIrradianceHorizontal = extraIrradianceHorizontal[i];
+    mySunPosition->shadow = (flag[i] & CELL_SHADOW);
+
+    *isIlluminated = (flag[i] & CELL_ILLUMINATED);
+    *beamHorizontalClearSky = beamHorizontal[i];
+    *diffuseHorizontalClearSky = diffuseHorizontal[i];
+
+    return true;
+}
+
+
+/*!
+ * \brief write the map in a binary file, with the checksums of the DTM and of the settings.
+ * The map is written in a temporary file and then renamed: an interrupted write does not leave
+ * a truncated file with the final name
+ */
+bool Crit3DPotentialRadiationMap::writeFile(const string& fileName, string* myError) const
+{
+    if (! isLoaded())
+    {
+        *myError = "Potential radiation map not computed";
+        return false;
+    }
+
+    string tmpFileName = fileName + ".tmp";
+    ofstream myFile(tmpFileName.c_str(), ios::out | ios::binary);
+    if (! myFile.is_open())
+    {
+        *myError = "Cannot write file: " + tmpFileName;
+        return false;
+    }
+
+    char fileId[] = POTENTIAL_FILE_ID;
+    myFile.write(fileId, sizeof(fileId));
+    myFile.write(reinterpret_cast<const char*>(&nrRows), sizeof(nrRows));
+    myFile.write(reinterpret_cast<const char*>(&nrCols), sizeof(nrCols));
+    myFile.write(reinterpret_cast<const char*>(&dtmChecksum), sizeof(dtmChecksum));
+    myFile.write(reinterpret_cast<const char*>(&settingsChecksum), sizeof(settingsChecksum));
+    myFile.write(reinterpret_cast<const char*>(&dayOfYear), sizeof(dayOfYear));
+    myFile.write(reinterpret_cast<const char*>(&seconds), sizeof(seconds));
+
+    const vector <float>* fields[] = {&azimuth, &elevation, &elevationRefr, &incidence,
+                                      &extraIrradianceNormal, &extraIrradianceHorizontal,
+                                      &beamHorizontal, &diffuseHorizontal};
+    for (const vector <float>* field : fields)
+        myFile.write(reinterpret_cast<const char*>(field->data()), long(field->size() * sizeof(float)));
+    myFile.write(reinterpret_cast<const char*>(flag.data()), long(flag.size()));
+
+    myFile.close();
+    if (! myFile.good())
+    {
+        remove(tmpFileName.c_str());
+        *myError = "Cannot write file: " + tmpFileName;
+        return false;
+    }
+
+    // rename does not replace an existing file on Windows
+    remove(fileName.c_str());
+    if (rename(tmpFileName.c_str(), fileName.c_str()) != 0)
+    {
+        remove(tmpFileName.c_str());
+        *myError = "Cannot rename file: " + tmpFileName;
+        return false;
+    }
+
+    return true;
+}
+
+
+/*!
+ * \brief read the map computed on the same DTM with the same settings, day of year and time
+ * \return false if the file does not exist or does not match
+ */
+bool Crit3DPotentialRadiationMap::readFile(const string& fileName, int myNrRows, int myNrCols,
+                                           unsigned long long myDtmChecksum, unsigned long long mySettingsChecksum,
+                                           int myDayOfYear, int mySeconds, string* myError)
+{
+    clear();
+
+    ifstream myFile(fileName.c_str(), ios::in | ios::binary);
+    if (! myFile.is_open())
+    {
+        *myError = "Missing file: " + fileName;
+        return false;
+    }
+
+    char fileId[] = POTENTIAL_FILE_ID;
+    char readId[sizeof(fileId)];
+    int readNrRows, readNrCols, readDayOfYear, readSeconds;
+    unsigned long long readDtmChecksum, readSettingsChecksum;
+
+    myFile.read(readId, sizeof(readId));
+    myFile.read(reinterpret_cast<char*>(&readNrRows), sizeof(readNrRows));
+    myFile.read(reinterpret_cast<char*>(&readNrCols), sizeof(readNrCols));
+    myFile.read(reinterpret_cast<char*>(&readDtmChecksum), sizeof(readDtmChecksum));
+    myFile.read(reinterpret_cast<char*>(&readSettingsChecksum), sizeof(readSettingsChecksum));
+    myFile.read(reinterpret_cast<char*>(&readDayOfYear), sizeof(readDayOfYear));
+    myFile.read(reinterpret_cast<char*>(&readSeconds), sizeof(readSeconds));
+
+    if (! myFile.good() || string(readId, sizeof(readId)) != string(fileId, sizeof(fileId)))
+    {
+        *myError = "Wrong potential radiation file: " + fileName;
+        return false;
+    }
+
+    if (readNrRows != myNrRows || readNrCols != myNrCols
+        || readDtmChecksum != myDtmChecksum || readSettingsChecksum != mySettingsChecksum
+        || readDayOfYear != myDayOfYear || readSeconds != mySeconds)
+    {
+        *myError = "Potential radiation file computed on a different DTM or settings: " + fileName;
+        return false;
+    }
+
+    initialize(myNrRows, myNrCols, myDtmChecksum, mySettingsChecksum, myDayOfYear, mySeconds);
+
+    vector <float>* fields[] = {&azimuth, &elevation, &elevationRefr, &incidence,
+                                &extraIrradianceNormal, &extraIrradianceHorizontal,
+                                &beamHorizontal, &diffuseHorizontal};
+    for (vector <float>* field : fields)
+        myFile.read(reinterpret_cast<char*>(field->data()), long(field->size() * sizeof(float)));
+    myFile.read(reinterpret_cast<char*>(flag.data()), long(flag.size()));
+
+    if (! myFile.good())
+    {
+        clear();
+        *myError = "Wrong potential radiation file: " + fileName;
+        return false;
+    }
+
+    return true;
+}
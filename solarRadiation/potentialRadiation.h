@@ -0,0 +1,54 @@
+#ifndef POTENTIALRADIATION_H
+#define POTENTIALRADIATION_H
+
+    #ifndef VECTOR_H
+        #include <vector>
+    #endif
+    #ifndef STRING_H
+        #include <string>
+    #endif
+    #ifndef RADIATIONDEFINITIONS_H
+        #include "radiationDefinitions.h"
+    #endif
+
+    /*! potential (clear sky) part of the radiation on the cells of a DTM at one time of the day:
+     *  sun position, shadow and clear sky irradiance on a horizontal surface.
+     *  It does not depend on the transmissivity: it is saved once for each day of year and time
+     *  and the real sky radiation is computed on it (cache of computeRadiationGridRsun) */
+    class Crit3DPotentialRadiationMap
+    {
+    private:
+        int nrRows, nrCols;
+        unsigned long long dtmChecksum;
+        unsigned long long settingsChecksum;
+        int dayOfYear, seconds;
+
+        std::vector <float> azimuth;
+        std::vector <float> elevation;
+        std::vector <float> elevationRefr;
+        std::vector <float> incidence;
+        std::vector <float> extraIrradianceNormal;
+        std::vector <float> extraIrradianceHorizontal;
+        std::vector <float> beamHorizontal;         /*!< clear sky beam irradiance on a horizontal surface [W m-2] */
+        std::vector <float> diffuseHorizontal;      /*!< clear sky diffuse irradiance on a horizontal surface [W m-2] */
+        std::vector <unsigned char> flag;           /*!< computed, illuminated, shadow */
+
+    public:
+        Crit3DPotentialRadiationMap();
+
+        void clear();
+        bool isLoaded() const;
+        void initialize(int myNrRows, int myNrCols, unsigned long long myDtmChecksum,
+                        unsigned long long mySettingsChecksum, int myDayOfYear, int mySeconds);
+
+        void setCell(int row, int col, const TsunPosition& mySunPosition, bool isIlluminated,
+                     float beamHorizontalClearSky, float diffuseHorizontalClearSky);
+        bool getCell(int row, int col, TsunPosition* mySunPosition, bool* isIlluminated,
+                     float* beamHorizontalClearSky, float* diffuseHorizontalClearSky) const;
+
+        bool writeFile(const std::string& fileName, std::string* myError) const;
+        bool readFile(const std::string& fileName, int myNrRows, int myNrCols, unsigned long long myDtmChecksum,
+                      unsigned long long mySettingsChecksum, int myDayOfYear, int mySeconds, std::string* myError);
+    };
+
+#endif // POTENTIALRADIATION_H
@@ -17,6 +17,13 @@
     /*! Drummond factor for partly cloudy skies */
     #define SBSKY 0.04f
 
+    /*! sun position computed on every cell (0, default) or every n cells and interpolated
+     *  (Crit3DRadiationSettings::setSunLatticeStep) */
+    #define SUN_LATTICE_STEP_DEFAULT 0
+
+    /*! maximum size [MB] of the potential radiation cache folder (0: no cache, default) */
+    #define POTENTIAL_CACHE_SIZE_DEFAULT 0
+
     #define TRANSMISSIVITY_SAMANI_COEFF_DEFAULT  0.17f
     #define CLEAR_SKY_TRANSMISSIVITY_DEFAULT     0.75f
 
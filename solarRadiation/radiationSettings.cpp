@@ -1,5 +1,6 @@
 #include "commonConstants.h"
 #include "radiationSettings.h"
+#include "horizon.h"
 
 
 Crit3DRadiationSettings::Crit3DRadiationSettings()
@@ -9,6 +10,9 @@ Crit3DRadiationSettings::Crit3DRadiationSettings()
     timeStepIntegration = 1;
     computeShadowing = true;
     shadowDistanceFactor = 1;
+    horizonSectors = HORIZON_SECTORS_DEFAULT;
+    sunLatticeStep = SUN_LATTICE_STEP_DEFAULT;
+    potentialCacheSize = POTENTIAL_CACHE_SIZE_DEFAULT;
     linkeMode = PARAM_MODE_FIXED;
     linke = 4.0;
     landUse = LAND_USE_RURAL;
@@ -51,6 +55,24 @@ bool Crit3DRadiationSettings::getComputeShadowing()
 float Crit3DRadiationSettings::getShadowDistanceFactor()
 { return shadowDistanceFactor;}
 
+int Crit3DRadiationSettings::getHorizonSectors()
+{ return horizonSectors;}
+
+void Crit3DRadiationSettings::setHorizonSectors(int myNrSectors)
+{ horizonSectors = myNrSectors;}
+
+int Crit3DRadiationSettings::getSunLatticeStep()
+{ return sunLatticeStep;}
+
+void Crit3DRadiationSettings::setSunLatticeStep(int myStep)
+{ sunLatticeStep = myStep;}
+
+int Crit3DRadiationSettings::getPotentialCacheSize()
+{ return potentialCacheSize;}
+
+void Crit3DRadiationSettings::setPotentialCacheSize(int mySize)
+{ potentialCacheSize = mySize;}
+
 TparameterMode Crit3DRadiationSettings::getLinkeMode()
 { return linkeMode;}
 
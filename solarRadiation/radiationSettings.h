@@ -32,6 +32,9 @@
         float timeStepIntegration;
         bool computeShadowing;
         float shadowDistanceFactor;
+        int horizonSectors;
+        int sunLatticeStep;
+        int potentialCacheSize;
         float linke;
         float albedo;
         float tilt;
@@ -49,6 +52,12 @@
         float getTimeStepIntegration();
         bool getComputeShadowing();
         float getShadowDistanceFactor();
+        int getHorizonSectors();
+        void setHorizonSectors(int myNrSectors);
+        int getSunLatticeStep();
+        void setSunLatticeStep(int myStep);
+        int getPotentialCacheSize();
+        void setPotentialCacheSize(int mySize);
         float getLinke();
         float getAlbedo();
         float getTilt();
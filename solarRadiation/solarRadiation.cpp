@@ -25,10 +25,17 @@
     gantolini@arpae.it
 */
 
+#include <vector>
+#include <map>
+#include <sstream>
+
 #include "commonConstants.h"
 #include "sunPosition.h"
 #include "solarRadiation.h"
 
+#define RADIATION_GRID_OUTPUTS 8
+#define RADIATION_ROW_BLOCK 8
+
 
 float getSinDecimalDegree(float angle)
 {
@@ -66,6 +73,10 @@ Crit3DRadiationMaps::Crit3DRadiationMaps()
     sunRiseMap = new gis::Crit3DRasterGrid;
     sunSetMap = new gis::Crit3DRasterGrid;
     sunShadowMap = new gis::Crit3DRasterGrid;
+    horizonMap = new Crit3DHorizonMap;
+    potentialMap = new Crit3DPotentialRadiationMap;
+    potentialCacheDtmChecksum = 0;
+    dtmChecksum = 0;
 
     isLoaded = false;
 }
@@ -100,6 +111,10 @@ Crit3DRadiationMaps::Crit3DRadiationMaps(const gis::Crit3DRasterGrid& myDtm, con
     sunRiseMap = new gis::Crit3DRasterGrid;
     sunSetMap = new gis::Crit3DRasterGrid;
     sunShadowMap = new gis::Crit3DRasterGrid;
+    horizonMap = new Crit3DHorizonMap;
+    potentialMap = new Crit3DPotentialRadiationMap;
+    potentialCacheDtmChecksum = 0;
+    dtmChecksum = gis::getRasterChecksum(myDtm);
 
     beamRadiationMap->initializeGrid(myDtm);
     diffuseRadiationMap->initializeGrid(myDtm);
@@ -154,6 +169,8 @@ Crit3DRadiationMaps::~Crit3DRadiationMaps()
     delete sunSetMap;
     delete sunShadowMap;
     delete transmissivityMap;
+    delete horizonMap;
+    delete potentialMap;
 }
 
 Crit3DTransmissivityPoint::Crit3DTransmissivityPoint()
@@ -555,29 +572,29 @@ namespace radiation
     }
 
 
-bool computeRadiationPointRsun(float myTemperature, float myPressure, Crit3DTime myTime,
-            float myLinke,float myAlbedo, float myClearSkyTransmissivity, float myTransmissivity ,
-            TsunPosition* mySunPosition, TradPoint* myPoint, const gis::Crit3DRasterGrid& myDtm)
+    Crit3DTime getLocalTime(const Crit3DTime& myTime)
+    {
+        Crit3DTime localTime = myTime;
+        if (radiationSettings.gisSettings->isUTC)
+            localTime.addSeconds(float(radiationSettings.gisSettings->timeZone * 3600));
+        return localTime;
+    }
+
+
+    /*!
+     * \brief potential (clear sky) part of the radiation: sun position, shadowing,
+     * clear sky beam and diffuse irradiance on a horizontal surface (only if illuminated)
+     * \param isSunPositionComputed mySunPosition is given (interpolated on the lattice), not computed for the point
+     */
+    bool computePotentialPointRsun(float myTemperature, float myPressure, Crit3DTime myTime, float myLinke,
+            TsunPosition* mySunPosition, TradPoint* myPoint, const gis::Crit3DRasterGrid& myDtm,
+            const Crit3DHorizonMap* myHorizonMap, bool isSunPositionComputed,
+            bool* isPointIlluminated, float* Bhc, float* Dhc)
     {
         int myYear, myMonth, myDay;
         int myHour, myMinute, mySecond;
-        float Bhc, Bh;
-        float Dhc, dH;
-        float Ghc, Gh;
-        //float td, Tt;
-        float normalizedTransmittance;
-        float globalTransmittance;  /*!<   real sky global irradiation coefficient (global transmittance) */
-        float diffuseTransmittance; /*!<   real sky mypoint.diffuse irradiation coefficient (mypoint.diffuse transmittance) */
-        //float beamTransmittance;    /*! real sky mypoint.beam irradiation coefficient (mypoint.beam transmittance) */
-        float dhsOverGhs;           /*!<  ratio horizontal mypoint.diffuse over horizontal global */
-        bool isPointIlluminated;
-
-        bool output = false ;
 
-        Crit3DTime localTime;
-        localTime = myTime;
-        if (radiationSettings.gisSettings->isUTC)
-            localTime.addSeconds(float(radiationSettings.gisSettings->timeZone * 3600));
+        Crit3DTime localTime = getLocalTime(myTime);
 
         myYear = localTime.date.year;
         myMonth =  localTime.date.month;
@@ -587,30 +604,64 @@ bool computeRadiationPointRsun(float myTemperature, float myPressure, Crit3DTime
         mySecond = int(localTime.getSeconds());
 
         /*! Sun position */
-        if (! computeSunPosition(float(myPoint->lon), float(myPoint->lat), radiationSettings.gisSettings->timeZone,
-            myYear, myMonth, myDay, myHour, myMinute, mySecond,
-            myTemperature, myPressure, float(myPoint->aspect), float(myPoint->slope), mySunPosition)) return output;
+        if (! isSunPositionComputed)
+            if (! computeSunPosition(float(myPoint->lon), float(myPoint->lat), radiationSettings.gisSettings->timeZone,
+                myYear, myMonth, myDay, myHour, myMinute, mySecond,
+                myTemperature, myPressure, float(myPoint->aspect), float(myPoint->slope), mySunPosition)) return false;
 
         /*! Shadowing */
-        isPointIlluminated = isIlluminated(localTime.time, (*mySunPosition).rise, (*mySunPosition).set, (*mySunPosition).elevationRefr);
+        *isPointIlluminated = isIlluminated(localTime.time, (*mySunPosition).rise, (*mySunPosition).set, (*mySunPosition).elevationRefr);
         if (radiationSettings.getComputeShadowing())
         {
             if (gis::isOutOfGridXY(myPoint->x, myPoint->y, myDtm.header))
-                (*mySunPosition).shadow = ! isPointIlluminated;
+                (*mySunPosition).shadow = ! (*isPointIlluminated);
             else
             {
-                if (isPointIlluminated)
-                    (*mySunPosition).shadow = computeShadow(myPoint, mySunPosition, myDtm);
+                if (*isPointIlluminated)
+                {
+                    if (myHorizonMap != nullptr)
+                        (*mySunPosition).shadow = myHorizonMap->isShadow(myPoint->x, myPoint->y,
+                                                                         mySunPosition->azimuth, mySunPosition->elevation);
+                    else
+                        (*mySunPosition).shadow = computeShadow(myPoint, mySunPosition, myDtm);
+                }
                 else
                     (*mySunPosition).shadow = true;
             }
         }
 
+        /*! Clear sky radiation */
+        if (*isPointIlluminated)
+        {
+            *Bhc = clearSkyBeamHorizontal(myLinke, mySunPosition);
+            *Dhc = clearSkyDiffuseHorizontal(myLinke, mySunPosition);
+        }
+        else
+        {
+            *Bhc = 0;
+            *Dhc = 0;
+        }
+
+        return true;
+    }
+
+
+    /*!
+     * \brief real sky radiation on the point, from the potential part (computePotentialPointRsun)
+     */
+    void computeRealSkyPointRsun(float myAlbedo, float myClearSkyTransmissivity, float myTransmissivity,
+            bool isPointIlluminated, float Bhc, float Dhc, TsunPosition* mySunPosition, TradPoint* myPoint)
+    {
+        float Bh, dH;
+        float Ghc, Gh;
+        float normalizedTransmittance;
+        float globalTransmittance;  /*!<   real sky global irradiation coefficient (global transmittance) */
+        float diffuseTransmittance; /*!<   real sky mypoint.diffuse irradiation coefficient (mypoint.diffuse transmittance) */
+        float dhsOverGhs;           /*!<  ratio horizontal mypoint.diffuse over horizontal global */
+
         /*! Radiation */
         if (isPointIlluminated)
         {
-            Bhc = clearSkyBeamHorizontal(myLinke, mySunPosition);
-            Dhc = clearSkyDiffuseHorizontal(myLinke, mySunPosition);
             Ghc = Dhc + Bhc;
             if (radiationSettings.getComputeRealData())
             {
@@ -676,17 +727,202 @@ bool computeRadiationPointRsun(float myTemperature, float myPressure, Crit3DTime
             myPoint->reflected = 0;
             myPoint->global = 0;
         }
-        output = true;
-        return output;
     }
 
+
+    /*!
+     * \param isSunPositionComputed mySunPosition is given (interpolated on the lattice), not computed for the point
+     */
+    bool computeRadiationPointRsun(float myTemperature, float myPressure, Crit3DTime myTime,
+            float myLinke,float myAlbedo, float myClearSkyTransmissivity, float myTransmissivity ,
+            TsunPosition* mySunPosition, TradPoint* myPoint, const gis::Crit3DRasterGrid& myDtm,
+            const Crit3DHorizonMap* myHorizonMap = nullptr, bool isSunPositionComputed = false)
+    {
+        bool isPointIlluminated;
+        float Bhc, Dhc;
+
+        if (! computePotentialPointRsun(myTemperature, myPressure, myTime, myLinke, mySunPosition, myPoint, myDtm,
+                                        myHorizonMap, isSunPositionComputed, &isPointIlluminated, &Bhc, &Dhc))
+            return false;
+
+        computeRealSkyPointRsun(myAlbedo, myClearSkyTransmissivity, myTransmissivity,
+                                isPointIlluminated, Bhc, Dhc, mySunPosition, myPoint);
+        return true;
+    }
+
+    void addChecksum(unsigned long long* hash, const void* value, unsigned int size)
+    {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(value);
+        for (unsigned int i = 0; i < size; i++)
+            *hash = (*hash ^ bytes[i]) * 1099511628211ULL;
+    }
+
+
+    /*!
+     * \brief checksum of the radiation and gis settings used by the potential radiation
+     */
+    unsigned long long getSettingsChecksum()
+    {
+        unsigned long long hash = 14695981039346656037ULL;
+
+        int intValues[] = {int(radiationSettings.getAlgorithm()), int(radiationSettings.getLinkeMode()),
+                           int(radiationSettings.getTiltMode()), int(radiationSettings.getComputeShadowing()),
+                           radiationSettings.getHorizonSectors(), radiationSettings.getSunLatticeStep(),
+                           radiationSettings.gisSettings->utmZone, int(radiationSettings.gisSettings->isNorthernEmisphere),
+                           radiationSettings.gisSettings->timeZone, int(radiationSettings.gisSettings->isUTC)};
+        float floatValues[] = {radiationSettings.getLinke(), radiationSettings.getTilt(),
+                               radiationSettings.getAspect(), radiationSettings.getShadowDistanceFactor()};
+
+        addChecksum(&hash, intValues, sizeof(intValues));
+        addChecksum(&hash, floatValues, sizeof(floatValues));
+        return hash;
+    }
+
+
+    /*! potential global radiation of a station at the time steps of three days (previous, current, next)
+     *  and its prefix sums: the radiation on a window of time steps is the difference of two sums */
+    struct TpotentialCurve
+    {
+        std::vector <float> global;
+        std::vector <double> sumGlobal;         /*!< sumGlobal[i]: sum of global[0 .. i-1] */
+    };
+
+    struct TpotentialCurveKey
+    {
+        double x, y, height, slope, aspect;
+
+        bool operator < (const TpotentialCurveKey& other) const
+        {
+            if (x != other.x) return x < other.x;
+            if (y != other.y) return y < other.y;
+            if (height != other.height) return height < other.height;
+            if (slope != other.slope) return slope < other.slope;
+            return aspect < other.aspect;
+        }
+    };
+
+    /*! curves of the stations for one DTM, date, time step and settings: the transmissivity windows
+     *  of a station for all the hours of a day reuse the same values instead of computing
+     *  the radiation again. The curves are removed when the DTM, the date, the time step or the settings change
+     *  (the shadows depend on the DTM).
+     *  thread_local: each thread has its own curves (as the solpos data) */
+    struct TpotentialCurveMemo
+    {
+        Crit3DDate date;
+        int timeStep;
+        unsigned long long settingsChecksum;
+        unsigned long long dtmChecksum;
+        std::map <TpotentialCurveKey, TpotentialCurve> curves;
+    };
+
+    thread_local TpotentialCurveMemo potentialCurveMemo;
+
+
+    float computePotentialGlobal(TradPoint* myRadPoint, const Crit3DTime& myTime, float myLinke, float myAlbedo,
+                                 float myClearSkyTransmissivity, const gis::Crit3DRasterGrid& myDtm)
+    {
+        TsunPosition mySunPosition;
+        mySunPosition.shadow = false;
+        computeRadiationPointRsun(TEMPERATURE_DEFAULT, PRESSURE_DEFAULT, myTime, myLinke, myAlbedo, myClearSkyTransmissivity,
+                                  myClearSkyTransmissivity, &mySunPosition, myRadPoint, myDtm);
+        return float(myRadPoint->global);
+    }
+
+
+    /*!
+     * \brief curve of the station for the date of myTime, computed at the first request
+     * \return nullptr if the time step does not divide the day or myTime is not a step of the day.
+     * The curve is valid until the next request for a different date, time step or settings
+     */
+    const TpotentialCurve* getPotentialCurve(TradPoint* myRadPoint, const Crit3DTime& myTime, int timeStep,
+                                             float myLinke, float myAlbedo, float myClearSkyTransmissivity,
+                                             const gis::Crit3DRasterGrid& myDtm, unsigned long long dtmChecksum)
+    {
+        if (timeStep <= 0 || int(DAY_SECONDS) % timeStep != 0) return nullptr;
+        if (myTime.time != float(int(myTime.time)) || int(myTime.time) % timeStep != 0) return nullptr;
+
+        const Crit3DDate& myDate = myTime.date;
+
+        unsigned long long checksum = getSettingsChecksum();
+        float realSkyValues[] = {myLinke, myAlbedo, myClearSkyTransmissivity,
+                                 float(radiationSettings.getComputeRealData()), float(radiationSettings.getTransmissivityUseTotal())};
+        addChecksum(&checksum, realSkyValues, sizeof(realSkyValues));
+
+        TpotentialCurveMemo& memo = potentialCurveMemo;
+        if (memo.date != myDate || memo.timeStep != timeStep || memo.settingsChecksum != checksum
+            || memo.dtmChecksum != dtmChecksum)
+        {
+            memo.curves.clear();
+            memo.date = myDate;
+            memo.timeStep = timeStep;
+            memo.settingsChecksum = checksum;
+            memo.dtmChecksum = dtmChecksum;
+        }
+
+        TpotentialCurveKey key = {myRadPoint->x, myRadPoint->y, myRadPoint->height, myRadPoint->slope, myRadPoint->aspect};
+        std::map <TpotentialCurveKey, TpotentialCurve>::iterator it = memo.curves.find(key);
+        if (it != memo.curves.end()) return &(it->second);
+
+        TpotentialCurve& curve = memo.curves[key];
+        int nrStepsDay = int(DAY_SECONDS) / timeStep;
+        curve.global.resize(unsigned(3 * nrStepsDay));
+        curve.sumGlobal.resize(unsigned(3 * nrStepsDay + 1));
+        curve.sumGlobal[0] = 0;
+
+        for (int i = 0; i < 3 * nrStepsDay; i++)
+        {
+            Crit3DTime myTime(myDate.addDays(i / nrStepsDay - 1), float((i % nrStepsDay) * timeStep));
+            curve.global[unsigned(i)] = computePotentialGlobal(myRadPoint, myTime, myLinke, myAlbedo,
+                                                               myClearSkyTransmissivity, myDtm);
+            curve.sumGlobal[unsigned(i+1)] = curve.sumGlobal[unsigned(i)] + double(curve.global[unsigned(i)]);
+        }
+
+        return &curve;
+    }
+
+
+    /*!
+     * \brief index of the time in the curves of the memo
+     * \return NODATA if the time is not a step of the curves
+     */
+    int getPotentialCurveIndex(const Crit3DTime& myTime)
+    {
+        const TpotentialCurveMemo& memo = potentialCurveMemo;
+        if (myTime.time != float(int(myTime.time)) || int(myTime.time) % memo.timeStep != 0) return NODATA;
+
+        int dayOffset = memo.date.daysTo(myTime.date);
+        if (dayOffset < -1 || dayOffset > 1) return NODATA;
+
+        return (dayOffset + 1) * int(DAY_SECONDS) / memo.timeStep + int(myTime.time) / memo.timeStep;
+    }
+
+
+    /*!
+     * \brief potential global radiation of the point: read from the curve if the time is a step of the curve,
+     * computed otherwise
+     */
+    float getPotentialGlobal(const TpotentialCurve* curve, int index, TradPoint* myRadPoint, const Crit3DTime& myTime,
+                             float myLinke, float myAlbedo, float myClearSkyTransmissivity, const gis::Crit3DRasterGrid& myDtm)
+    {
+        if (curve != nullptr && index >= 0 && index < int(curve->global.size()))
+            return curve->global[unsigned(index)];
+
+        return computePotentialGlobal(myRadPoint, myTime, myLinke, myAlbedo, myClearSkyTransmissivity, myDtm);
+    }
+
+
+    /*!
+     * \brief number of time steps of the window centered on UTCTime where the potential radiation
+     * reaches the potential radiation at noon. On the daily potential curve of the point
+     * the sum on a window is a difference of prefix sums and the width is found by bisection
+     * (the sum increases with the width)
+     */
     int estimateTransmissivityWindow(const gis::Crit3DRasterGrid& myDtm,
                                      const Crit3DRadiationMaps& myRadiationMaps,
                                      gis::Crit3DPoint* myPoint, Crit3DTime UTCTime, int timeStepSecond)
     {
         double latDegrees, lonDegrees;
         TradPoint myRadPoint;
-        TsunPosition mySunPosition;
         float myLinke, myAlbedo;
         float  myClearSkyTransmissivity;
         float sumPotentialRadThreshold = 0.;
@@ -719,12 +955,38 @@ bool computeRadiationPointRsun(float myTemperature, float myPressure, Crit3DTime
         /*! threshold: noon potential radiation */
         myTmpTime = UTCTime;
         myTmpTime.time = 43200;
-        computeRadiationPointRsun(TEMPERATURE_DEFAULT, PRESSURE_DEFAULT, myTmpTime, myLinke, myAlbedo, myClearSkyTransmissivity, myClearSkyTransmissivity, &mySunPosition, &myRadPoint, myDtm);
-        sumPotentialRadThreshold = float(myRadPoint.global);
 
-        computeRadiationPointRsun(TEMPERATURE_DEFAULT, PRESSURE_DEFAULT, UTCTime, myLinke, myAlbedo, myClearSkyTransmissivity, myClearSkyTransmissivity, &mySunPosition, &myRadPoint, myDtm);
-        sumPotentialRad = float(myRadPoint.global);
+        const TpotentialCurve* curve = getPotentialCurve(&myRadPoint, UTCTime, timeStepSecond,
+                                                         myLinke, myAlbedo, myClearSkyTransmissivity, myDtm,
+                                                         myRadiationMaps.dtmChecksum);
+        int center = (curve == nullptr) ? NODATA : getPotentialCurveIndex(UTCTime);
+        int noon = (center == NODATA) ? NODATA : getPotentialCurveIndex(myTmpTime);
+
+        sumPotentialRadThreshold = getPotentialGlobal(curve, noon, &myRadPoint, myTmpTime, myLinke, myAlbedo, myClearSkyTransmissivity, myDtm);
+        sumPotentialRad = getPotentialGlobal(curve, center, &myRadPoint, UTCTime, myLinke, myAlbedo, myClearSkyTransmissivity, myDtm);
+
+        if (center != NODATA && sumPotentialRad < sumPotentialRadThreshold)
+        {
+            const std::vector <double>& sumGlobal = curve->sumGlobal;
+            int maxHalfWidth = minValue(center, int(curve->global.size()) - 1 - center);
+
+            if (sumGlobal[unsigned(center + maxHalfWidth + 1)] - sumGlobal[unsigned(center - maxHalfWidth)] >= sumPotentialRadThreshold)
+            {
+                int first = 1;
+                int last = maxHalfWidth;
+                while (first < last)
+                {
+                    int halfWidth = (first + last) / 2;
+                    if (sumGlobal[unsigned(center + halfWidth + 1)] - sumGlobal[unsigned(center - halfWidth)] >= sumPotentialRadThreshold)
+                        last = halfWidth;
+                    else
+                        first = halfWidth + 1;
+                }
+                return 2 * first + 1;
+            }
+        }
 
+        /*! time out of the curve or window wider than the curve: sum step by step */
         int backwardTimeStep,forwardTimeStep;
         backwardTimeStep = forwardTimeStep = 0;
         myWindowSteps = 1;
@@ -739,11 +1001,11 @@ bool computeRadiationPointRsun(float myTemperature, float myPressure, Crit3DTime
             backwardTime = UTCTime.addSeconds(float(backwardTimeStep));
             forwardTime = UTCTime.addSeconds(float(forwardTimeStep));
 
-            computeRadiationPointRsun(TEMPERATURE_DEFAULT, PRESSURE_DEFAULT, backwardTime, myLinke, myAlbedo, myClearSkyTransmissivity, myClearSkyTransmissivity, &mySunPosition, &myRadPoint, myDtm);
-            sumPotentialRad+= float(myRadPoint.global);
-
-            computeRadiationPointRsun(TEMPERATURE_DEFAULT, PRESSURE_DEFAULT, forwardTime, myLinke, myAlbedo, myClearSkyTransmissivity, myClearSkyTransmissivity, &mySunPosition, &myRadPoint, myDtm);
-            sumPotentialRad+= float(myRadPoint.global);
+            int halfWidth = myWindowSteps / 2;
+            sumPotentialRad+= getPotentialGlobal(curve, (center == NODATA) ? NODATA : center - halfWidth, &myRadPoint,
+                                                 backwardTime, myLinke, myAlbedo, myClearSkyTransmissivity, myDtm);
+            sumPotentialRad+= getPotentialGlobal(curve, (center == NODATA) ? NODATA : center + halfWidth, &myRadPoint,
+                                                 forwardTime, myLinke, myAlbedo, myClearSkyTransmissivity, myDtm);
         }
 
         return myWindowSteps;
@@ -766,57 +1028,406 @@ bool computeRadiationPointRsun(float myTemperature, float myPressure, Crit3DTime
         return output;
     }
 
-   bool computeRadiationGridRsun(const gis::Crit3DRasterGrid& myDtm,
-                                 Crit3DRadiationMaps* radiationMaps,
-                                 const Crit3DTime& UTCTime)
+    /*! sun position on a horizontal surface in the nodes of a lattice of DTM cells,
+     *  every step rows and columns (the last row and column are always nodes) */
+    struct TsunLattice
+    {
+        int step;
+        int nrRows, nrCols;
+        std::vector <TsunPosition> node;
+    };
+
 
+    int getLatticeNrNodes(int nrCells, int step)
     {
-        int myRow, myCol;
-        TsunPosition mySunPosition;
-        TradPoint myRadPoint;
+        return (nrCells - 1 + step - 1) / step + 1;
+    }
+
+
+    void getLatticeInterval(int cell, int nrCells, int step, int nrNodes, int* node0, int* node1, float* weight)
+    {
+        if (nrNodes == 1)
+        {
+            *node0 = 0;
+            *node1 = 0;
+            *weight = 0;
+            return;
+        }
+
+        *node0 = minValue(cell / step, nrNodes - 2);
+        *node1 = *node0 + 1;
+        int cell0 = *node0 * step;
+        int cell1 = minValue(*node1 * step, nrCells - 1);
+        *weight = float(cell - cell0) / float(cell1 - cell0);
+    }
+
+
+    float bilinear(float v00, float v01, float v10, float v11, float weightRow, float weightCol)
+    {
+        return (1 - weightRow) * ((1 - weightCol) * v00 + weightCol * v01)
+                + weightRow * ((1 - weightCol) * v10 + weightCol * v11);
+    }
+
+
+    bool computeSunLattice(const gis::Crit3DRasterGrid& myDtm, const Crit3DTime& UTCTime, int step, int nrThreads,
+                           TsunLattice* lattice)
+    {
+        Crit3DTime localTime = getLocalTime(UTCTime);
+
+        lattice->step = step;
+        lattice->nrRows = getLatticeNrNodes(myDtm.header->nrRows, step);
+        lattice->nrCols = getLatticeNrNodes(myDtm.header->nrCols, step);
+        lattice->node.resize(unsigned(lattice->nrRows * lattice->nrCols));
+
+        bool isOk = true;
+
+        #pragma omp parallel for num_threads(maxValue(nrThreads, 1)) reduction(&&:isOk)
+        for (int i = 0; i < lattice->nrRows; i++)
+            for (int j = 0; j < lattice->nrCols; j++)
+            {
+                double x, y, lat, lon;
+                int row = minValue(i * step, myDtm.header->nrRows - 1);
+                int col = minValue(j * step, myDtm.header->nrCols - 1);
+                gis::getUtmXYFromRowCol(myDtm, row, col, &x, &y);
+                gis::getLatLonFromUtm(*(radiationSettings.gisSettings), x, y, &lat, &lon);
+
+                if (! computeSunPosition(float(lon), float(lat), radiationSettings.gisSettings->timeZone,
+                                         localTime.date.year, localTime.date.month, localTime.date.day,
+                                         localTime.getHour(), localTime.getMinutes(), int(localTime.getSeconds()),
+                                         TEMPERATURE_DEFAULT, PRESSURE_DEFAULT, 180, 0, &(lattice->node[unsigned(i * lattice->nrCols + j)])))
+                    isOk = false;
+            }
+
+        return isOk;
+    }
+
+
+    /*!
+     * \brief sun position in the cell: bilinear interpolation of the lattice nodes,
+     * incidence computed on slope and aspect of the cell (as in solpos)
+     * \return false if the nodes are not all above (or all below) the horizon: compute the cell exactly
+     */
+    bool interpolateSunLattice(const TsunLattice& lattice, const gis::Crit3DRasterGrid& myDtm, int row, int col,
+                               float slope, float aspect, TsunPosition* mySunPosition)
+    {
+        int i0, i1, j0, j1;
+        float weightRow, weightCol;
+
+        getLatticeInterval(row, myDtm.header->nrRows, lattice.step, lattice.nrRows, &i0, &i1, &weightRow);
+        getLatticeInterval(col, myDtm.header->nrCols, lattice.step, lattice.nrCols, &j0, &j1, &weightCol);
+
+        const TsunPosition& p00 = lattice.node[unsigned(i0 * lattice.nrCols + j0)];
+        const TsunPosition& p01 = lattice.node[unsigned(i0 * lattice.nrCols + j1)];
+        const TsunPosition& p10 = lattice.node[unsigned(i1 * lattice.nrCols + j0)];
+        const TsunPosition& p11 = lattice.node[unsigned(i1 * lattice.nrCols + j1)];
+
+        bool isUp = (p00.elevationRefr > 0);
+        if ((p01.elevationRefr > 0) != isUp || (p10.elevationRefr > 0) != isUp || (p11.elevationRefr > 0) != isUp)
+            return false;
+
+        // azimuth: continuous around the first node
+        float azimuth[4] = {p00.azimuth, p01.azimuth, p10.azimuth, p11.azimuth};
+        for (int k = 1; k < 4; k++)
+        {
+            if (azimuth[k] - azimuth[0] > 180) azimuth[k] -= 360;
+            else if (azimuth[k] - azimuth[0] < -180) azimuth[k] += 360;
+        }
+
+        *mySunPosition = p00;
+        mySunPosition->azimuth = bilinear(azimuth[0], azimuth[1], azimuth[2], azimuth[3], weightRow, weightCol);
+        if (mySunPosition->azimuth < 0) mySunPosition->azimuth += 360;
+        else if (mySunPosition->azimuth >= 360) mySunPosition->azimuth -= 360;
+
+        mySunPosition->elevation = bilinear(p00.elevation, p01.elevation, p10.elevation, p11.elevation, weightRow, weightCol);
+        mySunPosition->elevationRefr = bilinear(p00.elevationRefr, p01.elevationRefr, p10.elevationRefr, p11.elevationRefr, weightRow, weightCol);
+        mySunPosition->relOptAirMass = bilinear(p00.relOptAirMass, p01.relOptAirMass, p10.relOptAirMass, p11.relOptAirMass, weightRow, weightCol);
+        mySunPosition->relOptAirMassCorr = bilinear(p00.relOptAirMassCorr, p01.relOptAirMassCorr, p10.relOptAirMassCorr, p11.relOptAirMassCorr, weightRow, weightCol);
+        mySunPosition->extraIrradianceNormal = bilinear(p00.extraIrradianceNormal, p01.extraIrradianceNormal, p10.extraIrradianceNormal, p11.extraIrradianceNormal, weightRow, weightCol);
+        mySunPosition->extraIrradianceHorizontal = bilinear(p00.extraIrradianceHorizontal, p01.extraIrradianceHorizontal, p10.extraIrradianceHorizontal, p11.extraIrradianceHorizontal, weightRow, weightCol);
+        mySunPosition->rise = bilinear(p00.rise, p01.rise, p10.rise, p11.rise, weightRow, weightCol);
+        mySunPosition->set = bilinear(p00.set, p01.set, p10.set, p11.set, weightRow, weightCol);
+
+        // incidence on the cell surface
+        double zenithRad = (90. - mySunPosition->elevationRefr) * DEG_TO_RAD;
+        double cosIncidence = cos(zenithRad) * cos(slope * DEG_TO_RAD)
+                + sin(zenithRad) * sin(slope * DEG_TO_RAD) * cos((mySunPosition->azimuth - aspect) * DEG_TO_RAD);
+        cosIncidence = maxValue(-1., minValue(1., cosIncidence));
+        mySunPosition->incidence = float(maxValue(0, RAD_TO_DEG * ((PI / 2.0) - acos(cosIncidence))));
+        mySunPosition->shadow = false;
+
+        return true;
+    }
+
+
+    /*!
+     * \brief accuracy of the sun lattice: maximum errors of the interpolated sun position
+     * against the position computed in each cell
+     * \param fallbackRatio ratio of cells computed exactly (nodes across the horizon)
+     */
+    bool getSunLatticeError(const gis::Crit3DRasterGrid& myDtm, Crit3DRadiationMaps* radiationMaps,
+                            const Crit3DTime& UTCTime, int latticeStep, float* maxElevationError,
+                            float* maxAzimuthError, float* maxIncidenceError, float* fallbackRatio)
+    {
+        TsunLattice lattice;
+        TsunPosition exactPosition, latticePosition;
+        Crit3DTime localTime = getLocalTime(UTCTime);
+        long nrCells = 0, nrFallback = 0;
+
+        *maxElevationError = 0;
+        *maxAzimuthError = 0;
+        *maxIncidenceError = 0;
+        *fallbackRatio = 0;
+
+        if (latticeStep < 1 || ! computeSunLattice(myDtm, UTCTime, latticeStep, 1, &lattice)) return false;
+
+        for (int row = 0; row < myDtm.header->nrRows; row++)
+            for (int col = 0; col < myDtm.header->nrCols; col++)
+            {
+                if (! isGridPointComputable(row, col, myDtm, radiationMaps)) continue;
+
+                float slope = readSlope(radiationMaps->slopeMap, row, col);
+                float aspect = readAspect(radiationMaps->aspectMap, row, col);
+                if (! computeSunPosition(radiationMaps->lonMap->value[row][col], radiationMaps->latMap->value[row][col],
+                                         radiationSettings.gisSettings->timeZone,
+                                         localTime.date.year, localTime.date.month, localTime.date.day,
+                                         localTime.getHour(), localTime.getMinutes(), int(localTime.getSeconds()),
+                                         TEMPERATURE_DEFAULT, PRESSURE_DEFAULT, aspect, slope, &exactPosition))
+                    return false;
+
+                nrCells++;
+                if (! interpolateSunLattice(lattice, myDtm, row, col, slope, aspect, &latticePosition))
+                {
+                    nrFallback++;
+                    continue;
+                }
+
+                float azimuthError = float(fabs(exactPosition.azimuth - latticePosition.azimuth));
+                if (azimuthError > 180) azimuthError = 360 - azimuthError;
+
+                *maxElevationError = maxValue(*maxElevationError, float(fabs(exactPosition.elevationRefr - latticePosition.elevationRefr)));
+                *maxAzimuthError = maxValue(*maxAzimuthError, azimuthError);
+                *maxIncidenceError = maxValue(*maxIncidenceError, float(fabs(exactPosition.incidence - latticePosition.incidence)));
+            }
+
+        if (nrCells > 0) *fallbackRatio = float(nrFallback) / float(nrCells);
+        return true;
+    }
+
+    void setMinMaxRasterGrid(gis::Crit3DRasterGrid* myGrid, float minimum, float maximum)
+    {
+        myGrid->minimum = minimum;
+        myGrid->maximum = maximum;
+        myGrid->colorScale->minimum = minimum;
+        myGrid->colorScale->maximum = maximum;
+    }
+
+    /*!
+     * \brief checksum of the settings that change the potential radiation of the cells
+     * (the linke map is included only if it is used)
+     * \param isHorizonMap shadows computed on the horizon map instead of the DTM
+     */
+    unsigned long long getPotentialSettingsChecksum(Crit3DRadiationMaps* radiationMaps, bool isHorizonMap)
+    {
+        unsigned long long hash = getSettingsChecksum();
+        int horizonFlag = int(isHorizonMap);
+        addChecksum(&hash, &horizonFlag, sizeof(horizonFlag));
+
+        if (radiationSettings.getLinkeMode() == PARAM_MODE_MAP)
+        {
+            unsigned long long linkeChecksum = gis::getRasterChecksum(*(radiationMaps->linkeMap));
+            addChecksum(&hash, &linkeChecksum, sizeof(linkeChecksum));
+        }
+
+        return hash;
+    }
+
+
+    /*!
+     * \brief the potential radiation of the grid is saved in cachePath for each day of year and time
+     * and reused by the following runs on the same DTM (empty cachePath: no cache).
+     * The cache is used only if enabled in the radiation settings (potentialCacheSize > 0)
+     */
+    void setPotentialRadiationCache(const gis::Crit3DRasterGrid& myDtm, Crit3DRadiationMaps* radiationMaps,
+                                    const std::string& cachePath)
+    {
+        radiationMaps->potentialMap->clear();
+        radiationMaps->potentialCachePath = cachePath;
+        radiationMaps->potentialCacheDtmChecksum = cachePath.empty() ? 0 : gis::getRasterChecksum(myDtm);
+    }
+
+
+    std::string getPotentialCacheFileName(Crit3DRadiationMaps* radiationMaps, unsigned long long settingsChecksum,
+                                          int dayOfYear, int seconds)
+    {
+        std::ostringstream fileName;
+        fileName << radiationMaps->potentialCachePath << "potential_" << std::hex
+                 << radiationMaps->potentialCacheDtmChecksum << "_" << settingsChecksum << std::dec
+                 << "_" << dayOfYear << "_" << seconds << ".bin";
+        return fileName.str();
+    }
+
+
+    /*!
+     * \brief radiation on the cells of the DTM: blocks of rows are computed in parallel (nrThreads)
+     * and the minimum and maximum of the output maps are updated in the same pass.
+     * With the potential radiation cache, sun position, shadows and clear sky irradiance
+     * are read from file (if already computed for the day of year and time) and only
+     * the transmissivity is applied to them
+     */
+    bool computeRadiationGridRsun(const gis::Crit3DRasterGrid& myDtm,
+                                  Crit3DRadiationMaps* radiationMaps,
+                                  const Crit3DTime& UTCTime, int nrThreads)
+    {
+        /*! precomputed horizon instead of ray marching (if available for this DTM) */
+        const Crit3DHorizonMap* myHorizonMap = nullptr;
+        if (radiationSettings.getComputeShadowing()
+            && radiationMaps->horizonMap->isValid(myDtm, radiationSettings.getHorizonSectors(), radiationSettings.getShadowDistanceFactor()))
+            myHorizonMap = radiationMaps->horizonMap;
+
+        /*! potential radiation read from the cache (if available) */
+        Crit3DPotentialRadiationMap* myPotentialMap = radiationMaps->potentialMap;
+        bool isPotentialLoaded = false;
+        bool isPotentialSaved = false;
+        std::string potentialFileName, myError;
+
+        if (! radiationMaps->potentialCachePath.empty() && radiationSettings.getPotentialCacheSize() > 0)
+        {
+            unsigned long long settingsChecksum = getPotentialSettingsChecksum(radiationMaps, myHorizonMap != nullptr);
+            int dayOfYear = getDoyFromDate(UTCTime.date);
+            int seconds = int(UTCTime.time);
+
+            potentialFileName = getPotentialCacheFileName(radiationMaps, settingsChecksum, dayOfYear, seconds);
+            isPotentialLoaded = myPotentialMap->readFile(potentialFileName, myDtm.header->nrRows, myDtm.header->nrCols,
+                                                         radiationMaps->potentialCacheDtmChecksum, settingsChecksum,
+                                                         dayOfYear, seconds, &myError);
+            if (! isPotentialLoaded)
+            {
+                myPotentialMap->initialize(myDtm.header->nrRows, myDtm.header->nrCols,
+                                           radiationMaps->potentialCacheDtmChecksum, settingsChecksum, dayOfYear, seconds);
+                isPotentialSaved = true;
+            }
+        }
+
+        /*! sun position interpolated on a lattice of cells (if required) */
+        TsunLattice sunLattice;
+        int latticeStep = radiationSettings.getSunLatticeStep();
+        bool useLattice = (! isPotentialLoaded && latticeStep > 1
+                           && computeSunLattice(myDtm, UTCTime, latticeStep, nrThreads, &sunLattice));
+
+        gis::Crit3DRasterGrid* outputMaps[RADIATION_GRID_OUTPUTS] = {
+            radiationMaps->sunAzimuthMap, radiationMaps->sunElevationMap, radiationMaps->sunIncidenceMap,
+            radiationMaps->sunShadowMap, radiationMaps->beamRadiationMap, radiationMaps->diffuseRadiationMap,
+            radiationMaps->reflectedRadiationMap, radiationMaps->globalRadiationMap};
+
+        float minimum[RADIATION_GRID_OUTPUTS], maximum[RADIATION_GRID_OUTPUTS];
+        bool isFirstValue = true;
+        bool isOk = true;
+        int nrRows = myDtm.header->nrRows;
 
-        for (myRow=0;myRow< myDtm.header->nrRows ; myRow++ )
+        #pragma omp parallel num_threads(maxValue(nrThreads, 1))
         {
-            for (myCol=0;myCol < myDtm.header->nrCols; myCol++)
+            TsunPosition mySunPosition;
+            TradPoint myRadPoint;
+            bool isPointIlluminated;
+            float Bhc, Dhc;
+            float values[RADIATION_GRID_OUTPUTS];
+            float threadMinimum[RADIATION_GRID_OUTPUTS], threadMaximum[RADIATION_GRID_OUTPUTS];
+            bool isThreadFirstValue = true;
+            bool isThreadOk = true;
+            int i;
+
+            #pragma omp for schedule(dynamic, RADIATION_ROW_BLOCK)
+            for (int myRow = 0; myRow < nrRows; myRow++)
             {
-                if(isGridPointComputable(myRow, myCol, myDtm, radiationMaps))
+                for (int myCol = 0; myCol < myDtm.header->nrCols; myCol++)
                 {
+                    if (! isGridPointComputable(myRow, myCol, myDtm, radiationMaps)) continue;
+
                     gis::getUtmXYFromRowCol(myDtm, myRow, myCol, &(myRadPoint.x), &(myRadPoint.y));
                     myRadPoint.height = myDtm.value[myRow][myCol];
                     myRadPoint.lat = radiationMaps->latMap->value[myRow][myCol];
                     myRadPoint.lon = radiationMaps->lonMap->value[myRow][myCol];
                     myRadPoint.slope = readSlope(radiationMaps->slopeMap, myRow, myCol);
                     myRadPoint.aspect = readAspect(radiationMaps->aspectMap, myRow, myCol);
-                    //CHIAMATA A SINGLE POINT
-                    if (!computeRadiationPointRsun(TEMPERATURE_DEFAULT, PRESSURE_DEFAULT, UTCTime,
-                                    readLinke(myRow, myCol, *(radiationMaps->linkeMap)), readAlbedo(myRow, myCol, *(radiationMaps->albedoMap)), radiationSettings.getClearSky(), radiationMaps->transmissivityMap->value[myRow][myCol], &mySunPosition, &myRadPoint, myDtm))
-                        return false;
 
-                    radiationMaps->sunAzimuthMap->value[myRow][myCol] = mySunPosition.azimuth;
-                    radiationMaps->sunElevationMap->value[myRow][myCol] = mySunPosition.elevationRefr;
-                    radiationMaps->sunIncidenceMap->value[myRow][myCol] = mySunPosition.incidence;
+                    if (! isPotentialLoaded || ! myPotentialMap->getCell(myRow, myCol, &mySunPosition,
+                                                                         &isPointIlluminated, &Bhc, &Dhc))
+                    {
+                        bool isSunPositionComputed = (useLattice && interpolateSunLattice(sunLattice, myDtm, myRow, myCol,
+                                                                float(myRadPoint.slope), float(myRadPoint.aspect), &mySunPosition));
+
+                        if (! computePotentialPointRsun(TEMPERATURE_DEFAULT, PRESSURE_DEFAULT, UTCTime,
+                                                        readLinke(myRow, myCol, *(radiationMaps->linkeMap)),
+                                                        &mySunPosition, &myRadPoint, myDtm, myHorizonMap,
+                                                        isSunPositionComputed, &isPointIlluminated, &Bhc, &Dhc))
+                        {
+                            isThreadOk = false;
+                            continue;
+                        }
+
+                        if (isPotentialSaved)
+                            myPotentialMap->setCell(myRow, myCol, mySunPosition, isPointIlluminated, Bhc, Dhc);
+                    }
+
+                    computeRealSkyPointRsun(readAlbedo(myRow, myCol, *(radiationMaps->albedoMap)), radiationSettings.getClearSky(),
+                                            radiationMaps->transmissivityMap->value[myRow][myCol],
+                                            isPointIlluminated, Bhc, Dhc, &mySunPosition, &myRadPoint);
 
-                    radiationMaps->sunShadowMap->value[myRow][myCol] = float((mySunPosition.shadow) ?  0 : 1);
+                    values[0] = mySunPosition.azimuth;
+                    values[1] = mySunPosition.elevationRefr;
+                    values[2] = mySunPosition.incidence;
+                    values[3] = float((mySunPosition.shadow) ?  0 : 1);
+                    values[4] = float(myRadPoint.beam);
+                    values[5] = float(myRadPoint.diffuse);
+                    values[6] = float(myRadPoint.reflected);
+                    values[7] = float(myRadPoint.global);
+
+                    for (i = 0; i < RADIATION_GRID_OUTPUTS; i++)
+                    {
+                        outputMaps[i]->value[myRow][myCol] = values[i];
+                        if (isThreadFirstValue)
+                        {
+                            threadMinimum[i] = values[i];
+                            threadMaximum[i] = values[i];
+                        }
+                        else
+                        {
+                            threadMinimum[i] = minValue(threadMinimum[i], values[i]);
+                            threadMaximum[i] = maxValue(threadMaximum[i], values[i]);
+                        }
+                    }
+                    isThreadFirstValue = false;
+                }
+            }
 
-                    radiationMaps->beamRadiationMap->value[myRow][myCol] = float(myRadPoint.beam);
-                    radiationMaps->diffuseRadiationMap->value[myRow][myCol] = float(myRadPoint.diffuse);
-                    radiationMaps->reflectedRadiationMap->value[myRow][myCol] = float(myRadPoint.reflected);
-                    radiationMaps->globalRadiationMap->value[myRow][myCol] = float(myRadPoint.global);
+            #pragma omp critical
+            {
+                if (! isThreadOk) isOk = false;
+                if (! isThreadFirstValue)
+                {
+                    for (i = 0; i < RADIATION_GRID_OUTPUTS; i++)
+                    {
+                        minimum[i] = isFirstValue ? threadMinimum[i] : minValue(minimum[i], threadMinimum[i]);
+                        maximum[i] = isFirstValue ? threadMaximum[i] : maxValue(maximum[i], threadMaximum[i]);
+                    }
+                    isFirstValue = false;
                 }
             }
         }
 
-        gis::updateMinMaxRasterGrid(radiationMaps->sunAzimuthMap);
-        gis::updateMinMaxRasterGrid(radiationMaps->sunElevationMap);
-        gis::updateMinMaxRasterGrid(radiationMaps->sunIncidenceMap);
+        if (! isOk) return false;
+
+        // the radiation is valid even if the cache cannot be written
+        if (isPotentialSaved)
+            myPotentialMap->writeFile(potentialFileName, &myError);
+
+        if (! isFirstValue)
+            for (int i = 0; i < RADIATION_GRID_OUTPUTS; i++)
+                setMinMaxRasterGrid(outputMaps[i], minimum[i], maximum[i]);
+
         gis::updateMinMaxRasterGrid(radiationMaps->sunRiseMap);
         gis::updateMinMaxRasterGrid(radiationMaps->sunSetMap);
-        gis::updateMinMaxRasterGrid(radiationMaps->sunShadowMap);
         gis::updateMinMaxRasterGrid(radiationMaps->transmissivityMap);
-        gis::updateMinMaxRasterGrid(radiationMaps->diffuseRadiationMap);
-        gis::updateMinMaxRasterGrid(radiationMaps->reflectedRadiationMap);
-        gis::updateMinMaxRasterGrid(radiationMaps->beamRadiationMap);
-        gis::updateMinMaxRasterGrid(radiationMaps->globalRadiationMap);
 
         return true;
     }
@@ -979,13 +1590,13 @@ bool computeRadiationPointRsun(float myTemperature, float myPressure, Crit3DTime
 
     bool computeRadiationGridPresentTime(const gis::Crit3DRasterGrid& myDtm,
                                          Crit3DRadiationMaps* radiationMaps,
-                                         const Crit3DTime& myCrit3DTime)
+                                         const Crit3DTime& myCrit3DTime, int nrThreads)
     {
         if (! preConditionsRadiationGrid(radiationMaps))
             return false;        
 
         if (radiationSettings.getAlgorithm() == RADIATION_ALGORITHM_RSUN)
-            return computeRadiationGridRsun(myDtm, radiationMaps, myCrit3DTime);
+            return computeRadiationGridRsun(myDtm, radiationMaps, myCrit3DTime, nrThreads);
         else if (radiationSettings.getAlgorithm() == RADIATION_ALGORITHM_BROOKS)
             // to do
             return false;
@@ -993,8 +1604,38 @@ bool computeRadiationPointRsun(float myTemperature, float myPressure, Crit3DTime
             return false;
     }
 
+    /*!
+     * \brief horizon map of the DTM for the terrain shadowing: read from file if computed
+     * on the same DTM with the same settings, otherwise computed and saved
+     * \param fileName cache file of the horizon map
+     * \return false if the shadowing is not required or the map cannot be computed
+     */
+    bool loadHorizonMap(const gis::Crit3DRasterGrid& myDtm, Crit3DRadiationMaps* radiationMaps,
+                        const std::string& fileName, int nrThreads, std::string* myError)
+    {
+        int nrSectors = radiationSettings.getHorizonSectors();
+        float distanceFactor = radiationSettings.getShadowDistanceFactor();
+
+        if (! radiationSettings.getComputeShadowing() || nrSectors <= 0) return false;
+        if (radiationMaps->horizonMap->isValid(myDtm, nrSectors, distanceFactor)) return true;
+
+        if (radiationMaps->horizonMap->readFile(fileName, myDtm, nrSectors, distanceFactor, myError))
+            return true;
+
+        if (! radiationMaps->horizonMap->build(myDtm, nrSectors, distanceFactor, nrThreads))
+        {
+            *myError = "Error computing the horizon map";
+            return false;
+        }
+
+        // the map is valid even if the cache cannot be written
+        radiationMaps->horizonMap->writeFile(fileName, myError);
+        return true;
+    }
+
     float computePointTransmissivity(const gis::Crit3DPoint& myPoint, Crit3DTime UTCTime, float* measuredRad,
-                                     int windowWidth, int timeStepSecond, const gis::Crit3DRasterGrid& myDtm)
+                                     int windowWidth, int timeStepSecond, const gis::Crit3DRasterGrid& myDtm,
+                                     const Crit3DRadiationMaps& myRadiationMaps)
     {
         if (windowWidth % 2 != 1) return PARAMETER_ERROR;
 
@@ -1003,7 +1644,6 @@ bool computeRadiationPointRsun(float myTemperature, float myPressure, Crit3DTime
         double latDegrees, lonDegrees;
         float ratioTransmissivity;
         TradPoint myRadPoint;
-        TsunPosition mySunPosition;
         float myLinke, myAlbedo;
         float  myClearSkyTransmissivity;
         float myTransmissivity;
@@ -1030,6 +1670,11 @@ bool computeRadiationPointRsun(float myTemperature, float myPressure, Crit3DTime
         myAlbedo = readAlbedo();
         myClearSkyTransmissivity = radiationSettings.getClearSky();
 
+        const TpotentialCurve* curve = getPotentialCurve(&myRadPoint, UTCTime, timeStepSecond,
+                                                         myLinke, myAlbedo, myClearSkyTransmissivity, myDtm,
+                                                         myRadiationMaps.dtmChecksum);
+        int center = (curve == nullptr) ? NODATA : getPotentialCurveIndex(UTCTime);
+
         int backwardTimeStep,forwardTimeStep;
         backwardTimeStep = forwardTimeStep = 0;
         backwardTime = forwardTime = UTCTime;
@@ -1042,12 +1687,12 @@ bool computeRadiationPointRsun(float myTemperature, float myPressure, Crit3DTime
         if (measuredRad[myIntervalCenter] != NODATA)
         {
             sumMeasuredRad += measuredRad[myIntervalCenter];
-            computeRadiationPointRsun(TEMPERATURE_DEFAULT, PRESSURE_DEFAULT, UTCTime, myLinke, myAlbedo, myClearSkyTransmissivity, myClearSkyTransmissivity, &mySunPosition, &myRadPoint, myDtm);
-            sumPotentialRad += float(myRadPoint.global);
+            sumPotentialRad += getPotentialGlobal(curve, center, &myRadPoint, UTCTime, myLinke, myAlbedo, myClearSkyTransmissivity, myDtm);
         }
 
         for (int windowIndex = (myIntervalCenter - 1); windowIndex >= 0; windowIndex--)
         {
+            int halfWidth = myIntervalCenter - windowIndex;
             backwardTimeStep -= timeStepSecond;
             forwardTimeStep += timeStepSecond;
             backwardTime = UTCTime.addSeconds(float(backwardTimeStep));
@@ -1056,14 +1701,14 @@ bool computeRadiationPointRsun(float myTemperature, float myPressure, Crit3DTime
             if (measuredRad[windowIndex] != NODATA)
             {
                 sumMeasuredRad += measuredRad[windowIndex];
-                computeRadiationPointRsun(TEMPERATURE_DEFAULT, PRESSURE_DEFAULT, backwardTime, myLinke, myAlbedo, myClearSkyTransmissivity, myClearSkyTransmissivity, &mySunPosition, &myRadPoint, myDtm);
-                sumPotentialRad += float(myRadPoint.global);
+                sumPotentialRad += getPotentialGlobal(curve, (center == NODATA) ? NODATA : center - halfWidth, &myRadPoint,
+                                                      backwardTime, myLinke, myAlbedo, myClearSkyTransmissivity, myDtm);
             }
             if (measuredRad[windowWidth-windowIndex-1] != NODATA)
             {
                 sumMeasuredRad+= measuredRad[windowWidth-windowIndex-1];
-                computeRadiationPointRsun(TEMPERATURE_DEFAULT, PRESSURE_DEFAULT, forwardTime, myLinke, myAlbedo, myClearSkyTransmissivity, myClearSkyTransmissivity, &mySunPosition, &myRadPoint, myDtm);
-                sumPotentialRad+= float(myRadPoint.global);
+                sumPotentialRad += getPotentialGlobal(curve, (center == NODATA) ? NODATA : center + halfWidth, &myRadPoint,
+                                                      forwardTime, myLinke, myAlbedo, myClearSkyTransmissivity, myDtm);
             }
         }
         ratioTransmissivity = maxValue(sumMeasuredRad/sumPotentialRad, float(0.0));
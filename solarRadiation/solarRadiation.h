@@ -4,6 +4,12 @@
     #ifndef RADIATIONDEFINITIONS_H
         #include "radiationSettings.h"
     #endif
+    #ifndef HORIZON_H
+        #include "horizon.h"
+    #endif
+    #ifndef POTENTIALRADIATION_H
+        #include "potentialRadiation.h"
+    #endif
 
     class Crit3DRadiationMaps
     {
@@ -26,6 +32,12 @@
         gis::Crit3DRasterGrid* sunShadowMap;
         gis::Crit3DRasterGrid* linkeMap;
         gis::Crit3DRasterGrid* albedoMap;
+        Crit3DHorizonMap* horizonMap;
+        Crit3DPotentialRadiationMap* potentialMap;
+
+        std::string potentialCachePath;                 /*!< folder of the potential radiation files (empty: no cache) */
+        unsigned long long potentialCacheDtmChecksum;
+        unsigned long long dtmChecksum;                 /*!< checksum of the DTM of the maps (0: no DTM) */
 
         Crit3DRadiationMaps();
         Crit3DRadiationMaps(const gis::Crit3DRasterGrid& myDtm, const gis::Crit3DGisSettings& myGisSettings);
@@ -47,10 +59,21 @@
                                  gis::Crit3DPoint* myPoint, Crit3DTime UTCTime, int timeStepSecond);
 
         bool computeRadiationGridPresentTime(const gis::Crit3DRasterGrid& myDtm,
-                                 Crit3DRadiationMaps* radiationMaps, const Crit3DTime& myCrit3DTime);
+                                 Crit3DRadiationMaps* radiationMaps, const Crit3DTime& myCrit3DTime, int nrThreads = 1);
+
+        bool getSunLatticeError(const gis::Crit3DRasterGrid& myDtm, Crit3DRadiationMaps* radiationMaps,
+                                const Crit3DTime& UTCTime, int latticeStep, float* maxElevationError,
+                                float* maxAzimuthError, float* maxIncidenceError, float* fallbackRatio);
+
+        bool loadHorizonMap(const gis::Crit3DRasterGrid& myDtm, Crit3DRadiationMaps* radiationMaps,
+                            const std::string& fileName, int nrThreads, std::string* myError);
+
+        void setPotentialRadiationCache(const gis::Crit3DRasterGrid& myDtm, Crit3DRadiationMaps* radiationMaps,
+                                        const std::string& cachePath);
 
         float computePointTransmissivity(const gis::Crit3DPoint& myPoint, Crit3DTime UTCTime, float* measuredRad,
-                                         int windowWidth, int timeStepSecond, const gis::Crit3DRasterGrid& myDtm);
+                                         int windowWidth, int timeStepSecond, const gis::Crit3DRasterGrid& myDtm,
+                                         const Crit3DRadiationMaps& myRadiationMaps);
 
         gis::Crit3DRasterGrid* getBeamRadiationMap();
         gis::Crit3DRasterGrid* getDiffuseRadiationMap();
@@ -11,6 +11,10 @@ TARGET = solarRadiation
 TEMPLATE = lib
 CONFIG += staticlib
 
+# parallel horizon map and radiation grid
+win32-msvc*: QMAKE_CXXFLAGS += -openmp
+else: QMAKE_CXXFLAGS += -fopenmp
+
 INCLUDEPATH += ../crit3dDate ../mathFunctions ../gis ../meteo
 
 SOURCES += \
@@ -18,7 +22,9 @@ SOURCES += \
     solarRadiation.cpp \
     sunPosition.cpp \
     radiationSettings.cpp \
-    transmissivity.cpp
+    transmissivity.cpp \
+    horizon.cpp \
+    potentialRadiation.cpp
 
 HEADERS += \
     solPos.h \
@@ -26,5 +32,7 @@ HEADERS += \
     radiationSettings.h \
     radiationDefinitions.h \
     solarRadiation.h \
-    transmissivity.h
+    transmissivity.h \
+    horizon.h \
+    potentialRadiation.h
 
@@ -30,7 +30,8 @@
 #include "solPos.h"
 #include "sunPosition.h"
 
-struct posdata pd, *pdat; /*!< declare solpos data struct and a pointer for it */
+/*! declare solpos data struct and a pointer for it (one for each thread: the grid is computed in parallel) */
+thread_local struct posdata pd, *pdat;
 
 
 long RSUN_compute_solar_position (float longitude, float latitude, int myTimezone,
@@ -17,7 +17,7 @@ float computePointTransmissivitySamani(float tmin, float tmax, float samaniCoeff
 
 
 int computeTransmissivity(Crit3DMeteoPoint* meteoPoints, int nrMeteoPoints, int intervalWidth,
-                          Crit3DTime myTime, const gis::Crit3DRasterGrid& myDtm)
+                          Crit3DTime myTime, const gis::Crit3DRasterGrid& myDtm, const Crit3DRadiationMaps& myRadiationMaps)
 {
     if (nrMeteoPoints <= 0) return 0;
 
@@ -58,7 +58,8 @@ int computeTransmissivity(Crit3DMeteoPoint* meteoPoints, int nrMeteoPoints, int
             indexSubDaily = (hourlyFraction * myTime.getHour()) + myTime.getMinutes() % (60 / hourlyFraction);
 
             meteoPoints[i].obsDataH[indexDate].transmissivity[indexSubDaily] =
-                    radiation::computePointTransmissivity(myPoint, myTime, myObsRad, intervalWidth, deltaSeconds, myDtm);
+                    radiation::computePointTransmissivity(myPoint, myTime, myObsRad, intervalWidth, deltaSeconds,
+                                                         myDtm, myRadiationMaps);
 
             myCounter++;
         }
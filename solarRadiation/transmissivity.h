@@ -5,13 +5,16 @@
         #include "meteoPoint.h"
     #endif
 
+    class Crit3DRadiationMaps;
+
     float computePointTransmissivitySamani(float tmin, float tmax, float samaniCoeff);
 
     float computePointTransmissivity(const gis::Crit3DPoint& myPoint, Crit3DTime UTCTime, float* measuredRad,
                                  int windowWidth, int timeStepSecond, const gis::Crit3DRasterGrid& myDtm);
 
     int computeTransmissivity(Crit3DMeteoPoint* meteoPoints, int nrMeteoPoints, int intervalWidth,
-                                Crit3DTime myTime, const gis::Crit3DRasterGrid& myDtm);
+                                Crit3DTime myTime, const gis::Crit3DRasterGrid& myDtm,
+                                const Crit3DRadiationMaps& myRadiationMaps);
 
     int computeTransmissivityFromTRange(Crit3DMeteoPoint* meteoPoints, int nrMeteoPoints, Crit3DTime currentTime);
 